@@ -66,8 +66,9 @@ public:
 
   DISABLE_COPY_MOVE_AND_ASSIGN(Client)
 
-  void Init(const std::string &input, const std::string &output)
+  void Init(const std::string &input, const std::string &output, bool binary = false)
   {
+    binary_ = binary;
     if (!input.empty()) {
       input_.open(input);
       if (!input_.is_open()) {
@@ -177,6 +178,16 @@ private:
     if ((err_no_ = connect(sock_fd_, (struct sockaddr *)&serverAddress, sizeof(serverAddress))) < 0) {
       WSDB_LOG("ERROR connecting");
     }
+    if (err_no_ >= 0 && binary_) {
+      // ask the server to send records in column blocks
+      pkg_.type_   = net::NET_PKG_SET_FORMAT;
+      pkg_.len_    = 1;
+      pkg_.buf_[0] = static_cast<char>(net::NET_FORMAT_BINARY);
+      if ((err_no_ = net::WriteNetPkg(sock_fd_, pkg_)) < 0) {
+        WSDB_LOG("ERROR writing to socket");
+      }
+      DoReceive();
+    }
   }
 
   void CloseSocket() const { close(sock_fd_); }
@@ -223,6 +234,17 @@ private:
           PrintRecord(rec, col_width);
         }
         rec_num += records.size();
+      } else if (pkg_.type_ == net::NET_PKG_REC_BLOCK) {
+        std::vector<std::string> records;
+        if (!net::DecodeRecBlock(pkg_, records)) {
+          WSDB_LOG("ERROR decoding record block");
+          err_no_ = -1;
+          break;
+        }
+        for (auto &rec : records) {
+          PrintRecord(rec, col_width);
+        }
+        rec_num += records.size();
       } else if (pkg_.type_ == net::NET_PKG_REC_END) {
         // print bottom line
         PrintSeperator(col_width);
@@ -284,6 +306,7 @@ private:
 
 private:
   bool                     is_interactive_{true};
+  bool                     binary_{false};
   std::ifstream            input_;
   std::ofstream            output_file_;
   std::ostream             output_{std::cout.rdbuf()};
@@ -300,6 +323,10 @@ int main(int argc, char *argv[])
   program.add_argument("-h", "--help").help("show help").default_value(false).implicit_value(true);
   program.add_argument("-i", "--input").required().help("input file").default_value(std::string());
   program.add_argument("-o", "--output").required().help("output file").default_value(std::string());
+  program.add_argument("-b", "--binary")
+      .help("receive records in the binary column format")
+      .default_value(false)
+      .implicit_value(true);
 
   Client client;
   try {
@@ -312,7 +339,8 @@ int main(int argc, char *argv[])
       std::cout << "wsdb client 0.1" << std::endl;
       return 0;
     }
-    client.Init(program.get<std::string>("--input"), program.get<std::string>("--output"));
+    client.Init(
+        program.get<std::string>("--input"), program.get<std::string>("--output"), program.get<bool>("--binary"));
   } catch (const std::runtime_error &err) {
     std::cerr << err.what() << std::endl;
     return 1;
@@ -19,7 +19,9 @@
 // Created by ziqi on 2024/7/31.
 //
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <cstring>
 #include "net.h"
 #include "../error.h"
 #include "../micro.h"
@@ -44,12 +46,20 @@ static ssize_t readn(int sockfd, char *buf, int len)
   return len;
 }
 
-static ssize_t writen(int sockfd, char *buf, int len)
+static ssize_t writevn(int sockfd, struct iovec *iov, int iovcnt, int flags)
 {
-  ssize_t n;
-  ssize_t nleft = len;
+  ssize_t total = 0;
+  for (int i = 0; i < iovcnt; ++i) {
+    total += static_cast<ssize_t>(iov[i].iov_len);
+  }
+  ssize_t nleft = total;
   while (nleft > 0) {
-    n = write(sockfd, buf, nleft);
+    struct msghdr msg
+    {};
+    msg.msg_iov    = iov;
+    msg.msg_iovlen = iovcnt;
+    // report a closed peer as an error instead of raising SIGPIPE
+    auto n = sendmsg(sockfd, &msg, flags | MSG_NOSIGNAL);
     if (n < 0) {
       WSDB_LOG("ERROR writing to socket");
       return -1;
@@ -58,9 +68,18 @@ static ssize_t writen(int sockfd, char *buf, int len)
       return -1;
     }
     nleft -= n;
-    buf += n;
+    // skip what has been sent
+    while (iovcnt > 0 && static_cast<size_t>(n) >= iov->iov_len) {
+      n -= static_cast<ssize_t>(iov->iov_len);
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = static_cast<char *>(iov->iov_base) + n;
+      iov->iov_len -= n;
+    }
   }
-  return len;
+  return total;
 }
 
 int ReadNetPkg(int sockfd, NetPkg &pkg)
@@ -77,29 +96,171 @@ int ReadNetPkg(int sockfd, NetPkg &pkg)
   if (pkg.len_ == 0) {
     return static_cast<int>(sizeof(pkg.type_) + sizeof(pkg.len_));
   }
+  if (pkg.len_ > NET_BUFFER_SIZE) {
+    WSDB_LOG(fmt::format("package of {} bytes exceeds the buffer", pkg.len_));
+    return -1;
+  }
   n = readn(sockfd, pkg.buf_, static_cast<int>(pkg.len_));
   if (n <= 0)
     return static_cast<int>(n);
   return static_cast<int>(sizeof(pkg.type_) + sizeof(pkg.len_) + n);
 }
 
-int WriteNetPkg(int sockfd, NetPkg &pkg)
+int WriteNetPkg(int sockfd, const NetPkg &pkg, bool more)
 {
-  // write pkg type
-  auto n = writen(sockfd, (char *)&pkg.type_, sizeof(pkg.type_));
-  if (n <= 0)
-    return static_cast<int>(n);
-  // write pkg length
-  n = writen(sockfd, (char *)&pkg.len_, sizeof(pkg.len_));
-  if (n <= 0)
-    return static_cast<int>(n);
-  // write pkg data
-  if (pkg.len_ == 0) {
-    return static_cast<int>(sizeof(pkg.type_) + sizeof(pkg.len_));
+  // pkg type, pkg length and pkg data go out in one call straight from the package
+  struct iovec iov[3];
+  iov[0].iov_base = const_cast<NetPkgType *>(&pkg.type_);
+  iov[0].iov_len  = sizeof(pkg.type_);
+  iov[1].iov_base = const_cast<size_t *>(&pkg.len_);
+  iov[1].iov_len  = sizeof(pkg.len_);
+  iov[2].iov_base = const_cast<char *>(pkg.buf_);
+  iov[2].iov_len  = pkg.len_;
+  auto n          = writevn(sockfd, iov, pkg.len_ == 0 ? 2 : 3, more ? MSG_MORE : 0);
+  return static_cast<int>(n);
+}
+bool DecodeRecBlock(const NetPkg &pkg, std::vector<std::string> &records)
+{
+  const char *pos = pkg.buf_;
+  const char *end = pkg.buf_ + pkg.len_;
+  auto        read = [&pos, end](void *dst, size_t len) {
+    if (static_cast<size_t>(end - pos) < len) {
+      return false;
+    }
+    memcpy(dst, pos, len);
+    pos += len;
+    return true;
+  };
+  uint32_t row_num = 0;
+  uint32_t col_num = 0;
+  if (!read(&row_num, sizeof(row_num)) || !read(&col_num, sizeof(col_num))) {
+    return false;
   }
-  n = writen(sockfd, pkg.buf_, static_cast<int>(pkg.len_));
-  if (n <= 0)
-    return static_cast<int>(n);
-  return static_cast<int>(sizeof(pkg.type_) + sizeof(pkg.len_) + n);
+  std::vector<std::string> rows(row_num);
+  for (uint32_t c = 0; c < col_num; ++c) {
+    uint8_t type = 0;
+    if (!read(&type, sizeof(type))) {
+      return false;
+    }
+    std::vector<uint8_t> nulls((row_num + 7) / 8);
+    if (!read(nulls.data(), nulls.size())) {
+      return false;
+    }
+    auto is_null = [&nulls](uint32_t r) { return (nulls[r / 8] & (1 << (r % 8))) != 0; };
+    // values are formatted like Value::ToString
+    std::vector<uint32_t> lens;
+    if (type == NET_COL_STRING) {
+      lens.resize(row_num);
+      if (!read(lens.data(), lens.size() * sizeof(uint32_t))) {
+        return false;
+      }
+    }
+    for (uint32_t r = 0; r < row_num; ++r) {
+      std::string field;
+      switch (type) {
+        case NET_COL_INT: {
+          int32_t v = 0;
+          if (!read(&v, sizeof(v))) {
+            return false;
+          }
+          field = std::to_string(v);
+          break;
+        }
+        case NET_COL_FLOAT: {
+          float v = 0;
+          if (!read(&v, sizeof(v))) {
+            return false;
+          }
+          field = std::to_string(v);
+          break;
+        }
+        case NET_COL_BOOL: {
+          uint8_t v = 0;
+          if (!read(&v, sizeof(v))) {
+            return false;
+          }
+          field = std::to_string(v != 0);
+          break;
+        }
+        case NET_COL_STRING: {
+          field.resize(lens[r]);
+          if (!read(field.data(), field.size())) {
+            return false;
+          }
+          break;
+        }
+        default: return false;
+      }
+      rows[r] += is_null(r) ? "(null)" : field;
+      rows[r] += '\t';
+    }
+  }
+  records.insert(records.end(), rows.begin(), rows.end());
+  return pos == end;
+}
+
+bool EncodeExecute(NetPkg &pkg, uint32_t stmt_id, const std::vector<NetParam> &params)
+{
+  pkg.type_ = NET_PKG_EXECUTE;
+  pkg.len_  = 0;
+  auto write = [&pkg](const void *src, size_t len) {
+    if (NET_BUFFER_SIZE - pkg.len_ < len) {
+      return false;
+    }
+    memcpy(pkg.buf_ + pkg.len_, src, len);
+    pkg.len_ += len;
+    return true;
+  };
+  auto param_num = static_cast<uint32_t>(params.size());
+  if (!write(&stmt_id, sizeof(stmt_id)) || !write(&param_num, sizeof(param_num))) {
+    return false;
+  }
+  for (const auto &param : params) {
+    auto    type    = static_cast<uint8_t>(param.type_);
+    uint8_t is_null = param.is_null_ ? 1 : 0;
+    auto    len     = static_cast<uint32_t>(param.data_.size());
+    if (!write(&type, sizeof(type)) || !write(&is_null, sizeof(is_null)) || !write(&len, sizeof(len)) ||
+        !write(param.data_.data(), len)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DecodeExecute(const NetPkg &pkg, uint32_t &stmt_id, std::vector<NetParam> &params)
+{
+  const char *pos  = pkg.buf_;
+  const char *end  = pkg.buf_ + pkg.len_;
+  auto        read = [&pos, end](void *dst, size_t len) {
+    if (static_cast<size_t>(end - pos) < len) {
+      return false;
+    }
+    memcpy(dst, pos, len);
+    pos += len;
+    return true;
+  };
+  uint32_t param_num = 0;
+  if (!read(&stmt_id, sizeof(stmt_id)) || !read(&param_num, sizeof(param_num))) {
+    return false;
+  }
+  params.clear();
+  for (uint32_t i = 0; i < param_num; ++i) {
+    uint8_t  type    = 0;
+    uint8_t  is_null = 0;
+    uint32_t len     = 0;
+    if (!read(&type, sizeof(type)) || !read(&is_null, sizeof(is_null)) || !read(&len, sizeof(len)) ||
+        type > NET_COL_STRING) {
+      return false;
+    }
+    NetParam param;
+    param.type_    = static_cast<NetColType>(type);
+    param.is_null_ = is_null != 0;
+    param.data_.resize(len);
+    if (!read(param.data_.data(), len)) {
+      return false;
+    }
+    params.push_back(std::move(param));
+  }
+  return pos == end;
 }
 }  // namespace net
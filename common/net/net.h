@@ -23,13 +23,22 @@
 #define WSDB_NET_H
 
 #include <unistd.h>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 namespace net {
 
-constexpr size_t MAX_CLIENTS     = 10;
-constexpr size_t NET_BUFFER_SIZE = 2048;
+// backlog of pending connections, accepted clients are multiplexed by epoll and not limited by it
+constexpr size_t MAX_CLIENTS     = 1024;
+// max number of events taken by one epoll_wait
+constexpr int    MAX_EVENTS      = 256;
+constexpr size_t NET_BUFFER_SIZE = 64 * 1024;
 constexpr int    SERVER_PORT     = 5001;
 constexpr int    CLIENT_PORT     = 5002;
+// records are sent in batches of up to NET_BUFFER_SIZE bytes, a batch older than this is sent even if not full so
+// that slow queries still show their first rows early
+constexpr int NET_FLUSH_INTERVAL_MS = 20;
 
 enum NetPkgType
 {
@@ -39,7 +48,48 @@ enum NetPkgType
   NET_PKG_REC_END,
   NET_PKG_ERROR,
   NET_PKG_OK,
-  NET_PKG_RAW_STRING
+  NET_PKG_RAW_STRING,
+  NET_PKG_SET_FORMAT,
+  NET_PKG_REC_BLOCK,
+  // a statement with '?' placeholders to prepare, answered with NET_PKG_PREPARED or NET_PKG_ERROR
+  NET_PKG_PREPARE,
+  // uint32 statement id followed by the uint32 number of its parameters
+  NET_PKG_PREPARED,
+  // run a prepared statement with the parameters bound, see EncodeExecute, answered like a query
+  NET_PKG_EXECUTE,
+  // uint32 id of the prepared statement to drop, answered with NET_PKG_OK
+  NET_PKG_CLOSE_STMT
+};
+
+/// how records are sent, chosen by the client with a NET_PKG_SET_FORMAT package holding the format as one byte
+enum NetResultFormat : uint8_t
+{
+  // NET_PKG_REC_BODY, fields as text followed by '\t', records followed by '\0'
+  NET_FORMAT_TEXT = 0,
+  // NET_PKG_REC_BLOCK, blocks of records stored by column
+  NET_FORMAT_BINARY
+};
+
+/**
+ * Column types of a NET_PKG_REC_BLOCK package, a block is made of a uint32 row number and a uint32 column number
+ * followed by the columns. Each column is its type as one byte, a null bitmap of one bit per row, then the values:
+ * a native 4-byte value per row for INT and FLOAT, a byte per row for BOOL, and for STRING a uint32 length per row
+ * followed by the bytes of all rows. Null rows hold zeros or an empty string
+ */
+enum NetColType : uint8_t
+{
+  NET_COL_INT = 0,
+  NET_COL_FLOAT,
+  NET_COL_BOOL,
+  NET_COL_STRING
+};
+
+/// a parameter of NET_PKG_EXECUTE, data_ holds the native 4 bytes of INT and FLOAT, a byte for BOOL or the string
+struct NetParam
+{
+  NetColType  type_{NET_COL_INT};
+  bool        is_null_{false};
+  std::string data_;
 };
 
 struct NetPkg
@@ -51,7 +101,27 @@ struct NetPkg
 
 int ReadNetPkg(int sockfd, NetPkg &pkg);
 
-int WriteNetPkg(int sockfd, NetPkg &pkg);
+/**
+ * Write the package with a single gathered send
+ * @param more more packages follow right away, the kernel may hold the data back to fill full segments
+ */
+int WriteNetPkg(int sockfd, const NetPkg &pkg, bool more = false);
+
+/**
+ * Decode a NET_PKG_REC_BLOCK package into records in the text format, without the '\0' separators
+ * @return false if the package is malformed
+ */
+bool DecodeRecBlock(const NetPkg &pkg, std::vector<std::string> &records);
+
+/**
+ * Make a NET_PKG_EXECUTE package: uint32 statement id and uint32 parameter number, then for each parameter its type
+ * as one byte, a null byte, the uint32 length of its data and the data
+ * @return false if the parameters do not fit in the package
+ */
+bool EncodeExecute(NetPkg &pkg, uint32_t stmt_id, const std::vector<NetParam> &params);
+
+/// @return false if the package is malformed
+bool DecodeExecute(const NetPkg &pkg, uint32_t &stmt_id, std::vector<NetParam> &params);
 }  // namespace net
 
 #endif  // WSDB_NET_H
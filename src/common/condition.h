@@ -98,6 +98,24 @@ public:
     return subquery_id_;
   }
 
+  /**
+   * the same condition between two columns with the columns swapped, e.g. a.x < b.y becomes b.y > a.x
+   * @return
+   */
+  [[nodiscard]] auto Flip() const -> Condition
+  {
+    WSDB_ASSERT(rval_type_ == kColumn, "only a condition between columns can be flipped");
+    CompOp op = op_;
+    switch (op_) {
+      case OP_LT: op = OP_GT; break;
+      case OP_LE: op = OP_GE; break;
+      case OP_GT: op = OP_LT; break;
+      case OP_GE: op = OP_LE; break;
+      default: break;
+    }
+    return {op, r_col_, l_col_};
+  }
+
   auto ToString() const -> std::string
   {
     std::string str;
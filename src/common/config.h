@@ -25,21 +25,109 @@
 /// storage
 constexpr size_t  PAGE_SIZE        = 4096;
 constexpr size_t  BUFFER_POOL_SIZE = 8;
+// number of independent partitions the buffer pool is split into, every partition owns
+// BUFFER_POOL_SIZE / BUFFER_POOL_PARTITIONS frames with its own latch, free list and replacer.
+// raise it together with BUFFER_POOL_SIZE when many clients hit the pool concurrently
+constexpr size_t BUFFER_POOL_PARTITIONS = 1;
+static_assert(BUFFER_POOL_SIZE % BUFFER_POOL_PARTITIONS == 0, "BUFFER_POOL_SIZE must be divisible by partitions");
+// one of "LRUReplacer", "LRUKReplacer", "TwoQReplacer"
 const std::string REPLACER         = "LRUReplacer";
 // enable this to use LRUKReplacer
 const size_t REPLACER_LRU_K = 10;
+// TwoQReplacer: max share of frames in the probation queue before it is preferred for eviction, and the number of
+// other frames that must be accessed in between for a re-access to count as a real reference
+constexpr size_t REPLACER_2Q_KIN_PERCENT = 25;
+constexpr size_t REPLACER_2Q_CRP         = 4;
+// background page cleaner: every BUFFER_POOL_CLEANER_INTERVAL_MS it writes back dirty unpinned frames once more than
+// BUFFER_POOL_DIRTY_RATIO_LOW of the pool is dirty, at most BUFFER_POOL_CLEANER_PAGES pages a round unless the dirty
+// ratio exceeds BUFFER_POOL_DIRTY_RATIO_HIGH, consecutive pages are coalesced into writes of up to
+// BUFFER_POOL_CLEANER_MAX_RUN pages
+constexpr double BUFFER_POOL_DIRTY_RATIO_LOW     = 0.1;
+constexpr double BUFFER_POOL_DIRTY_RATIO_HIGH    = 0.5;
+constexpr size_t BUFFER_POOL_CLEANER_PAGES       = 64;
+constexpr size_t BUFFER_POOL_CLEANER_INTERVAL_MS = 10;
+constexpr size_t BUFFER_POOL_CLEANER_MAX_RUN     = 64;
+// read-ahead of sequential scans starts after READ_AHEAD_TRIGGER consecutive pages, the window begins with
+// READ_AHEAD_MIN_PAGES and doubles whenever the scan reaches a page that is not loaded yet, bounded by READ_AHEAD_MAX_PAGES and a quarter
+// of the buffer pool
+constexpr size_t READ_AHEAD_TRIGGER   = 2;
+constexpr size_t READ_AHEAD_MIN_PAGES = 2;
+constexpr size_t READ_AHEAD_MAX_PAGES = 32;
+// number of threads serving read-ahead requests, i.e. max prefetch reads in flight
+constexpr size_t READ_AHEAD_WORKERS = 4;
+// backend of asynchronous page io, "IOUring" falls back to "PosixIO" (pread/pwrite) if the kernel refuses io_uring
+const std::string DISK_IO_BACKEND = "IOUring";
+// max number of page requests in flight in the io_uring backend
+constexpr unsigned DISK_IO_DEPTH = 64;
+// a hash index starts with HASH_INDEX_INIT_BUCKETS buckets and splits one more bucket whenever its entries fill more
+// than HASH_INDEX_MAX_LOAD of the primary bucket pages
+constexpr size_t HASH_INDEX_INIT_BUCKETS = 4;
+constexpr double HASH_INDEX_MAX_LOAD     = 0.75;
+/// log
+// records are appended to an in-memory buffer of LOG_BUFFER_SIZE bytes, a flusher thread writes and syncs it when a
+// committing transaction or a page write waits for it, and at least every LOG_FLUSH_INTERVAL_MS. Commits arriving
+// while a sync is in progress are made durable together by the next one
+constexpr size_t  LOG_BUFFER_SIZE       = 1024 * 1024;
+constexpr size_t  LOG_FLUSH_INTERVAL_MS = 10;
+const std::string LOG_FILE_NAME         = "wsdb.log";
+// a fuzzy checkpoint is taken every CHECKPOINT_INTERVAL_MS, restart reads the log from the last one. Redo replays the
+// records of different pages on RECOVERY_REDO_WORKER_NUM threads
+constexpr size_t CHECKPOINT_INTERVAL_MS   = 30000;
+constexpr size_t RECOVERY_REDO_WORKER_NUM = 4;
+/// transaction
+// readers see a snapshot taken when their transaction starts, versions overwritten since are kept in memory and
+// collected every MVCC_GC_INTERVAL_MS once no running transaction can see them
+constexpr size_t MVCC_GC_INTERVAL_MS = 100;
+// writers lock the rows they change, the lock queues are spread over LOCK_MANAGER_BUCKETS latches. Waits that form a
+// cycle are found every DEADLOCK_DETECT_INTERVAL_MS and the youngest transaction on it is aborted
+constexpr size_t LOCK_MANAGER_BUCKETS        = 64;
+constexpr size_t DEADLOCK_DETECT_INTERVAL_MS = 50;
 /// system
 constexpr size_t MAX_REC_SIZE = 1024;
+// number of threads running client statements, 0 uses one per core. clients beyond it wait in a queue and are served
+// one statement at a time in the order their input arrived
+constexpr size_t SERVER_WORKER_NUM = 0;
+// how often the network loop checks whether the server is shutting down
+constexpr int SERVER_POLL_INTERVAL_MS = 100;
 /// executor
-// 64MB, used for sort executor's buffer
+// number of rows vectorized executors aim to pass in one chunk, a chunk of a seq scan is made of whole pages so it
+// may be slightly larger
+constexpr size_t CHUNK_SIZE = 1024;
+// 64MB, used for sort executor's buffer, inputs that do not fit are sorted into runs and merged from tmp files
 constexpr size_t SORT_BUFFER_SIZE = 64 * 1024 * 1024;
-// 10-way merge sort, max tmp file to use in merge sort
-constexpr size_t SORT_WAY_NUM = 10;
+// max number of runs merged at once, more runs take extra merge passes
+constexpr size_t SORT_WAY_NUM = 64;
+// number of threads sorting runs in parallel
+constexpr size_t SORT_WORKER_NUM = 4;
+// 256KB, size of the block each run is read and written with
+constexpr size_t SORT_IO_BLOCK_SIZE = 256 * 1024;
+// max limit of an ORDER BY ... LIMIT that is fused into a top-n heap, larger limits keep the sort, which can spill
+constexpr size_t TOP_N_MAX_LIMIT = 100000;
+// 64MB, max size of the build side a hash join keeps in memory, a larger build side is partitioned by hash into
+// HASH_JOIN_PARTITION_NUM tmp files per input
+constexpr size_t HASH_JOIN_BUFFER_SIZE   = 64 * 1024 * 1024;
+constexpr size_t HASH_JOIN_PARTITION_NUM = 16;
+// number of rows COPY parses before writing them to the table pages and the indexes at once
+constexpr size_t LOAD_BATCH_SIZE = 4096;
+// ANALYZE keeps an equi-depth histogram of STATS_HISTOGRAM_BUCKETS buckets for every column, strings are ordered by
+// their first STATS_KEY_PREFIX bytes in it
+constexpr size_t STATS_HISTOGRAM_BUCKETS = 32;
+constexpr size_t STATS_KEY_PREFIX        = 6;
+// the histograms are built from a uniform sample of at most STATS_SAMPLE_SIZE values of every column, distinct values
+// are counted exactly up to STATS_NDV_EXACT_LIMIT and estimated by a HyperLogLog of 2^STATS_NDV_SKETCH_BITS registers
+// above, so the memory of ANALYZE does not grow with the table
+constexpr size_t STATS_SAMPLE_SIZE     = 30000;
+constexpr size_t STATS_NDV_EXACT_LIMIT = 4096;
+constexpr size_t STATS_NDV_SKETCH_BITS = 12;
+// inner joins of up to JOIN_REORDER_DP_LIMIT tables are ordered by dynamic programming over all subsets of the tables,
+// more tables are joined greedily by the smallest result first
+constexpr size_t JOIN_REORDER_DP_LIMIT = 10;
 
-const std::string DB_SUFFIX  = ".db";
-const std::string TAB_SUFFIX = ".tab";
-const std::string IDX_SUFFIX = ".idx";
-const std::string TMP_SUFFIX = ".tmp";
+const std::string DB_SUFFIX   = ".db";
+const std::string TAB_SUFFIX  = ".tab";
+const std::string IDX_SUFFIX  = ".idx";
+const std::string STAT_SUFFIX = ".stat";
+const std::string TMP_SUFFIX  = ".tmp";
 
 const std::string DB_DIR  = "db";
 const std::string TAB_DIR = "tab";
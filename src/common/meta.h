@@ -95,4 +95,14 @@ struct TableHeader
   size_t    nullmap_size_{0};  // null map size == BITMAP_SIZE(n_field)
 };
 
+/**
+ * Index header is the first page of an index file, it is followed by the name of the indexed table and the key fields
+ * arranged like the fields of a table header, the index keeps its own meta information from the second page on
+ */
+struct IndexHeader
+{
+  size_t field_num_{0};
+  size_t tab_name_len_{0};
+};
+
 #endif  // WSDB_META_H
@@ -22,6 +22,8 @@
 #ifndef WSDB_PAGE_H
 #define WSDB_PAGE_H
 
+#include <shared_mutex>
+
 #include "../../common/micro.h"
 #include "config.h"
 #include "types.h"
@@ -88,6 +90,15 @@ public:
     *reinterpret_cast<size_t *>(data_ + PAGE_RECORD_NUM_OFFSET) = record_num;
   }
 
+  /// latches protect the page content while it is pinned, e.g. the nodes of an index
+  void RLatch() { latch_.lock_shared(); }
+
+  void RUnlatch() { latch_.unlock_shared(); }
+
+  void WLatch() { latch_.lock(); }
+
+  void WUnlatch() { latch_.unlock(); }
+
   void Clear()
   {
     fid_ = INVALID_FILE_ID;
@@ -99,6 +110,8 @@ private:
   file_id_t fid_{INVALID_FILE_ID};
   page_id_t pid_{INVALID_PAGE_ID};
   char      data_[PAGE_SIZE]{};
+
+  std::shared_mutex latch_;
 };
 
 #endif  // WSDB_PAGE_H
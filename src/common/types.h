@@ -43,6 +43,7 @@ constexpr int32_t INVALID_TABLE_ID = -1;
 constexpr int32_t INVALID_FRAME_ID = -1;
 constexpr int32_t INVALID_TXN_ID   = -1;
 constexpr int32_t INVALID_FILE_ID  = -1;
+constexpr int32_t INVALID_LSN      = -1;
 
 
 #define ENUM_ENTITIES \
@@ -56,6 +57,13 @@ ENUM_TO_STRING_BODY(StorageModel)
 #undef ENUM
 #undef ENUM_ENTITIES
 
+enum class IndexType
+{
+  NONE,
+  BPTREE,
+  HASH,
+};
+
 #define ENUM_ENTITIES \
   ENUM(TYPE_NULL)     \
   ENUM(TYPE_BOOL)     \
@@ -109,7 +117,9 @@ ENUM_TO_STRING_BODY(JoinType)
 
 #define ENUM_ENTITIES \
   ENUM(NESTED_LOOP)   \
-  ENUM(SORT_MERGE)
+  ENUM(SORT_MERGE)    \
+  ENUM(HASH_JOIN)     \
+  ENUM(COST_BASED)
 #define ENUM(ent) ENUMENTRY(ent)
 DECLARE_ENUM(JoinStrategy)
 #undef ENUM
@@ -23,7 +23,9 @@
 #define WSDB_VALUE_H
 
 #include <algorithm>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "types.h"
 #include "../../common/error.h"
@@ -635,6 +637,221 @@ public:
   }
 };
 
+/**
+ * ValueRef is the compact counterpart of Value used on hot paths like filter, sort, join and aggregation. It is a
+ * tagged union without virtual functions or reference counting, numbers are stored inline while strings point into
+ * the memory they are read from (a record, a page or a StringValue), so a ValueRef must not outlive that memory.
+ * Use ToValue to get an owning Value when the value has to be kept
+ */
+class ValueRef
+{
+public:
+  ValueRef() : type_(FieldType::TYPE_NULL), is_null_(true), int_(0) {}
+
+  static auto Null(FieldType type) -> ValueRef
+  {
+    ValueRef ref;
+    ref.type_ = type;
+    return ref;
+  }
+
+  static auto Int(int32_t value) -> ValueRef
+  {
+    ValueRef ref(FieldType::TYPE_INT);
+    ref.int_ = value;
+    return ref;
+  }
+
+  static auto Float(float value) -> ValueRef
+  {
+    ValueRef ref(FieldType::TYPE_FLOAT);
+    ref.float_ = value;
+    return ref;
+  }
+
+  static auto Bool(bool value) -> ValueRef
+  {
+    ValueRef ref(FieldType::TYPE_BOOL);
+    ref.bool_ = value;
+    return ref;
+  }
+
+  static auto String(std::string_view value) -> ValueRef
+  {
+    ValueRef ref(FieldType::TYPE_STRING);
+    ref.str_ = value;
+    return ref;
+  }
+
+  /**
+   * read a non-null field from raw memory, a string ends at its first '\0' like StringValue
+   * @param type
+   * @param data
+   * @param size size of the field, only used by strings
+   * @return
+   */
+  static auto FromMem(FieldType type, const char *data, size_t size) -> ValueRef
+  {
+    switch (type) {
+      case FieldType::TYPE_BOOL: return Bool(*reinterpret_cast<const bool *>(data));
+      case FieldType::TYPE_INT: {
+        int32_t value;
+        std::memcpy(&value, data, sizeof(int32_t));
+        return Int(value);
+      }
+      case FieldType::TYPE_FLOAT: {
+        float value;
+        std::memcpy(&value, data, sizeof(float));
+        return Float(value);
+      }
+      case FieldType::TYPE_STRING: return String(std::string_view(data, strnlen(data, size)));
+      default: WSDB_FETAL("Unsupported field type");
+    }
+  }
+
+  /**
+   * view a value, the value must outlive the returned reference, arrays are not supported
+   * @param value
+   * @return
+   */
+  static auto FromValue(const Value &value) -> ValueRef
+  {
+    if (value.IsNull()) {
+      return Null(value.GetType());
+    }
+    switch (value.GetType()) {
+      case FieldType::TYPE_BOOL: return Bool(static_cast<const BoolValue &>(value).Get());
+      case FieldType::TYPE_INT: return Int(static_cast<const IntValue &>(value).Get());
+      case FieldType::TYPE_FLOAT: return Float(static_cast<const FloatValue &>(value).Get());
+      case FieldType::TYPE_STRING: return String(static_cast<const StringValue &>(value).Get());
+      default: WSDB_THROW(WSDB_UNSUPPORTED_OP, FieldTypeToString(value.GetType()));
+    }
+  }
+
+  [[nodiscard]] auto GetType() const -> FieldType { return type_; }
+
+  [[nodiscard]] auto IsNull() const -> bool { return is_null_; }
+
+  [[nodiscard]] auto GetInt() const -> int32_t { return int_; }
+
+  [[nodiscard]] auto GetFloat() const -> float { return float_; }
+
+  [[nodiscard]] auto GetBool() const -> bool { return bool_; }
+
+  [[nodiscard]] auto GetString() const -> std::string_view { return str_; }
+
+  /// int is widened to float when compared with a float, the same as ValueFactory::AlignTypes
+  [[nodiscard]] auto GetNumber() const -> float
+  {
+    return type_ == FieldType::TYPE_INT ? static_cast<float>(int_) : float_;
+  }
+
+  /// create an owning value with the same content
+  [[nodiscard]] auto ToValue() const -> ValueSptr
+  {
+    if (is_null_) {
+      return ValueFactory::CreateNullValue(type_);
+    }
+    switch (type_) {
+      case FieldType::TYPE_BOOL: return ValueFactory::CreateBoolValue(bool_);
+      case FieldType::TYPE_INT: return ValueFactory::CreateIntValue(int_);
+      case FieldType::TYPE_FLOAT: return ValueFactory::CreateFloatValue(float_);
+      case FieldType::TYPE_STRING: {
+        // StringValue looks for the terminating '\0', which a view into a record may not have
+        std::string str(str_);
+        return ValueFactory::CreateStringValue(str.c_str(), str.size());
+      }
+      default: WSDB_FETAL("Unsupported field type");
+    }
+  }
+
+  /**
+   * three-way comparison, null equals null and is smaller than any other value like Record::Compare
+   * @param lhs
+   * @param rhs
+   * @return negative, zero or positive when lhs is less than, equal to or greater than rhs
+   */
+  static auto Compare(const ValueRef &lhs, const ValueRef &rhs) -> int
+  {
+    CheckTypes(lhs, rhs);
+    if (lhs.is_null_ || rhs.is_null_) {
+      return static_cast<int>(rhs.is_null_) - static_cast<int>(lhs.is_null_);
+    }
+    if (lhs.type_ != rhs.type_ || lhs.type_ == FieldType::TYPE_FLOAT) {
+      auto l = lhs.GetNumber();
+      auto r = rhs.GetNumber();
+      return (l > r) - (l < r);
+    }
+    switch (lhs.type_) {
+      case FieldType::TYPE_INT: return (lhs.int_ > rhs.int_) - (lhs.int_ < rhs.int_);
+      case FieldType::TYPE_BOOL: return static_cast<int>(lhs.bool_) - static_cast<int>(rhs.bool_);
+      case FieldType::TYPE_STRING: return lhs.str_.compare(rhs.str_);
+      default: WSDB_FETAL("Unsupported field type");
+    }
+  }
+
+  /**
+   * evaluate lhs op rhs with the null semantics of Value operators: null only equals null and is never ordered,
+   * OP_IN is not supported since a ValueRef can not hold an array
+   * @param op
+   * @param lhs
+   * @param rhs
+   * @return
+   */
+  static auto Eval(CompOp op, const ValueRef &lhs, const ValueRef &rhs) -> bool
+  {
+    if (lhs.is_null_ || rhs.is_null_) {
+      CheckTypes(lhs, rhs);
+      bool both_null = lhs.is_null_ && rhs.is_null_;
+      switch (op) {
+        case OP_EQ: return both_null;
+        case OP_NE: return !both_null;
+        case OP_LT:
+        case OP_LE:
+        case OP_GT:
+        case OP_GE: return false;
+        default: WSDB_FETAL(CompOpToString(op));
+      }
+    }
+    auto cmp = Compare(lhs, rhs);
+    switch (op) {
+      case OP_EQ: return cmp == 0;
+      case OP_NE: return cmp != 0;
+      case OP_LT: return cmp < 0;
+      case OP_LE: return cmp <= 0;
+      case OP_GT: return cmp > 0;
+      case OP_GE: return cmp >= 0;
+      default: WSDB_FETAL(CompOpToString(op));
+    }
+  }
+
+  /// only values of the same type or a pair of int and float can be compared
+  static void CheckTypes(const ValueRef &lhs, const ValueRef &rhs)
+  {
+    if (lhs.type_ == rhs.type_) {
+      return;
+    }
+    auto numeric = [](FieldType type) { return type == FieldType::TYPE_INT || type == FieldType::TYPE_FLOAT; };
+    if (!numeric(lhs.type_) || !numeric(rhs.type_)) {
+      WSDB_THROW(WSDB_TYPE_MISSMATCH,
+          fmt::format("Type mismatch: {} != {}", FieldTypeToString(lhs.type_), FieldTypeToString(rhs.type_)));
+    }
+  }
+
+private:
+  explicit ValueRef(FieldType type) : type_(type), is_null_(false), int_(0) {}
+
+  FieldType type_;
+  bool      is_null_;
+  union
+  {
+    int32_t          int_;
+    float            float_;
+    bool             bool_;
+    std::string_view str_;
+  };
+};
+
 }  // namespace wsdb
 
 #endif  // WSDB_VALUE_H
@@ -20,3 +20,308 @@
 //
 
 #include "lock_manager.h"
+#include "txn_manager.h"
+#include "../common/error.h"
+#include "common/config.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <set>
+
+namespace wsdb {
+
+// whether holding held gives every right of requested
+static auto Covers(LockMode held, LockMode requested) -> bool
+{
+  using enum LockMode;
+  switch (held) {
+    case INTENTION_SHARED: return requested == INTENTION_SHARED;
+    case INTENTION_EXCLUSIVE:
+    case SHARED: return requested == INTENTION_SHARED || requested == held;
+    case SHARED_INTENTION_EXCLUSIVE: return requested != EXCLUSIVE;
+    case EXCLUSIVE: return true;
+    default: WSDB_FETAL("Unknown lock mode");
+  }
+}
+
+// weakest mode covering both, what a transaction holds after asking for requested on top of held
+static auto Combine(LockMode held, LockMode requested) -> LockMode
+{
+  if (Covers(held, requested)) {
+    return held;
+  }
+  if (Covers(requested, held)) {
+    return requested;
+  }
+  // S and IX
+  return LockMode::SHARED_INTENTION_EXCLUSIVE;
+}
+
+LockManager::LockManager() : buckets_(LOCK_MANAGER_BUCKETS) {}
+
+LockManager::~LockManager() { StopDeadlockDetector(); }
+
+auto LockManager::IsCompatible(LockMode held, LockMode requested) -> bool
+{
+  using enum LockMode;
+  switch (held) {
+    case INTENTION_SHARED: return requested != EXCLUSIVE;
+    case INTENTION_EXCLUSIVE: return requested == INTENTION_SHARED || requested == INTENTION_EXCLUSIVE;
+    case SHARED: return requested == INTENTION_SHARED || requested == SHARED;
+    case SHARED_INTENTION_EXCLUSIVE: return requested == INTENTION_SHARED;
+    case EXCLUSIVE: return false;
+    default: WSDB_FETAL("Unknown lock mode");
+  }
+}
+
+void LockManager::LockTable(Transaction *txn, LockMode mode, table_id_t table_id) { Lock(txn, mode, {table_id, INVALID_RID}); }
+
+void LockManager::LockRow(Transaction *txn, LockMode mode, table_id_t table_id, const RID &rid)
+{
+  if (mode != LockMode::SHARED && mode != LockMode::EXCLUSIVE) {
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, "rows can only be locked in S or X mode");
+  }
+  Lock(txn, mode == LockMode::SHARED ? LockMode::INTENTION_SHARED : LockMode::INTENTION_EXCLUSIVE, {table_id, INVALID_RID});
+  Lock(txn, mode, {table_id, rid});
+}
+
+void LockManager::UnlockTable(Transaction *txn, table_id_t table_id)
+{
+  auto &locks = txn->GetLocks();
+  if (std::any_of(locks.begin(), locks.end(), [table_id](const auto &lock) {
+        return lock.first.IsRow() && lock.first.table_id_ == table_id;
+      })) {
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, fmt::format("rows of table {} are still locked", table_id));
+  }
+  Unlock(txn, {table_id, INVALID_RID});
+}
+
+void LockManager::UnlockRow(Transaction *txn, table_id_t table_id, const RID &rid) { Unlock(txn, {table_id, rid}); }
+
+void LockManager::UnlockAll(Transaction *txn)
+{
+  auto &locks = txn->GetLocks();
+  for (auto &[target, mode] : locks) {
+    if (target.IsRow()) {
+      Release(txn, target);
+    }
+  }
+  for (auto &[target, mode] : locks) {
+    if (!target.IsRow()) {
+      Release(txn, target);
+    }
+  }
+  locks.clear();
+}
+
+void LockManager::Lock(Transaction *txn, LockMode mode, const LockTarget &target)
+{
+  if (txn->GetState() != TxnState::GROWING) {
+    WSDB_THROW(WSDB_TXN_ABORTED, fmt::format("transaction {} can not take locks anymore", txn->GetTxnId()));
+  }
+  // a lock held already costs no latch
+  auto &locks = txn->GetLocks();
+  auto  held  = locks.find(target);
+  if (held != locks.end() && Combine(held->second, mode) == held->second) {
+    return;
+  }
+  auto  new_mode = held == locks.end() ? mode : Combine(held->second, mode);
+  auto &bucket   = GetBucket(target);
+
+  std::unique_lock lock(bucket.latch_);
+  auto            &queue = bucket.queues_[target];
+  if (queue == nullptr) {
+    queue = std::make_unique<LockRequestQueue>();
+  }
+  auto &requests = queue->requests_;
+  auto  request  = requests.end();
+  if (held != locks.end()) {
+    if (queue->upgrading_ != INVALID_TXN_ID) {
+      WSDB_THROW(WSDB_TXN_ABORTED, fmt::format("transaction {} is upgrading a lock already", queue->upgrading_));
+    }
+    // the upgrade waits in front of the requests that are not granted yet
+    requests.remove_if([txn](const LockRequest &req) { return req.txn_ == txn; });
+    auto pos = std::find_if(requests.begin(), requests.end(), [](const LockRequest &req) { return !req.granted_; });
+    request  = requests.insert(pos, {txn, new_mode});
+    queue->upgrading_ = txn->GetTxnId();
+  } else {
+    request = requests.insert(requests.end(), {txn, new_mode});
+  }
+  GrantWaiting(*queue);
+  queue->cv_.wait(lock, [&] { return request->granted_ || txn->GetState() == TxnState::ABORTED; });
+  if (queue->upgrading_ == txn->GetTxnId()) {
+    queue->upgrading_ = INVALID_TXN_ID;
+  }
+  if (txn->GetState() == TxnState::ABORTED) {
+    // chosen as the victim of a deadlock, the lock held before an upgrade is gone as well
+    requests.erase(request);
+    locks.erase(target);
+    GrantWaiting(*queue);
+    queue->cv_.notify_all();
+    WSDB_THROW(WSDB_TXN_ABORTED, fmt::format("transaction {} is aborted to break a deadlock", txn->GetTxnId()));
+  }
+  locks[target] = new_mode;
+}
+
+void LockManager::Unlock(Transaction *txn, const LockTarget &target)
+{
+  auto &locks = txn->GetLocks();
+  auto  held  = locks.find(target);
+  if (held == locks.end()) {
+    return;
+  }
+  // releasing a S or X lock before the end ends the growing phase
+  if (txn->GetState() == TxnState::GROWING &&
+      (held->second == LockMode::SHARED || held->second == LockMode::EXCLUSIVE)) {
+    txn->SetState(TxnState::SHIRNKING);
+  }
+  Release(txn, target);
+  locks.erase(held);
+}
+
+void LockManager::Release(Transaction *txn, const LockTarget &target)
+{
+  auto                       &bucket = GetBucket(target);
+  std::lock_guard<std::mutex> guard(bucket.latch_);
+  auto                        queue = bucket.queues_.find(target);
+  if (queue == bucket.queues_.end()) {
+    return;
+  }
+  auto &requests = queue->second->requests_;
+  requests.remove_if([txn](const LockRequest &req) { return req.txn_ == txn; });
+  if (requests.empty()) {
+    bucket.queues_.erase(queue);
+  } else {
+    GrantWaiting(*queue->second);
+    queue->second->cv_.notify_all();
+  }
+}
+
+void LockManager::GrantWaiting(LockRequestQueue &queue)
+{
+  std::vector<LockMode> granted;
+  for (auto &req : queue.requests_) {
+    if (req.granted_) {
+      granted.push_back(req.mode_);
+    }
+  }
+  for (auto &req : queue.requests_) {
+    if (req.granted_) {
+      continue;
+    }
+    if (!std::all_of(granted.begin(), granted.end(), [&req](LockMode mode) { return IsCompatible(mode, req.mode_); })) {
+      return;
+    }
+    req.granted_ = true;
+    granted.push_back(req.mode_);
+  }
+}
+
+auto LockManager::GetBucket(const LockTarget &target) -> Bucket &
+{
+  return buckets_[LockTargetHash()(target) % buckets_.size()];
+}
+
+void LockManager::DetectDeadlocks()
+{
+  // the wait edges are collected one bucket at a time, the latches of all the buckets are never held together
+  std::map<txn_id_t, std::set<txn_id_t>>                           edges;
+  std::unordered_map<txn_id_t, std::pair<Transaction *, LockTarget>> waiting;
+  for (auto &bucket : buckets_) {
+    std::lock_guard<std::mutex> guard(bucket.latch_);
+    for (auto &[target, queue] : bucket.queues_) {
+      for (auto waiter = queue->requests_.begin(); waiter != queue->requests_.end(); ++waiter) {
+        if (waiter->granted_) {
+          continue;
+        }
+        waiting[waiter->txn_->GetTxnId()] = {waiter->txn_, target};
+        // granted requests come first, a waiter waits for the requests in front of it that it conflicts with
+        for (auto other = queue->requests_.begin(); other != waiter; ++other) {
+          if (!IsCompatible(other->mode_, waiter->mode_)) {
+            edges[waiter->txn_->GetTxnId()].insert(other->txn_->GetTxnId());
+          }
+        }
+      }
+    }
+  }
+  // a depth first search from the oldest transactions, the youngest one on a cycle is the victim
+  std::set<txn_id_t> aborted;
+  while (true) {
+    std::set<txn_id_t>    visited;
+    std::vector<txn_id_t> path;
+    txn_id_t              victim = INVALID_TXN_ID;
+    std::function<bool(txn_id_t)> dfs = [&](txn_id_t txn_id) {
+      if (auto it = std::find(path.begin(), path.end(), txn_id); it != path.end()) {
+        victim = *std::max_element(it, path.end());
+        return true;
+      }
+      if (!visited.insert(txn_id).second) {
+        return false;
+      }
+      path.push_back(txn_id);
+      for (auto next : edges[txn_id]) {
+        if (aborted.count(next) == 0 && dfs(next)) {
+          return true;
+        }
+      }
+      path.pop_back();
+      return false;
+    };
+    for (auto &[txn_id, waits_for] : edges) {
+      if (aborted.count(txn_id) == 0 && dfs(txn_id)) {
+        break;
+      }
+    }
+    if (victim == INVALID_TXN_ID) {
+      return;
+    }
+    aborted.insert(victim);
+    edges.erase(victim);
+    auto &[txn, target] = waiting[victim];
+    AbortWaiting(txn, target);
+  }
+}
+
+void LockManager::AbortWaiting(Transaction *txn, const LockTarget &target)
+{
+  auto                       &bucket = GetBucket(target);
+  std::lock_guard<std::mutex> guard(bucket.latch_);
+  auto                        queue = bucket.queues_.find(target);
+  if (queue == bucket.queues_.end()) {
+    return;
+  }
+  auto &requests = queue->second->requests_;
+  // the graph is built bucket by bucket, the transaction may have got the lock in the meantime
+  if (std::any_of(requests.begin(), requests.end(), [txn](const LockRequest &req) { return req.txn_ == txn && !req.granted_; })) {
+    txn->SetState(TxnState::ABORTED);
+    queue->second->cv_.notify_all();
+  }
+}
+
+void LockManager::StartDeadlockDetector()
+{
+  stop_detector_ = false;
+  detector_      = std::thread([this] {
+    std::unique_lock lock(detector_latch_);
+    while (!detector_cv_.wait_for(lock, std::chrono::milliseconds(DEADLOCK_DETECT_INTERVAL_MS), [this] { return stop_detector_; })) {
+      lock.unlock();
+      DetectDeadlocks();
+      lock.lock();
+    }
+  });
+}
+
+void LockManager::StopDeadlockDetector()
+{
+  {
+    std::lock_guard<std::mutex> guard(detector_latch_);
+    stop_detector_ = true;
+    detector_cv_.notify_all();
+  }
+  if (detector_.joinable()) {
+    detector_.join();
+  }
+}
+
+}  // namespace wsdb
@@ -22,9 +22,152 @@
 #ifndef WSDB_LOCK_MANAGER_H
 #define WSDB_LOCK_MANAGER_H
 
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/rid.h"
+#include "common/types.h"
+
+namespace wsdb {
+
+class Transaction;
+
+enum class LockMode
+{
+  INTENTION_SHARED           = 0,
+  INTENTION_EXCLUSIVE        = 1,
+  SHARED                     = 2,
+  SHARED_INTENTION_EXCLUSIVE = 3,
+  EXCLUSIVE                  = 4
+};
+
+/// a table, or a row of it if rid is valid
+struct LockTarget
+{
+  table_id_t table_id_{INVALID_TABLE_ID};
+  RID        rid_{INVALID_RID};
+
+  auto operator==(const LockTarget &other) const -> bool
+  {
+    return table_id_ == other.table_id_ && rid_ == other.rid_;
+  }
+
+  [[nodiscard]] auto IsRow() const -> bool { return rid_ != INVALID_RID; }
+};
+
+struct LockTargetHash
+{
+  auto operator()(const LockTarget &target) const -> size_t
+  {
+    return std::hash<table_id_t>()(target.table_id_) * 31 + target.rid_.GetHash();
+  }
+};
+
+/**
+ * Hierarchical two-phase locking of tables and rows. A transaction locks a table in any mode and a row in S or X
+ * mode, the intention lock the row needs on its table is taken first when the table is not locked strongly enough.
+ * Locks are only taken while the transaction is GROWING, unlocking a S or X lock before the transaction ends moves it
+ * to SHIRNKING, and everything left is released when it commits or aborts.
+ * Every locked target has a queue of requests granted in arrival order, an upgrade waits in front of the others.
+ * The queues are spread over LOCK_MANAGER_BUCKETS buckets with a latch each, so an uncontended lock only touches the
+ * latch of its own bucket, and a lock the transaction already holds touches none.
+ * A background detector builds the waits-for graph every DEADLOCK_DETECT_INTERVAL_MS and aborts the youngest
+ * transaction of every cycle, the victim wakes up and throws WSDB_TXN_ABORTED to be rolled back by its client
+ */
 class LockManager
 {
+public:
+  LockManager();
+
+  ~LockManager();
+
+  /**
+   * Lock a table for the transaction, waits until the lock is granted
+   * throws WSDB_TXN_ABORTED if the transaction is not growing or is chosen as the victim of a deadlock
+   * @param txn
+   * @param mode
+   * @param table_id
+   */
+  void LockTable(Transaction *txn, LockMode mode, table_id_t table_id);
+
+  /**
+   * Lock a row for the transaction, the table is locked in IS or IX mode first if needed
+   * throws WSDB_UNSUPPORTED_OP for intention modes, and WSDB_TXN_ABORTED as LockTable
+   * @param txn
+   * @param mode SHARED or EXCLUSIVE
+   * @param table_id
+   * @param rid
+   */
+  void LockRow(Transaction *txn, LockMode mode, table_id_t table_id, const RID &rid);
 
+  /// throws WSDB_UNSUPPORTED_OP if the transaction still holds locks on rows of the table
+  void UnlockTable(Transaction *txn, table_id_t table_id);
+
+  void UnlockRow(Transaction *txn, table_id_t table_id, const RID &rid);
+
+  /// release every lock of a transaction that has ended, rows first
+  void UnlockAll(Transaction *txn);
+
+  /// abort the youngest transaction of every cycle in the waits-for graph
+  void DetectDeadlocks();
+
+  void StartDeadlockDetector();
+
+  void StopDeadlockDetector();
+
+  /// whether a lock of mode held by one transaction lets another one hold requested
+  static auto IsCompatible(LockMode held, LockMode requested) -> bool;
+
+private:
+  struct LockRequest
+  {
+    Transaction *txn_;
+    LockMode     mode_;
+    bool         granted_{false};
+  };
+
+  struct LockRequestQueue
+  {
+    std::list<LockRequest>  requests_;
+    std::condition_variable cv_;
+    // the transaction upgrading its lock, only one at a time as two upgrades would wait for each other
+    txn_id_t upgrading_{INVALID_TXN_ID};
+  };
+
+  struct Bucket
+  {
+    std::mutex                                                                       latch_;
+    std::unordered_map<LockTarget, std::unique_ptr<LockRequestQueue>, LockTargetHash> queues_;
+  };
+
+  void Lock(Transaction *txn, LockMode mode, const LockTarget &target);
+
+  void Unlock(Transaction *txn, const LockTarget &target);
+
+  /// drop the request of the transaction from the queue of the target and grant the waiting ones
+  void Release(Transaction *txn, const LockTarget &target);
+
+  /// grant the waiting requests in order until one is not compatible with the granted ones
+  static void GrantWaiting(LockRequestQueue &queue);
+
+  auto GetBucket(const LockTarget &target) -> Bucket &;
+
+  /// abort the transaction if it is still waiting for the target
+  void AbortWaiting(Transaction *txn, const LockTarget &target);
+
+  std::vector<Bucket> buckets_;
+
+  std::thread             detector_;
+  std::mutex              detector_latch_;
+  std::condition_variable detector_cv_;
+  bool                    stop_detector_{false};
 };
 
+}  // namespace wsdb
+
 #endif  // WSDB_LOCK_MANAGER_H
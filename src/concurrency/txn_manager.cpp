@@ -21,15 +21,161 @@
 
 #include "txn_manager.h"
 #include "../common/error.h"
+#include "common/config.h"
 
 namespace wsdb {
 
 void TxnManager::Begin(txn_id_t txn_id) {}
 
-void TxnManager::Commit(txn_id_t txn_id) {}
+void TxnManager::Commit(txn_id_t txn_id)
+{
+  Transaction *txn;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    auto it = tid_to_ts_.find(txn_id);
+    if (it == tid_to_ts_.end()) {
+      return;
+    }
+    txn = it->second;
+    tid_to_ts_.erase(it);
+  }
+  // a transaction that has written nothing has nothing to make durable
+  if (log_manager_ != nullptr && txn->GetPrevLsn() != INVALID_LSN) {
+    LogRecord rec(LogType::COMMIT, txn_id, txn->GetPrevLsn());
+    auto      lsn = log_manager_->AppendLogRecord(rec);
+    txn->SetPrevLsn(lsn);
+    // returns together with the other transactions committed by the same sync
+    log_manager_->WaitForFlush(lsn);
+  }
+  // the changes become visible only once they are durable
+  if (!txn->GetWriteSet().empty()) {
+    std::lock_guard<std::mutex> guard(commit_latch_);
+    auto                        commit_ts = next_ts_.load();
+    for (auto &write : txn->GetWriteSet()) {
+      if (write.first_) {
+        write.store_->Commit(write.rid_, commit_ts);
+      }
+    }
+    next_ts_ = commit_ts + 1;
+    RetireWrites(txn, commit_ts);
+  }
+  if (lock_manager_ != nullptr) {
+    lock_manager_->UnlockAll(txn);
+  }
+  txn->SetState(TxnState::COMMITTED);
+}
 
-void TxnManager::Abort(txn_id_t txn_id) {}
+void TxnManager::Abort(txn_id_t txn_id)
+{
+  Transaction *txn;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    auto it = tid_to_ts_.find(txn_id);
+    if (it == tid_to_ts_.end()) {
+      return;
+    }
+    txn = it->second;
+    tid_to_ts_.erase(it);
+  }
+  // every undone change is compensated in the log, the abort record ends the rollback
+  auto &writes = txn->GetWriteSet();
+  for (auto write = writes.rbegin(); write != writes.rend(); ++write) {
+    write->store_->Undo(txn, *write);
+  }
+  if (log_manager_ != nullptr && txn->GetPrevLsn() != INVALID_LSN) {
+    LogRecord rec(LogType::ABORT, txn_id, txn->GetPrevLsn());
+    txn->SetPrevLsn(log_manager_->AppendLogRecord(rec));
+  }
+  RetireWrites(txn, next_ts_ - 1);
+  if (lock_manager_ != nullptr) {
+    lock_manager_->UnlockAll(txn);
+  }
+  txn->SetState(TxnState::ABORTED);
+}
 
-void TxnManager::SetTransaction(Transaction *txn) {}
+void TxnManager::SetTransaction(Transaction *txn)
+{
+  if (!txn->IsRunning()) {
+    txn->SetTxnId(next_tid_++);
+    txn->SetState(TxnState::GROWING);
+    txn->SetPrevLsn(INVALID_LSN);
+    txn->GetWriteSet().clear();
+    txn->GetLocks().clear();
+    txn->SetLockManager(lock_manager_);
+    // the read timestamp is taken under the latch so that the watermark never passes it
+    std::lock_guard<std::mutex> guard(latch_);
+    txn->SetReadTs(next_ts_ - 1);
+    tid_to_ts_[txn->GetTxnId()] = txn;
+  }
+  current_txn_ = txn;
+}
 
-}  // namespace wsdb
\ No newline at end of file
+auto TxnManager::GetWatermark() -> timestamp_t
+{
+  std::lock_guard<std::mutex> guard(latch_);
+  timestamp_t                 watermark = next_ts_ - 1;
+  for (auto &[txn_id, txn] : tid_to_ts_) {
+    watermark = std::min(watermark, txn->GetReadTs());
+  }
+  return watermark;
+}
+
+void TxnManager::CollectGarbage()
+{
+  auto                      watermark = GetWatermark();
+  std::vector<GarbageEntry> ready;
+  {
+    std::lock_guard<std::mutex> guard(gc_latch_);
+    while (!garbage_.empty() && garbage_.front().ts_ <= watermark) {
+      ready.push_back(std::move(garbage_.front()));
+      garbage_.pop_front();
+    }
+  }
+  for (auto &entry : ready) {
+    for (auto &[store, rid] : entry.slots_) {
+      store->Prune(rid, watermark);
+    }
+  }
+}
+
+void TxnManager::StartGarbageCollector()
+{
+  stop_gc_   = false;
+  gc_thread_ = std::thread([this] {
+    std::unique_lock lock(gc_latch_);
+    while (!gc_cv_.wait_for(lock, std::chrono::milliseconds(MVCC_GC_INTERVAL_MS), [this] { return stop_gc_; })) {
+      lock.unlock();
+      CollectGarbage();
+      lock.lock();
+    }
+  });
+}
+
+void TxnManager::StopGarbageCollector()
+{
+  {
+    std::lock_guard<std::mutex> guard(gc_latch_);
+    stop_gc_ = true;
+    gc_cv_.notify_all();
+  }
+  if (gc_thread_.joinable()) {
+    gc_thread_.join();
+  }
+}
+
+void TxnManager::RetireWrites(Transaction *txn, timestamp_t ts)
+{
+  GarbageEntry entry{ts, {}};
+  for (auto &write : txn->GetWriteSet()) {
+    if (write.first_) {
+      entry.slots_.emplace_back(std::move(write.store_), write.rid_);
+    }
+  }
+  txn->GetWriteSet().clear();
+  if (!entry.slots_.empty()) {
+    std::lock_guard<std::mutex> guard(gc_latch_);
+    garbage_.push_back(std::move(entry));
+  }
+}
+
+}  // namespace wsdb
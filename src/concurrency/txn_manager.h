@@ -23,11 +23,16 @@
 #define WSDB_TXN_MANAGER_H
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
 
 #include "common/types.h"
+#include "lock_manager.h"
 #include "log/log_manager.h"
+#include "version_store.h"
 
 namespace wsdb {
 
@@ -49,42 +54,131 @@ public:
 
   [[nodiscard]] auto GetTxnId() const -> txn_id_t { return txn_id_; }
 
+  void SetTxnId(txn_id_t txn_id) { txn_id_ = txn_id; }
+
   [[nodiscard]] auto GetState() const -> TxnState { return state_; }
 
   void SetState(TxnState state) { state_ = state; }
 
+  [[nodiscard]] auto IsRunning() const -> bool { return state_ == TxnState::GROWING || state_ == TxnState::SHIRNKING; }
+
   [[nodiscard]] auto IsExplicit() const -> bool { return is_explcit_; }
 
+  /// lsn of the last log record written by the transaction, INVALID_LSN if it has written nothing
+  [[nodiscard]] auto GetPrevLsn() const -> lsn_t { return prev_lsn_; }
+
+  void SetPrevLsn(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
+
+  /// the transaction sees the versions committed at or before its read timestamp, and its own changes
+  [[nodiscard]] auto GetReadTs() const -> timestamp_t { return read_ts_; }
+
+  void SetReadTs(timestamp_t read_ts) { read_ts_ = read_ts; }
+
+  /// changes made by the transaction in the order they were made
+  auto GetWriteSet() -> std::vector<WriteRecord> & { return write_set_; }
+
+  /// locks held by the transaction, only touched by the thread running it
+  auto GetLocks() -> std::unordered_map<LockTarget, LockMode, LockTargetHash> & { return locks_; }
+
+  /// lock manager the transaction takes its locks from, nullptr if it runs without locking
+  [[nodiscard]] auto GetLockManager() const -> LockManager * { return lock_manager_; }
+
+  void SetLockManager(LockManager *lock_manager) { lock_manager_ = lock_manager; }
+
 private:
   txn_id_t txn_id_{INVALID_TXN_ID};
-  TxnState state_{TxnState::INVALID};
+  // set by the deadlock detector while the transaction waits for a lock
+  std::atomic<TxnState> state_{TxnState::INVALID};
   // whether the transaction is explicit, i.e. started by begin command.
-  bool is_explcit_{false};
+  bool        is_explcit_{false};
+  lsn_t       prev_lsn_{INVALID_LSN};
+  timestamp_t read_ts_{0};
+
+  std::vector<WriteRecord> write_set_;
+
+  std::unordered_map<LockTarget, LockMode, LockTargetHash> locks_;
+  LockManager                                             *lock_manager_{nullptr};
 };
 
 class TxnManager
 {
 public:
   TxnManager() = delete;
-  explicit TxnManager(LogManager *log_manager) : log_manager_(log_manager) {}
-  virtual ~TxnManager() = default;
+  /// transaction ids continue after those in the log so that recovery never mixes up transactions of different runs
+  explicit TxnManager(LogManager *log_manager, LockManager *lock_manager = nullptr)
+      : next_tid_(log_manager == nullptr ? 0 : log_manager->GetMaxTxnId() + 1),
+        log_manager_(log_manager),
+        lock_manager_(lock_manager)
+  {}
+  virtual ~TxnManager() { StopGarbageCollector(); }
 
   void Begin(txn_id_t txn_id);
 
+  /**
+   * Make the changes of the transaction durable and then visible, they are stamped with the next commit timestamp so
+   * that transactions starting after the commit returns see them and those running already do not. The locks of the
+   * transaction are released last
+   */
   void Commit(txn_id_t txn_id);
 
+  /**
+   * Roll back the changes of the transaction in reverse order, log the end of the transaction and release its locks,
+   * it may be called from another thread than the one running the transaction
+   */
   void Abort(txn_id_t txn_id);
 
+  /**
+   * Make txn the transaction of the statements run by the calling thread, a new transaction is started if txn is not
+   * running
+   */
   void SetTransaction(Transaction *txn);
 
+  /// transaction of the calling thread, nullptr if the thread does not run statements of a client
+  static auto GetTransaction() -> Transaction * { return current_txn_; }
+
+  /// detach the calling thread from its transaction, which may be ended and freed by another thread afterwards
+  static void ClearTransaction() { current_txn_ = nullptr; }
+
+  /// read timestamp of the oldest running transaction, versions older than what it sees are garbage
+  auto GetWatermark() -> timestamp_t;
+
+  /// drop the versions of the ended transactions that no running transaction can see anymore
+  void CollectGarbage();
+
+  /// collect garbage every MVCC_GC_INTERVAL_MS in the background
+  void StartGarbageCollector();
+
+  void StopGarbageCollector();
+
 private:
-  std::atomic<txn_id_t>                                      next_tid_{0};
-  std::atomic<txn_id_t>                                      next_ts_{0};
-  std::unordered_map<txn_id_t, std::unique_ptr<Transaction>> tid_to_ts_;
+  /// slots whose version chains can be pruned once the watermark reaches ts
+  struct GarbageEntry
+  {
+    timestamp_t                                                ts_;
+    std::vector<std::pair<std::shared_ptr<VersionStore>, RID>> slots_;
+  };
+
+  /// hand the chains created by the transaction over to the garbage collector and clear its write set
+  void RetireWrites(Transaction *txn, timestamp_t ts);
+
+  static inline thread_local Transaction *current_txn_{nullptr};
+
+  std::atomic<txn_id_t>                       next_tid_{0};
+  std::atomic<timestamp_t>                    next_ts_{1};  // commit timestamp of the next writer to commit
+  std::unordered_map<txn_id_t, Transaction *> tid_to_ts_;   // running transactions, owned by the client sessions
 
-  LogManager *log_manager_;
+  LogManager  *log_manager_;
+  LockManager *lock_manager_;
 
   std::mutex latch_;
+  // commits stamp their versions one at a time so that a read timestamp never sees half of a commit
+  std::mutex commit_latch_;
+
+  std::deque<GarbageEntry> garbage_;
+  std::mutex               gc_latch_;
+  std::condition_variable  gc_cv_;
+  std::thread              gc_thread_;
+  bool                     stop_gc_{false};
 };
 }  // namespace wsdb
 
@@ -0,0 +1,207 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "version_store.h"
+#include "txn_manager.h"
+#include "../common/error.h"
+
+namespace wsdb {
+
+auto VersionStore::BeginWrite(Transaction *txn, const RID &rid, std::string before) -> bool
+{
+  std::lock_guard<std::mutex> guard(latch_);
+  auto                        chain = FindChain(rid);
+  if (chain == nullptr) {
+    chain = &pages_[rid.PageID()][rid.SlotID()];
+    chain_num_++;
+  } else if (IsConflict(txn, *chain)) {
+    return false;
+  }
+  bool first = chain->writer_ != txn->GetTxnId();
+  if (first) {
+    // the version the slot has now stays readable until no snapshot needs it
+    chain->versions_.push_back({before, chain->ts_});
+    chain->writer_ = txn->GetTxnId();
+  }
+  txn->GetWriteSet().push_back({shared_from_this(), rid, std::move(before), txn->GetPrevLsn(), first});
+  return true;
+}
+
+auto VersionStore::IsConflict(const Transaction *txn, const RID &rid) -> bool
+{
+  if (chain_num_ == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  auto                        chain = FindChain(rid);
+  return chain != nullptr && IsConflict(txn, *chain);
+}
+
+auto VersionStore::HasVersions(page_id_t page_id) -> bool
+{
+  if (chain_num_ == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  return pages_.count(page_id) > 0;
+}
+
+auto VersionStore::IsVersioned(const RID &rid) -> bool
+{
+  if (chain_num_ == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  return FindChain(rid) != nullptr;
+}
+
+auto VersionStore::GetVisible(const Transaction *txn, const RID &rid, std::string &image) -> bool
+{
+  if (chain_num_ == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  auto                        chain = FindChain(rid);
+  return chain != nullptr && FindVisible(txn, *chain, image);
+}
+
+auto VersionStore::GetVisible(
+    const Transaction *txn, page_id_t page_id, std::vector<std::pair<slot_id_t, std::string>> &images) -> bool
+{
+  images.clear();
+  if (chain_num_ == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  auto                        page = pages_.find(page_id);
+  if (page == pages_.end()) {
+    return false;
+  }
+  std::string image;
+  for (auto &[slot_id, chain] : page->second) {
+    if (FindVisible(txn, chain, image)) {
+      images.emplace_back(slot_id, std::move(image));
+    }
+  }
+  return !images.empty();
+}
+
+void VersionStore::Commit(const RID &rid, timestamp_t commit_ts)
+{
+  std::lock_guard<std::mutex> guard(latch_);
+  auto                        chain = FindChain(rid);
+  WSDB_ASSERT(chain != nullptr, "committed slot has no version chain");
+  chain->writer_ = INVALID_TXN_ID;
+  chain->ts_     = commit_ts;
+}
+
+void VersionStore::Undo(Transaction *txn, const WriteRecord &write)
+{
+  UndoFunc undo;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    undo = undo_;
+  }
+  // readers still see the version in the chain while the page is brought back
+  if (undo) {
+    undo(txn, write);
+  }
+  if (!write.first_) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  auto                        chain = FindChain(write.rid_);
+  WSDB_ASSERT(chain != nullptr && !chain->versions_.empty(), "rolled back slot has no version chain");
+  chain->writer_ = INVALID_TXN_ID;
+  chain->ts_     = chain->versions_.back().ts_;
+  chain->versions_.pop_back();
+  if (chain->ts_ == 0 && chain->versions_.empty()) {
+    EraseChain(write.rid_);
+  }
+}
+
+void VersionStore::Prune(const RID &rid, timestamp_t watermark)
+{
+  std::lock_guard<std::mutex> guard(latch_);
+  auto                        chain = FindChain(rid);
+  if (chain == nullptr) {
+    return;
+  }
+  if (chain->writer_ == INVALID_TXN_ID && chain->ts_ <= watermark) {
+    EraseChain(rid);
+    return;
+  }
+  // keep the newest version every running transaction can see and the ones after it
+  auto &versions = chain->versions_;
+  for (auto i = versions.size(); i > 0; i--) {
+    if (versions[i - 1].ts_ <= watermark) {
+      versions.erase(versions.begin(), versions.begin() + static_cast<std::ptrdiff_t>(i - 1));
+      break;
+    }
+  }
+}
+
+void VersionStore::Detach()
+{
+  std::lock_guard<std::mutex> guard(latch_);
+  undo_ = nullptr;
+}
+
+auto VersionStore::IsConflict(const Transaction *txn, const VersionChain &chain) -> bool
+{
+  if (chain.writer_ != INVALID_TXN_ID) {
+    return chain.writer_ != txn->GetTxnId();
+  }
+  return chain.ts_ > txn->GetReadTs();
+}
+
+auto VersionStore::FindVisible(const Transaction *txn, const VersionChain &chain, std::string &image) -> bool
+{
+  if (chain.writer_ == txn->GetTxnId() || (chain.writer_ == INVALID_TXN_ID && chain.ts_ <= txn->GetReadTs())) {
+    return false;
+  }
+  image.clear();
+  for (auto it = chain.versions_.rbegin(); it != chain.versions_.rend(); ++it) {
+    if (it->ts_ <= txn->GetReadTs()) {
+      image = it->image_;
+      break;
+    }
+  }
+  return true;
+}
+
+auto VersionStore::FindChain(const RID &rid) -> VersionChain *
+{
+  auto page = pages_.find(rid.PageID());
+  if (page == pages_.end()) {
+    return nullptr;
+  }
+  auto chain = page->second.find(rid.SlotID());
+  return chain == page->second.end() ? nullptr : &chain->second;
+}
+
+void VersionStore::EraseChain(const RID &rid)
+{
+  auto page = pages_.find(rid.PageID());
+  page->second.erase(rid.SlotID());
+  if (page->second.empty()) {
+    pages_.erase(page);
+  }
+  chain_num_--;
+}
+
+}  // namespace wsdb
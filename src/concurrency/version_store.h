@@ -0,0 +1,147 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#ifndef WSDB_VERSION_STORE_H
+#define WSDB_VERSION_STORE_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/rid.h"
+#include "common/types.h"
+
+namespace wsdb {
+
+class Transaction;
+class VersionStore;
+
+/**
+ * A change of a slot made by a running transaction, kept until the transaction ends so that it can be rolled back
+ */
+struct WriteRecord
+{
+  std::shared_ptr<VersionStore> store_;
+  RID                           rid_;
+  std::string                   before_;                 // image of the slot before the change, empty if it was free
+  lsn_t                         prev_lsn_{INVALID_LSN};  // last record of the transaction before the change
+  bool                          first_{false};           // first change of the slot by the transaction
+};
+
+/**
+ * Older versions of the records of a table. The record in a page is the newest version of its slot, a slot changed by
+ * a running transaction, or by one committed after the snapshot of some reader, keeps the images it had before in a
+ * chain here. Every version carries the commit timestamp of its writer, a transaction reading at timestamp ts sees its
+ * own changes and otherwise the newest version committed at or before ts. Slots without a chain look the same to every
+ * transaction, so readers only consult the store for pages that have chains.
+ * Writers follow first-updater-wins, a slot that is being changed by another transaction or was changed by one that
+ * committed after the snapshot of the writer can not be changed and the writer has to abort
+ */
+class VersionStore : public std::enable_shared_from_this<VersionStore>
+{
+public:
+  /// roll a change back in the page, provided by the table owning the pages
+  using UndoFunc = std::function<void(Transaction *txn, const WriteRecord &write)>;
+
+  explicit VersionStore(UndoFunc undo) : undo_(std::move(undo)) {}
+
+  /**
+   * Make the transaction the writer of the slot before it changes the slot, the image the slot has now stays readable
+   * for the others and the change is added to the write set of the transaction
+   * @param before image of the slot, null map followed by the data, empty if the slot is free
+   * @return false if the change conflicts with another transaction, nothing is recorded then
+   */
+  auto BeginWrite(Transaction *txn, const RID &rid, std::string before) -> bool;
+
+  /// whether changing the slot would conflict with another transaction
+  auto IsConflict(const Transaction *txn, const RID &rid) -> bool;
+
+  /// whether some slots of the page have version chains
+  auto HasVersions(page_id_t page_id) -> bool;
+
+  /// whether the slot has a version chain, inserts skip free slots with chains as a rollback may still fill them
+  auto IsVersioned(const RID &rid) -> bool;
+
+  /**
+   * The version of a slot the transaction sees if it is not the one in the page
+   * @param image set to the visible image, empty if the record does not exist for the transaction
+   * @return false if the transaction sees the slot as it is in the page
+   */
+  auto GetVisible(const Transaction *txn, const RID &rid, std::string &image) -> bool;
+
+  /**
+   * The slots of a page the transaction does not see as they are in the page, together with the images it sees
+   * @return false if there are none
+   */
+  auto GetVisible(const Transaction *txn, page_id_t page_id, std::vector<std::pair<slot_id_t, std::string>> &images)
+      -> bool;
+
+  /// the writer of the slot has committed at commit ts, its image in the page becomes visible from then on
+  void Commit(const RID &rid, timestamp_t commit_ts);
+
+  /// roll the change back in the page, the chain loses the version of the first change
+  void Undo(Transaction *txn, const WriteRecord &write);
+
+  /**
+   * Drop the versions no transaction can see anymore, the chain goes away once the page version is visible to all
+   * @param watermark read timestamp of the oldest running transaction
+   */
+  void Prune(const RID &rid, timestamp_t watermark);
+
+  /// the table is closed, pages can no longer be rolled back through the store
+  void Detach();
+
+  [[nodiscard]] auto GetChainNum() const -> size_t { return chain_num_; }
+
+private:
+  struct Version
+  {
+    std::string image_;  // empty if the record did not exist
+    timestamp_t ts_;
+  };
+
+  struct VersionChain
+  {
+    txn_id_t             writer_{INVALID_TXN_ID};  // running transaction that has changed the slot
+    timestamp_t          ts_{0};                   // commit ts of the version in the page, 0 if older than any snapshot
+    std::vector<Version> versions_;                // older versions, the newest at the back
+  };
+
+  static auto IsConflict(const Transaction *txn, const VersionChain &chain) -> bool;
+
+  /// whether the transaction sees another version than the one in the page, image is set to it then
+  static auto FindVisible(const Transaction *txn, const VersionChain &chain, std::string &image) -> bool;
+
+  auto FindChain(const RID &rid) -> VersionChain *;
+
+  void EraseChain(const RID &rid);
+
+  UndoFunc undo_;
+
+  std::mutex                                                                latch_;
+  std::unordered_map<page_id_t, std::unordered_map<slot_id_t, VersionChain>> pages_;
+  // lets readers of a table without chains skip the latch
+  std::atomic<size_t> chain_num_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_VERSION_STORE_H
@@ -22,7 +22,7 @@
 #include "executor.h"
 #include "executor_defs.h"
 
-#include "expr/condition_expr.h"
+#include "expr/compiled_condition.h"
 
 namespace wsdb {
 
@@ -32,6 +32,13 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
   if (db == nullptr) {
     WSDB_THROW(WSDB_DB_NOT_OPEN, "");
   }
+  // only Execute consumes chunks, so the whole tree has to be vectorizable
+  return TranslatePlan(plan, db, CanVectorize(plan, db));
+}
+
+auto Executor::TranslatePlan(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db, bool vectorized)
+    -> AbstractExecutorUptr
+{
   // translate
   if (const auto create_table = std::dynamic_pointer_cast<CreateTablePlan>(plan)) {
     return std::make_unique<CreateTableExecutor>(
@@ -42,72 +49,141 @@ auto Executor::Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHand
     return std::make_unique<DescTableExecutor>(db->GetTable(desc_table->table_name_));
   } else if (const auto show_table = std::dynamic_pointer_cast<ShowTablesPlan>(plan)) {
     return std::make_unique<ShowTablesExecutor>(db);
+  } else if (const auto analyze = std::dynamic_pointer_cast<AnalyzePlan>(plan)) {
+    return std::make_unique<AnalyzeExecutor>(analyze->table_name_, db);
+  } else if (const auto create_index = std::dynamic_pointer_cast<CreateIndexPlan>(plan)) {
+    return std::make_unique<CreateIndexExecutor>(
+        create_index->table_name_, create_index->col_names_, create_index->index_type_, db);
+  } else if (const auto drop_index = std::dynamic_pointer_cast<DropIndexPlan>(plan)) {
+    return std::make_unique<DropIndexExecutor>(drop_index->table_name_, drop_index->col_names_, db);
   } else if (const auto insert = std::dynamic_pointer_cast<InsertPlan>(plan)) {
     if (db->GetTable(insert->table_name_) == nullptr) {
       WSDB_THROW(WSDB_TABLE_MISS, insert->table_name_);
     }
     auto                    tab = db->GetTable(insert->table_name_);
     std::vector<RecordUptr> inserts;
-    inserts.emplace_back(std::make_unique<Record>(&tab->GetSchema(), insert->values_, INVALID_RID));
+    inserts.reserve(insert->rows_.size());
+    for (const auto &row : insert->rows_) {
+      if (row.size() != tab->GetSchema().GetFieldCount()) {
+        WSDB_THROW(WSDB_INVALID_SQL,
+            fmt::format("{} values given for {} columns", row.size(), tab->GetSchema().GetFieldCount()));
+      }
+      inserts.emplace_back(std::make_unique<Record>(&tab->GetSchema(), row, INVALID_RID));
+    }
     return std::make_unique<InsertExecutor>(tab, db->GetIndexes(insert->table_name_), std::move(inserts));
+  } else if (const auto load = std::dynamic_pointer_cast<LoadPlan>(plan)) {
+    auto tab = db->GetTable(load->table_name_);
+    if (tab == nullptr) {
+      WSDB_THROW(WSDB_TABLE_MISS, load->table_name_);
+    }
+    return std::make_unique<LoadExecutor>(tab, db->GetIndexes(load->table_name_), load->file_name_);
   } else if (const auto update = std::dynamic_pointer_cast<UpdatePlan>(plan)) {
     auto tab = db->GetTable(update->table_name_);
     if (tab == nullptr) {
       WSDB_THROW(WSDB_TABLE_MISS, update->table_name_);
     }
-    return std::make_unique<UpdateExecutor>(
-        Translate(update->child_, db), tab, db->GetIndexes(update->table_name_), std::move(update->updates_));
+    return std::make_unique<UpdateExecutor>(TranslatePlan(update->child_, db, false),
+        tab,
+        db->GetIndexes(update->table_name_),
+        update->updates_);
   } else if (const auto del = std::dynamic_pointer_cast<DeletePlan>(plan)) {
     auto tab = db->GetTable(del->table_name_);
     if (tab == nullptr) {
       WSDB_THROW(WSDB_TABLE_MISS, del->table_name_);
     }
-    return std::make_unique<DeleteExecutor>(Translate(del->child_, db), tab, db->GetIndexes(del->table_name_));
+    return std::make_unique<DeleteExecutor>(
+        TranslatePlan(del->child_, db, false), tab, db->GetIndexes(del->table_name_));
   } else if (const auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
-    std::function<bool(const Record &)> filter_func = [filter](const Record &record) {
-      return ConditionExpr::Eval(filter->conds_, record);
-    };
-    return std::make_unique<FilterExecutor>(Translate(filter->child_, db), std::move(filter_func));
+    // compile the conditions against the child schema once instead of interpreting them per record
+    auto child = TranslatePlan(filter->child_, db, vectorized);
+    auto cond  = std::make_shared<CompiledCondition>(filter->conds_, child->GetOutSchema());
+    std::function<bool(const Record &)> filter_func  = [cond](const Record &record) { return cond->Eval(record); };
+    std::function<void(Chunk &)>        chunk_filter = [cond](Chunk &chunk) { cond->Eval(chunk); };
+    return std::make_unique<FilterExecutor>(std::move(child), std::move(filter_func), std::move(chunk_filter));
   } else if (const auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
     auto tab = db->GetTable(scan->table_name_);
     if (tab == nullptr) {
       WSDB_THROW(WSDB_TABLE_MISS, scan->table_name_);
     }
-    return std::make_unique<SeqScanExecutor>(tab);
+    return std::make_unique<SeqScanExecutor>(tab, vectorized);
   } else if (const auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
     return std::make_unique<IdxScanExecutor>(db->GetTable(idx_scan->table_name_),
         db->GetIndex(idx_scan->idx_id_),
         idx_scan->conds_,
         idx_scan->matched_fields_);
   } else if (const auto sort_plan = std::dynamic_pointer_cast<SortPlan>(plan)) {
-    return std::make_unique<SortExecutor>(
-        Translate(sort_plan->child_, db), std::move(sort_plan->key_schema_), sort_plan->is_desc_);
+    return std::make_unique<SortExecutor>(TranslatePlan(sort_plan->child_, db, false),
+        std::make_unique<RecordSchema>(sort_plan->key_schema_->GetFields()),
+        sort_plan->is_desc_);
+  } else if (const auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    return std::make_unique<TopNExecutor>(TranslatePlan(top_n->child_, db, false),
+        std::make_unique<RecordSchema>(top_n->key_schema_->GetFields()),
+        top_n->is_desc_,
+        top_n->limit_);
   } else if (const auto proj_plan = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
-    return std::make_unique<ProjectionExecutor>(Translate(proj_plan->child_, db), std::move(proj_plan->schema_));
+    return std::make_unique<ProjectionExecutor>(TranslatePlan(proj_plan->child_, db, vectorized),
+        std::make_unique<RecordSchema>(proj_plan->schema_->GetFields()));
   } else if (const auto join_plan = std::dynamic_pointer_cast<JoinPlan>(plan)) {
     if (join_plan->strategy_ == NESTED_LOOP) {
-      return std::make_unique<NestedLoopJoinExecutor>(
-          join_plan->type_, Translate(join_plan->left_, db), Translate(join_plan->right_, db), join_plan->conds_);
+      return std::make_unique<NestedLoopJoinExecutor>(join_plan->type_,
+          TranslatePlan(join_plan->left_, db, false),
+          TranslatePlan(join_plan->right_, db, false),
+          join_plan->conds_);
     } else if (join_plan->strategy_ == SORT_MERGE) {
       return std::make_unique<SortMergeJoinExecutor>(join_plan->type_,
-          Translate(join_plan->left_, db),
-          Translate(join_plan->right_, db),
-          std::move(join_plan->left_key_schema_),
-          std::move(join_plan->right_key_schema_));
+          TranslatePlan(join_plan->left_, db, false),
+          TranslatePlan(join_plan->right_, db, false),
+          std::make_unique<RecordSchema>(join_plan->left_key_schema_->GetFields()),
+          std::make_unique<RecordSchema>(join_plan->right_key_schema_->GetFields()));
+    } else if (join_plan->strategy_ == HASH_JOIN) {
+      return std::make_unique<HashJoinExecutor>(join_plan->type_,
+          TranslatePlan(join_plan->left_, db, false),
+          TranslatePlan(join_plan->right_, db, false),
+          std::make_unique<RecordSchema>(join_plan->left_key_schema_->GetFields()),
+          std::make_unique<RecordSchema>(join_plan->right_key_schema_->GetFields()),
+          join_plan->build_left_);
     }
   } else if (const auto agg_plan = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
     auto agg_schema   = std::make_unique<RecordSchema>(agg_plan->agg_fields);
     auto group_schema = std::make_unique<RecordSchema>(agg_plan->group_fields_);
+    // aggregate a pax table on its raw columns when possible
+    if (const auto scan = std::dynamic_pointer_cast<ScanPlan>(agg_plan->child_)) {
+      auto tab = db->GetTable(scan->table_name_);
+      if (tab != nullptr && AggregateExecutorVec::IsSupported(tab, *agg_schema, *group_schema)) {
+        return std::make_unique<AggregateExecutorVec>(tab, std::move(agg_schema), std::move(group_schema), vectorized);
+      }
+    }
     return std::make_unique<AggregateExecutor>(
-        Translate(agg_plan->child_, db), std::move(agg_schema), std::move(group_schema));
+        TranslatePlan(agg_plan->child_, db, vectorized), std::move(agg_schema), std::move(group_schema));
   } else if (const auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
-    return std::make_unique<LimitExecutor>(Translate(lim->child_, db), lim->limit_);
+    return std::make_unique<LimitExecutor>(TranslatePlan(lim->child_, db, vectorized), lim->limit_);
 
   } else {
     WSDB_FETAL("Unknown plan type");
   }
   return nullptr;
 }
+
+auto Executor::CanVectorize(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> bool
+{
+  if (const auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+    auto tab = db->GetTable(scan->table_name_);
+    return tab != nullptr && tab->GetStorageModel() == PAX_MODEL;
+  } else if (const auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    return std::all_of(filter->conds_.begin(),
+               filter->conds_.end(),
+               [](const Condition &cond) { return cond.GetRhsType() == kValue || cond.GetRhsType() == kColumn; }) &&
+           CanVectorize(filter->child_, db);
+  } else if (const auto proj_plan = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
+    return CanVectorize(proj_plan->child_, db);
+  } else if (const auto agg_plan = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+    return CanVectorize(agg_plan->child_, db);
+  } else if (const auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+    return CanVectorize(lim->child_, db);
+  }
+  return false;
+}
+
 void Executor::Execute(const AbstractExecutorUptr &executor, Context *ctx)
 {
   if (executor->GetType() == TXN) {
@@ -134,6 +210,14 @@ void Executor::Execute(const AbstractExecutorUptr &executor, Context *ctx)
   } else {
     auto header = executor->GetOutSchema();
     ctx->nt_ctl_->SendRecHeader(ctx->client_fd_, header);
+    if (executor->IsVectorized()) {
+      executor->Init();
+      for (auto chunk = executor->NextChunk(); chunk != nullptr; chunk = executor->NextChunk()) {
+        ctx->nt_ctl_->SendChunk(ctx->client_fd_, *chunk);
+      }
+      ctx->nt_ctl_->SendRecFinish(ctx->client_fd_);
+      return;
+    }
     for (executor->Init(); !executor->IsEnd(); executor->Next()) {
       auto rec = executor->GetRecord();
       WSDB_ASSERT(rec != nullptr, "");
@@ -32,9 +32,23 @@ class Executor
 public:
   Executor() = default;
 
+  /**
+   * Translate the plan to an executor tree, the tree runs vectorized if every node of it supports chunks and it
+   * scans a pax table, see CanVectorize. The plan is left intact so that a prepared plan can be translated again
+   */
   static auto Translate(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> AbstractExecutorUptr;
 
   static void Execute(const AbstractExecutorUptr &executor, Context *ctx);
+
+private:
+  static auto TranslatePlan(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db, bool vectorized)
+      -> AbstractExecutorUptr;
+
+  /**
+   * Check if the plan is a chain of filter, projection, limit and aggregate over a scan of a pax table, which are the
+   * executors supporting NextChunk
+   */
+  static auto CanVectorize(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> bool;
 };
 }  // namespace wsdb
 
@@ -24,6 +24,7 @@
 
 #include "../../common/error.h"
 #include "../../common/micro.h"
+#include "common/config.h"
 #include "system/handle/record_handle.h"
 
 namespace wsdb {
@@ -55,6 +56,15 @@ public:
 
   [[nodiscard]] virtual auto IsEnd() const -> bool = 0;
 
+  /**
+   * Vectorized interface, only available when IsVectorized() is true. In that mode Init() only prepares the executor
+   * and the output is pulled by NextChunk() instead of Next()/GetRecord(), the two interfaces must not be mixed
+   * @return the next batch of about CHUNK_SIZE rows, only rows in its selection vector are output, nullptr if exhausted
+   */
+  virtual auto NextChunk() -> ChunkUptr { WSDB_THROW(WSDB_NOT_IMPLEMENTED, "NextChunk"); }
+
+  [[nodiscard]] auto IsVectorized() const -> bool { return vectorized_; }
+
   [[nodiscard]] virtual auto GetOutSchema() const -> const RecordSchema *
   {
     WSDB_ASSERT(out_schema_ != nullptr, "out_schema_ is nullptr");
@@ -74,6 +84,8 @@ public:
 protected:
   RecordSchemaUptr out_schema_;
   RecordUptr       record_;
+  // decided at construction, a vectorized executor is fed by a vectorized child and fed to a vectorized parent
+  bool vectorized_{false};
 
 private:
   ExecutorType type_;
@@ -23,19 +23,155 @@
 
 namespace wsdb {
 
-AggregateExecutor::AggregateValue::AggregateValue(RecordSchema *schema) : schema_(schema) { WSDB_STUDENT_TODO(l3, t3); }
+AggregateExecutor::AggregateValue::AggregateValue(RecordSchema *schema) : schema_(schema)
+{
+    values_.reserve(schema_->GetFieldCount());
+    for (const auto &field : schema_->GetFields()) {
+        // 计数从 0 开始，其余聚合在没有输入时为 NULL
+        if (field.agg_type_ == AGG_COUNT || field.agg_type_ == AGG_COUNT_STAR) {
+            values_.push_back(ValueFactory::CreateIntValue(0));
+        } else {
+            values_.push_back(ValueFactory::CreateNullValue(field.field_.field_type_));
+        }
+    }
+}
+
 AggregateExecutor::AggregateValue::AggregateValue(RecordSchema *schema, const Record &record)
+    : AggregateValue(schema)
 {
-  WSDB_STUDENT_TODO(l3, t3);
+    auto rec_schema = record.GetSchema();
+    std::vector<ValueRef> inputs;
+    inputs.reserve(schema_->GetFieldCount());
+    for (const auto &field : schema_->GetFields()) {
+        if (field.agg_type_ == AGG_COUNT_STAR) {
+            inputs.emplace_back();
+            continue;
+        }
+        // 聚合字段的类型可能被改写，只按表 id 与字段名查找输入列
+        auto idx = rec_schema->GetFieldIndex(field.field_.table_id_, field.field_.field_name_);
+        WSDB_ASSERT(idx != rec_schema->GetFieldCount(), "Aggregate field not found in record");
+        inputs.push_back(record.GetValueRefAt(idx));
+    }
+    Accumulate(inputs);
 }
+
 void AggregateExecutor::AggregateValue::CombineWith(const AggregateExecutor::AggregateValue &other)
 {
-  WSDB_STUDENT_TODO(l3, t3);
+    for (size_t i = 0; i < values_.size(); i++) {
+        const auto &other_val = other.values_[i];
+        auto        agg_type  = schema_->GetFieldAt(i).agg_type_;
+        switch (agg_type) {
+            case AGG_COUNT:
+            case AGG_COUNT_STAR: *values_[i] += *other_val; break;
+            case AGG_AVG:
+                if (other.avg_count_map_.count(i) != 0) {
+                    avg_count_map_[i] += other.avg_count_map_.at(i);
+                }
+                [[fallthrough]];
+            case AGG_SUM:
+            case AGG_MAX:
+            case AGG_MIN:
+                if (!other_val->IsNull()) {
+                    Update(i, agg_type, ValueRef::FromValue(*other_val));
+                }
+                break;
+            default: WSDB_FETAL(fmt::format("Unsupported aggregate type {}", AggTypeToString(agg_type)));
+        }
+    }
+}
+
+void AggregateExecutor::AggregateValue::Accumulate(const std::vector<ValueRef> &inputs)
+{
+    for (size_t i = 0; i < values_.size(); i++) {
+        auto agg_type = schema_->GetFieldAt(i).agg_type_;
+        if (agg_type == AGG_COUNT_STAR) {
+            auto &count = static_cast<IntValue &>(*values_[i]);
+            count.Set(count.Get() + 1);
+            continue;
+        }
+        const auto &input = inputs[i];
+        // NULL 不参与任何聚合
+        if (input.IsNull()) {
+            continue;
+        }
+        switch (agg_type) {
+            case AGG_COUNT: {
+                auto &count = static_cast<IntValue &>(*values_[i]);
+                count.Set(count.Get() + 1);
+                break;
+            }
+            case AGG_AVG: avg_count_map_[i]++; [[fallthrough]];
+            case AGG_SUM:
+            case AGG_MAX:
+            case AGG_MIN: Update(i, agg_type, input); break;
+            default: WSDB_FETAL(fmt::format("Unsupported aggregate type {}", AggTypeToString(agg_type)));
+        }
+    }
+}
+
+void AggregateExecutor::AggregateValue::Update(size_t i, AggType agg_type, const ValueRef &input)
+{
+    // 第一个非 NULL 输入复制一份，之后都在这份值上原地修改，values_ 中的值只属于当前分组
+    if (values_[i]->IsNull()) {
+        values_[i] = input.ToValue();
+        return;
+    }
+    auto &value = *values_[i];
+    switch (agg_type) {
+        case AGG_AVG:
+        case AGG_SUM:
+            if (value.GetType() == TYPE_INT) {
+                auto &sum = static_cast<IntValue &>(value);
+                sum.Set(sum.Get() + input.GetInt());
+            } else if (value.GetType() == TYPE_FLOAT) {
+                auto &sum = static_cast<FloatValue &>(value);
+                sum.Set(sum.Get() + input.GetNumber());
+            } else {
+                value += *input.ToValue();
+            }
+            break;
+        case AGG_MAX:
+            if (ValueRef::Compare(input, ValueRef::FromValue(value)) > 0) {
+                Assign(i, input);
+            }
+            break;
+        case AGG_MIN:
+            if (ValueRef::Compare(input, ValueRef::FromValue(value)) < 0) {
+                Assign(i, input);
+            }
+            break;
+        default: WSDB_FETAL(fmt::format("Unsupported aggregate type {}", AggTypeToString(agg_type)));
+    }
+}
+
+void AggregateExecutor::AggregateValue::Assign(size_t i, const ValueRef &input)
+{
+    auto &value = *values_[i];
+    switch (value.GetType()) {
+        case TYPE_BOOL: static_cast<BoolValue &>(value).Set(input.GetBool()); break;
+        case TYPE_INT: static_cast<IntValue &>(value).Set(input.GetInt()); break;
+        case TYPE_FLOAT: static_cast<FloatValue &>(value).Set(input.GetNumber()); break;
+        case TYPE_STRING: {
+            auto str = input.GetString();
+            static_cast<StringValue &>(value).Set(str.data(), str.size());
+            break;
+        }
+        default: WSDB_FETAL(fmt::format("Unsupported field type {}", FieldTypeToString(value.GetType())));
+    }
 }
 
 auto AggregateExecutor::AggregateValue::Values() const -> const std::vector<ValueSptr> & { return values_; }
 
-void AggregateExecutor::AggregateValue::Finalize() { WSDB_STUDENT_TODO(l3, t3); }
+void AggregateExecutor::AggregateValue::Finalize()
+{
+    if (summarized_) {
+        return;
+    }
+    for (const auto &[idx, count] : avg_count_map_) {
+        *values_[idx] /= count;
+    }
+    summarized_ = true;
+}
 
 AggregateExecutor::AggregateExecutor(
     AbstractExecutorUptr child, RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema)
@@ -52,12 +188,133 @@ AggregateExecutor::AggregateExecutor(
     fields.push_back(field);
   }
   out_schema_ = std::make_unique<RecordSchema>(fields);
+  vectorized_ = child_->IsVectorized();
+  auto child_schema = child_->GetOutSchema();
+  for (const auto &field : group_schema_->GetFields()) {
+    group_idx_.push_back(child_schema->GetRTFieldIndex(field));
+  }
+  for (const auto &field : agg_schema_->GetFields()) {
+    agg_idx_.push_back(field.agg_type_ == AGG_COUNT_STAR
+                           ? child_schema->GetFieldCount()
+                           : child_schema->GetFieldIndex(field.field_.table_id_, field.field_.field_name_));
+  }
 }
 
-void AggregateExecutor::Init() { WSDB_STUDENT_TODO(l3, t3); }
+void AggregateExecutor::Init()
+{
+    child_->Init();
+    group_map_.clear();
+    if (vectorized_) {
+        AggregateChunks();
+        FinishAggregation();
+        return;
+    }
+    // 输入直接引用记录中的字段，不再为每行每个字段创建 Value
+    auto child_schema = child_->GetOutSchema();
+    std::vector<ValueRef> inputs(agg_idx_.size());
+    for (; !child_->IsEnd(); child_->Next()) {
+        auto rec = child_->GetRecord();
+        for (size_t i = 0; i < agg_idx_.size(); i++) {
+            inputs[i] = agg_idx_[i] == child_schema->GetFieldCount() ? ValueRef() : rec->GetValueRefAt(agg_idx_[i]);
+        }
+        Record group(group_schema_.get(), *rec);
+        auto iter = group_map_.find(group);
+        if (iter == group_map_.end()) {
+            iter = group_map_.emplace(std::move(group), AggregateValue(agg_schema_.get())).first;
+        }
+        iter->second.Accumulate(inputs);
+    }
+    FinishAggregation();
+    record_ = nullptr;
+    if (group_iter_ != group_map_.end()) {
+        record_ = std::make_unique<Record>(
+            out_schema_.get(), MakeOutputValues(group_iter_->first, group_iter_->second), INVALID_RID);
+    }
+}
+
+void AggregateExecutor::Next()
+{
+    record_ = nullptr;
+    if (group_iter_ == group_map_.end()) {
+        return;
+    }
+    ++group_iter_;
+    if (group_iter_ != group_map_.end()) {
+        record_ = std::make_unique<Record>(
+            out_schema_.get(), MakeOutputValues(group_iter_->first, group_iter_->second), INVALID_RID);
+    }
+}
+
+auto AggregateExecutor::NextChunk() -> ChunkUptr
+{
+    if (group_iter_ == group_map_.end()) {
+        return nullptr;
+    }
+    std::vector<ArrayValueSptr> cols;
+    for (size_t i = 0; i < out_schema_->GetFieldCount(); i++) {
+        cols.push_back(ValueFactory::CreateArrayValue());
+    }
+    // 每次输出最多 CHUNK_SIZE 个分组
+    for (size_t n = 0; n < CHUNK_SIZE && group_iter_ != group_map_.end(); n++, ++group_iter_) {
+        auto values = MakeOutputValues(group_iter_->first, group_iter_->second);
+        for (size_t i = 0; i < values.size(); i++) {
+            cols[i]->Append(values[i]);
+        }
+    }
+    return std::make_unique<Chunk>(out_schema_.get(), std::move(cols));
+}
 
-void AggregateExecutor::Next() { WSDB_STUDENT_TODO(l3, t3); }
+auto AggregateExecutor::IsEnd() const -> bool { return group_iter_ == group_map_.end(); }
 
-auto AggregateExecutor::IsEnd() const -> bool { WSDB_STUDENT_TODO(l3, t3); }
+auto AggregateExecutor::MakeOutputValues(const Record &group, const AggregateValue &agg) const
+    -> std::vector<ValueSptr>
+{
+    std::vector<ValueSptr> values;
+    values.reserve(out_schema_->GetFieldCount());
+    for (size_t i = 0; i < group_schema_->GetFieldCount(); i++) {
+        values.push_back(group.GetValueAt(i));
+    }
+    values.insert(values.end(), agg.Values().begin(), agg.Values().end());
+    return values;
+}
+
+void AggregateExecutor::AggregateChunks()
+{
+    auto child_schema = child_->GetOutSchema();
+    std::vector<ValueSptr> group_values(group_idx_.size());
+    std::vector<ValueRef> inputs(agg_idx_.size());
+    for (auto chunk = child_->NextChunk(); chunk != nullptr; chunk = child_->NextChunk()) {
+        for (auto row : chunk->GetSel()) {
+            for (size_t i = 0; i < group_idx_.size(); i++) {
+                group_values[i] = chunk->GetValueAt(group_idx_[i], row);
+            }
+            for (size_t i = 0; i < agg_idx_.size(); i++) {
+                // COUNT(*) 没有输入列
+                inputs[i] = agg_idx_[i] == child_schema->GetFieldCount()
+                                ? ValueRef()
+                                : ValueRef::FromValue(*chunk->GetValueAt(agg_idx_[i], row));
+            }
+            Record group(group_schema_.get(), group_values, INVALID_RID);
+            auto iter = group_map_.find(group);
+            if (iter == group_map_.end()) {
+                iter = group_map_.emplace(std::move(group), AggregateValue(agg_schema_.get())).first;
+            }
+            iter->second.Accumulate(inputs);
+        }
+    }
+}
+
+void AggregateExecutor::FinishAggregation()
+{
+    // 没有 group by 时即使输入为空也要输出一行，例如 count(*) 为 0
+    if (group_map_.empty() && group_schema_->GetFieldCount() == 0) {
+        group_map_.emplace(Record(group_schema_.get(), std::vector<ValueSptr>{}, INVALID_RID),
+            AggregateValue(agg_schema_.get()));
+    }
+    for (auto &[group, agg] : group_map_) {
+        agg.Finalize();
+    }
+    group_iter_ = group_map_.begin();
+}
 
-}  // namespace wsdb
\ No newline at end of file
+}  // namespace wsdb
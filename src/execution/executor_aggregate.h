@@ -35,6 +35,8 @@ public:
 
   void Next() override;
 
+  auto NextChunk() -> ChunkUptr override;
+
   [[nodiscard]] auto IsEnd() const -> bool override;
 
 private:
@@ -59,12 +61,25 @@ private:
 
     void CombineWith(const AggregateValue &other);
 
+    /**
+     * accumulate one input row, the aggregate values are updated in place so no value is created per row
+     * @param inputs input value of each aggregate field, ignored for COUNT(*)
+     */
+    void Accumulate(const std::vector<ValueRef> &inputs);
+
     [[nodiscard]] auto Values() const -> const std::vector<ValueSptr> &;
 
     void Finalize();
 
     virtual ~AggregateValue() = default;
 
+  private:
+    // fold a non-null input into the i-th SUM, AVG, MAX or MIN value
+    void Update(size_t i, AggType agg_type, const ValueRef &input);
+
+    // overwrite the i-th value with input, used by MAX and MIN
+    void Assign(size_t i, const ValueRef &input);
+
   private:
     RecordSchema          *schema_;
     std::vector<ValueSptr> values_;
@@ -74,12 +89,31 @@ private:
     std::unordered_map<size_t, int> avg_count_map_;
   };
 
+private:
+  /**
+   * build the output record of a group, group values are followed by aggregate values
+   * @param group
+   * @param agg
+   * @return
+   */
+  auto MakeOutputValues(const Record &group, const AggregateValue &agg) const -> std::vector<ValueSptr>;
+
+  // drain the child chunk by chunk, used by Init in vectorized mode
+  void AggregateChunks();
+
+  // add the group of an aggregation without group by over empty input and finalize all groups
+  void FinishAggregation();
+
 private:
   AbstractExecutorUptr                                 child_;
   RecordSchemaUptr                                     agg_schema_;
   RecordSchemaUptr                                     group_schema_;
   std::unordered_map<Record, AggregateValue>           group_map_;
   std::unordered_map<Record, AggregateValue>::iterator group_iter_;
+  // column index of each group field and each aggregate input in the child schema,
+  // COUNT(*) has no input and is marked by the field count of the child schema
+  std::vector<size_t> group_idx_;
+  std::vector<size_t> agg_idx_;
 };
 
 }  // namespace wsdb
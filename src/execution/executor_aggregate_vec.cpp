@@ -21,4 +21,394 @@
 
 #include "executor_aggregate_vec.h"
 
-namespace wsdb {}  // namespace wsdb
\ No newline at end of file
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+namespace wsdb {
+
+namespace {
+
+// kernels over one column of a page, the ungrouped ones are branch free so that the compiler can vectorize them
+
+auto CountMasked(const uint8_t *mask, size_t n) -> int64_t
+{
+  int64_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    count += mask[i];
+  }
+  return count;
+}
+
+template <typename T, typename Acc>
+auto SumMasked(const T *vals, const uint8_t *mask, size_t n) -> Acc
+{
+  Acc sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    sum += mask[i] ? static_cast<Acc>(vals[i]) : Acc{0};
+  }
+  return sum;
+}
+
+template <typename T>
+auto MinMasked(const T *vals, const uint8_t *mask, size_t n) -> T
+{
+  T res = std::numeric_limits<T>::max();
+  for (size_t i = 0; i < n; i++) {
+    T v = mask[i] ? vals[i] : std::numeric_limits<T>::max();
+    res = v < res ? v : res;
+  }
+  return res;
+}
+
+template <typename T>
+auto MaxMasked(const T *vals, const uint8_t *mask, size_t n) -> T
+{
+  T res = std::numeric_limits<T>::lowest();
+  for (size_t i = 0; i < n; i++) {
+    T v = mask[i] ? vals[i] : std::numeric_limits<T>::lowest();
+    res = v > res ? v : res;
+  }
+  return res;
+}
+
+template <typename T, typename Acc>
+void AggregateGrouped(
+    AggType type, const T *vals, const uint8_t *mask, const uint32_t *gids, size_t n, Acc *accs, int64_t *counts)
+{
+  switch (type) {
+    case AGG_SUM:
+    case AGG_AVG:
+      for (size_t i = 0; i < n; i++) {
+        if (mask[i]) {
+          accs[gids[i]] += static_cast<Acc>(vals[i]);
+          counts[gids[i]]++;
+        }
+      }
+      break;
+    case AGG_MIN:
+      for (size_t i = 0; i < n; i++) {
+        if (mask[i]) {
+          accs[gids[i]] = std::min(accs[gids[i]], static_cast<Acc>(vals[i]));
+          counts[gids[i]]++;
+        }
+      }
+      break;
+    case AGG_MAX:
+      for (size_t i = 0; i < n; i++) {
+        if (mask[i]) {
+          accs[gids[i]] = std::max(accs[gids[i]], static_cast<Acc>(vals[i]));
+          counts[gids[i]]++;
+        }
+      }
+      break;
+    default: WSDB_FETAL(fmt::format("Unsupported aggregate type {}", AggTypeToString(type)));
+  }
+}
+
+template <typename T, typename Acc>
+void AggregateUngrouped(AggType type, const T *vals, const uint8_t *mask, size_t n, Acc &acc, int64_t &count)
+{
+  auto cnt = CountMasked(mask, n);
+  if (cnt == 0) {
+    return;
+  }
+  count += cnt;
+  switch (type) {
+    case AGG_SUM:
+    case AGG_AVG: acc += SumMasked<T, Acc>(vals, mask, n); break;
+    case AGG_MIN: acc = std::min(acc, static_cast<Acc>(MinMasked(vals, mask, n))); break;
+    case AGG_MAX: acc = std::max(acc, static_cast<Acc>(MaxMasked(vals, mask, n))); break;
+    default: WSDB_FETAL(fmt::format("Unsupported aggregate type {}", AggTypeToString(type)));
+  }
+}
+
+template <typename Acc>
+auto InitialAcc(AggType type) -> Acc
+{
+  switch (type) {
+    case AGG_MIN: return std::numeric_limits<Acc>::max();
+    case AGG_MAX: return std::numeric_limits<Acc>::lowest();
+    default: return Acc{0};
+  }
+}
+
+constexpr size_t INITIAL_SLOT_NUM = 1024;
+
+}  // namespace
+
+AggregateExecutorVec::AggregateExecutorVec(
+    TableHandle *tab, RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema, bool vectorized)
+    : AbstractExecutor(Basic), tab_(tab), agg_schema_(std::move(agg_schema)), group_schema_(std::move(group_schema))
+{
+  WSDB_ASSERT(IsSupported(tab_, *agg_schema_, *group_schema_), "aggregation is not supported on raw columns");
+  vectorized_ = vectorized;
+  std::vector<RTField> fields;
+  for (const auto &field : group_schema_->GetFields()) {
+    fields.push_back(field);
+  }
+  for (const auto &field : agg_schema_->GetFields()) {
+    fields.push_back(field);
+  }
+  out_schema_ = std::make_unique<RecordSchema>(fields);
+
+  const auto &tab_schema = tab_->GetSchema();
+  for (const auto &field : group_schema_->GetFields()) {
+    batch_fields_.push_back(tab_schema.GetFieldIndex(field.field_.table_id_, field.field_.field_name_));
+    key_size_ += 1 + field.field_.field_size_;
+  }
+  key_buf_.resize(key_size_);
+  for (const auto &field : agg_schema_->GetFields()) {
+    AggState agg;
+    agg.type_ = field.agg_type_;
+    if (agg.type_ != AGG_COUNT_STAR) {
+      auto idx        = tab_schema.GetFieldIndex(field.field_.table_id_, field.field_.field_name_);
+      agg.input_type_ = tab_schema.GetFieldAt(idx).field_.field_type_;
+      // share the column with group fields and other aggregates on the same field
+      auto iter = std::find(batch_fields_.begin(), batch_fields_.end(), idx);
+      agg.col_  = iter - batch_fields_.begin();
+      if (iter == batch_fields_.end()) {
+        batch_fields_.push_back(idx);
+      }
+    }
+    aggs_.push_back(std::move(agg));
+  }
+}
+
+auto AggregateExecutorVec::IsSupported(
+    TableHandle *tab, const RecordSchema &agg_schema, const RecordSchema &group_schema) -> bool
+{
+  if (tab->GetStorageModel() != PAX_MODEL) {
+    return false;
+  }
+  const auto &tab_schema = tab->GetSchema();
+  for (const auto &field : group_schema.GetFields()) {
+    if (tab_schema.GetFieldIndex(field.field_.table_id_, field.field_.field_name_) == tab_schema.GetFieldCount()) {
+      return false;
+    }
+  }
+  for (const auto &field : agg_schema.GetFields()) {
+    if (field.agg_type_ == AGG_COUNT_STAR) {
+      continue;
+    }
+    auto idx = tab_schema.GetFieldIndex(field.field_.table_id_, field.field_.field_name_);
+    if (idx == tab_schema.GetFieldCount()) {
+      return false;
+    }
+    auto type = tab_schema.GetFieldAt(idx).field_.field_type_;
+    if (field.agg_type_ != AGG_COUNT && type != TYPE_INT && type != TYPE_FLOAT) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AggregateExecutorVec::Init()
+{
+  keys_.clear();
+  hashes_.clear();
+  slots_.assign(INITIAL_SLOT_NUM, 0);
+  group_num_ = 0;
+  for (auto &agg : aggs_) {
+    agg.count_.clear();
+    agg.ival_.clear();
+    agg.fval_.clear();
+  }
+  // without group by there is exactly one group, even if the table is empty
+  if (group_schema_->GetFieldCount() == 0) {
+    FindOrInsertGroup(key_buf_.data());
+  }
+  auto page_num = static_cast<page_id_t>(tab_->GetTableHeader().page_num_);
+  for (page_id_t pid = FILE_HEADER_PAGE_ID + 1; pid < page_num; pid++) {
+    tab_->GetColumnBatch(pid, batch_fields_, batch_);
+    AggregateBatch();
+  }
+  cursor_ = 0;
+  record_ = nullptr;
+  if (!vectorized_ && cursor_ < group_num_) {
+    record_ = std::make_unique<Record>(out_schema_.get(), MakeOutputValues(cursor_), INVALID_RID);
+  }
+}
+
+void AggregateExecutorVec::Next()
+{
+  record_ = nullptr;
+  if (cursor_ >= group_num_) {
+    return;
+  }
+  if (++cursor_ < group_num_) {
+    record_ = std::make_unique<Record>(out_schema_.get(), MakeOutputValues(cursor_), INVALID_RID);
+  }
+}
+
+auto AggregateExecutorVec::NextChunk() -> ChunkUptr
+{
+  if (cursor_ >= group_num_) {
+    return nullptr;
+  }
+  std::vector<ArrayValueSptr> cols;
+  for (size_t i = 0; i < out_schema_->GetFieldCount(); i++) {
+    cols.push_back(ValueFactory::CreateArrayValue());
+  }
+  for (size_t n = 0; n < CHUNK_SIZE && cursor_ < group_num_; n++, cursor_++) {
+    auto values = MakeOutputValues(cursor_);
+    for (size_t i = 0; i < values.size(); i++) {
+      cols[i]->Append(values[i]);
+    }
+  }
+  return std::make_unique<Chunk>(out_schema_.get(), std::move(cols));
+}
+
+auto AggregateExecutorVec::IsEnd() const -> bool { return cursor_ >= group_num_; }
+
+auto AggregateExecutorVec::FindOrInsertGroup(const char *key) -> size_t
+{
+  auto   hash = std::hash<std::string_view>{}(std::string_view(key, key_size_));
+  size_t mask = slots_.size() - 1;
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    if (slots_[pos] == 0) {
+      auto gid = group_num_++;
+      slots_[pos] = static_cast<uint32_t>(gid + 1);
+      keys_.insert(keys_.end(), key, key + key_size_);
+      hashes_.push_back(hash);
+      for (auto &agg : aggs_) {
+        agg.count_.push_back(0);
+        if (agg.input_type_ == TYPE_INT) {
+          agg.ival_.push_back(InitialAcc<int64_t>(agg.type_));
+        } else if (agg.input_type_ == TYPE_FLOAT) {
+          agg.fval_.push_back(InitialAcc<double>(agg.type_));
+        }
+      }
+      // keep the load factor under 1/2
+      if (group_num_ * 2 > slots_.size()) {
+        GrowSlots();
+      }
+      return gid;
+    }
+    auto gid = slots_[pos] - 1;
+    if (hashes_[gid] == hash && std::memcmp(keys_.data() + gid * key_size_, key, key_size_) == 0) {
+      return gid;
+    }
+  }
+}
+
+void AggregateExecutorVec::GrowSlots()
+{
+  slots_.assign(slots_.size() * 2, 0);
+  size_t mask = slots_.size() - 1;
+  for (size_t gid = 0; gid < group_num_; gid++) {
+    auto pos = hashes_[gid] & mask;
+    while (slots_[pos] != 0) {
+      pos = (pos + 1) & mask;
+    }
+    slots_[pos] = static_cast<uint32_t>(gid + 1);
+  }
+}
+
+void AggregateExecutorVec::ComputeGroups()
+{
+  size_t n = batch_.slot_num_;
+  gids_.assign(n, 0);
+  if (key_size_ == 0) {
+    return;
+  }
+  for (size_t slot = 0; slot < n; slot++) {
+    if (!batch_.valid_[slot]) {
+      continue;
+    }
+    size_t off = 0;
+    for (size_t k = 0; k < group_schema_->GetFieldCount(); k++) {
+      size_t size   = group_schema_->GetFieldAt(k).field_.field_size_;
+      bool   null   = batch_.nulls_[k][slot];
+      key_buf_[off] = static_cast<char>(null);
+      if (null) {
+        std::memset(key_buf_.data() + off + 1, 0, size);
+      } else {
+        std::memcpy(key_buf_.data() + off + 1, batch_.cols_[k].data() + slot * size, size);
+      }
+      off += 1 + size;
+    }
+    gids_[slot] = static_cast<uint32_t>(FindOrInsertGroup(key_buf_.data()));
+  }
+}
+
+void AggregateExecutorVec::AggregateBatch()
+{
+  size_t n = batch_.slot_num_;
+  ComputeGroups();
+  // an empty page of a grouped aggregation may come before any group exists
+  if (group_num_ == 0) {
+    return;
+  }
+  bool grouped = key_size_ != 0;
+  mask_.resize(n);
+  for (auto &agg : aggs_) {
+    if (agg.type_ == AGG_COUNT_STAR) {
+      std::copy(batch_.valid_.begin(), batch_.valid_.end(), mask_.begin());
+    } else {
+      const auto *nulls = batch_.nulls_[agg.col_].data();
+      for (size_t i = 0; i < n; i++) {
+        mask_[i] = batch_.valid_[i] & (nulls[i] ^ 1);
+      }
+    }
+    if (agg.type_ == AGG_COUNT || agg.type_ == AGG_COUNT_STAR) {
+      if (grouped) {
+        for (size_t i = 0; i < n; i++) {
+          agg.count_[gids_[i]] += mask_[i];
+        }
+      } else {
+        agg.count_[0] += CountMasked(mask_.data(), n);
+      }
+      continue;
+    }
+    const char *col = batch_.cols_[agg.col_].data();
+    if (agg.input_type_ == TYPE_INT) {
+      const auto *vals = reinterpret_cast<const int32_t *>(col);
+      if (grouped) {
+        AggregateGrouped(agg.type_, vals, mask_.data(), gids_.data(), n, agg.ival_.data(), agg.count_.data());
+      } else {
+        AggregateUngrouped(agg.type_, vals, mask_.data(), n, agg.ival_[0], agg.count_[0]);
+      }
+    } else {
+      const auto *vals = reinterpret_cast<const float *>(col);
+      if (grouped) {
+        AggregateGrouped(agg.type_, vals, mask_.data(), gids_.data(), n, agg.fval_.data(), agg.count_.data());
+      } else {
+        AggregateUngrouped(agg.type_, vals, mask_.data(), n, agg.fval_[0], agg.count_[0]);
+      }
+    }
+  }
+}
+
+auto AggregateExecutorVec::MakeOutputValues(size_t gid) const -> std::vector<ValueSptr>
+{
+  std::vector<ValueSptr> values;
+  values.reserve(out_schema_->GetFieldCount());
+  const char *key = keys_.data() + gid * key_size_;
+  for (const auto &field : group_schema_->GetFields()) {
+    if (*key != 0) {
+      values.push_back(ValueFactory::CreateNullValue(field.field_.field_type_));
+    } else {
+      values.push_back(ValueFactory::CreateValue(field.field_.field_type_, key + 1, field.field_.field_size_));
+    }
+    key += 1 + field.field_.field_size_;
+  }
+  for (size_t i = 0; i < aggs_.size(); i++) {
+    const auto &agg   = aggs_[i];
+    auto        count = agg.count_[gid];
+    if (agg.type_ == AGG_COUNT || agg.type_ == AGG_COUNT_STAR) {
+      values.push_back(ValueFactory::CreateIntValue(static_cast<int>(count)));
+    } else if (count == 0) {
+      values.push_back(ValueFactory::CreateNullValue(agg_schema_->GetFieldAt(i).field_.field_type_));
+    } else if (agg.input_type_ == TYPE_INT) {
+      auto val = agg.type_ == AGG_AVG ? agg.ival_[gid] / count : agg.ival_[gid];
+      values.push_back(ValueFactory::CreateIntValue(static_cast<int32_t>(val)));
+    } else {
+      auto val = agg.type_ == AGG_AVG ? agg.fval_[gid] / static_cast<double>(count) : agg.fval_[gid];
+      values.push_back(ValueFactory::CreateFloatValue(static_cast<float>(val)));
+    }
+  }
+  return values;
+}
+
+}  // namespace wsdb
@@ -19,14 +19,104 @@
 // Created by ziqi on 2024/8/12.
 //
 
+/**
+ * @brief Vectorized hash aggregation that reads raw columns of a pax table instead of records
+ *
+ */
+
 #ifndef WSDB_EXECUTOR_AGGREGATE_VEC_H
 #define WSDB_EXECUTOR_AGGREGATE_VEC_H
 #include "executor_abstract.h"
+#include "system/handle/table_handle.h"
 
 namespace wsdb {
 
 class AggregateExecutorVec : public AbstractExecutor
-{};
+{
+public:
+  /**
+   * @param tab table to aggregate, must be stored in pax model
+   * @param agg_schema
+   * @param group_schema
+   * @param vectorized output groups by NextChunk instead of Next
+   */
+  AggregateExecutorVec(
+      TableHandle *tab, RecordSchemaUptr agg_schema, RecordSchemaUptr group_schema, bool vectorized = false);
+
+  /**
+   * Check if the aggregation can be done on raw columns: the table is in pax model, the inputs of SUM and AVG are int
+   * or float and the inputs of MIN and MAX are int or float
+   */
+  static auto IsSupported(TableHandle *tab, const RecordSchema &agg_schema, const RecordSchema &group_schema) -> bool;
+
+  void Init() override;
+
+  void Next() override;
+
+  auto NextChunk() -> ChunkUptr override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  // state of one aggregate of all groups in struct-of-arrays layout, index g holds the state of group g
+  struct AggState
+  {
+    AggType   type_{AGG_NONE};
+    FieldType input_type_{TYPE_NULL};
+    // index of the input in the column batch, unused by COUNT(*)
+    size_t col_{0};
+    // number of non-null inputs, also tells whether sum, min and max are null
+    std::vector<int64_t> count_;
+    // sum, min or max, int inputs are kept in ival_ and float inputs in fval_
+    std::vector<int64_t> ival_;
+    std::vector<double>  fval_;
+  };
+
+  /**
+   * Find the group of the key or create it
+   * @param key key_size_ bytes
+   * @return group id
+   */
+  auto FindOrInsertGroup(const char *key) -> size_t;
+
+  // double the hash table and reinsert all groups
+  void GrowSlots();
+
+  // fill gids_ with the group of every valid slot of the batch
+  void ComputeGroups();
+
+  // aggregate one page of columns
+  void AggregateBatch();
+
+  auto MakeOutputValues(size_t gid) const -> std::vector<ValueSptr>;
+
+private:
+  TableHandle     *tab_;
+  RecordSchemaUptr agg_schema_;
+  RecordSchemaUptr group_schema_;
+
+  // table field of every column in batch_, group fields first, then distinct aggregate inputs
+  std::vector<size_t> batch_fields_;
+  ColumnBatch         batch_;
+  // group id of every slot of the current batch
+  std::vector<uint32_t> gids_;
+  // masks of the current batch: valid and non-null, reused across pages
+  std::vector<uint8_t> mask_;
+
+  std::vector<AggState> aggs_;
+
+  // group keys, every key is key_size_ bytes: a null flag followed by the raw value for each group field
+  size_t              key_size_{0};
+  std::vector<char>   keys_;
+  std::vector<char>   key_buf_;
+  size_t              group_num_{0};
+  // open addressing hash table of group id + 1, 0 means empty, its size is a power of 2
+  std::vector<uint32_t> slots_;
+  std::vector<size_t>   hashes_;
+
+  // next group to output
+  size_t cursor_{0};
+};
 
 }  // namespace wsdb
 
@@ -208,4 +208,124 @@ void ShowTablesExecutor::Next()
 }
 auto ShowTablesExecutor::IsEnd() const -> bool { return is_end_; }
 
+/// Analyze Executor
+AnalyzeExecutor::AnalyzeExecutor(std::string table_name, wsdb::DatabaseHandle *db)
+    : AbstractExecutor(DDL), db_(db), is_end_(false), cursor_(0)
+{
+  if (!table_name.empty()) {
+    tab_names_.push_back(std::move(table_name));
+  } else {
+    for (const auto &[tid, tab_hdl] : db_->GetAllTables()) {
+      if (tab_hdl != nullptr) {
+        tab_names_.push_back(tab_hdl->GetTableName());
+      }
+    }
+  }
+  // analyze header is | Table | Rows
+  std::vector<RTField> fields(2);
+  fields[0]   = RTField{.field_ = {.table_id_ = INVALID_TABLE_ID,
+                            .field_name_      = "Table",
+                            .field_size_      = MAX_TABNAME_LEN,
+                            .field_type_      = TYPE_STRING}};
+  fields[1]   = RTField{.field_ = {.table_id_ = INVALID_TABLE_ID,
+                            .field_name_      = "Rows",
+                            .field_size_      = sizeof(int),
+                            .field_type_      = TYPE_INT}};
+  out_schema_ = std::make_unique<RecordSchema>(fields);
+}
+
+void AnalyzeExecutor::Init() { WSDB_FETAL("AnalyzeExecutor does not support Init"); }
+void AnalyzeExecutor::Next()
+{
+  if (is_end_) {
+    WSDB_FETAL("AnalyzeExecutor is end");
+  }
+  if (cursor_ >= tab_names_.size()) {
+    is_end_ = true;
+    return;
+  }
+  const auto &tab_name = tab_names_[cursor_];
+  db_->AnalyzeTable(tab_name);
+  auto                   stats = db_->GetTable(tab_name)->GetStatistics();
+  std::vector<ValueSptr> values(2);
+  values[0] = ValueFactory::CreateStringValue(tab_name.c_str(), tab_name.size());
+  values[1] = ValueFactory::CreateIntValue(static_cast<int>(stats->rec_num_));
+  record_   = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
+  cursor_++;
+}
+auto AnalyzeExecutor::IsEnd() const -> bool { return is_end_; }
+
+/// CreateIndex Executor
+CreateIndexExecutor::CreateIndexExecutor(
+    std::string table_name, std::vector<std::string> col_names, IndexType index_type, wsdb::DatabaseHandle *db)
+    : AbstractExecutor(DDL),
+      tab_name_(std::move(table_name)),
+      col_names_(std::move(col_names)),
+      index_type_(index_type),
+      db_(db),
+      is_end_(false)
+{
+  out_schema_ = MakeTableDescOutSchema(db_->GetName().size(), tab_name_.size());
+}
+
+void CreateIndexExecutor::Init() { WSDB_FETAL("CreateIndexExecutor does not support Init"); }
+void CreateIndexExecutor::Next()
+{
+  if (is_end_) {
+    WSDB_FETAL("CreateIndexExecutor is end");
+  }
+  auto tab = db_->GetTable(tab_name_);
+  if (tab == nullptr) {
+    WSDB_THROW(WSDB_TABLE_MISS, tab_name_);
+  }
+  std::vector<RTField> key_fields;
+  for (const auto &col_name : col_names_) {
+    if (!tab->HasField(col_name)) {
+      WSDB_THROW(WSDB_FIELD_MISS, fmt::format("{}.{}", tab_name_, col_name));
+    }
+    key_fields.push_back(tab->GetSchema().GetFieldByName(tab->GetTableId(), col_name));
+  }
+  RecordSchema key_schema(key_fields);
+  db_->CreateIndex(tab_name_, key_schema, index_type_);
+  auto values = MakeTableDescValue(db_->GetName(),
+      tab_name_,
+      tab->GetSchema().GetFieldCount(),
+      tab->GetSchema().GetRecordLength(),
+      StorageModelToString(tab->GetStorageModel()),
+      db_->GetIndexNum(tab->GetTableId()));
+  record_     = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
+  is_end_     = true;
+}
+auto CreateIndexExecutor::IsEnd() const -> bool { return is_end_; }
+
+/// DropIndex Executor
+DropIndexExecutor::DropIndexExecutor(
+    std::string table_name, std::vector<std::string> col_names, wsdb::DatabaseHandle *db)
+    : AbstractExecutor(DDL), tab_name_(std::move(table_name)), col_names_(std::move(col_names)), db_(db), is_end_(false)
+{
+  out_schema_ = MakeTableDescOutSchema(db_->GetName().size(), tab_name_.size());
+}
+
+void DropIndexExecutor::Init() { WSDB_FETAL("DropIndexExecutor does not support Init"); }
+void DropIndexExecutor::Next()
+{
+  if (is_end_) {
+    WSDB_FETAL("DropIndexExecutor is end");
+  }
+  auto tab = db_->GetTable(tab_name_);
+  if (tab == nullptr) {
+    WSDB_THROW(WSDB_TABLE_MISS, tab_name_);
+  }
+  db_->DropIndex(DatabaseHandle::GetIndexName(tab_name_, col_names_));
+  auto values = MakeTableDescValue(db_->GetName(),
+      tab_name_,
+      tab->GetSchema().GetFieldCount(),
+      tab->GetSchema().GetRecordLength(),
+      StorageModelToString(tab->GetStorageModel()),
+      db_->GetIndexNum(tab->GetTableId()));
+  record_     = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
+  is_end_     = true;
+}
+auto DropIndexExecutor::IsEnd() const -> bool { return is_end_; }
+
 }  // namespace wsdb
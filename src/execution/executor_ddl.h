@@ -106,6 +106,71 @@ private:
   size_t cursor_;
 };
 
+/**
+ * Collects the statistics of one table, or of every table if the name is empty, one table per Next
+ */
+class AnalyzeExecutor : public AbstractExecutor
+{
+public:
+  AnalyzeExecutor(std::string table_name, DatabaseHandle *db);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  std::vector<std::string> tab_names_;
+  DatabaseHandle          *db_;
+
+private:
+  bool   is_end_;
+  size_t cursor_;
+};
+
+class CreateIndexExecutor : public AbstractExecutor
+{
+public:
+  CreateIndexExecutor(
+      std::string table_name, std::vector<std::string> col_names, IndexType index_type, DatabaseHandle *db);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  std::string              tab_name_;
+  std::vector<std::string> col_names_;
+  IndexType                index_type_;
+  DatabaseHandle          *db_;
+
+private:
+  bool is_end_;
+};
+
+class DropIndexExecutor : public AbstractExecutor
+{
+public:
+  DropIndexExecutor(std::string table_name, std::vector<std::string> col_names, DatabaseHandle *db);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  std::string              tab_name_;
+  std::vector<std::string> col_names_;
+  DatabaseHandle          *db_;
+
+private:
+  bool is_end_;
+};
+
 }  // namespace wsdb
 
 #endif  // WSDB_EXECUTOR_DDL_H
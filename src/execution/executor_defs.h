@@ -23,6 +23,7 @@
 #define WSDB_EXECUTOR_DEFS_H
 
 #include "executor_aggregate.h"
+#include "executor_aggregate_vec.h"
 #include "executor_ddl.h"
 #include "executor_delete.h"
 #include "executor_filter.h"
@@ -30,10 +31,13 @@
 #include "executor_insert.h"
 #include "executor_join_nestedloop.h"
 #include "executor_join_sortmerge.h"
+#include "executor_join_hash.h"
 #include "executor_limit.h"
+#include "executor_load.h"
 #include "executor_projection.h"
 #include "executor_seqscan.h"
 #include "executor_sort.h"
+#include "executor_topn.h"
 #include "executor_update.h"
 
 #endif  // WSDB_EXECUTOR_DEFS_H
@@ -23,12 +23,22 @@
 
 namespace wsdb {
 
-FilterExecutor::FilterExecutor(AbstractExecutorUptr child, std::function<bool(const Record &)> filter)
-    : AbstractExecutor(Basic), child_(std::move(child)), filter_(std::move(filter))
-{}
+FilterExecutor::FilterExecutor(
+    AbstractExecutorUptr child, std::function<bool(const Record &)> filter, std::function<void(Chunk &)> chunk_filter)
+    : AbstractExecutor(Basic),
+      child_(std::move(child)),
+      filter_(std::move(filter)),
+      chunk_filter_(std::move(chunk_filter))
+{
+  vectorized_ = child_->IsVectorized();
+  WSDB_ASSERT(!vectorized_ || chunk_filter_ != nullptr, "vectorized filter needs a chunk filter");
+}
 
 void FilterExecutor::Init() {
     child_->Init();
+    if (vectorized_) {
+        return;
+    }
     while (!child_->IsEnd()) {
         auto rec = child_->GetRecord();
         if (rec && filter_(*rec)) {
@@ -57,6 +67,17 @@ void FilterExecutor::Next() {
     record_ = nullptr;
 }
 
+auto FilterExecutor::NextChunk() -> ChunkUptr {
+    // 跳过过滤后为空的块，避免向上层传递空块
+    for (auto chunk = child_->NextChunk(); chunk != nullptr; chunk = child_->NextChunk()) {
+        chunk_filter_(*chunk);
+        if (chunk->GetSelCount() > 0) {
+            return chunk;
+        }
+    }
+    return nullptr;
+}
+
 auto FilterExecutor::IsEnd() const -> bool {
     return record_ == nullptr;
 }
@@ -34,12 +34,21 @@ namespace wsdb {
 class FilterExecutor : public AbstractExecutor
 {
 public:
-  FilterExecutor(AbstractExecutorUptr child, std::function<bool(const Record &)> filter);
+  /**
+   * @param child
+   * @param filter row filter
+   * @param chunk_filter narrows the selection vector of a chunk to the rows passing the filter, required if the child
+   * is vectorized
+   */
+  FilterExecutor(AbstractExecutorUptr child, std::function<bool(const Record &)> filter,
+      std::function<void(Chunk &)> chunk_filter = nullptr);
 
   void Init() override;
 
   void Next() override;
 
+  auto NextChunk() -> ChunkUptr override;
+
   [[nodiscard]] auto IsEnd() const -> bool override;
 
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
@@ -47,6 +56,7 @@ public:
 private:
   AbstractExecutorUptr                child_;
   std::function<bool(const Record &)> filter_;
+  std::function<void(Chunk &)>        chunk_filter_;
 };
 
 }  // namespace wsdb
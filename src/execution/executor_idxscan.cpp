@@ -26,11 +26,91 @@ namespace wsdb {
 IdxScanExecutor::IdxScanExecutor(TableHandle *tbl, IndexHandle *idx, ConditionVec conds, int cmp_field_num)
     : AbstractExecutor(Basic), tbl_(tbl), idx_(idx), conds_(std::move(conds)), cmp_field_num_(cmp_field_num)
 {
-  // TODO: generate low key and high key using conds, conds has been rearranged to match the index key prefix
+  // conds fix a prefix of the key with equalities and may bound the field after it, a null bound is the smallest key
+  const auto            &key_schema = idx_->GetKeySchema();
+  std::vector<ValueSptr> low_vals;
+  std::vector<ValueSptr> high_vals;
+  for (const auto &field : key_schema.GetFields()) {
+    low_vals.push_back(ValueFactory::CreateNullValue(field.field_.field_type_));
+    high_vals.push_back(ValueFactory::CreateNullValue(field.field_.field_type_));
+  }
+  std::vector<bool> has_low(low_vals.size(), false);
+  std::vector<bool> has_high(high_vals.size(), false);
+  for (size_t i = 0; i < key_schema.GetFieldCount() && i < static_cast<size_t>(cmp_field_num_); ++i) {
+    const auto &field = key_schema.GetFieldAt(i);
+    for (const auto &cond : conds_) {
+      const auto &lcol = cond.GetLCol();
+      if (cond.GetRhsType() != kValue || lcol.field_.table_id_ != field.field_.table_id_ ||
+          lcol.field_.field_name_ != field.field_.field_name_) {
+        continue;
+      }
+      // a float bound of an int key is truncated toward zero, which only widens the range
+      auto val = ValueFactory::CastTo(cond.GetRVal(), field.field_.field_type_);
+      switch (cond.GetOp()) {
+        case OP_EQ:
+          low_vals[i]  = val;
+          high_vals[i] = val;
+          has_low[i]   = true;
+          has_high[i]  = true;
+          break;
+        case OP_GT:
+        case OP_GE:
+          if (!has_low[i] || *val > *low_vals[i]) {
+            low_vals[i] = val;
+          }
+          has_low[i] = true;
+          break;
+        case OP_LT:
+        case OP_LE:
+          if (!has_high[i] || *val < *high_vals[i]) {
+            high_vals[i] = val;
+          }
+          has_high[i] = true;
+          break;
+        default: break;
+      }
+    }
+    if (has_low[i]) {
+      low_field_num_ = i + 1;
+    }
+    if (has_high[i]) {
+      high_field_num_ = i + 1;
+    }
+  }
+  low_  = std::make_unique<Record>(&key_schema, low_vals, INVALID_RID);
+  high_ = std::make_unique<Record>(&key_schema, high_vals, INVALID_RID);
 }
-// TODO(ziqi): implement the following functions to support index scan
-void IdxScanExecutor::Init() {}
-void IdxScanExecutor::Next() {}
-auto IdxScanExecutor::IsEnd() const -> bool { return false; }
 
-}  // namespace wsdb
\ No newline at end of file
+void IdxScanExecutor::Init()
+{
+  iter_ = idx_->GetIndex()->Scan(*low_, low_field_num_, *high_, high_field_num_);
+  LoadRecord();
+}
+
+void IdxScanExecutor::Next()
+{
+  iter_->Next();
+  LoadRecord();
+}
+
+auto IdxScanExecutor::IsEnd() const -> bool { return iter_ == nullptr || iter_->IsEnd(); }
+
+auto IdxScanExecutor::GetOutSchema() const -> const RecordSchema * { return &tbl_->GetSchema(); }
+
+void IdxScanExecutor::LoadRecord()
+{
+  record_ = nullptr;
+  // the index is not versioned, skip the entries of records the transaction does not see
+  for (; !iter_->IsEnd(); iter_->Next()) {
+    try {
+      record_ = tbl_->GetRecord(iter_->GetRID());
+      return;
+    } catch (WSDBException_ &e) {
+      if (e.type_ != WSDB_RECORD_MISS) {
+        throw;
+      }
+    }
+  }
+}
+
+}  // namespace wsdb
@@ -44,20 +44,27 @@ public:
 
   [[nodiscard]] auto IsEnd() const -> bool override;
 
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
+
+private:
+  /// read the record of the current rid of the iterator
+  void LoadRecord();
+
 private:
-  /// Index scan should find all the records in the range [low, high),
-  /// where the comparison is based on the first cmp_field_num fields.
-  /// low, high should be generated using conds. Both the schema of
-  /// record low and record high are the same as the index key
-  /// schema. Store the record fetched from the table handle with the
-  /// indexed rid into AbstractExecutor::record_. Remove [[maybe_unused]]
-  /// when you implement this executor
-  TableHandle *tbl_;            // table handle
-  IndexHandle *idx_;            // index handle
-  ConditionVec conds_;          // conditions
-  RecordUptr   low_;            // low key
-  RecordUptr   high_;           // high key
-  int          cmp_field_num_;  // number of field to be compared from the 0th field
+  /// Index scan finds all the records whose keys are in the range [low, high], where low is compared on the first
+  /// low_field_num_ fields and high on the first high_field_num_ fields. low, high are generated from conds and may
+  /// cover more records than conds do, the filter above the scan still checks every condition. Both the schema of
+  /// record low and record high are the same as the index key schema. Records are fetched from the table handle with
+  /// the rids streamed by the index in key order
+  TableHandle      *tbl_;            // table handle
+  IndexHandle      *idx_;            // index handle
+  ConditionVec      conds_;          // conditions
+  RecordUptr        low_;            // low key
+  RecordUptr        high_;           // high key
+  int               cmp_field_num_;  // number of field to be compared from the 0th field
+  size_t            low_field_num_{0};
+  size_t            high_field_num_{0};
+  IndexIteratorUptr iter_;
 };
 }  // namespace wsdb
 
@@ -35,16 +35,12 @@ void InsertExecutor::Init() { WSDB_FETAL("InsertExecutor does not support Init")
 
 void InsertExecutor::Next()
 {
-  // number of inserted records
-  int count = 0;
-
-  for (auto& insert : inserts_) {
-    tbl_->InsertRecord(*insert);
-    for (auto* idx : indexes_) {
-      idx->InsertRecord(*insert);
-    }    
-    count++;
+  // fill pages a batch at a time, the records get their rids before reaching the indexes
+  tbl_->InsertRecords(inserts_);
+  for (auto *idx : indexes_) {
+    idx->InsertRecords(inserts_);
   }
+  auto count = static_cast<int>(inserts_.size());
   std::vector<ValueSptr> values{ValueFactory::CreateIntValue(count)};
   record_ = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
   is_end_ = true;
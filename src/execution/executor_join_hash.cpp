@@ -0,0 +1,340 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/22.
+//
+
+#include "executor_join_hash.h"
+#include <filesystem>
+#include <string_view>
+
+static long long hash_join_fresh_id_ = 0;
+#define HASH_JOIN_FILE_PATH(obj_name) FILE_NAME(TMP_DIR, obj_name, TMP_SUFFIX)
+
+namespace wsdb {
+
+HashJoinExecutor::HashJoinExecutor(JoinType join_type, AbstractExecutorUptr left, AbstractExecutorUptr right,
+    RecordSchemaUptr left_key_schema, RecordSchemaUptr right_key_schema, bool build_left, size_t mem_budget)
+    // condition vec is not used in hash join, it has been converted to key schemas
+    : JoinExecutor(join_type, std::move(left), std::move(right), {}),
+      left_key_schema_(std::move(left_key_schema)),
+      right_key_schema_(std::move(right_key_schema)),
+      build_left_(build_left),
+      mem_budget_(mem_budget),
+      build_child_(build_left ? left_.get() : right_.get()),
+      probe_child_(build_left ? right_.get() : left_.get()),
+      file_prefix_(fmt::format("hash_join_{}", hash_join_fresh_id_++))
+{
+  WSDB_ASSERT(left_key_schema_->GetFieldCount() == right_key_schema_->GetFieldCount(), "key field count mismatch");
+  auto &build_keys = build_left_ ? left_key_schema_ : right_key_schema_;
+  auto &probe_keys = build_left_ ? right_key_schema_ : left_key_schema_;
+  for (size_t i = 0; i < build_keys->GetFieldCount(); ++i) {
+    auto build_idx = build_child_->GetOutSchema()->GetRTFieldIndex(build_keys->GetFieldAt(i));
+    auto probe_idx = probe_child_->GetOutSchema()->GetRTFieldIndex(probe_keys->GetFieldAt(i));
+    WSDB_ASSERT(build_idx != build_child_->GetOutSchema()->GetFieldCount(), "build key not found");
+    WSDB_ASSERT(probe_idx != probe_child_->GetOutSchema()->GetFieldCount(), "probe key not found");
+    auto build_type = build_keys->GetFieldAt(i).field_.field_type_;
+    auto probe_type = probe_keys->GetFieldAt(i).field_.field_type_;
+    // reject incomparable keys before reading any input
+    ValueRef::CheckTypes(ValueRef::Null(build_type), ValueRef::Null(probe_type));
+    build_key_idx_.push_back(build_idx);
+    probe_key_idx_.push_back(probe_idx);
+    key_as_float_.push_back(build_type != probe_type);
+  }
+  // the right side of a left outer join is padded with nulls
+  null_rec_ = std::make_unique<Record>(right_->GetOutSchema());
+}
+
+HashJoinExecutor::~HashJoinExecutor() { RemovePartitionFiles(); }
+
+void HashJoinExecutor::InitInnerJoin()
+{
+  Build();
+  Advance();
+}
+
+void HashJoinExecutor::NextInnerJoin() { Advance(); }
+
+auto HashJoinExecutor::IsEndInnerJoin() const -> bool { return phase_ == kDone && record_ == nullptr; }
+
+void HashJoinExecutor::InitOuterJoin()
+{
+  Build();
+  Advance();
+}
+
+void HashJoinExecutor::NextOuterJoin() { Advance(); }
+
+auto HashJoinExecutor::IsEndOuterJoin() const -> bool { return phase_ == kDone && record_ == nullptr; }
+
+void HashJoinExecutor::Build()
+{
+  RemovePartitionFiles();
+  build_recs_.clear();
+  probe_rec_     = nullptr;
+  probe_started_ = false;
+  partitioned_   = false;
+  partition_     = 0;
+  record_        = nullptr;
+  // memory held by one build record, its data plus the bookkeeping of the hash table
+  auto build_schema = build_child_->GetOutSchema();
+  auto rec_bytes    = build_schema->GetRecordLength() + BITMAP_SIZE(build_schema->GetFieldCount()) + sizeof(Record) +
+                   sizeof(size_t) * 3;
+  size_t                     bytes = 0;
+  std::vector<std::ofstream> files;
+  auto                       open_files = [this, &files](bool build) {
+    files.clear();
+    for (size_t p = 0; p < HASH_JOIN_PARTITION_NUM; ++p) {
+      files.emplace_back(GetPartitionFile(build, p), std::ios::binary | std::ios::trunc);
+      if (!files.back().is_open()) {
+        WSDB_THROW(WSDB_FILE_NOT_OPEN, GetPartitionFile(build, p));
+      }
+    }
+  };
+  auto partition_of = [](size_t hash) { return (hash >> 32) % HASH_JOIN_PARTITION_NUM; };
+  for (build_child_->Init(); !build_child_->IsEnd(); build_child_->Next()) {
+    auto rec = build_child_->GetRecord();
+    if (partitioned_) {
+      WriteRecord(files[partition_of(KeyHash(*rec, build_key_idx_))], *rec);
+      continue;
+    }
+    build_recs_.push_back(std::move(*rec));
+    bytes += rec_bytes;
+    if (bytes > mem_budget_) {
+      // over the budget, move everything read so far to the partitions and spill the rest directly
+      std::filesystem::create_directories(TMP_DIR);
+      partitioned_ = true;
+      open_files(true);
+      for (const auto &build_rec : build_recs_) {
+        WriteRecord(files[partition_of(KeyHash(build_rec, build_key_idx_))], build_rec);
+      }
+      build_recs_.clear();
+      build_recs_.shrink_to_fit();
+    }
+  }
+  if (!partitioned_) {
+    BuildTable();
+    probe_child_->Init();
+    phase_ = kProbe;
+    return;
+  }
+  // the probe side is partitioned with the same hash so that matching records meet in the same partition
+  open_files(false);
+  for (probe_child_->Init(); !probe_child_->IsEnd(); probe_child_->Next()) {
+    auto rec = probe_child_->GetRecord();
+    WriteRecord(files[partition_of(KeyHash(*rec, probe_key_idx_))], *rec);
+  }
+  files.clear();
+  phase_ = LoadNextPartition() ? kProbe : kDone;
+}
+
+void HashJoinExecutor::BuildTable()
+{
+  size_t bucket_num = 1;
+  while (bucket_num < build_recs_.size() * 2) {
+    bucket_num <<= 1;
+  }
+  bucket_mask_ = bucket_num - 1;
+  buckets_.assign(bucket_num, 0);
+  hashes_.resize(build_recs_.size());
+  next_.resize(build_recs_.size());
+  matched_.assign(build_recs_.size(), false);
+  // insert backwards so that each chain lists its records in input order
+  for (size_t i = build_recs_.size(); i-- > 0;) {
+    hashes_[i]  = KeyHash(build_recs_[i], build_key_idx_);
+    auto bucket = hashes_[i] & bucket_mask_;
+    next_[i]    = buckets_[bucket];
+    buckets_[bucket] = i + 1;
+  }
+}
+
+auto HashJoinExecutor::LoadNextPartition() -> bool
+{
+  if (probe_file_ != nullptr) {
+    probe_file_ = nullptr;
+    std::filesystem::remove(GetPartitionFile(false, partition_ - 1));
+  }
+  while (partition_ < HASH_JOIN_PARTITION_NUM) {
+    auto p = partition_++;
+    build_recs_.clear();
+    {
+      std::ifstream build_file(GetPartitionFile(true, p), std::ios::binary);
+      for (auto rec = ReadRecord(build_file, build_child_->GetOutSchema()); rec != nullptr;
+           rec      = ReadRecord(build_file, build_child_->GetOutSchema())) {
+        build_recs_.push_back(std::move(*rec));
+      }
+    }
+    std::filesystem::remove(GetPartitionFile(true, p));
+    // nothing to match, only a left outer join probing with the left side still has output
+    if (build_recs_.empty() && (join_type_ == INNER_JOIN || build_left_)) {
+      std::filesystem::remove(GetPartitionFile(false, p));
+      continue;
+    }
+    // a partition larger than the budget is still joined in memory, records of one skewed key can not be split
+    BuildTable();
+    probe_file_ = std::make_unique<std::ifstream>(GetPartitionFile(false, p), std::ios::binary);
+    return true;
+  }
+  return false;
+}
+
+auto HashJoinExecutor::FetchProbe() -> bool
+{
+  if (partitioned_) {
+    probe_rec_ = ReadRecord(*probe_file_, probe_child_->GetOutSchema());
+    return probe_rec_ != nullptr;
+  }
+  if (probe_started_) {
+    probe_child_->Next();
+  }
+  probe_started_ = true;
+  if (probe_child_->IsEnd()) {
+    return false;
+  }
+  probe_rec_ = probe_child_->GetRecord();
+  return probe_rec_ != nullptr;
+}
+
+void HashJoinExecutor::Advance()
+{
+  record_ = nullptr;
+  while (phase_ != kDone) {
+    if (phase_ == kProbe) {
+      if (probe_rec_ != nullptr) {
+        // walk the rest of the chain of the current probe record
+        while (chain_ != 0) {
+          auto idx = chain_ - 1;
+          chain_   = next_[idx];
+          if (hashes_[idx] == probe_hash_ && KeyEqual(build_recs_[idx], *probe_rec_)) {
+            matched_[idx]  = true;
+            probe_matched_ = true;
+            record_        = MakeOutput(build_recs_[idx], *probe_rec_);
+            return;
+          }
+        }
+        auto probe = std::move(probe_rec_);
+        if (join_type_ == OUTER_JOIN && !build_left_ && !probe_matched_) {
+          record_ = std::make_unique<Record>(out_schema_.get(), *probe, *null_rec_);
+          return;
+        }
+      }
+      if (FetchProbe()) {
+        probe_hash_    = KeyHash(*probe_rec_, probe_key_idx_);
+        chain_         = buckets_[probe_hash_ & bucket_mask_];
+        probe_matched_ = false;
+        continue;
+      }
+      if (join_type_ == OUTER_JOIN && build_left_) {
+        phase_         = kUnmatched;
+        unmatched_pos_ = 0;
+        continue;
+      }
+    } else {
+      while (unmatched_pos_ < build_recs_.size()) {
+        auto idx = unmatched_pos_++;
+        if (!matched_[idx]) {
+          record_ = std::make_unique<Record>(out_schema_.get(), build_recs_[idx], *null_rec_);
+          return;
+        }
+      }
+    }
+    // the current partition is done
+    phase_ = partitioned_ && LoadNextPartition() ? kProbe : kDone;
+  }
+}
+
+auto HashJoinExecutor::KeyHash(const Record &rec, const std::vector<size_t> &key_idx) const -> size_t
+{
+  size_t hash = 0;
+  for (size_t i = 0; i < key_idx.size(); ++i) {
+    auto   value = rec.GetValueRefAt(key_idx[i]);
+    size_t h     = 0;
+    if (value.IsNull()) {
+      // null matches null like Record::Compare, so all nulls share one hash
+      h = 0x9e3779b97f4a7c15ULL;
+    } else if (key_as_float_[i] || value.GetType() == TYPE_FLOAT) {
+      // 0.0 and -0.0 are equal but hash differently
+      auto f = value.GetNumber();
+      h      = std::hash<float>{}(f == 0 ? 0.0f : f);
+    } else if (value.GetType() == TYPE_INT) {
+      h = std::hash<int32_t>{}(value.GetInt());
+    } else if (value.GetType() == TYPE_BOOL) {
+      h = static_cast<size_t>(value.GetBool());
+    } else {
+      h = std::hash<std::string_view>{}(value.GetString());
+    }
+    hash = (hash ^ h) * 0x9e3779b97f4a7c15ULL + i;
+  }
+  // mix all bits, buckets take the low bits and partitions the high ones
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+auto HashJoinExecutor::KeyEqual(const Record &build, const Record &probe) const -> bool
+{
+  for (size_t i = 0; i < build_key_idx_.size(); ++i) {
+    if (ValueRef::Compare(build.GetValueRefAt(build_key_idx_[i]), probe.GetValueRefAt(probe_key_idx_[i])) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto HashJoinExecutor::MakeOutput(const Record &build, const Record &probe) const -> RecordUptr
+{
+  // output is always the left record followed by the right one
+  return build_left_ ? std::make_unique<Record>(out_schema_.get(), build, probe)
+                     : std::make_unique<Record>(out_schema_.get(), probe, build);
+}
+
+auto HashJoinExecutor::GetPartitionFile(bool build, size_t partition) const -> std::string
+{
+  return HASH_JOIN_FILE_PATH(fmt::format("{}_{}_{}", file_prefix_, build ? "build" : "probe", partition));
+}
+
+void HashJoinExecutor::WriteRecord(std::ofstream &file, const Record &rec) const
+{
+  file.write(rec.GetNullMap(), static_cast<std::streamsize>(BITMAP_SIZE(rec.GetSchema()->GetFieldCount())));
+  file.write(rec.GetData(), static_cast<std::streamsize>(rec.GetSchema()->GetRecordLength()));
+}
+
+auto HashJoinExecutor::ReadRecord(std::ifstream &file, const RecordSchema *schema) const -> RecordUptr
+{
+  auto              nullmap_size = BITMAP_SIZE(schema->GetFieldCount());
+  std::vector<char> buf(nullmap_size + schema->GetRecordLength());
+  if (!file.read(buf.data(), static_cast<std::streamsize>(buf.size()))) {
+    return nullptr;
+  }
+  return std::make_unique<Record>(schema, buf.data(), buf.data() + nullmap_size, INVALID_RID);
+}
+
+void HashJoinExecutor::RemovePartitionFiles()
+{
+  probe_file_ = nullptr;
+  std::error_code ec;
+  for (size_t p = 0; p < HASH_JOIN_PARTITION_NUM; ++p) {
+    std::filesystem::remove(GetPartitionFile(true, p), ec);
+    std::filesystem::remove(GetPartitionFile(false, p), ec);
+  }
+}
+
+}  // namespace wsdb
@@ -0,0 +1,147 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/22.
+//
+
+/**
+ * @brief Equi-join two inputs by hashing, the build side is kept in memory and the probe side is streamed. When the
+ * build side does not fit into the memory budget, both sides are partitioned by the key hash into temporary files and
+ * joined partition by partition (grace hash join)
+ *
+ */
+
+#ifndef WSDB_EXECUTOR_JOIN_HASH_H
+#define WSDB_EXECUTOR_JOIN_HASH_H
+
+#include <fstream>
+#include "executor_join.h"
+
+namespace wsdb {
+
+class HashJoinExecutor : public JoinExecutor
+{
+public:
+  /**
+   * @param join_type inner or left outer join
+   * @param left
+   * @param right
+   * @param left_key_schema join keys in the left input
+   * @param right_key_schema join keys in the right input, compared with the left keys in order
+   * @param build_left build the hash table on the left input, should be the smaller one
+   * @param mem_budget max bytes of build records held in memory before partitioning to disk
+   */
+  HashJoinExecutor(JoinType join_type, AbstractExecutorUptr left, AbstractExecutorUptr right,
+      RecordSchemaUptr left_key_schema, RecordSchemaUptr right_key_schema, bool build_left,
+      size_t mem_budget = HASH_JOIN_BUFFER_SIZE);
+
+  ~HashJoinExecutor() override;
+
+  /// whether the last Init had to partition the inputs to disk
+  [[nodiscard]] auto IsPartitioned() const -> bool { return partitioned_; }
+
+private:
+  void InitInnerJoin() override;
+
+  void NextInnerJoin() override;
+
+  [[nodiscard]] auto IsEndInnerJoin() const -> bool override;
+
+  void InitOuterJoin() override;
+
+  void NextOuterJoin() override;
+
+  [[nodiscard]] auto IsEndOuterJoin() const -> bool override;
+
+private:
+  enum Phase
+  {
+    kProbe,      // streaming the probe side of the current partition
+    kUnmatched,  // emitting unmatched build records of a left outer join built on the left
+    kDone
+  };
+
+  // drain the build side into memory, or into partition files with the probe side once over the budget
+  void Build();
+
+  // index build_recs_ by key hash
+  void BuildTable();
+
+  // load the build records of the next partition and open its probe file, false if all partitions are joined
+  auto LoadNextPartition() -> bool;
+
+  // fetch the next probe record of the current partition into probe_rec_
+  auto FetchProbe() -> bool;
+
+  // produce the next output record into record_, or finish the join
+  void Advance();
+
+  [[nodiscard]] auto KeyHash(const Record &rec, const std::vector<size_t> &key_idx) const -> size_t;
+
+  [[nodiscard]] auto KeyEqual(const Record &build, const Record &probe) const -> bool;
+
+  [[nodiscard]] auto MakeOutput(const Record &build, const Record &probe) const -> RecordUptr;
+
+  [[nodiscard]] auto GetPartitionFile(bool build, size_t partition) const -> std::string;
+
+  void WriteRecord(std::ofstream &file, const Record &rec) const;
+
+  auto ReadRecord(std::ifstream &file, const RecordSchema *schema) const -> RecordUptr;
+
+  void RemovePartitionFiles();
+
+private:
+  RecordSchemaUptr left_key_schema_;
+  RecordSchemaUptr right_key_schema_;
+  bool             build_left_;
+  size_t           mem_budget_;
+  AbstractExecutor *build_child_;
+  AbstractExecutor *probe_child_;
+  // key field indexes in the build and probe records, keys of int and float are hashed as float
+  std::vector<size_t> build_key_idx_;
+  std::vector<size_t> probe_key_idx_;
+  std::vector<bool>   key_as_float_;
+
+  // in-memory hash table over build_recs_, buckets_ holds the first record of each chain plus one, next_ links the
+  // records with the same bucket
+  std::vector<Record> build_recs_;
+  std::vector<size_t> hashes_;
+  std::vector<size_t> buckets_;
+  std::vector<size_t> next_;
+  std::vector<bool>   matched_;
+  size_t              bucket_mask_{0};
+
+  RecordUptr null_rec_;
+  RecordUptr probe_rec_;
+  size_t     probe_hash_{0};
+  size_t     chain_{0};
+  bool       probe_matched_{false};
+  bool       probe_started_{false};
+  size_t     unmatched_pos_{0};
+  Phase      phase_{kDone};
+
+  // grace partitioning
+  bool                          partitioned_{false};
+  size_t                        partition_{0};
+  std::string                   file_prefix_;
+  std::unique_ptr<std::ifstream> probe_file_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_JOIN_HASH_H
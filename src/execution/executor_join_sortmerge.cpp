@@ -27,14 +27,19 @@ SortMergeJoinExecutor::SortMergeJoinExecutor(JoinType join_type, AbstractExecuto
     // condition vec is not used in sort merge join, it has been converted to key schemas
     : JoinExecutor(join_type, std::move(left), std::move(right), {}),
       left_key_schema_(std::move(left_key_schema)),
-      right_key_schema_(std::move(right_key_schema))
+      right_key_schema_(std::move(right_key_schema)),
+      left_encoder_(left_->GetOutSchema(), left_key_schema_.get(), false, right_key_schema_.get()),
+      right_encoder_(right_->GetOutSchema(), right_key_schema_.get(), false, left_key_schema_.get()),
+      left_key_(left_encoder_.GetKeySize(), '\0'),
+      right_key_(right_encoder_.GetKeySize(), '\0')
 {}
 
 auto SortMergeJoinExecutor::Compare(const wsdb::Record &left, const wsdb::Record &right) const -> int
 {
-  auto left_key  = std::make_unique<Record>(left_key_schema_.get(), left);
-  auto right_key = std::make_unique<Record>(right_key_schema_.get(), right);
-  return Record::Compare(*left_key, *right_key);
+  left_encoder_.Encode(left, left_key_.data());
+  right_encoder_.Encode(right, right_key_.data());
+  auto cmp = left_encoder_.Compare(left_key_.data(), right_key_.data());
+  return cmp < 0 ? -1 : (cmp > 0 ? 1 : 0);
 }
 
 void SortMergeJoinExecutor::InitInnerJoin() { WSDB_STUDENT_TODO(l3, f1); }
@@ -28,6 +28,7 @@
 #define WSDB_EXECUTOR_JOIN_SORTMERGE_H
 
 #include "executor_join.h"
+#include "system/handle/key_encoder.h"
 
 namespace wsdb {
 class SortMergeJoinExecutor : public JoinExecutor
@@ -54,6 +55,11 @@ private:
 private:
   RecordSchemaUptr left_key_schema_;
   RecordSchemaUptr right_key_schema_;
+  // keys of both sides are encoded alike so that they compare with memcmp
+  KeyEncoder          left_encoder_;
+  KeyEncoder          right_encoder_;
+  mutable std::string left_key_;
+  mutable std::string right_key_;
 
   // temporarily store record from the left executor
   RecordUptr left_rec_;
@@ -24,11 +24,16 @@
 namespace wsdb {
 LimitExecutor::LimitExecutor(AbstractExecutorUptr child, int limit)
     : AbstractExecutor(Basic), child_(std::move(child)), limit_(limit), count_(0)
-{}
+{
+  vectorized_ = child_->IsVectorized();
+}
 
 void LimitExecutor::Init() { 
     count_ = 0;
     child_->Init();
+    if (vectorized_) {
+        return;
+    }
     if (!child_->IsEnd()) {
         record_ = child_->GetRecord();
     }
@@ -44,6 +49,25 @@ void LimitExecutor::Next() {
     }
 }
 
+auto LimitExecutor::NextChunk() -> ChunkUptr {
+    // 达到上限后不再拉取子节点，避免多余的扫描
+    if (count_ >= limit_) {
+        return nullptr;
+    }
+    auto chunk = child_->NextChunk();
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+    auto remain = static_cast<size_t>(limit_ - count_);
+    if (chunk->GetSelCount() > remain) {
+        auto sel = chunk->GetSel();
+        sel.resize(remain);
+        chunk->SetSel(std::move(sel));
+    }
+    count_ += static_cast<int>(chunk->GetSelCount());
+    return chunk;
+}
+
 [[nodiscard]] auto LimitExecutor::IsEnd() const -> bool { 
     return count_ >= limit_ || child_->IsEnd();
 }
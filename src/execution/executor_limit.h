@@ -39,6 +39,8 @@ public:
 
   void Next() override;
 
+  auto NextChunk() -> ChunkUptr override;
+
   [[nodiscard]] auto IsEnd() const -> bool override;
 
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
@@ -0,0 +1,189 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/31.
+//
+
+#include "executor_load.h"
+
+#include <charconv>
+#include <fstream>
+
+namespace wsdb {
+
+LoadExecutor::LoadExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes, std::string file_name)
+    : AbstractExecutor(DML),
+      tbl_(tbl),
+      indexes_(std::move(indexes)),
+      file_name_(std::move(file_name)),
+      is_end_(false),
+      nullmap_(BITMAP_SIZE(tbl->GetSchema().GetFieldCount())),
+      data_(tbl->GetSchema().GetRecordLength())
+{
+  std::vector<RTField> fields(1);
+  fields[0]   = RTField{.field_ = {.field_name_ = "loaded", .field_size_ = sizeof(int), .field_type_ = TYPE_INT}};
+  out_schema_ = std::make_unique<RecordSchema>(fields);
+}
+
+void LoadExecutor::Init() { WSDB_FETAL("LoadExecutor does not support Init"); }
+
+void LoadExecutor::Next()
+{
+  std::ifstream in(file_name_);
+  if (!in.is_open()) {
+    WSDB_THROW(WSDB_FILE_NOT_EXISTS, file_name_);
+  }
+  int                     count   = 0;
+  size_t                  line_no = 0;
+  std::string             line;
+  std::vector<RecordUptr> batch;
+  batch.reserve(LOAD_BATCH_SIZE);
+  while (std::getline(in, line)) {
+    line_no++;
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      continue;
+    }
+    batch.push_back(ParseLine(line, line_no));
+    count++;
+    if (batch.size() == LOAD_BATCH_SIZE) {
+      Flush(batch);
+    }
+  }
+  Flush(batch);
+  std::vector<ValueSptr> values{ValueFactory::CreateIntValue(count)};
+  record_ = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
+  is_end_ = true;
+}
+
+auto LoadExecutor::IsEnd() const -> bool { return is_end_; }
+
+auto LoadExecutor::ParseLine(const std::string &line, size_t line_no) -> RecordUptr
+{
+  const auto &schema = tbl_->GetSchema();
+  std::fill(nullmap_.begin(), nullmap_.end(), 0);
+  std::fill(data_.begin(), data_.end(), 0);
+  size_t      pos = 0;
+  std::string field;
+  for (size_t i = 0; i < schema.GetFieldCount(); ++i) {
+    if (pos > line.size()) {
+      WSDB_THROW(WSDB_INVALID_SQL,
+          fmt::format("{}:{}: {} fields given for {} columns", file_name_, line_no, i, schema.GetFieldCount()));
+    }
+    // cut the next field
+    field.clear();
+    bool quoted = pos < line.size() && line[pos] == '"';
+    if (quoted) {
+      pos++;
+      while (true) {
+        auto quote = line.find('"', pos);
+        if (quote == std::string::npos) {
+          WSDB_THROW(WSDB_INVALID_SQL, fmt::format("{}:{}: unterminated quote", file_name_, line_no));
+        }
+        field.append(line, pos, quote - pos);
+        pos = quote + 1;
+        if (pos < line.size() && line[pos] == '"') {
+          field.push_back('"');
+          pos++;
+          continue;
+        }
+        break;
+      }
+      if (pos < line.size() && line[pos] != ',') {
+        WSDB_THROW(WSDB_INVALID_SQL, fmt::format("{}:{}: unexpected character after quote", file_name_, line_no));
+      }
+    } else {
+      auto comma = line.find(',', pos);
+      field.assign(line, pos, comma == std::string::npos ? std::string::npos : comma - pos);
+      pos = comma == std::string::npos ? line.size() : comma;
+    }
+    // skip the comma, a field that ends the line moves pos past it
+    pos++;
+
+    auto &rt_field = schema.GetFieldAt(i).field_;
+    if (!quoted && field.empty()) {
+      BitMap::SetBit(nullmap_.data(), i, true);
+      continue;
+    }
+    char       *dst   = data_.data() + schema.GetFieldOffset(i);
+    const char *begin = field.data();
+    const char *end   = field.data() + field.size();
+    bool        valid = true;
+    switch (rt_field.field_type_) {
+      case FieldType::TYPE_INT: {
+        int32_t v   = 0;
+        auto    res = std::from_chars(begin, end, v);
+        valid       = res.ec == std::errc() && res.ptr == end;
+        memcpy(dst, &v, sizeof(v));
+        break;
+      }
+      case FieldType::TYPE_FLOAT: {
+        float v   = 0;
+        auto  res = std::from_chars(begin, end, v);
+        valid     = res.ec == std::errc() && res.ptr == end;
+        memcpy(dst, &v, sizeof(v));
+        break;
+      }
+      case FieldType::TYPE_BOOL: {
+        bool v = field == "1" || field == "true" || field == "TRUE";
+        valid  = v || field == "0" || field == "false" || field == "FALSE";
+        memcpy(dst, &v, sizeof(v));
+        break;
+      }
+      case FieldType::TYPE_STRING: {
+        if (field.size() > rt_field.field_size_) {
+          WSDB_THROW(WSDB_STRING_OVERFLOW,
+              fmt::format("{}:{}: field:{}, size:{}, requested:{}",
+                  file_name_,
+                  line_no,
+                  rt_field.field_name_,
+                  rt_field.field_size_,
+                  field.size()));
+        }
+        memcpy(dst, field.data(), field.size());
+        break;
+      }
+      default: WSDB_FETAL("Unsupported field type");
+    }
+    if (!valid) {
+      WSDB_THROW(WSDB_TYPE_MISSMATCH,
+          fmt::format("{}:{}: {} is not {}", file_name_, line_no, field, FieldTypeToString(rt_field.field_type_)));
+    }
+  }
+  if (pos <= line.size()) {
+    WSDB_THROW(WSDB_INVALID_SQL,
+        fmt::format("{}:{}: more fields than {} columns", file_name_, line_no, schema.GetFieldCount()));
+  }
+  return std::make_unique<Record>(&schema, nullmap_.data(), data_.data(), INVALID_RID);
+}
+
+void LoadExecutor::Flush(std::vector<RecordUptr> &batch)
+{
+  if (batch.empty()) {
+    return;
+  }
+  tbl_->InsertRecords(batch);
+  for (auto *idx : indexes_) {
+    idx->InsertRecords(batch);
+  }
+  batch.clear();
+}
+
+}  // namespace wsdb
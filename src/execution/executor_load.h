@@ -0,0 +1,71 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/31.
+//
+
+/**
+ * @brief Load the rows of a csv file into the table and its indexes, fields are parsed straight into the record layout
+ * and inserted a batch at a time, so pages are filled up one after another and index keys arrive sorted per batch.
+ * An empty field is null, a field can be quoted with " to hold commas, a "" in a quoted field is a literal quote
+ *
+ */
+
+#ifndef WSDB_EXECUTOR_LOAD_H
+#define WSDB_EXECUTOR_LOAD_H
+
+#include "executor_abstract.h"
+#include "system/handle/table_handle.h"
+#include "system/handle/index_handle.h"
+
+namespace wsdb {
+
+class LoadExecutor : public AbstractExecutor
+{
+public:
+  LoadExecutor(TableHandle *tbl, std::list<IndexHandle *> indexes, std::string file_name);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+private:
+  /**
+   * Parse a line of the file into a record of the table schema
+   * @param line
+   * @param line_no used in error messages
+   * @return
+   */
+  auto ParseLine(const std::string &line, size_t line_no) -> RecordUptr;
+
+  void Flush(std::vector<RecordUptr> &batch);
+
+private:
+  TableHandle             *tbl_;
+  std::list<IndexHandle *> indexes_;
+  std::string              file_name_;
+  bool                     is_end_;
+  // reused by every line
+  std::vector<char> nullmap_;
+  std::vector<char> data_;
+};
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_LOAD_H
@@ -27,12 +27,23 @@ ProjectionExecutor::ProjectionExecutor(AbstractExecutorUptr child, RecordSchemaU
     : AbstractExecutor(Basic), child_(std::move(child))
 {
   out_schema_ = std::move(proj_schema);
+  vectorized_ = child_->IsVectorized();
+  if (vectorized_) {
+    for (const auto &field : out_schema_->GetFields()) {
+      auto idx = child_->GetOutSchema()->GetRTFieldIndex(field);
+      WSDB_ASSERT(idx != child_->GetOutSchema()->GetFieldCount(), "Field not found in child schema");
+      col_idx_.push_back(idx);
+    }
+  }
 }
 
 // hint: record_ = std::make_unique<Record>(out_schema_.get(), *child_record);
 
 void ProjectionExecutor::Init() {
     child_->Init();   
+    if (vectorized_) {
+        return;
+    }
     record_ = nullptr;   
     if (!child_->IsEnd()) {
         RecordUptr child_record = child_->GetRecord();
@@ -53,6 +64,20 @@ void ProjectionExecutor::Next() {
     }
 }
 
+auto ProjectionExecutor::NextChunk() -> ChunkUptr {
+    auto chunk = child_->NextChunk();
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+    // 直接复用子节点的列，不拷贝数据，选择向量保持不变
+    std::vector<ArrayValueSptr> cols;
+    cols.reserve(col_idx_.size());
+    for (auto idx : col_idx_) {
+        cols.push_back(chunk->GetCol(static_cast<int>(idx)));
+    }
+    return std::make_unique<Chunk>(out_schema_.get(), std::move(cols), chunk->GetSel());
+}
+
 auto ProjectionExecutor::IsEnd() const -> bool {
     return child_->IsEnd() || record_ == nullptr;
 }
@@ -39,10 +39,14 @@ public:
 
   void Next() override;
 
+  auto NextChunk() -> ChunkUptr override;
+
   [[nodiscard]] auto IsEnd() const -> bool override;
 
 private:
   AbstractExecutorUptr child_;
+  // index of each output field in the child schema, used to pick columns from child chunks
+  std::vector<size_t> col_idx_;
 };
 }  // namespace wsdb
 
@@ -23,9 +23,19 @@
 
 namespace wsdb {
 
-SeqScanExecutor::SeqScanExecutor(TableHandle *tab) : AbstractExecutor(Basic), tab_(tab) {}
+SeqScanExecutor::SeqScanExecutor(TableHandle *tab, bool vectorized) : AbstractExecutor(Basic), tab_(tab)
+{
+  WSDB_ASSERT(!vectorized || tab_->GetStorageModel() == PAX_MODEL, "vectorized scan needs a pax table");
+  vectorized_ = vectorized;
+}
 
 void SeqScanExecutor::Init() {
+    if (vectorized_) {
+        // 向量化模式下逐页读取，从第一个数据页开始
+        chunk_pid_ = FILE_HEADER_PAGE_ID + 1;
+        is_end_ = false;
+        return;
+    }
     rid_ = tab_->GetFirstRID();
     is_end_ = (rid_ == INVALID_RID);
     record_ = nullptr;
@@ -53,7 +63,31 @@ void SeqScanExecutor::Next() {
     }
 }
 
+auto SeqScanExecutor::NextChunk() -> ChunkUptr {
+    ChunkUptr chunk = nullptr;
+    auto page_num = static_cast<page_id_t>(tab_->GetTableHeader().page_num_);
+    // 合并若干整页的列数据，直到凑满 CHUNK_SIZE 行或扫描结束
+    while (chunk_pid_ < page_num && (chunk == nullptr || chunk->GetSelCount() < CHUNK_SIZE)) {
+        auto page_chunk = tab_->GetChunk(chunk_pid_++, &tab_->GetSchema());
+        if (page_chunk->GetSelCount() == 0) {
+            continue;
+        }
+        if (chunk == nullptr) {
+            chunk = std::move(page_chunk);
+        } else {
+            chunk->Append(*page_chunk);
+        }
+    }
+    if (chunk == nullptr) {
+        is_end_ = true;
+    }
+    return chunk;
+}
+
 auto SeqScanExecutor::IsEnd() const -> bool {
+    if (vectorized_) {
+        return is_end_;
+    }
     return is_end_ || record_ == nullptr;
 }
 
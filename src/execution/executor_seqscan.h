@@ -33,12 +33,18 @@ namespace wsdb {
 class SeqScanExecutor : public AbstractExecutor
 {
 public:
-  explicit SeqScanExecutor(TableHandle *tab);
+  /**
+   * @param tab
+   * @param vectorized scan the table page by page through NextChunk, the table must be stored in PAX_MODEL
+   */
+  explicit SeqScanExecutor(TableHandle *tab, bool vectorized = false);
 
   void Init() override;
 
   void Next() override;
 
+  auto NextChunk() -> ChunkUptr override;
+
   [[nodiscard]] auto IsEnd() const -> bool override;
 
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
@@ -47,6 +53,8 @@ private:
   TableHandle *tab_;
   RID          rid_;
   bool is_end_{false};
+  // next page to read in vectorized mode
+  page_id_t chunk_pid_{INVALID_PAGE_ID};
 };
 }  // namespace wsdb
 
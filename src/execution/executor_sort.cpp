@@ -18,125 +18,385 @@
 //
 // Created by ziqi on 2024/8/5.
 //
-#include <unistd.h>
-#include "common/config.h"
 #include "executor_sort.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <future>
 
 static long long sort_result_fresh_id_ = 0;
 #define SORT_FILE_PATH(obj_name) FILE_NAME(TMP_DIR, obj_name, TMP_SUFFIX)
 
 namespace wsdb {
-SortExecutor::SortExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc)
+SortExecutor::SortExecutor(
+    AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc, size_t buffer_size, size_t worker_num)
     : AbstractExecutor(Basic),
       child_(std::move(child)),
       key_schema_(std::move(key_schema)),
+      encoder_(child_->GetOutSchema(), key_schema_.get(), is_desc),
       buf_idx_(0),
       is_desc_(is_desc),
-      is_sorted_(false),
       is_merge_sort_(false),
-      max_rec_num_(SORT_BUFFER_SIZE / child_->GetOutSchema()->GetRecordLength()),
-      tmp_file_num_(0),
-      merge_result_file_(fmt::format("sort_result_{}", sort_result_fresh_id_++))
+      max_rec_num_(0),
+      worker_num_(std::max<size_t>(worker_num, 1)),
+      key_size_(encoder_.GetKeySize()),
+      nullmap_size_(BITMAP_SIZE(child_->GetOutSchema()->GetFieldCount())),
+      rec_size_(key_size_ + nullmap_size_ + child_->GetOutSchema()->GetRecordLength()),
+      merge_result_file_(fmt::format("sort_result_{}", sort_result_fresh_id_++)),
+      merge_pass_(0)
 {
-  // comment the line below after testing
-  //  max_rec_num_ = 10;
+  // memory held by one buffered record, the packed record plus its entry
+  max_rec_num_ = std::max<size_t>(buffer_size / (rec_size_ + sizeof(SortEntry)), 1);
 }
 
-SortExecutor::~SortExecutor()
+SortExecutor::~SortExecutor() { RemoveRuns(); }
+
+void SortExecutor::Init()
 {
-  if (is_merge_sort_) {
-    // TODO: do some clean up, e.g. close the result file
-    WSDB_STUDENT_TODO(l2, f1);
+  RemoveRuns();
+  buf_idx_       = 0;
+  is_merge_sort_ = false;
+  merge_pass_    = 0;
+  record_        = nullptr;
+  sort_buffer_.clear();
+  sorted_recs_.clear();
+  child_->Init();
+  // buffer the child until it is exhausted or the buffer is full, only a child that does not fit is spilled
+  for (; !child_->IsEnd() && sort_buffer_.size() < max_rec_num_ * rec_size_; child_->Next()) {
+    PackRecord(sort_buffer_);
+  }
+  if (!child_->IsEnd()) {
+    is_merge_sort_ = true;
+    GenerateRuns();
+    Merge();
+    LoadMergeResult();
+    return;
   }
+  sorted_recs_ = MakeEntries(sort_buffer_);
+  SortRecords(sorted_recs_);
+  LoadBufferResult();
 }
 
-void SortExecutor::Init() {
-  // TODO: decide whether to use merge sort according to the cardinality of the child. 
-  is_merge_sort_ = false;
+void SortExecutor::Next()
+{
   if (is_merge_sort_) {
-    WSDB_STUDENT_TODO(l2, f1);
+    if (!merger_->IsEnd()) {
+      merger_->Pop();
+    }
+    LoadMergeResult();
+    return;
+  }
+  buf_idx_++;
+  LoadBufferResult();
+}
+
+auto SortExecutor::IsEnd() const -> bool { return record_ == nullptr; }
+
+auto SortExecutor::Compare(const SortEntry &lhs, const SortEntry &rhs) const -> bool
+{
+  if (lhs.prefix_ != rhs.prefix_) {
+    return lhs.prefix_ < rhs.prefix_;
+  }
+  return key_size_ > sizeof(uint64_t) && CompareKeys(lhs.rec_, rhs.rec_) < 0;
+}
+
+void SortExecutor::PackRecord(std::vector<char> &buffer)
+{
+  auto record = child_->GetRecord();
+  if (record == nullptr) {
     return;
   }
-  buf_idx_ = 0;
-  is_sorted_ = false;
+  auto off = buffer.size();
+  buffer.resize(off + rec_size_);
+  auto rec = buffer.data() + off;
+  encoder_.Encode(*record, rec);
+  std::memcpy(rec + key_size_, record->GetNullMap(), nullmap_size_);
+  std::memcpy(rec + key_size_ + nullmap_size_, record->GetData(), rec_size_ - key_size_ - nullmap_size_);
+}
+
+auto SortExecutor::MakeEntries(const std::vector<char> &buffer) const -> std::vector<SortEntry>
+{
+  std::vector<SortEntry> entries;
+  entries.reserve(buffer.size() / rec_size_);
+  for (size_t off = 0; off < buffer.size(); off += rec_size_) {
+    entries.push_back({encoder_.Prefix(buffer.data() + off), buffer.data() + off});
+  }
+  return entries;
+}
+
+void SortExecutor::LoadBufferResult()
+{
+  if (buf_idx_ >= sorted_recs_.size()) {
+    record_ = nullptr;
+    return;
+  }
+  auto rec = sorted_recs_[buf_idx_].rec_ + key_size_;
+  record_  = std::make_unique<Record>(GetOutSchema(), rec, rec + nullmap_size_, INVALID_RID);
+}
+
+auto SortExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
+
+void SortExecutor::SortRecords(std::vector<SortEntry> &records) const
+{
+  auto less = [this](const SortEntry &lhs, const SortEntry &rhs) { return Compare(lhs, rhs); };
+  // a slice smaller than a chunk is not worth a thread
+  auto slice_num = std::min(worker_num_, records.size() / CHUNK_SIZE);
+  if (slice_num <= 1) {
+    std::stable_sort(records.begin(), records.end(), less);
+    return;
+  }
+  std::vector<size_t> bounds(slice_num + 1);
+  for (size_t i = 0; i <= slice_num; ++i) {
+    bounds[i] = records.size() * i / slice_num;
+  }
+  auto                           begin = records.begin();
+  std::vector<std::future<void>> tasks;
+  for (size_t i = 0; i < slice_num; ++i) {
+    tasks.push_back(std::async(std::launch::async,
+        [&, i]() { std::stable_sort(begin + bounds[i], begin + bounds[i + 1], less); }));
+  }
+  for (auto &task : tasks) {
+    task.get();
+  }
+  // merge neighbouring slices pairwise until one is left, the merges of a round touch disjoint ranges
+  for (size_t width = 1; width < slice_num; width *= 2) {
+    tasks.clear();
+    for (size_t i = 0; i + width < slice_num; i += 2 * width) {
+      auto first = bounds[i];
+      auto mid   = bounds[i + width];
+      auto last  = bounds[std::min(i + 2 * width, slice_num)];
+      tasks.push_back(std::async(std::launch::async,
+          [&, first, mid, last]() { std::inplace_merge(begin + first, begin + mid, begin + last, less); }));
+    }
+    for (auto &task : tasks) {
+      task.get();
+    }
+  }
+}
+
+/// methods below are only used for merge sort
+
+auto SortExecutor::GetSortFileName(size_t file_group, size_t file_idx) const -> std::string
+{
+  return SORT_FILE_PATH(fmt::format("{}_{}_{}", merge_result_file_, file_group, file_idx));
+}
+
+void SortExecutor::DumpRun(std::vector<char> buffer, const std::string &file_name) const
+{
+  auto records = MakeEntries(buffer);
+  auto less    = [this](const SortEntry &lhs, const SortEntry &rhs) { return Compare(lhs, rhs); };
+  std::stable_sort(records.begin(), records.end(), less);
+  RunWriter writer(file_name, rec_size_);
+  for (const auto &entry : records) {
+    writer.Append(entry.rec_);
+  }
+  writer.Flush();
+}
+
+void SortExecutor::GenerateRuns()
+{
+  std::filesystem::create_directories(TMP_DIR);
+  // the buffer is shared by the run being read and the runs being sorted, so a run is a slice of it
+  auto run_size = std::max<size_t>(max_rec_num_ / (worker_num_ + 1), 1) * rec_size_;
+  std::deque<std::future<void>> tasks;
+  auto                          submit = [this, &tasks](std::vector<char> run) {
+    if (tasks.size() >= worker_num_) {
+      tasks.front().get();
+      tasks.pop_front();
+    }
+    runs_.push_back(GetSortFileName(0, runs_.size()));
+    tasks.push_back(std::async(std::launch::async,
+        [this, run = std::move(run), file_name = runs_.back()]() mutable { DumpRun(std::move(run), file_name); }));
+  };
+  // hand the full buffer to the workers first so they are busy while the rest of the child is read
+  for (size_t begin = 0; begin < sort_buffer_.size(); begin += run_size) {
+    auto end = std::min(begin + run_size, sort_buffer_.size());
+    submit(std::vector<char>(sort_buffer_.begin() + static_cast<ptrdiff_t>(begin),
+        sort_buffer_.begin() + static_cast<ptrdiff_t>(end)));
+  }
   sort_buffer_.clear();
-  child_->Init();
-  while (!child_->IsEnd()) {
-    auto record = child_->GetRecord();
-    if (record != nullptr) {
-      sort_buffer_.push_back(std::move(record));
+  sort_buffer_.shrink_to_fit();
+  std::vector<char> run;
+  run.reserve(run_size);
+  for (; !child_->IsEnd(); child_->Next()) {
+    PackRecord(run);
+    if (run.size() >= run_size) {
+      submit(std::move(run));
+      run = std::vector<char>();
+      run.reserve(run_size);
     }
-    child_->Next();
   }
-  if (!sort_buffer_.empty()) {
-    SortBuffer();
-    is_sorted_ = true;
-    record_ = std::make_unique<Record>(*sort_buffer_[0]);
+  if (!run.empty()) {
+    submit(std::move(run));
+  }
+  for (auto &task : tasks) {
+    task.get();
   }
 }
 
-void SortExecutor::Next() {
-  if (is_merge_sort_) {
-    WSDB_STUDENT_TODO(L2, f1);
-    return;
+void SortExecutor::Merge()
+{
+  while (runs_.size() > SORT_WAY_NUM) {
+    merge_pass_++;
+    std::vector<std::string>      merged;
+    std::vector<std::string>      obsolete;
+    std::deque<std::future<void>> tasks;
+    for (size_t begin = 0; begin < runs_.size(); begin += SORT_WAY_NUM) {
+      auto                     end = std::min(begin + SORT_WAY_NUM, runs_.size());
+      std::vector<std::string> group(
+          runs_.begin() + static_cast<ptrdiff_t>(begin), runs_.begin() + static_cast<ptrdiff_t>(end));
+      if (group.size() == 1) {
+        // a lone run is already merged
+        merged.push_back(group[0]);
+        continue;
+      }
+      obsolete.insert(obsolete.end(), group.begin(), group.end());
+      merged.push_back(GetSortFileName(merge_pass_, merged.size()));
+      if (tasks.size() >= worker_num_) {
+        tasks.front().get();
+        tasks.pop_front();
+      }
+      tasks.push_back(std::async(std::launch::async, [this, group = std::move(group), file_name = merged.back()]() {
+        RunMerger merger(this, group);
+        RunWriter writer(file_name, rec_size_);
+        for (; !merger.IsEnd(); merger.Pop()) {
+          writer.Append(merger.Top());
+        }
+        writer.Flush();
+      }));
+    }
+    for (auto &task : tasks) {
+      task.get();
+    }
+    std::error_code ec;
+    for (const auto &file_name : obsolete) {
+      std::filesystem::remove(file_name, ec);
+    }
+    runs_ = std::move(merged);
   }
+  // the last pass is merged while the parent pulls records
+  merger_ = std::make_unique<RunMerger>(this, runs_);
+}
 
-  if (!is_sorted_ || buf_idx_ >= sort_buffer_.size() - 1) {
+void SortExecutor::LoadMergeResult()
+{
+  if (merger_->IsEnd()) {
     record_ = nullptr;
     return;
   }
+  auto top = merger_->Top() + key_size_;
+  record_  = std::make_unique<Record>(GetOutSchema(), top, top + nullmap_size_, INVALID_RID);
+}
 
-  buf_idx_++;
-  if (buf_idx_ < sort_buffer_.size()) {
-    record_ = std::make_unique<Record>(*sort_buffer_[buf_idx_]);
-  } else {
-    record_ = nullptr;
+void SortExecutor::RemoveRuns()
+{
+  merger_ = nullptr;
+  std::error_code ec;
+  for (const auto &file_name : runs_) {
+    std::filesystem::remove(file_name, ec);
   }
+  runs_.clear();
 }
 
-auto SortExecutor::IsEnd() const -> bool {
-  if (is_merge_sort_) {
-    WSDB_STUDENT_TODO(L2, f1);
-    return true;
+SortExecutor::RunReader::RunReader(const std::string &file_name, size_t rec_size)
+    : file_(file_name, std::ios::binary), rec_size_(rec_size)
+{
+  if (!file_.is_open()) {
+    WSDB_THROW(WSDB_FILE_NOT_OPEN, file_name);
   }
-  
-  return !is_sorted_ || record_ == nullptr || buf_idx_ >= sort_buffer_.size();
+  buf_.resize(std::max<size_t>(SORT_IO_BLOCK_SIZE / rec_size_, 1) * rec_size_);
+  LoadBlock();
 }
 
-auto SortExecutor::Compare(const Record &lhs, const Record &rhs) const -> bool
+void SortExecutor::RunReader::Next()
 {
-  auto lkey = std::make_unique<Record>(key_schema_.get(), lhs);
-  auto rkey = std::make_unique<Record>(key_schema_.get(), rhs);
-  return is_desc_ ? Record::Compare(*lkey, *rkey) > 0 : lkey->Compare(*lkey, *rkey) < 0;
+  pos_ += rec_size_;
+  if (pos_ >= end_) {
+    LoadBlock();
+  }
 }
 
-auto SortExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
+void SortExecutor::RunReader::LoadBlock()
+{
+  file_.read(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+  end_ = static_cast<size_t>(file_.gcount());
+  end_ -= end_ % rec_size_;
+  pos_ = 0;
+}
 
-/// methods below are only used for merge sort
+SortExecutor::RunWriter::RunWriter(const std::string &file_name, size_t rec_size)
+    : file_(file_name, std::ios::binary | std::ios::trunc), rec_size_(rec_size)
+{
+  if (!file_.is_open()) {
+    WSDB_THROW(WSDB_FILE_NOT_OPEN, file_name);
+  }
+  buf_.resize(std::max<size_t>(SORT_IO_BLOCK_SIZE / rec_size_, 1) * rec_size_);
+}
 
-auto SortExecutor::GetSortFileName(size_t file_group, size_t file_idx) const -> std::string
+void SortExecutor::RunWriter::Append(const char *rec)
 {
-  return fmt::format("{}_{}_{}", merge_result_file_, file_group, file_idx);
+  if (pos_ + rec_size_ > buf_.size()) {
+    Flush();
+  }
+  std::memcpy(buf_.data() + pos_, rec, rec_size_);
+  pos_ += rec_size_;
 }
 
-void SortExecutor::SortBuffer() {
-  std::sort(sort_buffer_.begin(), sort_buffer_.end(), 
-    [this](const RecordUptr& a, const RecordUptr& b) {
-      return this->Compare(*a, *b);
-    });
+void SortExecutor::RunWriter::Flush()
+{
+  file_.write(buf_.data(), static_cast<std::streamsize>(pos_));
+  if (!file_) {
+    WSDB_THROW(WSDB_FILE_WRITE_ERROR, "failed to write sort run");
+  }
+  pos_ = 0;
 }
 
-void SortExecutor::DumpBufferToFile(size_t file_idx) { WSDB_STUDENT_TODO(L2, f1); }
+SortExecutor::RunMerger::RunMerger(const SortExecutor *sorter, const std::vector<std::string> &runs) : sorter_(sorter)
+{
+  WSDB_ASSERT(!runs.empty(), "no run to merge");
+  for (const auto &run : runs) {
+    readers_.push_back(std::make_unique<RunReader>(run, sorter_->rec_size_));
+  }
+  // leaf readers_.size() is a virtual leaf smaller than any record, it fills the tree so that playing every real
+  // leaf once pushes it out and leaves the losers of each match behind
+  tree_.assign(readers_.size(), readers_.size());
+  for (size_t leaf = readers_.size(); leaf-- > 0;) {
+    Replay(leaf);
+  }
+}
 
-void SortExecutor::LoadMergeResult() { WSDB_STUDENT_TODO(L2, f1); }
+void SortExecutor::RunMerger::Pop()
+{
+  auto leaf = tree_[0];
+  readers_[leaf]->Next();
+  Replay(leaf);
+}
 
-void SortExecutor::Merge()
+auto SortExecutor::RunMerger::Less(size_t lhs, size_t rhs) const -> bool
+{
+  auto virtual_leaf = readers_.size();
+  if (lhs == virtual_leaf || rhs == virtual_leaf) {
+    return lhs == virtual_leaf && rhs != virtual_leaf;
+  }
+  // an exhausted run is larger than any record
+  if (readers_[lhs]->IsEnd() || readers_[rhs]->IsEnd()) {
+    return !readers_[lhs]->IsEnd();
+  }
+  auto cmp = sorter_->CompareKeys(readers_[lhs]->Get(), readers_[rhs]->Get());
+  return cmp != 0 ? cmp < 0 : lhs < rhs;
+}
+
+void SortExecutor::RunMerger::Replay(size_t leaf)
 {
-  // 1. create a heap according to is_desc_
-  // 2. read the first tuple from each file
-  // 3. pop the top of the heap and write to file: group 1, file: file_index
-  // run until all runs are exhausted, then read tuples from group 1, file 0, write to group 0, file 0 ...
-  WSDB_STUDENT_TODO(L2, f1);
+  // play the new record of the leaf against the loser kept at each node up to the root, the winner moves on
+  auto winner = leaf;
+  for (auto node = (leaf + readers_.size()) / 2; node > 0; node /= 2) {
+    if (Less(tree_[node], winner)) {
+      std::swap(tree_[node], winner);
+    }
+  }
+  tree_[0] = winner;
 }
 
-}  // namespace wsdb
\ No newline at end of file
+}  // namespace wsdb
@@ -26,17 +26,27 @@
 
 #ifndef WSDB_EXECUTOR_SORT_H
 #define WSDB_EXECUTOR_SORT_H
-#include <functional>
 #include <fstream>
 #include <utility>
+#include "common/config.h"
 #include "executor_abstract.h"
+#include "system/handle/key_encoder.h"
 
 namespace wsdb {
 
 class SortExecutor : public AbstractExecutor
 {
 public:
-  SortExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc);
+  /**
+   * @param child
+   * @param key_schema fields of the child to sort by
+   * @param is_desc
+   * @param buffer_size memory used to buffer records, a child larger than that is sorted into runs in tmp files and
+   * merged
+   * @param worker_num threads sorting buffers in parallel
+   */
+  SortExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc,
+      size_t buffer_size = SORT_BUFFER_SIZE, size_t worker_num = SORT_WORKER_NUM);
 
   ~SortExecutor() override;
 
@@ -48,101 +58,139 @@ public:
 
   [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
 
+  /// whether the last Init spilled runs to tmp files
+  [[nodiscard]] auto IsMergeSort() const -> bool { return is_merge_sort_; }
+
 private:
-  /// @brief  Sort heap node for merge sort algorithm, ignore it in l2.t1
-  class SortHeapNode
+  /// @brief Sequential reader of a run file, records are read a block at a time and handed out in place
+  class RunReader
   {
   public:
-    SortHeapNode() = delete;
-
-    SortHeapNode(std::shared_ptr<std::ifstream> file_handle, const RecordSchema *schema, size_t rec_idx)
-        : file_handle_(std::move(file_handle)), schema_(schema), rec_idx_(rec_idx), record_(nullptr)
-    {}
-
-    SortHeapNode(const SortHeapNode &other)
-    {
-      file_handle_ = other.file_handle_;
-      schema_      = other.schema_;
-      rec_idx_     = other.rec_idx_;
-      record_      = std::make_unique<Record>(*other.record_);
-    }
-
-    SortHeapNode(SortHeapNode &&other) noexcept
-    {
-      file_handle_ = std::move(other.file_handle_);
-      schema_      = other.schema_;
-      rec_idx_     = other.rec_idx_;
-      record_      = std::move(other.record_);
-    }
-
-    auto operator=(const SortHeapNode &other) -> SortHeapNode &
-    {
-      if (this == &other) {
-        return *this;
-      }
-      file_handle_ = other.file_handle_;
-      schema_      = other.schema_;
-      rec_idx_     = other.rec_idx_;
-      record_      = std::make_unique<Record>(*other.record_);
-      return *this;
-    }
-
-    /**
-     * Load the next record from the file
-     * @param max_rec_num
-     * @return true if the record is loaded successfully, false if the file is end or idx exceeds the max record number
-     */
-    auto LoadNextRecord(size_t max_rec_num) -> bool
-    {
-      WSDB_ASSERT(file_handle_ != nullptr, "file_handle_ is nullptr");
-      WSDB_ASSERT(file_handle_->is_open(), "file_handle_ is not open");
-
-      WSDB_STUDENT_TODO(l2, f1);
-    }
-
-    [[nodiscard]] auto GetRecord() const -> const RecordUptr & { return record_; }
-
-    void CloseFile()
-    {
-      WSDB_ASSERT(file_handle_ != nullptr, "file_handle_ is nullptr");
-      file_handle_->close();
-      file_handle_ = nullptr;
-    }
+    RunReader(const std::string &file_name, size_t rec_size);
+
+    [[nodiscard]] auto IsEnd() const -> bool { return pos_ >= end_; }
+
+    /// the current packed record
+    [[nodiscard]] auto Get() const -> const char * { return buf_.data() + pos_; }
+
+    void Next();
 
   private:
-    std::shared_ptr<std::ifstream> file_handle_;
-    const RecordSchema            *schema_;   // schema of the record
-    size_t                         rec_idx_;  // index of the record in the file
-    RecordUptr                     record_;   // record
+    void LoadBlock();
+
+    std::ifstream     file_;
+    size_t            rec_size_;
+    std::vector<char> buf_;
+    size_t            pos_{0};
+    size_t            end_{0};
+  };
+
+  /// @brief Sequential writer of a run file, records are appended to a block that is written once it is full
+  class RunWriter
+  {
+  public:
+    RunWriter(const std::string &file_name, size_t rec_size);
+
+    /// append a packed record
+    void Append(const char *rec);
+
+    void Flush();
+
+  private:
+    std::ofstream     file_;
+    size_t            rec_size_;
+    std::vector<char> buf_;
+    size_t            pos_{0};
+  };
+
+  /**
+   * @brief K-way merge of runs with a loser tree, tree_[0] holds the leaf of the smallest record and every inner node
+   * the leaf that lost the match played there, so popping a record replays only the path of its leaf. Ties go to the
+   * earlier run, which keeps the merge stable
+   */
+  class RunMerger
+  {
+  public:
+    RunMerger(const SortExecutor *sorter, const std::vector<std::string> &runs);
+
+    [[nodiscard]] auto IsEnd() const -> bool { return readers_[tree_[0]]->IsEnd(); }
+
+    /// the smallest packed record
+    [[nodiscard]] auto Top() const -> const char * { return readers_[tree_[0]]->Get(); }
+
+    void Pop();
+
+  private:
+    [[nodiscard]] auto Less(size_t lhs, size_t rhs) const -> bool;
+
+    void Replay(size_t leaf);
+
+    const SortExecutor                      *sorter_;
+    std::vector<std::unique_ptr<RunReader>> readers_;
+    std::vector<size_t>                     tree_;
+  };
+
+  /// @brief A buffered record to sort, the prefix of its key settles most comparisons without touching the record
+  struct SortEntry
+  {
+    uint64_t    prefix_;
+    const char *rec_;
   };
 
 private:
   [[nodiscard]] inline auto GetSortFileName(size_t file_group, size_t file_idx) const -> std::string;
 
-  [[nodiscard]] inline auto Compare(const Record &lhs, const Record &rhs) const -> bool;
+  /**
+   * Three-way comparison of two packed records, i.e. the encoded sort key followed by the null map and the data
+   */
+  [[nodiscard]] auto CompareKeys(const char *lhs, const char *rhs) const -> int { return encoder_.Compare(lhs, rhs); }
+
+  [[nodiscard]] inline auto Compare(const SortEntry &lhs, const SortEntry &rhs) const -> bool;
+
+  /// append the current record of the child to a buffer of packed records
+  void PackRecord(std::vector<char> &buffer);
+
+  [[nodiscard]] auto MakeEntries(const std::vector<char> &buffer) const -> std::vector<SortEntry>;
+
+  /// stable sort of packed records, slices of large inputs are sorted on worker threads and merged
+  void SortRecords(std::vector<SortEntry> &records) const;
+
+  /// sort one buffer of packed records and write it to a tmp file as a run
+  void DumpRun(std::vector<char> buffer, const std::string &file_name) const;
+
+  /// read the rest of the child into runs, sorted and written by the workers while the child is read
+  void GenerateRuns();
 
-  void SortBuffer();
+  /// merge runs SORT_WAY_NUM at a time until the rest can be merged while emitting records
+  void Merge();
 
-  void DumpBufferToFile(size_t file_idx);
+  void LoadBufferResult();
 
   void LoadMergeResult();
 
-  inline void Merge();
+  void RemoveRuns();
 
 private:
-  AbstractExecutorUptr    child_;
-  RecordSchemaUptr        key_schema_;
-  std::vector<RecordUptr> sort_buffer_;
-  size_t                  buf_idx_;
-  bool                    is_desc_;
-  bool                    is_sorted_;
-  // use for merge sort, if you want to use merge sort, set it to true if the record number is larger than max_rec_num_
-  bool        is_merge_sort_;
-  size_t      max_rec_num_;
-  size_t      tmp_file_num_;
-  std::string merge_result_file_;
-  // we use file stream instead of disk manager to obtain faster sort speed;
-  std::unique_ptr<std::ifstream> merge_result_file_handle_;
+  AbstractExecutorUptr child_;
+  RecordSchemaUptr     key_schema_;
+  KeyEncoder           encoder_;
+  // records are buffered packed, i.e. the encoded sort key followed by the null map and the data, and sorted by
+  // pointer
+  std::vector<char>      sort_buffer_;
+  std::vector<SortEntry> sorted_recs_;
+  size_t                 buf_idx_;
+  bool                   is_desc_;
+  bool                   is_merge_sort_;
+  size_t                 max_rec_num_;
+  size_t                 worker_num_;
+  size_t                 key_size_;
+  size_t                 nullmap_size_;
+  size_t                 rec_size_;  // size of a packed record, also the size of a record in a run file
+  std::string            merge_result_file_;
+  // we use file streams instead of the disk manager to obtain faster sort speed
+  std::vector<std::string>   runs_;
+  size_t                     merge_pass_;
+  std::unique_ptr<RunMerger> merger_;
 };
 
 }  // namespace wsdb
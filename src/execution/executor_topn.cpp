@@ -0,0 +1,91 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/27.
+//
+
+#include "executor_topn.h"
+#include <algorithm>
+
+namespace wsdb {
+
+TopNExecutor::TopNExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc, size_t limit)
+    : AbstractExecutor(Basic),
+      child_(std::move(child)),
+      key_schema_(std::move(key_schema)),
+      encoder_(child_->GetOutSchema(), key_schema_.get(), is_desc),
+      limit_(limit)
+{}
+
+void TopNExecutor::Init()
+{
+  heap_.clear();
+  heap_idx_ = 0;
+  record_   = nullptr;
+  auto        less = [this](const HeapEntry &lhs, const HeapEntry &rhs) { return Less(lhs, rhs); };
+  std::string key(encoder_.GetKeySize(), '\0');
+  size_t      seq = 0;
+  for (child_->Init(); !child_->IsEnd() && limit_ > 0; child_->Next(), ++seq) {
+    auto rec = child_->GetRecord();
+    if (rec == nullptr) {
+      continue;
+    }
+    encoder_.Encode(*rec, key.data());
+    if (heap_.size() < limit_) {
+      heap_.push_back({key, seq, std::move(rec)});
+      std::push_heap(heap_.begin(), heap_.end(), less);
+      continue;
+    }
+    // a later record with an equal key never beats the top, it would come after it in a stable sort
+    if (encoder_.Compare(key.data(), heap_.front().key_.data()) >= 0) {
+      continue;
+    }
+    // replace the worst kept record, its entry is reused so the heap does not allocate once it is full
+    std::pop_heap(heap_.begin(), heap_.end(), less);
+    heap_.back().key_.swap(key);
+    heap_.back().seq_ = seq;
+    heap_.back().rec_ = std::move(rec);
+    std::push_heap(heap_.begin(), heap_.end(), less);
+  }
+  std::sort_heap(heap_.begin(), heap_.end(), less);
+  if (!heap_.empty()) {
+    record_ = std::move(heap_[0].rec_);
+  }
+}
+
+void TopNExecutor::Next()
+{
+  // every record is handed out once, so it can be moved out of the heap
+  if (++heap_idx_ < heap_.size()) {
+    record_ = std::move(heap_[heap_idx_].rec_);
+  } else {
+    record_ = nullptr;
+  }
+}
+
+auto TopNExecutor::IsEnd() const -> bool { return record_ == nullptr; }
+
+auto TopNExecutor::GetOutSchema() const -> const RecordSchema * { return child_->GetOutSchema(); }
+
+auto TopNExecutor::Less(const HeapEntry &lhs, const HeapEntry &rhs) const -> bool
+{
+  auto cmp = encoder_.Compare(lhs.key_.data(), rhs.key_.data());
+  return cmp != 0 ? cmp < 0 : lhs.seq_ < rhs.seq_;
+}
+
+}  // namespace wsdb
@@ -0,0 +1,73 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/27.
+//
+
+/**
+ * @brief Return the first limit records of the child in the order of the keys, i.e. a sort followed by a limit.
+ * Only a heap of the best limit records seen so far is kept, so the child is never materialized
+ *
+ */
+
+#ifndef WSDB_EXECUTOR_TOPN_H
+#define WSDB_EXECUTOR_TOPN_H
+
+#include "executor_abstract.h"
+#include "system/handle/key_encoder.h"
+
+namespace wsdb {
+
+class TopNExecutor : public AbstractExecutor
+{
+public:
+  TopNExecutor(AbstractExecutorUptr child, RecordSchemaUptr key_schema, bool is_desc, size_t limit);
+
+  void Init() override;
+
+  void Next() override;
+
+  [[nodiscard]] auto IsEnd() const -> bool override;
+
+  [[nodiscard]] auto GetOutSchema() const -> const RecordSchema * override;
+
+private:
+  /// @brief A kept record, records with equal keys are ordered by their position in the child like a stable sort
+  struct HeapEntry
+  {
+    std::string key_;
+    size_t      seq_;
+    RecordUptr  rec_;
+  };
+
+  /// whether lhs goes before rhs in the output
+  [[nodiscard]] auto Less(const HeapEntry &lhs, const HeapEntry &rhs) const -> bool;
+
+private:
+  AbstractExecutorUptr child_;
+  RecordSchemaUptr     key_schema_;
+  KeyEncoder           encoder_;
+  size_t               limit_;
+  // max-heap while reading the child, so the worst kept record is on top, sorted once the child is exhausted
+  std::vector<HeapEntry> heap_;
+  size_t                 heap_idx_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_EXECUTOR_TOPN_H
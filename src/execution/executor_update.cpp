@@ -45,20 +45,21 @@ void UpdateExecutor::Next() {
   }
 
   int count = 0;
-  child_->Init();
-
-  while (!child_->IsEnd()) {
-    auto old_rec_ptr = child_->GetRecord();
-    if (old_rec_ptr == nullptr) {
-      child_->Next();
-      continue;
+  // 先收集所有待更新的记录，索引扫描时更新后的键可能排在后面，边扫描边更新会重复更新同一条记录
+  std::vector<Record> old_recs;
+  for (child_->Init(); !child_->IsEnd(); child_->Next()) {
+    if (auto rec = child_->GetRecord(); rec != nullptr) {
+      old_recs.push_back(std::move(*rec));
     }
-    const RecordSchema *schema = old_rec_ptr->GetSchema();
-    RID old_rid = old_rec_ptr->GetRID();
+  }
+
+  for (const auto &old_rec : old_recs) {
+    const RecordSchema *schema = old_rec.GetSchema();
+    RID old_rid = old_rec.GetRID();
     std::vector<ValueSptr> new_values;
     new_values.reserve(schema->GetFieldCount());
     for (size_t i = 0; i < schema->GetFieldCount(); i++) {
-      new_values.push_back(old_rec_ptr->GetValueAt(i));
+      new_values.push_back(old_rec.GetValueAt(i));
     }
     for (const auto &[field, new_value] : updates_) {
       size_t field_idx = schema->GetRTFieldIndex(field);
@@ -69,14 +70,11 @@ void UpdateExecutor::Next() {
     Record new_rec(schema, new_values, old_rid);
     for (auto *idx : indexes_) {
       if (idx != nullptr) {
-        idx->UpdateRecord(*old_rec_ptr, new_rec);
+        idx->UpdateRecord(old_rec, new_rec);
       }
     }
     tbl_->UpdateRecord(old_rid, new_rec);
     count++;
-
-
-    child_->Next();
   }
   std::vector<ValueSptr> values{ValueFactory::CreateIntValue(count)};
   record_ = std::make_unique<Record>(out_schema_.get(), values, INVALID_RID);
@@ -0,0 +1,325 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/20.
+//
+
+#include "compiled_condition.h"
+#include "condition_expr.h"
+#include "common/config.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+namespace wsdb {
+
+namespace {
+
+// read a non-null field from raw record data
+template <typename T>
+inline auto Load(const char *data, size_t size) -> T
+{
+  if constexpr (std::is_same_v<T, std::string_view>) {
+    return {data, strnlen(data, size)};
+  } else {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+  }
+}
+
+// read a non-null value of a chunk column
+template <typename T>
+inline auto Get(const Value &value) -> T
+{
+  if constexpr (std::is_same_v<T, int32_t>) {
+    return static_cast<const IntValue &>(value).Get();
+  } else if constexpr (std::is_same_v<T, float>) {
+    return static_cast<const FloatValue &>(value).Get();
+  } else if constexpr (std::is_same_v<T, bool>) {
+    return static_cast<const BoolValue &>(value).Get();
+  } else {
+    return static_cast<const StringValue &>(value).Get();
+  }
+}
+
+template <typename T>
+inline auto Const(const ValueRef &value) -> T
+{
+  if constexpr (std::is_same_v<T, int32_t>) {
+    return value.GetInt();
+  } else if constexpr (std::is_same_v<T, float>) {
+    return value.GetFloat();
+  } else if constexpr (std::is_same_v<T, bool>) {
+    return value.GetBool();
+  } else {
+    return value.GetString();
+  }
+}
+
+// int and float are compared as float, the same as ValueRef
+template <CompOp op, typename L, typename R>
+inline auto Cmp(const L &lhs, const R &rhs) -> bool
+{
+  using C = std::conditional_t<std::is_same_v<L, R>, L, float>;
+  const C l = static_cast<C>(lhs);
+  const C r = static_cast<C>(rhs);
+  if constexpr (op == OP_EQ) {
+    return l == r;
+  } else if constexpr (op == OP_NE) {
+    return l != r;
+  } else if constexpr (op == OP_LT) {
+    return l < r;
+  } else if constexpr (op == OP_LE) {
+    return l <= r;
+  } else if constexpr (op == OP_GT) {
+    return l > r;
+  } else {
+    return l >= r;
+  }
+}
+
+// null only equals null and is never ordered
+template <CompOp op>
+inline auto CmpNull(bool l_null, bool r_null) -> bool
+{
+  if constexpr (op == OP_EQ) {
+    return l_null && r_null;
+  } else if constexpr (op == OP_NE) {
+    return !(l_null && r_null);
+  } else {
+    return false;
+  }
+}
+
+// initial guess of the pass rate of an operator
+auto EstimateRank(CompOp op) -> double
+{
+  switch (op) {
+    case OP_EQ: return 0.1;
+    case OP_IN: return 0.2;
+    case OP_NE: return 0.9;
+    default: return 1.0 / 3;
+  }
+}
+
+}  // namespace
+
+CompiledCondition::CompiledCondition(const ConditionVec &conds, const RecordSchema *schema)
+{
+  terms_.reserve(conds.size());
+  for (size_t i = 0; i < conds.size(); i++) {
+    const auto &cond = conds[i];
+    WSDB_ASSERT(cond.GetRhsType() == kValue || cond.GetRhsType() == kColumn, "Invalid condition type");
+    Term term{};
+    term.cond_idx_ = i;
+    term.op_       = cond.GetOp();
+    term.l_idx_    = schema->GetRTFieldIndex(cond.GetLCol());
+    WSDB_ASSERT(term.l_idx_ != schema->GetFieldCount(), "Invalid field");
+    term.l_off_     = schema->GetFieldOffset(term.l_idx_);
+    term.l_size_    = schema->GetFieldAt(term.l_idx_).field_.field_size_;
+    term.is_column_ = cond.GetRhsType() == kColumn;
+    term.rank_      = EstimateRank(term.op_);
+    auto ltype      = schema->GetFieldAt(term.l_idx_).field_.field_type_;
+    if (term.is_column_) {
+      term.r_idx_ = schema->GetRTFieldIndex(cond.GetRCol());
+      WSDB_ASSERT(term.r_idx_ != schema->GetFieldCount(), "Invalid field");
+      term.r_off_  = schema->GetFieldOffset(term.r_idx_);
+      term.r_size_ = schema->GetFieldAt(term.r_idx_).field_.field_size_;
+      Bind(term, ltype, schema->GetFieldAt(term.r_idx_).field_.field_type_);
+    } else {
+      term.r_holder_ = cond.GetRVal();
+      if (term.op_ == OP_IN || term.r_holder_->IsNull()) {
+        term.row_func_   = &EvalGeneric;
+        term.chunk_func_ = &FilterGeneric;
+      } else {
+        term.r_val_ = ValueRef::FromValue(*term.r_holder_);
+        Bind(term, ltype, term.r_val_.GetType());
+      }
+    }
+    terms_.push_back(std::move(term));
+  }
+  std::stable_sort(terms_.begin(), terms_.end(), [](const Term &a, const Term &b) { return a.rank_ < b.rank_; });
+}
+
+auto CompiledCondition::Eval(const Record &record) -> bool
+{
+  bool pass = true;
+  for (auto &term : terms_) {
+    term.evaluated_++;
+    if (!term.row_func_(term, record)) {
+      pass = false;
+      break;
+    }
+    term.passed_++;
+  }
+  if (++since_reorder_ >= CHUNK_SIZE) {
+    Reorder();
+  }
+  return pass;
+}
+
+void CompiledCondition::Eval(Chunk &chunk)
+{
+  auto sel = chunk.GetSel();
+  since_reorder_ += sel.size();
+  for (auto &term : terms_) {
+    if (sel.empty()) {
+      break;
+    }
+    term.evaluated_ += sel.size();
+    term.chunk_func_(term, chunk, sel);
+    term.passed_ += sel.size();
+  }
+  chunk.SetSel(std::move(sel));
+  if (since_reorder_ >= CHUNK_SIZE) {
+    Reorder();
+  }
+}
+
+auto CompiledCondition::GetOrder() const -> std::vector<size_t>
+{
+  std::vector<size_t> order;
+  order.reserve(terms_.size());
+  for (const auto &term : terms_) {
+    order.push_back(term.cond_idx_);
+  }
+  return order;
+}
+
+void CompiledCondition::Reorder()
+{
+  since_reorder_ = 0;
+  for (auto &term : terms_) {
+    // keep the current rank until there are enough samples, rows rejected earlier never reach later terms
+    if (term.evaluated_ >= CHUNK_SIZE / 8) {
+      term.rank_ = static_cast<double>(term.passed_) / static_cast<double>(term.evaluated_);
+    }
+  }
+  std::stable_sort(terms_.begin(), terms_.end(), [](const Term &a, const Term &b) { return a.rank_ < b.rank_; });
+}
+
+void CompiledCondition::Bind(Term &term, FieldType ltype, FieldType rtype)
+{
+  // reject incomparable types before any row is read
+  ValueRef::CheckTypes(ValueRef::Null(ltype), ValueRef::Null(rtype));
+  switch (ltype) {
+    case TYPE_INT: rtype == TYPE_INT ? Bind<int32_t, int32_t>(term) : Bind<int32_t, float>(term); break;
+    case TYPE_FLOAT: rtype == TYPE_INT ? Bind<float, int32_t>(term) : Bind<float, float>(term); break;
+    case TYPE_BOOL: Bind<bool, bool>(term); break;
+    case TYPE_STRING: Bind<std::string_view, std::string_view>(term); break;
+    default: WSDB_THROW(WSDB_UNSUPPORTED_OP, FieldTypeToString(ltype));
+  }
+}
+
+template <typename L, typename R>
+void CompiledCondition::Bind(Term &term)
+{
+#define WSDB_BIND_OP(op)                                                                       \
+  case op:                                                                                     \
+    term.row_func_   = term.is_column_ ? &EvalColumn<L, R, op> : &EvalValue<L, R, op>;       \
+    term.chunk_func_ = term.is_column_ ? &FilterColumn<L, R, op> : &FilterValue<L, R, op>; \
+    break;
+  switch (term.op_) {
+    WSDB_BIND_OP(OP_EQ)
+    WSDB_BIND_OP(OP_NE)
+    WSDB_BIND_OP(OP_LT)
+    WSDB_BIND_OP(OP_LE)
+    WSDB_BIND_OP(OP_GT)
+    WSDB_BIND_OP(OP_GE)
+    default: WSDB_THROW(WSDB_UNSUPPORTED_OP, CompOpToString(term.op_));
+  }
+#undef WSDB_BIND_OP
+}
+
+template <typename L, typename R, CompOp op>
+auto CompiledCondition::EvalValue(const Term &term, const Record &record) -> bool
+{
+  if (BitMap::GetBit(record.GetNullMap(), term.l_idx_)) {
+    return CmpNull<op>(true, false);
+  }
+  return Cmp<op>(Load<L>(record.GetData() + term.l_off_, term.l_size_), Const<R>(term.r_val_));
+}
+
+template <typename L, typename R, CompOp op>
+auto CompiledCondition::EvalColumn(const Term &term, const Record &record) -> bool
+{
+  bool l_null = BitMap::GetBit(record.GetNullMap(), term.l_idx_);
+  bool r_null = BitMap::GetBit(record.GetNullMap(), term.r_idx_);
+  if (l_null || r_null) {
+    return CmpNull<op>(l_null, r_null);
+  }
+  return Cmp<op>(Load<L>(record.GetData() + term.l_off_, term.l_size_),
+      Load<R>(record.GetData() + term.r_off_, term.r_size_));
+}
+
+template <typename L, typename R, CompOp op>
+void CompiledCondition::FilterValue(const Term &term, Chunk &chunk, std::vector<size_t> &sel)
+{
+  const auto &col = chunk.GetCol(static_cast<int>(term.l_idx_))->Get();
+  const R     rhs = Const<R>(term.r_val_);
+  // compact the selection vector in place without branching on the result
+  size_t n = 0;
+  for (auto row : sel) {
+    const auto &value = *col[row];
+    sel[n] = row;
+    n += value.IsNull() ? CmpNull<op>(true, false) : Cmp<op>(Get<L>(value), rhs);
+  }
+  sel.resize(n);
+}
+
+template <typename L, typename R, CompOp op>
+void CompiledCondition::FilterColumn(const Term &term, Chunk &chunk, std::vector<size_t> &sel)
+{
+  const auto &lcol = chunk.GetCol(static_cast<int>(term.l_idx_))->Get();
+  const auto &rcol = chunk.GetCol(static_cast<int>(term.r_idx_))->Get();
+  size_t      n    = 0;
+  for (auto row : sel) {
+    const auto &lhs = *lcol[row];
+    const auto &rhs = *rcol[row];
+    sel[n]          = row;
+    n += lhs.IsNull() || rhs.IsNull() ? CmpNull<op>(lhs.IsNull(), rhs.IsNull()) : Cmp<op>(Get<L>(lhs), Get<R>(rhs));
+  }
+  sel.resize(n);
+}
+
+auto CompiledCondition::EvalGeneric(const Term &term, const Record &record) -> bool
+{
+  auto lhs = record.GetValueRefAt(term.l_idx_);
+  if (term.op_ == OP_IN) {
+    return ConditionExpr::In(lhs, *term.r_holder_);
+  }
+  return ValueRef::Eval(term.op_, lhs, ValueRef::FromValue(*term.r_holder_));
+}
+
+void CompiledCondition::FilterGeneric(const Term &term, Chunk &chunk, std::vector<size_t> &sel)
+{
+  const auto &col = chunk.GetCol(static_cast<int>(term.l_idx_))->Get();
+  size_t      n   = 0;
+  for (auto row : sel) {
+    auto lhs = ValueRef::FromValue(*col[row]);
+    sel[n]   = row;
+    n += term.op_ == OP_IN ? ConditionExpr::In(lhs, *term.r_holder_)
+                           : ValueRef::Eval(term.op_, lhs, ValueRef::FromValue(*term.r_holder_));
+  }
+  sel.resize(n);
+}
+
+}  // namespace wsdb
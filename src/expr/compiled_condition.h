@@ -0,0 +1,126 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/20.
+//
+
+#ifndef WSDB_COMPILED_CONDITION_H
+#define WSDB_COMPILED_CONDITION_H
+
+#include "common/condition.h"
+#include "system/handle/record_handle.h"
+
+namespace wsdb {
+
+class CompiledCondition;
+DEFINE_SHARED_PTR(CompiledCondition);
+
+/**
+ * CompiledCondition is a conjunction of conditions specialized for one schema. Field indexes and offsets are resolved
+ * once, each term is bound to a comparator instantiated for its field types and operator, and records are read from
+ * their raw data without creating values. Terms are evaluated with short circuit, the ones expected to reject the
+ * most rows first: the order starts from a guess by operator and then follows the pass rates observed at runtime
+ */
+class CompiledCondition
+{
+public:
+  /**
+   * @param conds conditions with a value or a column as rhs
+   * @param schema schema of the records or chunks to evaluate
+   */
+  CompiledCondition(const ConditionVec &conds, const RecordSchema *schema);
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(CompiledCondition);
+
+  /**
+   * @param record should have the same layout as the compiled schema
+   * @return whether the record passes all conditions
+   */
+  auto Eval(const Record &record) -> bool;
+
+  /**
+   * Batch mode, the selection vector of the chunk is narrowed to the rows that pass all conditions
+   * @param chunk should have the compiled schema
+   */
+  void Eval(Chunk &chunk);
+
+  /// current evaluation order as indexes into the compiled conditions
+  [[nodiscard]] auto GetOrder() const -> std::vector<size_t>;
+
+private:
+  struct Term;
+  using RowFunc   = bool (*)(const Term &term, const Record &record);
+  using ChunkFunc = void (*)(const Term &term, Chunk &chunk, std::vector<size_t> &sel);
+
+  struct Term
+  {
+    size_t    cond_idx_;
+    CompOp    op_;
+    size_t    l_idx_;
+    size_t    l_off_;
+    size_t    l_size_;
+    // rhs is either a column of the same schema or a constant viewed through r_val_ and kept alive by r_holder_
+    bool      is_column_;
+    size_t    r_idx_;
+    size_t    r_off_;
+    size_t    r_size_;
+    ValueRef  r_val_;
+    ValueSptr r_holder_;
+    RowFunc   row_func_;
+    ChunkFunc chunk_func_;
+    // estimated fraction of rows that pass, terms with lower rank are evaluated first
+    double rank_;
+    size_t evaluated_{0};
+    size_t passed_{0};
+  };
+
+  // bind the comparators of a term according to the types of both sides
+  static void Bind(Term &term, FieldType ltype, FieldType rtype);
+
+  template <typename L, typename R>
+  static void Bind(Term &term);
+
+  template <typename L, typename R, CompOp op>
+  static auto EvalValue(const Term &term, const Record &record) -> bool;
+
+  template <typename L, typename R, CompOp op>
+  static auto EvalColumn(const Term &term, const Record &record) -> bool;
+
+  template <typename L, typename R, CompOp op>
+  static void FilterValue(const Term &term, Chunk &chunk, std::vector<size_t> &sel);
+
+  template <typename L, typename R, CompOp op>
+  static void FilterColumn(const Term &term, Chunk &chunk, std::vector<size_t> &sel);
+
+  // fallback for IN and null constants, goes through ValueRef::Eval
+  static auto EvalGeneric(const Term &term, const Record &record) -> bool;
+
+  static void FilterGeneric(const Term &term, Chunk &chunk, std::vector<size_t> &sel);
+
+  // refresh ranks from the observed pass rates and sort the terms by rank
+  void Reorder();
+
+private:
+  std::vector<Term> terms_;
+  // rows evaluated since the last reorder
+  size_t since_reorder_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_COMPILED_CONDITION_H
@@ -31,31 +31,76 @@ auto ConditionExpr::Eval(const ConditionVec &condition, const wsdb::Record &reco
 
 auto ConditionExpr::EvalCond(const Condition &condition, const wsdb::Record &record) -> bool
 {
-  // first get the lhs value according to condition
+  // first get the lhs value according to condition, fields are read in place without creating values
   auto idx = record.GetSchema()->GetRTFieldIndex(condition.GetLCol());
   WSDB_ASSERT(idx != record.GetSchema()->GetFieldCount(), "Invalid field");
-  auto lhs = record.GetValueAt(idx);
+  auto lhs = record.GetValueRefAt(idx);
   WSDB_ASSERT(condition.GetRhsType() == kValue || condition.GetRhsType() == kColumn, "Invalid condition type");
-  ValueSptr rhs;
   if (condition.GetRhsType() == kValue) {
-    rhs = condition.GetRVal();
+    if (condition.GetOp() == OP_IN) {
+      return In(lhs, *condition.GetRVal());
+    }
+    return ValueRef::Eval(condition.GetOp(), lhs, ValueRef::FromValue(*condition.GetRVal()));
+  }
+  idx = record.GetSchema()->GetRTFieldIndex(condition.GetRCol());
+  WSDB_ASSERT(idx != record.GetSchema()->GetFieldCount(), "Invalid field");
+  return ValueRef::Eval(condition.GetOp(), lhs, record.GetValueRefAt(idx));
+}
+
+void ConditionExpr::Eval(const ConditionVec &condition, Chunk &chunk)
+{
+  for (const auto &cond : condition) {
+    if (chunk.GetSelCount() == 0) {
+      return;
+    }
+    EvalCond(cond, chunk);
+  }
+}
+
+void ConditionExpr::EvalCond(const Condition &condition, Chunk &chunk)
+{
+  // resolve the columns once per chunk instead of once per row
+  auto schema = chunk.GetSchema();
+  auto op     = condition.GetOp();
+  auto l_idx  = schema->GetRTFieldIndex(condition.GetLCol());
+  WSDB_ASSERT(l_idx != schema->GetFieldCount(), "Invalid field");
+  WSDB_ASSERT(condition.GetRhsType() == kValue || condition.GetRhsType() == kColumn, "Invalid condition type");
+  size_t   r_idx = schema->GetFieldCount();
+  ValueRef r_val;
+  if (condition.GetRhsType() == kValue) {
+    if (op != OP_IN) {
+      r_val = ValueRef::FromValue(*condition.GetRVal());
+    }
   } else {
-    idx = record.GetSchema()->GetRTFieldIndex(condition.GetRCol());
-    WSDB_ASSERT(idx != record.GetSchema()->GetFieldCount(), "Invalid field");
-    rhs = record.GetValueAt(idx);
+    r_idx = schema->GetRTFieldIndex(condition.GetRCol());
+    WSDB_ASSERT(r_idx != schema->GetFieldCount(), "Invalid field");
   }
-  ValueFactory::AlignTypes(lhs, rhs);
-  switch (condition.GetOp()) {
-    case OP_EQ: return *lhs == *rhs;
-    case OP_NE: return *lhs != *rhs;
-    case OP_LT: return *lhs < *rhs;
-    case OP_LE: return *lhs <= *rhs;
-    case OP_GT: return *lhs > *rhs;
-    case OP_GE: return *lhs >= *rhs;
-    case OP_IN: return std::dynamic_pointer_cast<ArrayValue>(rhs)->Contains(lhs);
-    default: WSDB_FETAL(CompOpToString(condition.GetOp()));
+  std::vector<size_t> sel;
+  sel.reserve(chunk.GetSelCount());
+  for (auto row : chunk.GetSel()) {
+    auto lhs = ValueRef::FromValue(*chunk.GetValueAt(l_idx, row));
+    bool pass;
+    if (op == OP_IN) {
+      pass = In(lhs, *condition.GetRVal());
+    } else if (r_idx == schema->GetFieldCount()) {
+      pass = ValueRef::Eval(op, lhs, r_val);
+    } else {
+      pass = ValueRef::Eval(op, lhs, ValueRef::FromValue(*chunk.GetValueAt(r_idx, row)));
+    }
+    if (pass) {
+      sel.push_back(row);
+    }
   }
-  // should never reach here
+  chunk.SetSel(std::move(sel));
+}
+
+auto ConditionExpr::In(const ValueRef &lhs, const Value &rhs) -> bool
+{
+  WSDB_ASSERT(rhs.GetType() == TYPE_ARRAY, "rhs of IN should be an array");
+  const auto &values = static_cast<const ArrayValue &>(rhs).Get();
+  return std::any_of(values.begin(), values.end(), [&lhs](const ValueSptr &v) {
+    return ValueRef::Eval(OP_EQ, lhs, ValueRef::FromValue(*v));
+  });
 }
 
-}  // namespace wsdb
\ No newline at end of file
+}  // namespace wsdb
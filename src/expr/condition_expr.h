@@ -35,8 +35,22 @@ public:
 
   static auto Eval(const ConditionVec &condition, const Record &record)-> bool;
 
+  /**
+   * Evaluate the conditions over the selected rows of a chunk, rows that fail any condition are removed from the
+   * selection vector of the chunk
+   * @param condition
+   * @param chunk
+   */
+  static void Eval(const ConditionVec &condition, Chunk &chunk);
+
+  // lhs IN rhs, rhs should be an array value
+  static auto In(const ValueRef &lhs, const Value &rhs) -> bool;
+
 private:
   static auto EvalCond(const Condition &condition, const Record &record) -> bool;
+
+  static void EvalCond(const Condition &condition, Chunk &chunk);
+
 };
 
 }  // namespace wsdb
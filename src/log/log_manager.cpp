@@ -20,10 +20,195 @@
 //
 
 #include "log_manager.h"
+
+#include <cstring>
+#include <filesystem>
+
+#include "../../common/error.h"
+
 namespace wsdb {
 
-LogManager::LogManager(DiskManager *disk_manager) {}
+LogManager::LogManager(DiskManager *disk_manager, std::string log_file)
+    : disk_manager_(disk_manager), log_file_(std::move(log_file)), master_file_(log_file_ + ".ckpt")
+{
+  std::string master;
+  disk_manager_->ReadLog(master_file_, master);
+  lsn_t scan_lsn = 1;
+  if (master.size() == 2 * sizeof(lsn_t) + sizeof(uint64_t)) {
+    uint64_t scan_offset;
+    memcpy(&redo_lsn_, master.data(), sizeof(lsn_t));
+    memcpy(&scan_lsn, master.data() + sizeof(lsn_t), sizeof(lsn_t));
+    memcpy(&scan_offset, master.data() + 2 * sizeof(lsn_t), sizeof(uint64_t));
+    scan_offset_ = scan_offset;
+  }
+  // continue the lsns of the existing log, a torn record left by a crash is cut off so that new records follow the
+  // last whole one
+  std::string log;
+  disk_manager_->ReadLog(log_file_, log, scan_offset_);
+  lsn_t     last_lsn = scan_lsn - 1;
+  size_t    offset   = 0;
+  LogRecord rec;
+  while (offset < log.size()) {
+    auto size = rec.DeserializeFrom(log.data() + offset, log.size() - offset);
+    if (size == 0) {
+      break;
+    }
+    if (offset == 0) {
+      batch_offsets_.emplace(rec.lsn_, scan_offset_);
+    }
+    last_lsn    = rec.lsn_;
+    max_txn_id_ = std::max(max_txn_id_, rec.txn_id_);
+    offset += size;
+  }
+  if (offset < log.size()) {
+    WSDB_LOG(fmt::format("Log truncated from {} to {} bytes", scan_offset_ + log.size(), scan_offset_ + offset));
+    std::filesystem::resize_file(log_file_, scan_offset_ + offset);
+  }
+  next_lsn_    = last_lsn + 1;
+  flushed_lsn_ = last_lsn;
+  file_size_   = scan_offset_ + offset;
+  log_buffer_.reserve(LOG_BUFFER_SIZE);
+  flush_buffer_.reserve(LOG_BUFFER_SIZE);
+  flusher_ = std::thread(&LogManager::FlushLoop, this);
+}
+
+LogManager::~LogManager()
+{
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    stop_ = true;
+    flush_cv_.notify_one();
+  }
+  flusher_.join();
+}
+
+auto LogManager::AppendLogRecord(LogRecord &rec) -> lsn_t
+{
+  // serialize outside of the latch, only the lsn is stamped in afterwards
+  std::string buf;
+  rec.SerializeTo(buf);
+  std::unique_lock<std::mutex> lock(latch_);
+  if (log_buffer_.size() + buf.size() > LOG_BUFFER_SIZE) {
+    flush_cv_.notify_one();
+    flushed_cv_.wait(lock, [this, &buf] { return log_buffer_.empty() || log_buffer_.size() + buf.size() <= LOG_BUFFER_SIZE; });
+  }
+  rec.lsn_ = next_lsn_++;
+  memcpy(buf.data() + LOG_RECORD_LSN_OFFSET, &rec.lsn_, sizeof(lsn_t));
+  log_buffer_.append(buf);
+  if (rec.type_ == LogType::COMMIT || rec.type_ == LogType::ABORT) {
+    active_txns_.erase(rec.txn_id_);
+  } else if (rec.prev_lsn_ == INVALID_LSN) {
+    active_txns_.emplace(rec.txn_id_, rec.lsn_);
+  }
+  return rec.lsn_;
+}
+
+void LogManager::WaitForFlush(lsn_t lsn)
+{
+  if (lsn <= flushed_lsn_.load()) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  // a page not written by the log manager may hold any value in its lsn field
+  lsn = std::min(lsn, next_lsn_ - 1);
+  if (lsn > flush_request_) {
+    flush_request_ = lsn;
+    flush_cv_.notify_one();
+  }
+  flushed_cv_.wait(lock, [this, lsn] { return flushed_lsn_.load() >= lsn; });
+}
+
+void LogManager::FlushLog()
+{
+  lsn_t lsn;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    lsn = next_lsn_ - 1;
+  }
+  WaitForFlush(lsn);
+}
+
+void LogManager::Checkpoint(lsn_t redo_lsn, lsn_t scan_lsn)
+{
+  FlushLog();
+  size_t offset;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    // start of the batch that holds scan_lsn, batches before it are no longer needed. if no record from scan_lsn on
+    // has been appended yet, restart reads from the current end of the file
+    auto it = batch_offsets_.upper_bound(scan_lsn);
+    if (it != batch_offsets_.begin()) {
+      --it;
+    }
+    bool appended = scan_lsn < next_lsn_ || !log_buffer_.empty();
+    offset        = it == batch_offsets_.end() || !appended ? file_size_ : it->second;
+    batch_offsets_.erase(batch_offsets_.begin(), it);
+  }
+  std::string master;
+  auto        scan_offset = static_cast<uint64_t>(offset);
+  master.append(reinterpret_cast<const char *>(&redo_lsn), sizeof(lsn_t));
+  master.append(reinterpret_cast<const char *>(&scan_lsn), sizeof(lsn_t));
+  master.append(reinterpret_cast<const char *>(&scan_offset), sizeof(uint64_t));
+  DiskManager::WriteFileAtomic(master_file_, master);
+  redo_lsn_    = redo_lsn;
+  scan_offset_ = offset;
+}
+
+void LogManager::ReadLog(std::vector<LogRecord> &recs)
+{
+  std::string log;
+  disk_manager_->ReadLog(log_file_, log, scan_offset_);
+  LogRecord rec;
+  for (size_t offset = 0, size; offset < log.size(); offset += size) {
+    size = rec.DeserializeFrom(log.data() + offset, log.size() - offset);
+    if (size == 0) {
+      break;
+    }
+    recs.push_back(rec);
+  }
+}
+
+auto LogManager::GetMinActiveLsn() -> lsn_t
+{
+  std::lock_guard<std::mutex> guard(latch_);
+  lsn_t                       lsn = next_lsn_;
+  for (const auto &[txn_id, first_lsn] : active_txns_) {
+    lsn = std::min(lsn, first_lsn);
+  }
+  return lsn;
+}
 
-void LogManager::FlushLog() {}
+void LogManager::FlushLoop()
+{
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    flush_cv_.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS), [this] {
+      return stop_ || flush_request_ > flushed_lsn_.load() || log_buffer_.size() >= LOG_BUFFER_SIZE / 2;
+    });
+    if (log_buffer_.empty()) {
+      if (stop_) {
+        break;
+      }
+      continue;
+    }
+    // records appended from now on go to the other buffer and wait for the next round
+    std::swap(log_buffer_, flush_buffer_);
+    lsn_t last_lsn = next_lsn_ - 1;
+    batch_offsets_.emplace(flushed_lsn_ + 1, file_size_);
+    file_size_ += flush_buffer_.size();
+    flushed_cv_.notify_all();
+    lock.unlock();
+    try {
+      disk_manager_->WriteLog(log_file_, flush_buffer_);
+    } catch (WSDBException_ &e) {
+      // committed transactions can not be acknowledged without the log
+      WSDB_FETAL(e.what());
+    }
+    flush_buffer_.clear();
+    lock.lock();
+    flushed_lsn_ = last_lsn;
+    flushed_cv_.notify_all();
+  }
+}
 
 }  // namespace wsdb
@@ -22,17 +22,112 @@
 #ifndef WSDB_LOG_MANAGER_H
 #define WSDB_LOG_MANAGER_H
 
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "log_record.h"
 #include "storage/disk/disk_manager.h"
 
 namespace wsdb {
+
+/**
+ * The write-ahead log. Lsns are assigned in the order records are appended, starting after the last record already in
+ * the log file. Appending holds the latch only to take the lsn and copy the serialized record into the log buffer, a
+ * flusher thread swaps the buffer out and writes and syncs it with the latch released, so the records appended
+ * meanwhile are written by the next round and every thread waiting for them shares the same sync (group commit).
+ *
+ * A checkpoint is kept in a master file next to the log, | redo lsn | scan lsn | scan offset |. Restart reads the log
+ * from the scan offset, which is not after the first record of any transaction running at the checkpoint, and redoes
+ * it from the redo lsn, so the log in front of the checkpoint is never read again
+ */
 class LogManager
 {
 public:
-  explicit LogManager(DiskManager *disk_manager);
-  ~LogManager() = default;
+  explicit LogManager(DiskManager *disk_manager, std::string log_file = LOG_FILE_NAME);
+
+  /**
+   * Stop the flusher after everything appended is durable
+   */
+  ~LogManager();
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(LogManager)
+
+  /**
+   * Assign the next lsn to the record and append it to the log buffer, waits for the flusher if the buffer is full
+   * @return lsn of the record
+   */
+  auto AppendLogRecord(LogRecord &rec) -> lsn_t;
 
+  /**
+   * Block until the log is durable up to lsn, used by commits and by the buffer pool before writing a page
+   */
+  void WaitForFlush(lsn_t lsn);
+
+  /**
+   * Make everything appended so far durable
+   */
   void FlushLog();
+
+  /**
+   * Record a checkpoint in the master file after the log is flushed
+   * @param redo_lsn every change before it is in the data files
+   * @param scan_lsn no transaction still running has records before it
+   */
+  void Checkpoint(lsn_t redo_lsn, lsn_t scan_lsn);
+
+  /**
+   * Read the records from the scan offset of the last checkpoint to the end of the log file
+   */
+  void ReadLog(std::vector<LogRecord> &recs);
+
+  /// lsn redo starts from, as recorded by the last checkpoint
+  [[nodiscard]] auto GetRedoLsn() const -> lsn_t { return redo_lsn_; }
+
+  /// first lsn of the oldest running transaction, the next lsn if none is running
+  auto GetMinActiveLsn() -> lsn_t;
+
+  [[nodiscard]] auto GetNextLsn() const -> lsn_t { return next_lsn_.load(); }
+
+  [[nodiscard]] auto GetFlushedLsn() const -> lsn_t { return flushed_lsn_.load(); }
+
+  /// largest transaction id found in the log when it was opened
+  [[nodiscard]] auto GetMaxTxnId() const -> txn_id_t { return max_txn_id_; }
+
+  [[nodiscard]] auto GetLogFile() const -> const std::string & { return log_file_; }
+
+private:
+  void FlushLoop();
+
+private:
+  DiskManager *disk_manager_;
+  std::string  log_file_;
+  std::string  master_file_;
+  txn_id_t     max_txn_id_{INVALID_TXN_ID};
+  lsn_t        redo_lsn_{INVALID_LSN};
+  size_t       scan_offset_{0};
+
+  // guards everything below except flush_buffer_, which only the flusher touches
+  std::mutex              latch_;
+  std::condition_variable flush_cv_;    // wakes the flusher
+  std::condition_variable flushed_cv_;  // wakes threads waiting for a flush or for space in the buffer
+  std::string             log_buffer_;
+  std::string             flush_buffer_;
+  std::atomic<lsn_t>      next_lsn_;
+  lsn_t                   flush_request_{INVALID_LSN};  // largest lsn some thread waits for
+  std::atomic<lsn_t>      flushed_lsn_;
+  size_t                  file_size_{0};
+  std::map<lsn_t, size_t> batch_offsets_;  // first lsn of each batch written since the checkpoint -> its file offset
+  std::unordered_map<txn_id_t, lsn_t> active_txns_;  // running transactions that have written records -> first lsn
+  bool                    stop_{false};
+  std::thread             flusher_;
 };
+
 }  // namespace wsdb
 
 #endif  // WSDB_LOG_MANAGER_H
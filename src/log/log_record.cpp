@@ -0,0 +1,118 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/7/18.
+//
+
+#include "log_record.h"
+
+#include <cstring>
+
+namespace wsdb {
+
+template <typename T>
+static void Put(std::string &buf, T value)
+{
+  buf.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+static void PutBytes(std::string &buf, const std::string &bytes)
+{
+  Put(buf, static_cast<uint32_t>(bytes.size()));
+  buf.append(bytes);
+}
+
+template <typename T>
+static auto Get(const char *&pos, const char *end, T &value) -> bool
+{
+  if (static_cast<size_t>(end - pos) < sizeof(T)) {
+    return false;
+  }
+  memcpy(&value, pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+static auto GetBytes(const char *&pos, const char *end, std::string &bytes) -> bool
+{
+  uint32_t size;
+  if (!Get(pos, end, size) || static_cast<size_t>(end - pos) < size) {
+    return false;
+  }
+  bytes.assign(pos, size);
+  pos += size;
+  return true;
+}
+
+auto LogRecord::GetSize() const -> size_t
+{
+  if (!IsPageRecord()) {
+    return LOG_RECORD_HEADER_SIZE;
+  }
+  return LOG_RECORD_HEADER_SIZE + 3 * sizeof(uint32_t) + file_name_.size() + sizeof(page_id_t) + sizeof(slot_id_t) +
+         before_.size() + after_.size() + (type_ == LogType::CLR ? sizeof(lsn_t) : 0);
+}
+
+void LogRecord::SerializeTo(std::string &buf) const
+{
+  Put(buf, static_cast<uint32_t>(GetSize()));
+  Put(buf, lsn_);
+  Put(buf, prev_lsn_);
+  Put(buf, txn_id_);
+  Put(buf, static_cast<uint32_t>(type_));
+  if (IsPageRecord()) {
+    PutBytes(buf, file_name_);
+    Put(buf, page_id_);
+    Put(buf, slot_id_);
+    PutBytes(buf, before_);
+    PutBytes(buf, after_);
+  }
+  if (type_ == LogType::CLR) {
+    Put(buf, undo_next_lsn_);
+  }
+}
+
+auto LogRecord::DeserializeFrom(const char *data, size_t size) -> size_t
+{
+  const char *pos = data;
+  const char *end = data + size;
+  uint32_t    rec_size;
+  uint32_t    type = 0;
+  if (!Get(pos, end, rec_size) || rec_size < LOG_RECORD_HEADER_SIZE || rec_size > size) {
+    return 0;
+  }
+  end = data + rec_size;
+  Get(pos, end, lsn_);
+  Get(pos, end, prev_lsn_);
+  Get(pos, end, txn_id_);
+  Get(pos, end, type);
+  type_ = static_cast<LogType>(type);
+  if (type_ == LogType::INVALID || type_ > LogType::CLR) {
+    return 0;
+  }
+  if (IsPageRecord() && !(GetBytes(pos, end, file_name_) && Get(pos, end, page_id_) && Get(pos, end, slot_id_) &&
+                            GetBytes(pos, end, before_) && GetBytes(pos, end, after_))) {
+    return 0;
+  }
+  if (type_ == LogType::CLR && !Get(pos, end, undo_next_lsn_)) {
+    return 0;
+  }
+  return pos == end ? rec_size : 0;
+}
+
+}  // namespace wsdb
@@ -0,0 +1,91 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/7/18.
+//
+
+#ifndef WSDB_LOG_RECORD_H
+#define WSDB_LOG_RECORD_H
+
+#include <string>
+
+#include "common/types.h"
+
+namespace wsdb {
+
+enum class LogType : uint32_t
+{
+  INVALID  = 0,
+  COMMIT   = 1,
+  ABORT    = 2,
+  NEW_PAGE = 3,
+  INSERT   = 4,
+  DELETE   = 5,
+  UPDATE   = 6,
+  CLR      = 7
+};
+
+/**
+ * A record of the write-ahead log, serialized as
+ * | size | lsn | prev lsn | txn id | type | body |
+ * prev lsn links the records of a transaction backwards. Changes of table pages have a body of
+ * | file name size | file name | page id | slot id | before size | before image | after size | after image |
+ * an image is the null map followed by the data of the slot, INSERT has no before image and DELETE no after image,
+ * NEW_PAGE has neither. A CLR compensates a record undone by a rollback, its after image is what the slot is brought
+ * back to, empty if the slot is cleared, and it is followed by | undo next lsn |, the prev lsn of the undone record.
+ * COMMIT has no body, ABORT has no body and ends a transaction whose changes have all been undone
+ */
+struct LogRecord
+{
+  LogRecord() = default;
+
+  LogRecord(LogType type, txn_id_t txn_id, lsn_t prev_lsn) : txn_id_(txn_id), prev_lsn_(prev_lsn), type_(type) {}
+
+  [[nodiscard]] auto IsPageRecord() const -> bool { return type_ >= LogType::NEW_PAGE; }
+
+  /// number of bytes the record takes in the log
+  [[nodiscard]] auto GetSize() const -> size_t;
+
+  /// append the serialized record to buf
+  void SerializeTo(std::string &buf) const;
+
+  /**
+   * Parse a record from the front of data
+   * @return number of bytes consumed, 0 if data does not hold a whole record, e.g. the torn tail of the log
+   */
+  auto DeserializeFrom(const char *data, size_t size) -> size_t;
+
+  lsn_t       lsn_{INVALID_LSN};
+  txn_id_t    txn_id_{INVALID_TXN_ID};
+  lsn_t       prev_lsn_{INVALID_LSN};
+  LogType     type_{LogType::INVALID};
+  std::string file_name_;
+  page_id_t   page_id_{INVALID_PAGE_ID};
+  slot_id_t   slot_id_{INVALID_SLOT_ID};
+  std::string before_;
+  std::string after_;
+  lsn_t       undo_next_lsn_{INVALID_LSN};  // CLR only
+};
+
+// size and lsn come first so that the log manager can stamp the lsn into a serialized record
+constexpr size_t LOG_RECORD_LSN_OFFSET  = sizeof(uint32_t);
+constexpr size_t LOG_RECORD_HEADER_SIZE = sizeof(uint32_t) + sizeof(lsn_t) + sizeof(lsn_t) + sizeof(txn_id_t) + sizeof(uint32_t);
+
+}  // namespace wsdb
+
+#endif  // WSDB_LOG_RECORD_H
@@ -21,13 +21,213 @@
 
 #include "recovery.h"
 
+#include <algorithm>
+#include <future>
+
 namespace wsdb {
 
-void Recovery::SetDBHandle(DatabaseHandle *db_hdl) { db_hdl_ = db_hdl; }
+void Recovery::SetDBHandle(DatabaseHandle *db_hdl)
+{
+  db_hdl_    = db_hdl;
+  db_opened_ = false;
+}
+
+void Recovery::AnalyzeLog()
+{
+  records_.clear();
+  lsn_index_.clear();
+  losers_.clear();
+  page_nums_.clear();
+  auto log_manager = buffer_pool_manager_->GetLogManager();
+  if (log_manager == nullptr) {
+    return;
+  }
+  std::vector<LogRecord> recs;
+  log_manager->ReadLog(recs);
+  for (auto &rec : recs) {
+    if (!rec.IsPageRecord()) {
+      // a transaction that committed or aborted has nothing left to undo in any database
+      losers_.erase(rec.txn_id_);
+      continue;
+    }
+    losers_[rec.txn_id_] = rec.lsn_;
+    auto &page_num       = page_nums_[rec.file_name_];
+    page_num             = std::max(page_num, static_cast<size_t>(rec.page_id_) + 1);
+    lsn_index_[rec.lsn_] = records_.size();
+    records_.push_back(std::move(rec));
+  }
+  if (!records_.empty()) {
+    WSDB_LOG(fmt::format(
+        "Recovering from {} log records, {} transactions to roll back", records_.size(), losers_.size()));
+  }
+}
+
+void Recovery::Redo()
+{
+  if (db_hdl_ == nullptr ||
+      std::none_of(records_.begin(), records_.end(), [this](const auto &rec) { return IsOfDB(rec); })) {
+    return;
+  }
+  if (db_hdl_->ref_cnt_++ == 0) {
+    db_hdl_->Open();
+  }
+  db_opened_ = true;
+  // the records of a page go to the same partition in lsn order, partitions are replayed in parallel
+  auto redo_lsn = buffer_pool_manager_->GetLogManager()->GetRedoLsn();
+  std::vector<std::vector<std::pair<TableHandle *, const LogRecord *>>> partitions(RECOVERY_REDO_WORKER_NUM);
+  std::unordered_map<std::string, TableHandle *>                         tables;
+  for (const auto &rec : records_) {
+    if (rec.lsn_ < redo_lsn || !IsOfDB(rec)) {
+      continue;
+    }
+    auto it = tables.find(rec.file_name_);
+    if (it == tables.end()) {
+      it = tables.emplace(rec.file_name_, GetTable(rec)).first;
+    }
+    if (it->second == nullptr) {
+      continue;
+    }
+    auto part = (std::hash<std::string>()(rec.file_name_) * 31 + static_cast<size_t>(rec.page_id_)) % partitions.size();
+    partitions[part].emplace_back(it->second, &rec);
+  }
+  std::vector<std::future<void>> workers;
+  for (auto &partition : partitions) {
+    if (partition.empty()) {
+      continue;
+    }
+    workers.push_back(std::async(std::launch::async, [&partition] {
+      for (const auto &[tab, rec] : partition) {
+        RedoRecord(tab, *rec);
+      }
+    }));
+  }
+  for (auto &worker : workers) {
+    worker.get();
+  }
+}
+
+void Recovery::Undo()
+{
+  // Redo has opened the database if the log has changes of it
+  if (!db_opened_) {
+    return;
+  }
+  auto log_manager = buffer_pool_manager_->GetLogManager();
+  for (auto &[txn_id, last_lsn] : losers_) {
+    // follow the prev lsns backwards, a CLR of the database skips the records a previous rollback has already undone.
+    // a CLR of another database only skips records of that database, it is passed like any of its records
+    lsn_t prev_lsn = last_lsn;
+    lsn_t lsn      = last_lsn;
+    while (lsn != INVALID_LSN) {
+      auto it = lsn_index_.find(lsn);
+      if (it == lsn_index_.end()) {
+        break;
+      }
+      const auto &rec = records_[it->second];
+      if (!IsOfDB(rec)) {
+        lsn = rec.prev_lsn_;
+        continue;
+      }
+      if (rec.type_ == LogType::CLR) {
+        lsn = rec.undo_next_lsn_;
+        continue;
+      }
+      // a new page stays in the table, it is empty once the records written into it are undone
+      if (rec.type_ != LogType::NEW_PAGE) {
+        LogRecord clr(LogType::CLR, txn_id, prev_lsn);
+        clr.file_name_     = rec.file_name_;
+        clr.page_id_       = rec.page_id_;
+        clr.slot_id_       = rec.slot_id_;
+        clr.after_         = rec.before_;
+        clr.undo_next_lsn_ = rec.prev_lsn_;
+        prev_lsn           = log_manager->AppendLogRecord(clr);
+        if (auto tab = GetTable(rec); tab != nullptr) {
+          tab->RecoverSlot(clr.page_id_, clr.slot_id_, clr.after_, prev_lsn);
+        }
+      }
+      lsn = rec.prev_lsn_;
+    }
+    // the CLRs of the next database and the ABORT continue the chain of the transaction
+    last_lsn = prev_lsn;
+  }
+  log_manager->FlushLog();
+
+  for (const auto &[file_name, page_num] : page_nums_) {
+    if (file_name.compare(0, db_hdl_->GetName().size() + 1, db_hdl_->GetName() + "/") != 0) {
+      continue;
+    }
+    auto tab_name = OBJNAME_FROM_FILENAME(file_name);
+    auto tab      = db_hdl_->GetTable(tab_name);
+    if (tab == nullptr) {
+      continue;
+    }
+    tab->RebuildHeader(page_num);
+    db_hdl_->RebuildIndexes(tab_name);
+  }
+  // closing writes the table headers and the pages
+  db_hdl_->Close();
+  db_opened_ = false;
+}
+
+void Recovery::AbortLosers()
+{
+  auto log_manager = buffer_pool_manager_->GetLogManager();
+  if (log_manager == nullptr) {
+    return;
+  }
+  for (const auto &[txn_id, last_lsn] : losers_) {
+    LogRecord abort(LogType::ABORT, txn_id, last_lsn);
+    log_manager->AppendLogRecord(abort);
+  }
+  log_manager->FlushLog();
+  records_.clear();
+  lsn_index_.clear();
+  losers_.clear();
+  page_nums_.clear();
+}
+
+void Recovery::Checkpoint(lsn_t meta_lsn)
+{
+  auto log_manager = buffer_pool_manager_->GetLogManager();
+  if (log_manager == nullptr) {
+    return;
+  }
+  if (last_checkpoint_lsn_ != INVALID_LSN) {
+    buffer_pool_manager_->FlushPagesBefore(last_checkpoint_lsn_);
+  }
+  // a page pinned or written back from now on gets a rec lsn not less than next lsn
+  auto next_lsn = log_manager->GetNextLsn();
+  auto rec_lsn  = buffer_pool_manager_->GetMinRecLsn();
+  auto redo_lsn = rec_lsn == INVALID_LSN ? next_lsn : std::min(rec_lsn, next_lsn);
+  auto scan_lsn = std::min({redo_lsn, log_manager->GetMinActiveLsn(), meta_lsn});
+  // the pages written back so far are only in the page cache, they must be durable before restart skips their records
+  disk_manager_->SyncDataFiles();
+  log_manager->Checkpoint(redo_lsn, scan_lsn);
+  last_checkpoint_lsn_ = next_lsn;
+}
 
-void Recovery::AnalyzeLog() {}
+auto Recovery::GetTable(const LogRecord &rec) -> TableHandle *
+{
+  return db_hdl_->GetTable(OBJNAME_FROM_FILENAME(rec.file_name_));
+}
 
-void Recovery::Redo() {}
+auto Recovery::IsOfDB(const LogRecord &rec) const -> bool
+{
+  // files of the database are named db/obj.suffix
+  const auto &db_name = db_hdl_->GetName();
+  return rec.file_name_.size() > db_name.size() && rec.file_name_[db_name.size()] == '/' &&
+         rec.file_name_.compare(0, db_name.size(), db_name) == 0;
+}
 
-void Recovery::Undo() {}
+void Recovery::RedoRecord(TableHandle *tab, const LogRecord &rec)
+{
+  switch (rec.type_) {
+    case LogType::NEW_PAGE: tab->RecoverSlot(rec.page_id_, INVALID_SLOT_ID, {}, rec.lsn_); break;
+    case LogType::INSERT:
+    case LogType::UPDATE:
+    case LogType::CLR: tab->RecoverSlot(rec.page_id_, rec.slot_id_, rec.after_, rec.lsn_); break;
+    case LogType::DELETE: tab->RecoverSlot(rec.page_id_, rec.slot_id_, {}, rec.lsn_); break;
+    default: WSDB_FETAL(fmt::format("Unexpected log record type {}", static_cast<uint32_t>(rec.type_)));
+  }
+}
 }  // namespace wsdb
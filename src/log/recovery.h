@@ -22,10 +22,29 @@
 #ifndef WSDB_RECOVERY_H
 #define WSDB_RECOVERY_H
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "log/log_manager.h"
 #include "storage/storage.h"
 #include "system/handle/database_handle.h"
 
 namespace wsdb {
+
+/**
+ * ARIES style restart of the databases from the write-ahead log.
+ * AnalyzeLog reads the log from the scan offset of the last checkpoint once for all databases and finds the
+ * transactions that neither committed nor aborted, a transaction may have changed several databases. Then every
+ * database is set in turn: Redo repeats its history from the redo lsn of the checkpoint, the records are partitioned by
+ * page over RECOVERY_REDO_WORKER_NUM threads so that the records of a page are replayed in lsn order by one thread, and
+ * a record is skipped if the lsn of its page shows that it is already applied. Undo rolls back the changes the
+ * unfinished transactions made to the database, every undone record is compensated by a CLR so that a crash during
+ * undo never undoes a record twice. Table headers and indexes are not logged, they are rebuilt for the tables found in
+ * the log. AbortLosers ends the transactions once every database is rolled back.
+ *
+ * Checkpoints are fuzzy, nothing is blocked while one is taken, see Checkpoint
+ */
 class Recovery
 {
 
@@ -36,16 +55,61 @@ public:
 
   void SetDBHandle(DatabaseHandle *db_hdl);
 
+  /**
+   * Collect the page records of all databases and the transactions to roll back
+   */
   void AnalyzeLog();
 
+  /**
+   * Replay the page records of the database from the redo lsn in parallel, one thread per partition of the pages. The
+   * database is opened if the log has changes of it
+   */
   void Redo();
 
+  /**
+   * Roll back the changes the unfinished transactions made to the database with CLRs, then rebuild the headers and
+   * indexes of the tables found in the log and close the database
+   */
   void Undo();
 
+  /**
+   * End every unfinished transaction with an ABORT, called once all databases are undone so that a transaction is not
+   * taken as finished while a database still holds its changes
+   */
+  void AbortLosers();
+
+  /**
+   * Take a fuzzy checkpoint. Pages dirty since before the previous checkpoint are written first so that redo never
+   * has to go back further than one checkpoint interval, then the smallest rec lsn of the buffer pool becomes the redo
+   * lsn and the log is read from the first record of the oldest running transaction on restart. The data files are
+   * synced before the master record moves
+   * @param meta_lsn the table headers on disk reflect every record before it, see DatabaseHandle::FlushTableHeaders
+   */
+  void Checkpoint(lsn_t meta_lsn);
+
+private:
+  /// table changed by the record, nullptr if the table is dropped
+  auto GetTable(const LogRecord &rec) -> TableHandle *;
+
+  /// whether the record changes the database set by SetDBHandle
+  auto IsOfDB(const LogRecord &rec) const -> bool;
+
+  /// bring the slot of a page record or a CLR to the state after the record
+  static void RedoRecord(TableHandle *tab, const LogRecord &rec);
+
 private:
   DiskManager       *disk_manager_;
   BufferPoolManager *buffer_pool_manager_;
   DatabaseHandle    *db_hdl_{nullptr};
+
+  // built by AnalyzeLog for all databases
+  std::vector<LogRecord>                  records_;    // page records and CLRs in lsn order
+  std::unordered_map<lsn_t, size_t>       lsn_index_;  // lsn -> position in records_
+  std::unordered_map<txn_id_t, lsn_t>     losers_;     // transactions to roll back -> last lsn, CLRs included
+  std::unordered_map<std::string, size_t> page_nums_;  // table file -> number of pages the log shows
+
+  bool  db_opened_{false};                  // Redo has opened the database set by SetDBHandle
+  lsn_t last_checkpoint_lsn_{INVALID_LSN};  // next lsn when the previous checkpoint was taken
 };
 }  // namespace wsdb
 
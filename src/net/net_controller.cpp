@@ -21,14 +21,33 @@
 
 #include "net_controller.h"
 
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <fcntl.h>
+#include <poll.h>
 
 namespace wsdb {
 NetController::NetController()
 {
   max_client_  = net::MAX_CLIENTS;
   listen_port_ = net::SERVER_PORT;
+  epoll_fd_    = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    WSDB_FETAL(fmt::format("epoll_create1 failed: {}", strerror(errno)));
+  }
+  flusher_ = std::thread(&NetController::FlushLoop, this);
+}
+
+NetController::~NetController()
+{
+  {
+    std::unique_lock lock(latch_);
+    stop_ = true;
+    flush_cv_.notify_one();
+  }
+  flusher_.join();
+  close(epoll_fd_);
 }
 
 auto NetController::Listen() -> int
@@ -56,6 +75,16 @@ auto NetController::Listen() -> int
     WSDB_LOG("ERROR on listen");
     return -1;
   }
+  // Wait accepts every pending connection when the socket is readable, so accept must not block
+  fcntl(server_fd_, F_SETFL, fcntl(server_fd_, F_GETFL) | O_NONBLOCK);
+  struct epoll_event ev
+  {};
+  ev.events  = EPOLLIN;
+  ev.data.fd = server_fd_;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_fd_, &ev) < 0) {
+    WSDB_LOG("ERROR on watching server socket");
+    return -1;
+  }
   return 0;
 }
 auto NetController::Accept() const -> int
@@ -64,33 +93,143 @@ auto NetController::Accept() const -> int
   struct sockaddr_in cli_addr
   {};
   socklen_t clilen = sizeof(cli_addr);
-  client_sock      = accept(server_fd_, (struct sockaddr *)&cli_addr, &clilen);
+  client_sock      = accept4(server_fd_, (struct sockaddr *)&cli_addr, &clilen, SOCK_CLOEXEC);
   if (client_sock < 0) {
-    WSDB_LOG("ERROR on accept");
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      WSDB_LOG("ERROR on accept");
+    }
     return -1;
   }
   return client_sock;
 }
 void NetController::Close() const { close(server_fd_); }
-auto NetController::ReadSQL(int fd) -> std::string
+
+auto NetController::Wait(std::vector<int> &ready_fds, int timeout_ms) -> int
 {
-  auto &pkg_ = client_buffer_[fd];
-  auto  err  = net::ReadNetPkg(fd, pkg_);
-  if (err <= 0) {
-    WSDB_THROW(WSDB_CLIENT_DOWN, "");
+  ready_fds.clear();
+  struct epoll_event events[net::MAX_EVENTS];
+  auto               n = epoll_wait(epoll_fd_, events, net::MAX_EVENTS, timeout_ms);
+  if (n < 0) {
+    return errno == EINTR ? 0 : -1;
+  }
+  for (int i = 0; i < n; ++i) {
+    auto fd = events[i].data.fd;
+    if (fd != server_fd_) {
+      ready_fds.push_back(fd);
+      continue;
+    }
+    // take all pending connections, they are served once they send something
+    while (true) {
+      auto client_fd = Accept();
+      if (client_fd < 0) {
+        break;
+      }
+      Watch(client_fd);
+    }
+  }
+  return static_cast<int>(ready_fds.size());
+}
+
+void NetController::Watch(int fd)
+{
+  struct epoll_event ev
+  {};
+  ev.events  = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+  ev.data.fd = fd;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    WSDB_LOG(fmt::format("ERROR on watching client {}", fd));
+  }
+}
+
+void NetController::Rearm(int fd)
+{
+  struct epoll_event ev
+  {};
+  ev.events  = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+  ev.data.fd = fd;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) < 0) {
+    WSDB_LOG(fmt::format("ERROR on rearming client {}", fd));
   }
-  if (pkg_.type_ != net::NET_PKG_QUERY) {
+}
+auto NetController::ReadSQL(int fd) -> std::string
+{
+  auto req = ReadRequest(fd);
+  if (req.type_ != net::NET_PKG_QUERY) {
     WSDB_LOG("ERROR: not a query package");
     return "";
   }
-  return {pkg_.buf_, pkg_.len_};
+  return req.sql_;
+}
+
+auto NetController::ReadRequest(int fd) -> ClientRequest
+{
+  auto         &buffer = GetClientBuffer(fd);
+  auto         &pkg_   = buffer.pkg_;
+  ClientRequest req;
+  while (true) {
+    auto err = net::ReadNetPkg(fd, pkg_);
+    if (err <= 0) {
+      WSDB_THROW(WSDB_CLIENT_DOWN, "");
+    }
+    if (pkg_.type_ != net::NET_PKG_SET_FORMAT) {
+      break;
+    }
+    if (pkg_.len_ != 1 || static_cast<uint8_t>(pkg_.buf_[0]) > net::NET_FORMAT_BINARY) {
+      SendError(fd, "unknown result format");
+      continue;
+    }
+    buffer.format_ = static_cast<net::NetResultFormat>(pkg_.buf_[0]);
+    SendOK(fd);
+    // do not hold a worker waiting for a query that has not been sent yet
+    struct pollfd pfd
+    {
+      fd, POLLIN, 0
+    };
+    if (poll(&pfd, 1, 0) <= 0) {
+      return req;
+    }
+  }
+  req.type_ = pkg_.type_;
+  switch (pkg_.type_) {
+    case net::NET_PKG_QUERY:
+    case net::NET_PKG_PREPARE: req.sql_ = std::string(pkg_.buf_, pkg_.len_); break;
+    case net::NET_PKG_CLOSE_STMT:
+      if (pkg_.len_ != sizeof(req.stmt_id_)) {
+        pkg_.len_ = 0;
+        WSDB_THROW(WSDB_INVALID_SQL, "malformed close statement package");
+      }
+      memcpy(&req.stmt_id_, pkg_.buf_, sizeof(req.stmt_id_));
+      break;
+    case net::NET_PKG_EXECUTE: {
+      std::vector<net::NetParam> params;
+      if (!net::DecodeExecute(pkg_, req.stmt_id_, params)) {
+        pkg_.len_ = 0;
+        WSDB_THROW(WSDB_INVALID_SQL, "malformed execute package");
+      }
+      for (const auto &param : params) {
+        req.params_.push_back(MakeParamValue(param));
+      }
+      break;
+    }
+    default: WSDB_LOG(fmt::format("ERROR: unexpected package type {}", static_cast<int>(pkg_.type_)));
+  }
+  pkg_.len_ = 0;
+  return req;
+}
+
+void NetController::SendPrepared(int fd, uint32_t stmt_id, uint32_t param_num)
+{
+  auto &pkg_ = PreparePkg(fd, net::NET_PKG_PREPARED);
+  memcpy(pkg_.buf_, &stmt_id, sizeof(stmt_id));
+  memcpy(pkg_.buf_ + sizeof(stmt_id), &param_num, sizeof(param_num));
+  pkg_.len_ = sizeof(stmt_id) + sizeof(param_num);
+  FlushSend(fd);
 }
 
 void NetController::SendRecHeader(int fd, const RecordSchema *header)
 {
   // header format: {field_name}\t{field_name}\t ...
-  auto &pkg_ = client_buffer_[fd];
-  pkg_.type_ = net::NET_PKG_REC_HEADER;
+  auto       &pkg_ = PreparePkg(fd, net::NET_PKG_REC_HEADER);
   std::string header_str;
   for (int i = 0; i < static_cast<int>(header->GetFieldCount()); ++i) {
     auto &field = header->GetFieldAt(i);
@@ -110,82 +249,257 @@ void NetController::SendRecHeader(int fd, const RecordSchema *header)
     }
     header_str += '\t';
   }
+  if (header_str.size() > net::NET_BUFFER_SIZE) {
+    WSDB_THROW(WSDB_STRING_OVERFLOW, "record header exceeds the net buffer");
+  }
   pkg_.len_ = header_str.size();
   memcpy(pkg_.buf_, header_str.c_str(), pkg_.len_);
   FlushSend(fd);
+  auto &buffer = GetClientBuffer(fd);
+  if (buffer.format_ == net::NET_FORMAT_BINARY) {
+    buffer.block_ = std::make_unique<ResultBlockBuilder>(header);
+  }
 }
 void NetController::SendRec(int fd, const Record *rec)
 {
-  // append record to buffer and flush if buffer is full
-  auto &pkg_ = client_buffer_[fd];
-  pkg_.type_ = net::NET_PKG_REC_BODY;
+  auto &buffer = GetClientBuffer(fd);
+  if (buffer.format_ == net::NET_FORMAT_BINARY) {
+    WSDB_ASSERT(buffer.block_ != nullptr, "record header is not sent");
+    buffer.row_.clear();
+    for (size_t i = 0; i < rec->GetSchema()->GetFieldCount(); ++i) {
+      buffer.row_.push_back(rec->GetValueRefAt(i));
+    }
+    std::lock_guard guard(buffer.latch_);
+    AppendRow(fd, buffer);
+    return;
+  }
   // record format: {field_value}\t{field_value}\t ...
-  std::string rec_str;
+  auto &rec_str = buffer.rec_str_;
+  rec_str.clear();
   for (int i = 0; i < static_cast<int>(rec->GetSchema()->GetFieldCount()); ++i) {
     auto v = rec->GetValueAt(i);
     rec_str += v->ToString();
     rec_str += '\t';
   }
-  // FIXME: accumulate records and send, may cause client waiting sometimes
-  //  if (pkg_.len_ + rec_str.size() > net::NET_BUFFER_SIZE) {
-  //    FlushSend(fd);
-  //  }
-  memcpy(pkg_.buf_ + pkg_.len_, rec_str.c_str(), rec_str.size());
   // add '\0' to separate records
+  rec_str += '\0';
+  if (rec_str.size() > net::NET_BUFFER_SIZE) {
+    WSDB_THROW(WSDB_STRING_OVERFLOW, "record exceeds the net buffer");
+  }
+  std::lock_guard guard(buffer.latch_);
+  auto           &pkg_ = buffer.pkg_;
+  if (buffer.batch_open_ && pkg_.len_ + rec_str.size() > net::NET_BUFFER_SIZE) {
+    SendBatch(fd, buffer);
+  }
+  if (!buffer.batch_open_) {
+    pkg_.type_ = net::NET_PKG_REC_BODY;
+    pkg_.len_  = 0;
+    OpenBatch(buffer, fd);
+  }
+  memcpy(pkg_.buf_ + pkg_.len_, rec_str.data(), rec_str.size());
   pkg_.len_ += rec_str.size();
-  pkg_.buf_[pkg_.len_++] = '\0';
-  FlushSend(fd);
+  // the flusher skips a batch while records are added to it, so a busy batch is sent here once it is due
+  if (std::chrono::steady_clock::now() - buffer.batch_begin_ >= std::chrono::milliseconds(net::NET_FLUSH_INTERVAL_MS)) {
+    SendBatch(fd, buffer);
+  }
+}
+void NetController::SendChunk(int fd, const Chunk &chunk)
+{
+  auto &buffer = GetClientBuffer(fd);
+  if (buffer.format_ != net::NET_FORMAT_BINARY) {
+    for (auto row : chunk.GetSel()) {
+      auto rec = chunk.GetRecord(row);
+      SendRec(fd, rec.get());
+    }
+    return;
+  }
+  WSDB_ASSERT(buffer.block_ != nullptr, "record header is not sent");
+  auto            col_num = chunk.GetSchema()->GetFieldCount();
+  std::lock_guard guard(buffer.latch_);
+  for (auto row : chunk.GetSel()) {
+    buffer.row_.clear();
+    for (size_t col = 0; col < col_num; ++col) {
+      buffer.row_.push_back(ValueRef::FromValue(*chunk.GetValueAt(col, row)));
+    }
+    AppendRow(fd, buffer);
+  }
 }
 void NetController::SendRecFinish(int fd)
 {
-  auto &pkg_ = client_buffer_[fd];
-  //  if (pkg_.type_ == net::NET_PKG_REC_BODY) {
-  //    FlushSend(fd);
-  //  }
-  pkg_.type_ = net::NET_PKG_REC_END;
+  auto &pkg_ = PreparePkg(fd, net::NET_PKG_REC_END);
   pkg_.len_  = 0;
   FlushSend(fd);
 }
 void NetController::SendError(int fd, const std::string &error_msg)
 {
-  auto &pkg_ = client_buffer_[fd];
-  pkg_.type_ = net::NET_PKG_ERROR;
-  pkg_.len_  = error_msg.size();
+  auto &pkg_ = PreparePkg(fd, net::NET_PKG_ERROR);
+  pkg_.len_  = std::min(error_msg.size(), net::NET_BUFFER_SIZE);
   memcpy(pkg_.buf_, error_msg.c_str(), pkg_.len_);
   FlushSend(fd);
 }
 
 void NetController::SendOK(int fd)
 {
-  auto &pkg_ = client_buffer_[fd];
-  pkg_.type_ = net::NET_PKG_OK;
+  auto &pkg_ = PreparePkg(fd, net::NET_PKG_OK);
   pkg_.len_  = 0;
   FlushSend(fd);
 }
 
 void NetController::SendRawString(int fd, const std::string &str)
 {
-  auto &pkg_ = client_buffer_[fd];
-  pkg_.type_ = net::NET_PKG_RAW_STRING;
-  pkg_.len_  = str.size();
+  auto &pkg_ = PreparePkg(fd, net::NET_PKG_RAW_STRING);
+  pkg_.len_  = std::min(str.size(), net::NET_BUFFER_SIZE);
   memcpy(pkg_.buf_, str.c_str(), pkg_.len_);
   FlushSend(fd);
 }
 
 void NetController::FlushSend(int fd)
 {
-  auto err = net::WriteNetPkg(fd, client_buffer_[fd]);
+  auto &pkg_ = GetClientBuffer(fd).pkg_;
+  auto  err  = net::WriteNetPkg(fd, pkg_);
+  pkg_.len_  = 0;
   if (err <= 0) {
     WSDB_THROW(WSDB_CLIENT_DOWN, "");
   }
-  client_buffer_[fd].len_ = 0;
 }
 
 void NetController::Remove(int fd)
 {
-  if (client_buffer_.find(fd) != client_buffer_.end()) {
-    client_buffer_.erase(fd);
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  std::unique_lock lock(latch_);
+  auto             it = client_buffer_.find(fd);
+  if (it == client_buffer_.end()) {
+    return;
+  }
+  // wait for the flusher to finish a batch it is sending, it can not find the buffer again without the latch
+  {
+    std::lock_guard guard(it->second.latch_);
+  }
+  client_buffer_.erase(it);
+}
+
+auto NetController::MakeParamValue(const net::NetParam &param) -> ValueSptr
+{
+  static const FieldType types[] = {TYPE_INT, TYPE_FLOAT, TYPE_BOOL, TYPE_STRING};
+  auto                   type    = types[param.type_];
+  if (param.is_null_) {
+    return ValueFactory::CreateNullValue(type);
+  }
+  if (type == TYPE_STRING) {
+    return ValueFactory::CreateStringValue(param.data_.c_str(), param.data_.size());
+  }
+  auto size = type == TYPE_BOOL ? sizeof(bool) : sizeof(int32_t);
+  if (param.data_.size() != size) {
+    WSDB_THROW(WSDB_INVALID_SQL, fmt::format("parameter of {} bytes for type {}", param.data_.size(), FieldTypeToString(type)));
+  }
+  return ValueFactory::CreateValue(type, param.data_.data());
+}
+
+auto NetController::GetClientBuffer(int fd) -> ClientBuffer &
+{
+  // nodes of the map are stable, so the buffer can be used after the latch is released
+  std::unique_lock lock(latch_);
+  return client_buffer_[fd];
+}
+
+void NetController::OpenBatch(ClientBuffer &buffer, int fd)
+{
+  buffer.batch_open_  = true;
+  buffer.batch_begin_ = std::chrono::steady_clock::now();
+  std::unique_lock lock(latch_);
+  // batches are opened in deadline order, the flusher only needs waking if it has nothing to wait for
+  if (batch_deadlines_.empty()) {
+    flush_cv_.notify_one();
+  }
+  batch_deadlines_.emplace_back(buffer.batch_begin_ + std::chrono::milliseconds(net::NET_FLUSH_INTERVAL_MS), fd);
+}
+
+void NetController::SendBatch(int fd, ClientBuffer &buffer)
+{
+  if (buffer.down_) {
+    WSDB_THROW(WSDB_CLIENT_DOWN, "");
+  }
+  if (buffer.block_ != nullptr && buffer.block_->GetRowCount() > 0) {
+    buffer.block_->Encode(buffer.pkg_);
+  }
+  // a blocking write on the calling thread, a slow client holds back the executor by what the socket can not take
+  auto err           = net::WriteNetPkg(fd, buffer.pkg_, true);
+  buffer.pkg_.len_   = 0;
+  buffer.batch_open_ = false;
+  if (err <= 0) {
+    WSDB_THROW(WSDB_CLIENT_DOWN, "");
+  }
+}
+
+void NetController::AppendRow(int fd, ClientBuffer &buffer)
+{
+  auto &block    = *buffer.block_;
+  auto  row_size = block.GetRowSize(buffer.row_);
+  if (block.GetRowCount() > 0 && block.GetEncodedSize() + row_size > net::NET_BUFFER_SIZE) {
+    SendBatch(fd, buffer);
+  }
+  if (block.GetEncodedSize() + row_size > net::NET_BUFFER_SIZE) {
+    WSDB_THROW(WSDB_STRING_OVERFLOW, "record exceeds the net buffer");
+  }
+  if (!buffer.batch_open_) {
+    OpenBatch(buffer, fd);
   }
+  block.Append(buffer.row_);
+  if (std::chrono::steady_clock::now() - buffer.batch_begin_ >= std::chrono::milliseconds(net::NET_FLUSH_INTERVAL_MS)) {
+    SendBatch(fd, buffer);
+  }
+}
+
+void NetController::FlushLoop()
+{
+  std::unique_lock lock(latch_);
+  while (!stop_) {
+    if (batch_deadlines_.empty()) {
+      flush_cv_.wait(lock);
+      continue;
+    }
+    auto [deadline, fd] = batch_deadlines_.front();
+    if (std::chrono::steady_clock::now() < deadline) {
+      flush_cv_.wait_until(lock, deadline);
+      continue;
+    }
+    batch_deadlines_.pop_front();
+    auto it = client_buffer_.find(fd);
+    if (it == client_buffer_.end()) {
+      continue;
+    }
+    // a busy buffer is left to the thread adding records to it, it sends the batch itself once it is due
+    auto            &buffer = it->second;
+    std::unique_lock buffer_lock(buffer.latch_, std::try_to_lock);
+    if (!buffer_lock.owns_lock()) {
+      continue;
+    }
+    lock.unlock();
+    // the batch of the deadline may have been sent already, a newer batch has a deadline of its own
+    if (buffer.batch_open_ && deadline - buffer.batch_begin_ >= std::chrono::milliseconds(net::NET_FLUSH_INTERVAL_MS)) {
+      try {
+        SendBatch(fd, buffer);
+      } catch (WSDBException_ &) {
+        // reported to the thread serving the client on its next send
+        buffer.down_ = true;
+      }
+    }
+    buffer_lock.unlock();
+    lock.lock();
+  }
+}
+
+auto NetController::PreparePkg(int fd, net::NetPkgType type) -> net::NetPkg &
+{
+  auto           &buffer = GetClientBuffer(fd);
+  std::lock_guard guard(buffer.latch_);
+  auto           &pkg_ = buffer.pkg_;
+  if (buffer.batch_open_ || buffer.down_) {
+    SendBatch(fd, buffer);
+  }
+  pkg_.type_ = type;
+  pkg_.len_  = 0;
+  return pkg_;
 }
 
-}  // namespace wsdb
\ No newline at end of file
+}  // namespace wsdb
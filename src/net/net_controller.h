@@ -21,30 +21,82 @@
 
 #ifndef WSDB_NET_CONTROLLER_H
 #define WSDB_NET_CONTROLLER_H
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "system/handle/record_handle.h"
+#include "result_block.h"
 #include "../common/net/net.h"
 
 namespace wsdb {
 
+/// a request of a client, sql_ is empty if the client has not sent anything but format changes yet
+struct ClientRequest
+{
+  net::NetPkgType type_{net::NET_PKG_QUERY};
+  // query of NET_PKG_QUERY or statement of NET_PKG_PREPARE
+  std::string sql_;
+  // prepared statement of NET_PKG_EXECUTE and NET_PKG_CLOSE_STMT
+  uint32_t               stmt_id_{0};
+  std::vector<ValueSptr> params_;
+};
+
 class NetController
 {
 public:
   NetController();
+
+  ~NetController();
+
   auto Listen() -> int;
 
   auto Accept() const -> int;
 
   void Close() const;
 
+  /**
+   * wait up to timeout_ms for clients to become readable, new connections are accepted and watched on the way.
+   * a client is reported once and not watched again until Rearm, so only one worker serves it at a time
+   * @param ready_fds filled with the clients that have input or have hung up
+   * @return number of ready clients, -1 on error
+   */
+  auto Wait(std::vector<int> &ready_fds, int timeout_ms) -> int;
+
+  /// watch a connected client for input
+  void Watch(int fd);
+
+  /// watch the client again after it was reported by Wait
+  void Rearm(int fd);
+
+  /**
+   * read the next query of the client, NET_PKG_SET_FORMAT packages before it are answered with NET_PKG_OK and change
+   * the format records are sent in. returns an empty string if the client has nothing more to send after them
+   */
   auto ReadSQL(int fd) -> std::string;
 
+  /// read the next query or prepared statement request of the client, format changes are handled like in ReadSQL
+  auto ReadRequest(int fd) -> ClientRequest;
+
+  /// answer NET_PKG_PREPARE with the id the statement is executed by
+  void SendPrepared(int fd, uint32_t stmt_id, uint32_t param_num);
+
   void SendRecHeader(int fd, const RecordSchema *header);
 
-  /// record will be stored until buffer is full and flush to socket
+  /**
+   * record will be stored until buffer is full or the batch is older than NET_FLUSH_INTERVAL_MS, the flusher sends a
+   * batch that is due even if no more records come
+   */
   void SendRec(int fd, const Record *rec);
 
+  /// send the selected rows of a chunk, in the binary format the values go to the block without making records
+  void SendChunk(int fd, const Chunk &chunk);
+
   void SendRecFinish(int fd);
 
   void SendError(int fd, const std::string &error_msg);
@@ -58,11 +110,56 @@ public:
   void Remove(int fd);
 
 private:
-  // currently receive and send use the same pkg_
-  int                                  server_fd_{0};
-  int                                  listen_port_{0};
-  int                                  max_client_{0};
-  std::unordered_map<int, net::NetPkg> client_buffer_;
+  /// @brief Buffer of a client, the package is written by the thread serving the client or by the flusher
+  struct ClientBuffer
+  {
+    // held while records are added to the batch or the batch is sent
+    std::mutex latch_;
+    // currently receive and send use the same package
+    net::NetPkg pkg_;
+    // the package or the block holds records that are not sent yet, only then the flusher touches the package
+    bool                                  batch_open_{false};
+    std::chrono::steady_clock::time_point batch_begin_;
+    // a batch sent by the flusher failed, the client is down
+    bool                                  down_{false};
+    std::string                           rec_str_;
+    net::NetResultFormat                  format_{net::NET_FORMAT_TEXT};
+    // records of the binary format, set up by SendRecHeader
+    std::unique_ptr<ResultBlockBuilder> block_;
+    std::vector<ValueRef>               row_;
+  };
+
+  auto GetClientBuffer(int fd) -> ClientBuffer &;
+
+  static auto MakeParamValue(const net::NetParam &param) -> ValueSptr;
+
+  /// start a batch of records in the package, the flusher sends it once it is due, buffer.latch_ is held
+  void OpenBatch(ClientBuffer &buffer, int fd);
+
+  /// send the records of the open batch, buffer.latch_ is held
+  static void SendBatch(int fd, ClientBuffer &buffer);
+
+  /// append buffer.row_ to the block, the block is sent once full, buffer.latch_ is held
+  void AppendRow(int fd, ClientBuffer &buffer);
+
+  /// send the batches that are older than NET_FLUSH_INTERVAL_MS at their deadline
+  void FlushLoop();
+
+  /// get the package to fill for a non-record package, records still buffered are sent before it
+  auto PreparePkg(int fd, net::NetPkgType type) -> net::NetPkg &;
+
+  int                                   server_fd_{0};
+  int                                   epoll_fd_{-1};
+  int                                   listen_port_{0};
+  int                                   max_client_{0};
+  std::mutex                            latch_;  // protects client_buffer_, clients are served by different threads
+  std::unordered_map<int, ClientBuffer> client_buffer_;
+
+  // deadlines of the open batches with their clients, in the order the batches were opened
+  std::deque<std::pair<std::chrono::steady_clock::time_point, int>> batch_deadlines_;
+  std::condition_variable                                           flush_cv_;  // wakes the flusher
+  bool                                                              stop_{false};
+  std::thread                                                       flusher_;
 };
 
 }  // namespace wsdb
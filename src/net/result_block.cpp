@@ -0,0 +1,131 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/29.
+//
+
+#include "result_block.h"
+#include <cstring>
+
+namespace wsdb {
+
+ResultBlockBuilder::ResultBlockBuilder(const RecordSchema *schema)
+{
+  for (const auto &field : schema->GetFields()) {
+    Column col{};
+    switch (field.field_.field_type_) {
+      case TYPE_INT: col.type_ = net::NET_COL_INT; break;
+      case TYPE_FLOAT: col.type_ = net::NET_COL_FLOAT; break;
+      case TYPE_BOOL: col.type_ = net::NET_COL_BOOL; break;
+      case TYPE_STRING: col.type_ = net::NET_COL_STRING; break;
+      default:
+        WSDB_THROW(WSDB_TYPE_MISSMATCH,
+            fmt::format("cannot send {} in binary format", FieldTypeToString(field.field_.field_type_)));
+    }
+    cols_.push_back(std::move(col));
+  }
+}
+
+auto ResultBlockBuilder::GetEncodedSize() const -> size_t
+{
+  size_t size = sizeof(uint32_t) * 2;
+  for (const auto &col : cols_) {
+    size += sizeof(uint8_t) + BITMAP_SIZE(row_num_) + col.data_.size() + col.lens_.size() * sizeof(uint32_t);
+  }
+  return size;
+}
+
+auto ResultBlockBuilder::GetRowSize(const std::vector<ValueRef> &row) const -> size_t
+{
+  // one more byte of null bitmap per column at most
+  size_t size = cols_.size();
+  for (size_t i = 0; i < cols_.size(); ++i) {
+    switch (cols_[i].type_) {
+      case net::NET_COL_BOOL: size += 1; break;
+      case net::NET_COL_STRING: size += sizeof(uint32_t) + (row[i].IsNull() ? 0 : row[i].GetString().size()); break;
+      default: size += 4;
+    }
+  }
+  return size;
+}
+
+void ResultBlockBuilder::Append(const std::vector<ValueRef> &row)
+{
+  WSDB_ASSERT(row.size() == cols_.size(), "field count mismatch");
+  for (size_t i = 0; i < cols_.size(); ++i) {
+    auto &col = cols_[i];
+    auto &val = row[i];
+    if (row_num_ % 8 == 0) {
+      col.nulls_.push_back(0);
+    }
+    if (val.IsNull()) {
+      col.nulls_.back() |= static_cast<uint8_t>(1 << (row_num_ % 8));
+    }
+    switch (col.type_) {
+      case net::NET_COL_INT: {
+        int32_t v = val.IsNull() ? 0 : val.GetInt();
+        col.data_.insert(col.data_.end(), reinterpret_cast<char *>(&v), reinterpret_cast<char *>(&v) + sizeof(v));
+        break;
+      }
+      case net::NET_COL_FLOAT: {
+        // an int may be sent for a float field, e.g. the result of an aggregate
+        float v = val.IsNull() ? 0 : val.GetNumber();
+        col.data_.insert(col.data_.end(), reinterpret_cast<char *>(&v), reinterpret_cast<char *>(&v) + sizeof(v));
+        break;
+      }
+      case net::NET_COL_BOOL: col.data_.push_back(static_cast<char>(!val.IsNull() && val.GetBool())); break;
+      case net::NET_COL_STRING: {
+        auto str = val.IsNull() ? std::string_view() : val.GetString();
+        col.lens_.push_back(static_cast<uint32_t>(str.size()));
+        col.data_.insert(col.data_.end(), str.begin(), str.end());
+        break;
+      }
+    }
+  }
+  row_num_++;
+}
+
+void ResultBlockBuilder::Encode(net::NetPkg &pkg)
+{
+  WSDB_ASSERT(GetEncodedSize() <= net::NET_BUFFER_SIZE, "block exceeds the net buffer");
+  auto pos   = pkg.buf_;
+  auto write = [&pos](const void *src, size_t len) {
+    if (len > 0) {
+      memcpy(pos, src, len);
+      pos += len;
+    }
+  };
+  auto row_num = static_cast<uint32_t>(row_num_);
+  auto col_num = static_cast<uint32_t>(cols_.size());
+  write(&row_num, sizeof(row_num));
+  write(&col_num, sizeof(col_num));
+  for (auto &col : cols_) {
+    write(&col.type_, sizeof(col.type_));
+    write(col.nulls_.data(), col.nulls_.size());
+    write(col.lens_.data(), col.lens_.size() * sizeof(uint32_t));
+    write(col.data_.data(), col.data_.size());
+    col.nulls_.clear();
+    col.data_.clear();
+    col.lens_.clear();
+  }
+  pkg.type_ = net::NET_PKG_REC_BLOCK;
+  pkg.len_  = static_cast<size_t>(pos - pkg.buf_);
+  row_num_  = 0;
+}
+
+}  // namespace wsdb
@@ -0,0 +1,72 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/29.
+//
+
+/**
+ * @brief Build NET_PKG_REC_BLOCK packages, records are appended a row at a time and stored by column until the block
+ * is encoded into a package, see net::NetColType for the layout
+ */
+
+#ifndef WSDB_RESULT_BLOCK_H
+#define WSDB_RESULT_BLOCK_H
+
+#include "system/handle/record_handle.h"
+#include "../common/net/net.h"
+
+namespace wsdb {
+
+class ResultBlockBuilder
+{
+public:
+  ResultBlockBuilder() = delete;
+
+  explicit ResultBlockBuilder(const RecordSchema *schema);
+
+  [[nodiscard]] auto GetColCount() const -> size_t { return cols_.size(); }
+
+  [[nodiscard]] auto GetRowCount() const -> size_t { return row_num_; }
+
+  /// bytes the block takes once encoded
+  [[nodiscard]] auto GetEncodedSize() const -> size_t;
+
+  /// upper bound of the bytes a row adds to the encoded block
+  [[nodiscard]] auto GetRowSize(const std::vector<ValueRef> &row) const -> size_t;
+
+  void Append(const std::vector<ValueRef> &row);
+
+  /// encode the block into the package and clear it
+  void Encode(net::NetPkg &pkg);
+
+private:
+  struct Column
+  {
+    net::NetColType       type_;
+    std::vector<uint8_t>  nulls_;
+    std::vector<char>     data_;
+    std::vector<uint32_t> lens_;  // length of each string, only used by string columns
+  };
+
+  std::vector<Column> cols_;
+  size_t              row_num_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_RESULT_BLOCK_H
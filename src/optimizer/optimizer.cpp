@@ -20,6 +20,10 @@
 //
 
 #include "optimizer.h"
+
+#include <bit>
+#include <functional>
+
 namespace wsdb {
 auto Optimizer::Optimize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
 {
@@ -50,15 +54,21 @@ auto Optimizer::LogicalOptimize(std::shared_ptr<AbstractPlan> plan, DatabaseHand
     proj->child_ = LogicalOptimize(proj->child_, db);
     return proj;
   } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+    if (join->type_ == INNER_JOIN) {
+      return LogicalOptimizeJoinOrder(join, db);
+    }
     join->left_  = LogicalOptimize(join->left_, db);
     join->right_ = LogicalOptimize(join->right_, db);
-    return LogicalOptimizeJoin(join);
+    return LogicalOptimizeJoin(join, db);
   } else if (auto agg = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
     agg->child_ = LogicalOptimize(agg->child_, db);
     return agg;
   } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
     lim->child_ = LogicalOptimize(lim->child_, db);
-    return lim;
+    return LogicalOptimizeLimit(lim);
+  } else if (auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    top_n->child_ = LogicalOptimize(top_n->child_, db);
+    return top_n;
   }
   return plan;
 }
@@ -77,17 +87,21 @@ auto Optimizer::LogicalOptimizeScan(const std::shared_ptr<ScanPlan> &scan, Condi
   return new_scan;
 }
 
-auto Optimizer::LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shared_ptr<AbstractPlan>
+auto Optimizer::LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join, DatabaseHandle *db)
+    -> std::shared_ptr<AbstractPlan>
 {
   if (join->strategy_ == NESTED_LOOP) {
     return join;
   }
-  WSDB_ASSERT(join->strategy_ == SORT_MERGE, "Unknown join strategy");
-  // try to generate SortMergeJoin
-  // check if all conditions are equality comparison
-  auto all_eq =
-      std::all_of(join->conds_.begin(), join->conds_.end(), [](const auto &cond) { return cond.GetOp() == OP_EQ; });
-  if (!all_eq) {
+  WSDB_ASSERT(join->strategy_ == SORT_MERGE || join->strategy_ == HASH_JOIN || join->strategy_ == COST_BASED,
+      "Unknown join strategy");
+  // try to generate SortMergeJoin or HashJoin
+  // check if all conditions are equality comparison between columns
+  auto all_eq = std::all_of(join->conds_.begin(), join->conds_.end(), [](const auto &cond) {
+    return cond.GetOp() == OP_EQ && cond.GetRhsType() == kColumn;
+  });
+  // a hash join without keys degenerates into a nested loop over a single bucket
+  if (!all_eq || (join->strategy_ != SORT_MERGE && join->conds_.empty())) {
     join->strategy_ = NESTED_LOOP;
     return join;
   }
@@ -101,13 +115,46 @@ auto Optimizer::LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shar
     left_key_fields.push_back(cond.GetLCol());
     right_key_fields.push_back(cond.GetRCol());
   }
-  std::shared_ptr<AbstractPlan> left = std::dynamic_pointer_cast<IdxScanPlan>(join->left_);
+  // an index scan over a b+tree whose key starts with the join keys already returns the records in order, the filter
+  // that keeps the conditions of the scan above it does not change the order
+  auto sorted_by = [db](const std::shared_ptr<AbstractPlan> &plan, const std::vector<RTField> &key_fields) {
+    auto filter   = std::dynamic_pointer_cast<FilterPlan>(plan);
+    auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(filter != nullptr ? filter->child_ : plan);
+    if (idx_scan == nullptr) {
+      return false;
+    }
+    auto index = db->GetIndex(idx_scan->idx_id_);
+    if (index->GetIndexType() != IndexType::BPTREE || index->GetKeySchema().GetFieldCount() < key_fields.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < key_fields.size(); ++i) {
+      const auto &field = index->GetKeySchema().GetFieldAt(i).field_;
+      if (field.table_id_ != key_fields[i].field_.table_id_ || field.field_name_ != key_fields[i].field_.field_name_) {
+        return false;
+      }
+    }
+    return true;
+  };
+  if (join->strategy_ == COST_BASED) {
+    // merging inputs that already come in key order needs neither a sort nor a hash table
+    join->strategy_ =
+        sorted_by(join->left_, left_key_fields) && sorted_by(join->right_, right_key_fields) ? SORT_MERGE : HASH_JOIN;
+  }
+  if (join->strategy_ == HASH_JOIN) {
+    // no sort is needed, build on the input expected to be smaller, the left one is preserved by an outer join
+    // either way
+    join->left_key_schema_  = std::make_unique<RecordSchema>(left_key_fields);
+    join->right_key_schema_ = std::make_unique<RecordSchema>(right_key_fields);
+    join->build_left_       = EstimateRows(join->left_, db) < EstimateRows(join->right_, db);
+    return join;
+  }
+  std::shared_ptr<AbstractPlan> left = join->left_;
   // generate sort plan
-  if (left == nullptr) {
+  if (!sorted_by(left, left_key_fields)) {
     left = std::make_shared<SortPlan>(std::move(join->left_), std::make_unique<RecordSchema>(left_key_fields), false);
   }
-  std::shared_ptr<AbstractPlan> right = std::dynamic_pointer_cast<IdxScanPlan>(join->right_);
-  if (right == nullptr) {
+  std::shared_ptr<AbstractPlan> right = join->right_;
+  if (!sorted_by(right, right_key_fields)) {
     right =
         std::make_shared<SortPlan>(std::move(join->right_), std::make_unique<RecordSchema>(right_key_fields), false);
   }
@@ -118,6 +165,287 @@ auto Optimizer::LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shar
   return join;
 }
 
+auto Optimizer::LogicalOptimizeJoinOrder(std::shared_ptr<JoinPlan> join, DatabaseHandle *db)
+    -> std::shared_ptr<AbstractPlan>
+{
+  // flatten the tree of inner joins into its inputs and the conditions between them
+  std::vector<std::shared_ptr<AbstractPlan>> leaves;
+  ConditionVec                               conds;
+  std::function<void(const std::shared_ptr<AbstractPlan> &)> flatten = [&](const auto &plan) {
+    auto inner = std::dynamic_pointer_cast<JoinPlan>(plan);
+    if (inner == nullptr || inner->type_ != INNER_JOIN) {
+      leaves.push_back(plan);
+      return;
+    }
+    flatten(inner->left_);
+    flatten(inner->right_);
+    conds.insert(conds.end(), inner->conds_.begin(), inner->conds_.end());
+  };
+  flatten(join);
+  // every input is a set of tables, a condition joins the inputs of its two columns
+  std::unordered_map<table_id_t, uint64_t> table_masks;
+  std::function<bool(const std::shared_ptr<AbstractPlan> &, uint64_t)> add_tables = [&](const auto &plan,
+                                                                                       uint64_t     mask) {
+    if (auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+      auto tab = db->GetTable(scan->table_name_);
+      return tab != nullptr && table_masks.emplace(tab->GetTableId(), mask).second;
+    } else if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+      return add_tables(filter->child_, mask);
+    } else if (auto outer = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+      return add_tables(outer->left_, mask) && add_tables(outer->right_, mask);
+    }
+    return false;
+  };
+  bool reorder = leaves.size() <= 64;
+  for (size_t i = 0; reorder && i < leaves.size(); ++i) {
+    reorder = add_tables(leaves[i], uint64_t{1} << i);
+  }
+  std::vector<std::pair<uint64_t, uint64_t>> cond_masks;
+  for (const auto &cond : conds) {
+    if (!reorder || cond.GetRhsType() != kColumn) {
+      reorder = false;
+      break;
+    }
+    auto l = table_masks.find(cond.GetLCol().field_.table_id_);
+    auto r = table_masks.find(cond.GetRCol().field_.table_id_);
+    reorder = l != table_masks.end() && r != table_masks.end() && l->second != r->second;
+    cond_masks.emplace_back(reorder ? l->second : 0, reorder ? r->second : 0);
+  }
+  if (!reorder) {
+    join->left_  = LogicalOptimize(join->left_, db);
+    join->right_ = LogicalOptimize(join->right_, db);
+    return LogicalOptimizeJoin(join, db);
+  }
+
+  struct JoinRel
+  {
+    double   rows_;
+    double   cost_;
+    uint64_t left_;  // the inputs on one side of the cheapest join, 0 for a single input
+  };
+  std::unordered_map<uint64_t, JoinRel> rels;
+  for (size_t i = 0; i < leaves.size(); ++i) {
+    leaves[i] = LogicalOptimize(leaves[i], db);
+    auto rows = std::max(1.0, static_cast<double>(EstimateRows(leaves[i], db)));
+    rels[uint64_t{1} << i] = {rows, rows, 0};
+  }
+  // the conditions between two disjoint sets of inputs, with the columns of a on the left
+  auto conds_between = [&](uint64_t a, uint64_t b) {
+    ConditionVec between;
+    for (size_t i = 0; i < conds.size(); ++i) {
+      auto [l, r] = cond_masks[i];
+      if ((l & a) != 0 && (r & b) != 0) {
+        between.push_back(conds[i]);
+      } else if ((l & b) != 0 && (r & a) != 0) {
+        between.push_back(conds[i].Flip());
+      }
+    }
+    return between;
+  };
+  // a join reads both inputs once when it can hash or merge on equalities, and every pair of rows otherwise
+  auto join_rel = [&](uint64_t a, uint64_t b, const ConditionVec &between) {
+    const auto &ra       = rels.at(a);
+    const auto &rb       = rels.at(b);
+    double      sel      = EstimateJoinSelectivity(between, ra.rows_, rb.rows_, db);
+    double      rows     = std::max(1.0, ra.rows_ * rb.rows_ * sel);
+    bool        has_keys = !between.empty() && std::all_of(between.begin(), between.end(), [](const auto &cond) {
+      return cond.GetOp() == OP_EQ;
+    });
+    double      work     = has_keys ? ra.rows_ + rb.rows_ : ra.rows_ * rb.rows_;
+    return JoinRel{rows, ra.cost_ + rb.cost_ + work + rows, a};
+  };
+
+  auto all = leaves.size() == 64 ? ~uint64_t{0} : (uint64_t{1} << leaves.size()) - 1;
+  if (leaves.size() <= JOIN_REORDER_DP_LIMIT) {
+    // subsets are visited after all their own subsets. a cross product is priced like any other join, so it ends up
+    // at the top for inputs that are not connected, and low in the tree only for inputs small enough, e.g. the
+    // filtered dimensions of a star join
+    for (uint64_t mask = 1; mask <= all; ++mask) {
+      if (std::has_single_bit(mask)) {
+        continue;
+      }
+      auto lowest = mask & (~mask + 1);
+      // one side holds the lowest input so that every split is tried once
+      for (uint64_t a = (mask - 1) & mask; a > 0; a = (a - 1) & mask) {
+        if ((a & lowest) == 0) {
+          continue;
+        }
+        auto rel = join_rel(a, mask ^ a, conds_between(a, mask ^ a));
+        auto it  = rels.find(mask);
+        if (it == rels.end() || rel.cost_ < it->second.cost_) {
+          rels[mask] = rel;
+        }
+      }
+    }
+  } else {
+    // join the connected pair with the smallest result until one input is left
+    std::vector<uint64_t> parts;
+    for (size_t i = 0; i < leaves.size(); ++i) {
+      parts.push_back(uint64_t{1} << i);
+    }
+    while (parts.size() > 1) {
+      size_t  best_i         = 0;
+      size_t  best_j         = 1;
+      bool    best_connected = false;
+      JoinRel best{};
+      for (size_t i = 0; i < parts.size(); ++i) {
+        for (size_t j = i + 1; j < parts.size(); ++j) {
+          auto between   = conds_between(parts[i], parts[j]);
+          bool connected = !between.empty();
+          auto rel       = join_rel(parts[i], parts[j], between);
+          if ((i == 0 && j == 1) || (connected && !best_connected) ||
+              (connected == best_connected && rel.rows_ < best.rows_)) {
+            best_i         = i;
+            best_j         = j;
+            best_connected = connected;
+            best           = rel;
+          }
+        }
+      }
+      rels[parts[best_i] | parts[best_j]] = best;
+      parts[best_i] |= parts[best_j];
+      parts.erase(parts.begin() + static_cast<std::ptrdiff_t>(best_j));
+    }
+  }
+
+  std::function<std::shared_ptr<AbstractPlan>(uint64_t)> build = [&](uint64_t mask) -> std::shared_ptr<AbstractPlan> {
+    if (std::has_single_bit(mask)) {
+      return leaves[std::countr_zero(mask)];
+    }
+    auto a = rels.at(mask).left_;
+    auto b = mask ^ a;
+    // the larger input goes to the left, where a hash join probes and a nested loop join scans once
+    if (rels.at(a).rows_ < rels.at(b).rows_) {
+      std::swap(a, b);
+    }
+    auto between = conds_between(a, b);
+    auto plan    = std::make_shared<JoinPlan>(build(a), build(b), between, INNER_JOIN, join->strategy_);
+    return LogicalOptimizeJoin(plan, db);
+  };
+  return build(all);
+}
+
+auto Optimizer::LogicalOptimizeLimit(std::shared_ptr<LimitPlan> lim) -> std::shared_ptr<AbstractPlan>
+{
+  if (lim->limit_ > TOP_N_MAX_LIMIT) {
+    return lim;
+  }
+  auto make_top_n = [&lim](const std::shared_ptr<SortPlan> &sort) {
+    return std::make_shared<TopNPlan>(
+        std::move(sort->child_), std::move(sort->key_schema_), sort->is_desc_, lim->limit_);
+  };
+  if (auto sort = std::dynamic_pointer_cast<SortPlan>(lim->child_)) {
+    return make_top_n(sort);
+  }
+  // a projection keeps the order and the number of rows, so the limit can be applied below it
+  if (auto proj = std::dynamic_pointer_cast<ProjectPlan>(lim->child_)) {
+    if (auto sort = std::dynamic_pointer_cast<SortPlan>(proj->child_)) {
+      proj->child_ = make_top_n(sort);
+      return proj;
+    }
+  }
+  return lim;
+}
+
+auto Optimizer::EstimateRows(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> size_t
+{
+  if (auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+    auto tab = db->GetTable(scan->table_name_);
+    return tab == nullptr ? 0 : tab->GetTableHeader().rec_num_;
+  } else if (auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
+    auto tab = db->GetTable(idx_scan->table_name_);
+    if (tab == nullptr) {
+      return 0;
+    }
+    if (tab->GetStatistics() == nullptr) {
+      return tab->GetTableHeader().rec_num_ / 10;
+    }
+    auto rows = static_cast<double>(tab->GetTableHeader().rec_num_);
+    for (const auto &cond : idx_scan->conds_) {
+      rows *= EstimateSelectivity(cond, db);
+    }
+    return static_cast<size_t>(rows);
+  } else if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    // the conditions of an index scan are kept in the filter above it, so they are counted once against the table
+    size_t rows = 0;
+    if (auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(filter->child_)) {
+      rows = EstimateRows(std::make_shared<ScanPlan>(idx_scan->table_name_), db);
+    } else {
+      rows = EstimateRows(filter->child_, db);
+    }
+    auto sel = 1.0;
+    for (const auto &cond : filter->conds_) {
+      sel *= EstimateSelectivity(cond, db);
+    }
+    return static_cast<size_t>(static_cast<double>(rows) * sel);
+  } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+    auto left  = static_cast<double>(EstimateRows(join->left_, db));
+    auto right = static_cast<double>(EstimateRows(join->right_, db));
+    auto rows  = left * right * EstimateJoinSelectivity(join->conds_, left, right, db);
+    // every left row is kept by an outer join
+    if (join->type_ == OUTER_JOIN) {
+      rows = std::max(rows, left);
+    }
+    return static_cast<size_t>(std::min(rows, 1e18));
+  } else if (auto sort = std::dynamic_pointer_cast<SortPlan>(plan)) {
+    return EstimateRows(sort->child_, db);
+  } else if (auto proj = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
+    return EstimateRows(proj->child_, db);
+  } else if (auto agg = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+    return EstimateRows(agg->child_, db);
+  } else if (auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+    return std::min(EstimateRows(lim->child_, db), lim->limit_);
+  } else if (auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    return std::min(EstimateRows(top_n->child_, db), top_n->limit_);
+  }
+  return 0;
+}
+
+auto Optimizer::EstimateSelectivity(const Condition &cond, DatabaseHandle *db) -> double
+{
+  // without statistics assume each condition keeps a third of the rows
+  constexpr double default_sel = 1.0 / 3;
+  const auto      &field       = cond.GetLCol().field_;
+  if (cond.GetRhsType() != kValue || field.table_id_ == INVALID_TABLE_ID) {
+    return default_sel;
+  }
+  auto tab   = db->GetTable(field.table_id_);
+  auto stats = tab == nullptr ? nullptr : tab->GetStatistics();
+  if (stats == nullptr) {
+    return default_sel;
+  }
+  auto sel = stats->Selectivity(tab->GetSchema().GetRTFieldIndex(cond.GetLCol()), cond.GetOp(), *cond.GetRVal());
+  return sel < 0 ? default_sel : sel;
+}
+
+auto Optimizer::EstimateJoinSelectivity(
+    const ConditionVec &conds, double left_rows, double right_rows, DatabaseHandle *db) -> double
+{
+  auto sel = 1.0;
+  for (const auto &cond : conds) {
+    if (cond.GetRhsType() != kColumn || cond.GetOp() != OP_EQ) {
+      sel /= 3;
+      continue;
+    }
+    // an equality matches each value of the column with fewer distinct values to one of the other column
+    size_t ndv = 0;
+    for (const auto *col : {&cond.GetLCol(), &cond.GetRCol()}) {
+      if (col->field_.table_id_ == INVALID_TABLE_ID) {
+        continue;
+      }
+      auto tab   = db->GetTable(col->field_.table_id_);
+      auto stats = tab == nullptr ? nullptr : tab->GetStatistics();
+      auto idx   = tab == nullptr ? 0 : tab->GetSchema().GetRTFieldIndex(*col);
+      if (stats != nullptr && idx < stats->columns_.size()) {
+        ndv = std::max(ndv, stats->columns_[idx].ndv_);
+      }
+    }
+    // without statistics assume a key of the larger input, each row of the smaller one finds one match
+    sel /= ndv > 0 ? static_cast<double>(ndv) : std::max({left_rows, right_rows, 1.0});
+  }
+  return sel;
+}
+
 auto Optimizer::PhysicalOptimize(
     std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>
 {
@@ -131,31 +459,48 @@ auto Optimizer::CanIndexScan(ConditionVec &conds, ConditionVec &index_conds, con
   max_matched_fields      = 0;
   IndexHandle *best_index = nullptr;
   for (const auto idx : indexes) {
+    // key fields fixed by equalities form a prefix, the first field that is not fixed may still be bounded by ranges
     std::vector<int> tmp_conds_pos;
+    size_t           matched_fields = 0;
+    bool             is_hash        = idx->GetIndexType() == IndexType::HASH;
     for (const auto &field : idx->GetKeySchema().GetFields()) {
-      bool matched = false;
+      std::vector<int> eq_pos;
+      std::vector<int> range_pos;
       for (int i = 0; i < static_cast<int>(conds.size()); ++i) {
         auto       &cond = conds[i];
         const auto &lcol = cond.GetLCol();
-        if (lcol.field_.table_id_ == field.field_.table_id_ && lcol.field_.field_name_ == field.field_.field_name_) {
-          matched = true;
-          if (cond.GetOp() != OP_EQ) {
-            matched = false;
-          }
-          tmp_conds_pos.push_back(i);
-          break;
+        if (cond.GetRhsType() != kValue || lcol.field_.table_id_ != field.field_.table_id_ ||
+            lcol.field_.field_name_ != field.field_.field_name_) {
+          continue;
+        }
+        if (cond.GetOp() == OP_EQ) {
+          eq_pos.push_back(i);
+        } else if (cond.GetOp() == OP_LT || cond.GetOp() == OP_LE || cond.GetOp() == OP_GT || cond.GetOp() == OP_GE) {
+          range_pos.push_back(i);
         }
       }
-      if (!matched) {
-        break;
+      if (!eq_pos.empty()) {
+        tmp_conds_pos.insert(tmp_conds_pos.end(), eq_pos.begin(), eq_pos.end());
+        matched_fields++;
+        continue;
       }
+      if (!range_pos.empty() && !is_hash) {
+        tmp_conds_pos.insert(tmp_conds_pos.end(), range_pos.begin(), range_pos.end());
+        matched_fields++;
+      }
+      break;
+    }
+    // a hash index only finds keys equal on all the fields, and is preferred by point lookups as it reads one bucket
+    if (is_hash && matched_fields < idx->GetKeySchema().GetFieldCount()) {
+      continue;
     }
-    if (tmp_conds_pos.size() > best_conds_pos.size()) {
-      best_conds_pos = tmp_conds_pos;
-      best_index     = idx;
+    bool best_is_hash = best_index != nullptr && best_index->GetIndexType() == IndexType::HASH;
+    if (matched_fields > max_matched_fields || (matched_fields == max_matched_fields && is_hash && !best_is_hash)) {
+      max_matched_fields = matched_fields;
+      best_conds_pos     = tmp_conds_pos;
+      best_index         = idx;
     }
   }
-  max_matched_fields = best_conds_pos.size();
   if (max_matched_fields == 0) {
     return nullptr;
   }
@@ -164,7 +509,8 @@ auto Optimizer::CanIndexScan(ConditionVec &conds, ConditionVec &index_conds, con
   for (auto pos : best_conds_pos) {
     index_conds.push_back(conds[pos]);
   }
-  // erase index conds from conds
+  // erase index conds from conds, from the back so that the positions stay valid
+  std::sort(best_conds_pos.begin(), best_conds_pos.end(), std::greater<>());
   for (auto pos : best_conds_pos) {
     conds.erase(conds.begin() + pos);
   }
@@ -39,7 +39,40 @@ private:
   static auto LogicalOptimizeScan(const std::shared_ptr<ScanPlan> &scan, ConditionVec conds,
       wsdb::DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
 
-  static auto LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join) -> std::shared_ptr<AbstractPlan>;
+  static auto LogicalOptimizeJoin(std::shared_ptr<JoinPlan> join, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
+
+  /**
+   * reorder a tree of inner joins by the estimated cost, dynamic programming over the subsets of the joined tables
+   * for up to JOIN_REORDER_DP_LIMIT tables and greedily joining the pair with the smallest result above that
+   * @param join
+   * @param db
+   * @return
+   */
+  static auto LogicalOptimizeJoinOrder(
+      std::shared_ptr<JoinPlan> join, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
+
+  /**
+   * fuse a limit over a sort, possibly with a projection in between, into a top-n
+   * @param lim
+   * @return
+   */
+  static auto LogicalOptimizeLimit(std::shared_ptr<LimitPlan> lim) -> std::shared_ptr<AbstractPlan>;
+
+  /**
+   * rough number of output rows of a plan from the table sizes and the statistics collected by ANALYZE, used to order
+   * the joins and to pick the build side of a hash join
+   * @param plan
+   * @param db
+   * @return
+   */
+  static auto EstimateRows(const std::shared_ptr<AbstractPlan> &plan, DatabaseHandle *db) -> size_t;
+
+  /// fraction of the rows of a table kept by a condition of a filter or an index scan
+  static auto EstimateSelectivity(const Condition &cond, DatabaseHandle *db) -> double;
+
+  /// fraction of the pairs of left and right rows kept by the conditions of a join
+  static auto EstimateJoinSelectivity(
+      const ConditionVec &conds, double left_rows, double right_rows, DatabaseHandle *db) -> double;
 
   static auto PhysicalOptimize(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
 
@@ -24,5 +24,6 @@
 namespace wsdb {
 namespace ast{
 std::shared_ptr<TreeNode> wsdb_ast_;
+std::vector<std::shared_ptr<ParamLit>> wsdb_params_;
 }
 }
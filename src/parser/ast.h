@@ -28,6 +28,7 @@
 #include <memory>
 
 #include "common/types.h"
+#include "common/value.h"
 
 namespace wsdb {
 
@@ -136,13 +137,22 @@ struct DescTable : public TreeNode
   DescTable(std::string tab_name) : tab_name_(std::move(tab_name)) {}
 };
 
+/// collect the statistics of a table for the optimizer, of every table if the name is empty
+struct AnalyzeTable : public TreeNode
+{
+  std::string tab_name_;
+
+  explicit AnalyzeTable(std::string tab_name) : tab_name_(std::move(tab_name)) {}
+};
+
 struct CreateIndex : public TreeNode
 {
   std::string              tab_name_;
   std::vector<std::string> col_names_;
+  IndexType                index_type_;
 
-  CreateIndex(std::string tab_name, std::vector<std::string> col_names)
-      : tab_name_(std::move(tab_name)), col_names_(std::move(col_names))
+  CreateIndex(std::string tab_name, std::vector<std::string> col_names, IndexType index_type)
+      : tab_name_(std::move(tab_name)), col_names_(std::move(col_names)), index_type_(index_type)
   {}
 };
 
@@ -207,6 +217,16 @@ struct ArrLit : public Value
 struct NullLit : public Value
 {};
 
+/// '?' of a prepared statement, the planner makes a value of the type the context asks for and keeps it in slot_ to be
+/// bound before each execution
+struct ParamLit : public Value
+{
+  size_t    idx_;
+  ValueSptr slot_;
+
+  ParamLit(size_t idx) : idx_(idx) {}
+};
+
 struct Col : public Expr
 {
   std::string tab_name;
@@ -268,11 +288,21 @@ struct GroupBy : public TreeNode
 
 struct InsertStmt : public TreeNode
 {
-  std::string                         tab_name;
-  std::vector<std::shared_ptr<Value>> vals;
+  std::string                                      tab_name;
+  std::vector<std::vector<std::shared_ptr<Value>>> rows;
 
-  InsertStmt(std::string tab_name_, std::vector<std::shared_ptr<Value>> vals_)
-      : tab_name(std::move(tab_name_)), vals(std::move(vals_))
+  InsertStmt(std::string tab_name_, std::vector<std::vector<std::shared_ptr<Value>>> rows_)
+      : tab_name(std::move(tab_name_)), rows(std::move(rows_))
+  {}
+};
+
+struct CopyStmt : public TreeNode
+{
+  std::string tab_name;
+  std::string file_name;
+
+  CopyStmt(std::string tab_name_, std::string file_name_)
+      : tab_name(std::move(tab_name_)), file_name(std::move(file_name_))
   {}
 };
 
@@ -371,6 +401,8 @@ struct SemValue
 
   StorageModel sv_storage_model;
 
+  IndexType sv_index_type;
+
   std::shared_ptr<TypeLen> sv_type_len;
 
   std::shared_ptr<Field>              sv_field;
@@ -381,6 +413,8 @@ struct SemValue
   std::shared_ptr<Value>              sv_val;
   std::vector<std::shared_ptr<Value>> sv_vals;
 
+  std::vector<std::vector<std::shared_ptr<Value>>> sv_val_rows;
+
   std::shared_ptr<AggCol>           sv_agg_col;
   std::shared_ptr<Col>              sv_col;
   std::vector<std::shared_ptr<Col>> sv_cols;
@@ -398,6 +432,9 @@ struct SemValue
 
 extern std::shared_ptr<TreeNode> wsdb_ast_;
 
+// placeholders of the statement being parsed, in the order they appear
+extern std::vector<std::shared_ptr<ParamLit>> wsdb_params_;
+
 }  // namespace ast
 
 }  // namespace wsdb
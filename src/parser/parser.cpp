@@ -20,6 +20,9 @@
 //
 
 #include "parser.h"
+
+#include <mutex>
+
 #include "def.h"
 #include "../common/error.h"
 
@@ -27,12 +30,29 @@ namespace wsdb {
 
 std::shared_ptr<ast::TreeNode> Parser::Parse(const std::string &sql)
 {
+  std::vector<std::shared_ptr<ast::ParamLit>> params;
+  auto                                        ret = Parse(sql, params);
+  if (!params.empty()) {
+    WSDB_THROW(WSDB_INVALID_SQL, "placeholders are only allowed in prepared statements");
+  }
+  return ret;
+}
+
+std::shared_ptr<ast::TreeNode> Parser::Parse(
+    const std::string &sql, std::vector<std::shared_ptr<ast::ParamLit>> &params)
+{
+  // the lexer and the parser results are globals, clients are served by several workers
+  static std::mutex latch;
+  std::unique_lock  lock(latch);
+  ast::wsdb_params_.clear();
   auto buf = yy_scan_string(sql.c_str());
   if (yyparse() != 0) {
     yy_delete_buffer(buf);
     WSDB_THROW(WSDB_INVALID_SQL, sql);
   }
   auto ret = ast::wsdb_ast_;
+  params   = std::move(ast::wsdb_params_);
+  ast::wsdb_params_.clear();
   yy_delete_buffer(buf);
   return ret;
 }
@@ -34,6 +34,13 @@ public:
   DISABLE_COPY_MOVE_AND_ASSIGN(Parser)
 
   [[nodiscard]] static auto Parse(const std::string &sql) -> std::shared_ptr<ast::TreeNode>;
+
+  /**
+   * Parse a statement to prepare, which may hold '?' placeholders
+   * @param params filled with the placeholders in the order they appear
+   */
+  [[nodiscard]] static auto Parse(const std::string &sql, std::vector<std::shared_ptr<ast::ParamLit>> &params)
+      -> std::shared_ptr<ast::TreeNode>;
 };
 }  // namespace wsdb
 
@@ -32,8 +32,8 @@ using namespace ast;
 %define parse.error verbose
 
 // keywords
-%token EXPLAIN SHOW TABLES CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM OPEN DATABASE ON ASC AS ORDER GROUP BY SUM AVG MAX MIN COUNT IN STATIC_CHECKPOINT USING NESTED_LOOP_JOIN SORT_MERGE_JOIN
-WHERE HAVING UPDATE SET SELECT INT CHAR FLOAT BOOL INDEX AND JOIN INNER OUTER EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY ENABLE_NESTLOOP ENABLE_SORTMERGE STORAGE PAX NARY LIMIT
+%token EXPLAIN SHOW TABLES CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM OPEN DATABASE ON ASC AS ORDER GROUP BY SUM AVG MAX MIN COUNT IN STATIC_CHECKPOINT USING NESTED_LOOP_JOIN SORT_MERGE_JOIN HASH_JOIN_KW
+WHERE HAVING UPDATE SET SELECT INT CHAR FLOAT BOOL INDEX AND JOIN INNER OUTER EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY ENABLE_NESTLOOP ENABLE_SORTMERGE STORAGE PAX NARY LIMIT COPY BPTREE_KW HASH_KW ANALYZE
 // non-keywords
 %token LEQ NEQ GEQ T_EOF
 
@@ -51,10 +51,12 @@ WHERE HAVING UPDATE SET SELECT INT CHAR FLOAT BOOL INDEX AND JOIN INNER OUTER EX
 %type <sv_type_len> type
 %type <sv_comp_op> op
 %type <sv_storage_model> optStorageModel
+%type <sv_index_type> optIndexType
 %type <sv_int> optLimit
 %type <sv_expr> expr
 %type <sv_val> value
 %type <sv_vals> valueList
+%type <sv_val_rows> valueRows
 %type <sv_str> tbName colName optAlias
 %type <sv_strs> colNameList
 %type <sv_node_arr> tableList
@@ -168,9 +170,17 @@ ddl:
     {
         $$ = std::make_shared<DescTable>($2);
     }
-    |   CREATE INDEX tbName '(' colNameList ')'
+    |   ANALYZE tbName
     {
-        $$ = std::make_shared<CreateIndex>($3, $5);
+        $$ = std::make_shared<AnalyzeTable>($2);
+    }
+    |   ANALYZE
+    {
+        $$ = std::make_shared<AnalyzeTable>("");
+    }
+    |   CREATE INDEX tbName '(' colNameList ')' optIndexType
+    {
+        $$ = std::make_shared<CreateIndex>($3, $5, $7);
     }
     |   DROP INDEX tbName '(' colNameList ')'
     {
@@ -186,10 +196,22 @@ optStorageModel:
     { $$ = PAX_MODEL; }
     ;
 
+optIndexType:
+    /* epsilon */ { $$ = IndexType::BPTREE; }
+    | USING BPTREE_KW
+    { $$ = IndexType::BPTREE; }
+    | USING HASH_KW
+    { $$ = IndexType::HASH; }
+    ;
+
 dml:
-        INSERT INTO tbName VALUES '(' valueList ')'
+        INSERT INTO tbName VALUES valueRows
+    {
+        $$ = std::make_shared<InsertStmt>($3, $5);
+    }
+    |   COPY tbName FROM VALUE_STRING
     {
-        $$ = std::make_shared<InsertStmt>($3, $6);
+        $$ = std::make_shared<CopyStmt>($2, $4);
     }
     |   DELETE FROM tbName optWhereClause
     {
@@ -268,10 +290,21 @@ type:
     }
     ;
 
+valueRows:
+        '(' valueList ')'
+    {
+        $$ = std::vector<std::vector<std::shared_ptr<ast::Value>>>{$2};
+    }
+    |   valueRows ',' '(' valueList ')'
+    {
+        $$.push_back($4);
+    }
+    ;
+
 valueList:
         value
     {
-        $$ = std::vector<std::shared_ptr<Value>>{$1};
+        $$ = std::vector<std::shared_ptr<ast::Value>>{$1};
     }
     |   valueList ',' value
     {
@@ -296,6 +329,12 @@ value:
     {
         $$ = std::make_shared<BoolLit>($1);
     }
+    |   '?'
+    {
+        auto param = std::make_shared<ParamLit>(wsdb_params_.size());
+        wsdb_params_.push_back(param);
+        $$ = param;
+    }
     | /* epsilon */
     {
         $$ = std::make_shared<NullLit>();
@@ -350,11 +389,13 @@ optWhereClause:
     ;
 
 optUsingJoinClause:
-    /* epsilon */ {$$ = NESTED_LOOP;}
+    /* epsilon */ {$$ = COST_BASED;}
     |   USING NESTED_LOOP_JOIN
     {   $$ = NESTED_LOOP;  }
     |   USING SORT_MERGE_JOIN
     {   $$ = SORT_MERGE;}
+    |   USING HASH_JOIN_KW
+    {   $$ = HASH_JOIN;}
 
 conditionAgg:
         aggCol op value
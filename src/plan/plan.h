@@ -108,29 +108,105 @@ public:
   std::string table_name_;
 };
 
+class AnalyzePlan : public AbstractPlan
+{
+public:
+  explicit AnalyzePlan(std::string table_name) : table_name_(std::move(table_name)) {}
+  auto ToString(int level) const -> std::string override
+  {
+    return fmt::format("{}AnalyzePlan [{}]", TAB_STR(level), table_name_);
+  }
+  std::string table_name_;
+};
+
 class ShowTablesPlan : public AbstractPlan
 {
   auto ToString(int level) const -> std::string override { return fmt::format("{}ShowTablesPlan", TAB_STR(level)); }
 };
 
+class CreateIndexPlan : public AbstractPlan
+{
+public:
+  CreateIndexPlan(std::string table_name, std::vector<std::string> col_names, IndexType index_type)
+      : table_name_(std::move(table_name)), col_names_(std::move(col_names)), index_type_(index_type)
+  {}
+
+  auto ToString(int level) const -> std::string override
+  {
+    std::string cols_str;
+    for (const auto &col : col_names_) {
+      cols_str += col + ", ";
+    }
+    cols_str.resize(cols_str.size() - 2);
+    return fmt::format("{}CreateIndexPlan [{}] <{}> {}",
+        TAB_STR(level),
+        table_name_,
+        cols_str,
+        index_type_ == IndexType::HASH ? "HASH" : "BPTREE");
+  }
+
+  std::string              table_name_;
+  std::vector<std::string> col_names_;
+  IndexType                index_type_;
+};
+
+class DropIndexPlan : public AbstractPlan
+{
+public:
+  DropIndexPlan(std::string table_name, std::vector<std::string> col_names)
+      : table_name_(std::move(table_name)), col_names_(std::move(col_names))
+  {}
+
+  auto ToString(int level) const -> std::string override
+  {
+    std::string cols_str;
+    for (const auto &col : col_names_) {
+      cols_str += col + ", ";
+    }
+    cols_str.resize(cols_str.size() - 2);
+    return fmt::format("{}DropIndexPlan [{}] <{}>", TAB_STR(level), table_name_, cols_str);
+  }
+
+  std::string              table_name_;
+  std::vector<std::string> col_names_;
+};
+
 class InsertPlan : public AbstractPlan
 {
 public:
-  InsertPlan(std::string table_name, std::vector<ValueSptr> values)
-      : table_name_(std::move(table_name)), values_(std::move(values))
+  InsertPlan(std::string table_name, std::vector<std::vector<ValueSptr>> rows)
+      : table_name_(std::move(table_name)), rows_(std::move(rows))
   {}
   auto ToString(int level) const -> std::string override
   {
-    std::string value_str;
-    for (const auto &value : values_) {
-      value_str += value->ToString() + ", ";
+    std::string rows_str;
+    for (const auto &row : rows_) {
+      std::string value_str;
+      for (const auto &value : row) {
+        value_str += value->ToString() + ", ";
+      }
+      value_str.back() = ')';
+      rows_str += "(" + value_str + ", ";
     }
-    value_str.back() = ')';
-    value_str        = "(" + value_str;
-    return fmt::format("{}InsertPlan [{}] <{}>", TAB_STR(level), table_name_, value_str);
+    rows_str.resize(rows_str.size() - 2);
+    return fmt::format("{}InsertPlan [{}] <{}>", TAB_STR(level), table_name_, rows_str);
+  }
+  std::string                         table_name_;
+  std::vector<std::vector<ValueSptr>> rows_;
+};
+
+class LoadPlan : public AbstractPlan
+{
+public:
+  LoadPlan(std::string table_name, std::string file_name)
+      : table_name_(std::move(table_name)), file_name_(std::move(file_name))
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    return fmt::format("{}LoadPlan [{}] <{}>", TAB_STR(level), table_name_, file_name_);
   }
-  std::string            table_name_;
-  std::vector<ValueSptr> values_;
+  std::string table_name_;
+  std::string file_name_;
 };
 
 class UpdatePlan : public AbstractPlan
@@ -238,6 +314,29 @@ public:
   bool                          is_desc_;
 };
 
+/**
+ * Sort fused with a limit, only the first limit_ records in the order of the keys are kept
+ */
+class TopNPlan : public AbstractPlan
+{
+public:
+  TopNPlan(std::shared_ptr<AbstractPlan> child, RecordSchemaUptr key_schema, bool is_desc, size_t limit)
+      : child_(std::move(child)), key_schema_(std::move(key_schema)), is_desc_(is_desc), limit_(limit)
+  {}
+  auto ToString(int level) const -> std::string override
+  {
+    return fmt::format("{}TopNPlan <{}, limit to {}>\n{}",
+        TAB_STR(level),
+        key_schema_->ToString(),
+        limit_,
+        child_->ToString(level + 1));
+  }
+  std::shared_ptr<AbstractPlan> child_;
+  RecordSchemaUptr              key_schema_;
+  bool                          is_desc_;
+  size_t                        limit_;
+};
+
 class ProjectPlan : public AbstractPlan
 {
 public:
@@ -281,9 +380,11 @@ public:
   ConditionVec                  conds_;
   JoinType                      type_;
   JoinStrategy                  strategy_;
-  // below is available when strategy == SortMerge
+  // below is available when strategy == SortMerge or HashJoin
   RecordSchemaUptr left_key_schema_;
   RecordSchemaUptr right_key_schema_;
+  // below is available when strategy == HashJoin, build the hash table on the left input instead of the right one
+  bool build_left_{false};
 };
 
 class AggregatePlan : public AbstractPlan
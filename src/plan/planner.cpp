@@ -52,12 +52,26 @@ std::shared_ptr<AbstractPlan> Planner::PlanAST(const std::shared_ptr<ast::TreeNo
   }
   /// insert
   if (const auto ins = std::dynamic_pointer_cast<ast::InsertStmt>(ast)) {
-    std::vector<ValueSptr> values;
-    values.reserve(ins->vals.size());
-    for (const auto &v : ins->vals) {
-      values.push_back(TransformValue(v));
+    std::vector<std::vector<ValueSptr>> rows;
+    rows.reserve(ins->rows.size());
+    auto tbl = db == nullptr ? nullptr : db->GetTable(ins->tab_name);
+    for (const auto &vals : ins->rows) {
+      std::vector<ValueSptr> values;
+      values.reserve(vals.size());
+      for (size_t i = 0; i < vals.size(); ++i) {
+        const RTField *field = nullptr;
+        if (tbl != nullptr && i < tbl->GetSchema().GetFieldCount()) {
+          field = &tbl->GetSchema().GetFieldAt(i);
+        }
+        values.push_back(TransformValue(vals[i], field));
+      }
+      rows.push_back(std::move(values));
     }
-    return std::make_shared<InsertPlan>(ins->tab_name, values);
+    return std::make_shared<InsertPlan>(ins->tab_name, std::move(rows));
+  }
+  /// copy from a csv file
+  if (const auto copy = std::dynamic_pointer_cast<ast::CopyStmt>(ast)) {
+    return std::make_shared<LoadPlan>(copy->tab_name, copy->file_name);
   }
   /// update
   if (const auto upd = std::dynamic_pointer_cast<ast::UpdateStmt>(ast)) {
@@ -66,7 +80,7 @@ std::shared_ptr<AbstractPlan> Planner::PlanAST(const std::shared_ptr<ast::TreeNo
       CheckFieldTabName(upd->tab_name, u->col_name, db, {upd->tab_name});
       auto  tbl   = db->GetTable(upd->tab_name);
       auto &l_col = tbl->GetSchema().GetFieldByName(tbl->GetTableId(), u->col_name);
-      updates.emplace_back(l_col, TransformValue(u->val));
+      updates.emplace_back(l_col, TransformValue(u->val, &l_col));
     }
     auto conds = MakeConditionVec(upd->conds, db, {upd->tab_name});
     // ScanPlan
@@ -95,15 +109,19 @@ std::shared_ptr<AbstractPlan> Planner::PlanAST(const std::shared_ptr<ast::TreeNo
   if (const auto desc = std::dynamic_pointer_cast<ast::DescTable>(ast)) {
     return std::make_shared<DescTablePlan>(desc->tab_name_);
   }
+  /// analyze table
+  if (const auto atab = std::dynamic_pointer_cast<ast::AnalyzeTable>(ast)) {
+    return std::make_shared<AnalyzePlan>(atab->tab_name_);
+  }
   /// show tables
   if (const auto stab = std::dynamic_pointer_cast<ast::ShowTables>(ast)) {
     return std::make_shared<ShowTablesPlan>();
   }
   /// index related
   if (const auto cidx = std::dynamic_pointer_cast<ast::CreateIndex>(ast)) {
-
+    return std::make_shared<CreateIndexPlan>(cidx->tab_name_, cidx->col_names_, cidx->index_type_);
   } else if (const auto didx = std::dynamic_pointer_cast<ast::DropIndex>(ast)) {
-
+    return std::make_shared<DropIndexPlan>(didx->tab_name_, didx->col_names_);
   } else if (const auto sidx = std::dynamic_pointer_cast<ast::ShowIndexes>(ast)) {
   }
   /// transaction related
@@ -231,6 +249,10 @@ auto Planner::AnalyseSelect(const std::shared_ptr<ast::SelectStmt> &sel, wsdb::D
           // append join cond with newly added table
           auto join_cond_tmp = GetConditionsForJoin(left_tab_name, tab, where, db);
           join_cond.insert(join_cond.end(), join_cond_tmp.begin(), join_cond_tmp.end());
+          // conditions written the other way round, the left column of a join condition comes from the left input
+          for (const auto &cond : GetConditionsForJoin(tab, left_tab_name, where, db)) {
+            join_cond.push_back(cond.Flip());
+          }
         }
         auto left_cond = GetConditionsForTable(left_tab_name, where, db);
         auto left_plan = MakeFilterScanPlan(left_tab_name, left_cond);
@@ -249,7 +271,7 @@ auto Planner::AnalyseSelect(const std::shared_ptr<ast::SelectStmt> &sel, wsdb::D
   return nullptr;
 }
 
-auto Planner::TransformValue(const std::shared_ptr<ast::Value> &val) -> ValueSptr
+auto Planner::TransformValue(const std::shared_ptr<ast::Value> &val, const RTField *field) -> ValueSptr
 {
   if (const auto i = std::dynamic_pointer_cast<ast::IntLit>(val)) {
     return ValueFactory::CreateIntValue(i->val_);
@@ -261,6 +283,12 @@ auto Planner::TransformValue(const std::shared_ptr<ast::Value> &val) -> ValueSpt
     // as we do not know the type or size of the null value, we use int type and 0 size, should
     // handle carefully in executors
     return ValueFactory::CreateNullValue(TYPE_INT);
+  } else if (const auto p = std::dynamic_pointer_cast<ast::ParamLit>(val)) {
+    if (field == nullptr) {
+      WSDB_THROW(WSDB_GRAMMAR_ERROR, fmt::format("type of parameter {} is unknown", p->idx_));
+    }
+    p->slot_ = ValueFactory::CreateNullValue(field->field_.field_type_);
+    return p->slot_;
   } else {
     WSDB_FETAL("Invalid value type");
   }
@@ -319,7 +347,7 @@ auto Planner::MakeConditionVec(const std::vector<std::shared_ptr<ast::BinaryExpr
       r_rt.alias_ = col->alias;
       conds.emplace_back(e->op_, l_rt, r_rt);
     } else if (const auto val = std::dynamic_pointer_cast<ast::Value>(rhs)) {
-      auto v = TransformValue(val);
+      auto v = TransformValue(val, &l_rt);
       conds.emplace_back(e->op_, l_rt, v);
     } else if (const auto sel = std::dynamic_pointer_cast<ast::SelectStmt>(rhs)) {
       // TODO: subquery in condition
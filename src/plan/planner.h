@@ -41,8 +41,8 @@ public:
       const std::shared_ptr<ast::TreeNode> &ast, DatabaseHandle *db) -> std::shared_ptr<AbstractPlan>;
 
 private:
-  /// transform value to server defined value
-  static auto TransformValue(const std::shared_ptr<ast::Value> &val) -> ValueSptr;
+  /// transform value to server defined value, a placeholder gets an unbound value of the type of field
+  static auto TransformValue(const std::shared_ptr<ast::Value> &val, const RTField *field) -> ValueSptr;
 
   /// transform non-aggregation cols (like group by and order by) into RTFields
   static auto TransformCols(const std::vector<std::shared_ptr<ast::Col>> &cols, DatabaseHandle *db,
@@ -21,63 +21,268 @@
 #include "buffer_pool_manager.h"
 #include "replacer/lru_replacer.h"
 #include "replacer/lru_k_replacer.h"
+#include "replacer/two_q_replacer.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include "../../../common/error.h"
 
 namespace wsdb {
 
-  BufferPoolManager::BufferPoolManager(DiskManager* disk_manager, wsdb::LogManager* log_manager, size_t replacer_lru_k)
-    : disk_manager_(disk_manager), log_manager_(log_manager)
+  BufferPoolManager::BufferPoolManager(DiskManager* disk_manager, wsdb::LogManager* log_manager, size_t replacer_lru_k,
+    size_t pool_size, size_t num_partitions)
+    : disk_manager_(disk_manager), log_manager_(log_manager), pool_size_(pool_size)
   {
-    if (REPLACER == "LRUReplacer") {
-      replacer_ = std::make_unique<LRUReplacer>();
+    WSDB_ASSERT(num_partitions > 0 && pool_size % num_partitions == 0,
+      fmt::format("pool size {} can not be divided into {} partitions", pool_size, num_partitions));
+    partitions_.reserve(num_partitions);
+    for (size_t i = 0; i < num_partitions; i++) {
+      auto part = std::make_unique<Partition>(pool_size / num_partitions);
+      if (REPLACER == "LRUReplacer") {
+        part->replacer_ = std::make_unique<LRUReplacer>();
+      }
+      else if (REPLACER == "LRUKReplacer") {
+        part->replacer_ = std::make_unique<LRUKReplacer>(replacer_lru_k);
+      }
+      else if (REPLACER == "TwoQReplacer") {
+        part->replacer_ = std::make_unique<TwoQReplacer>();
+      }
+      else {
+        WSDB_FETAL("Unknown replacer: " + REPLACER);
+      }
+      // init free_list_
+      for (frame_id_t j = 0; j < static_cast<frame_id_t>(part->frame_num_); j++) {
+        part->free_list_.push_back(j);
+      }
+      partitions_.push_back(std::move(part));
+    }
+    for (size_t i = 0; i < READ_AHEAD_WORKERS; i++) {
+      prefetch_workers_.emplace_back(&BufferPoolManager::PrefetchLoop, this);
     }
-    else if (REPLACER == "LRUKReplacer") {
-      replacer_ = std::make_unique<LRUKReplacer>(replacer_lru_k);
+  }
+
+  BufferPoolManager::~BufferPoolManager() {
+    StopCleaner();
+    {
+      std::lock_guard<std::mutex> guard(prefetch_latch_);
+      stop_prefetch_ = true;
+      prefetch_cv_.notify_all();
     }
-    else {
-      WSDB_FETAL("Unknown replacer: " + REPLACER);
+    for (auto& worker : prefetch_workers_) {
+      worker.join();
     }
-    // init free_list_
-    for (frame_id_t i = 0; i < static_cast<frame_id_t>(BUFFER_POOL_SIZE); i++) {
-      free_list_.push_back(i);
+    for (auto& part : partitions_) {
+      std::lock_guard<std::mutex> guard(part->latch_);
+      std::vector<fid_pid_t> keys;
+      for (auto& [key, write_back] : part->writing_) {
+        write_back.done_.wait();
+        keys.push_back(key);
+      }
+      for (const auto& key : keys) {
+        try {
+          SettleWriteBack(*part, key);
+        } catch (WSDBException_& e) {
+          WSDB_LOG_ERROR(e.what());
+        }
+      }
     }
+  }
 
+  auto BufferPoolManager::GetPartition(file_id_t fid, page_id_t pid) -> Partition& {
+    return *partitions_[std::hash<fid_pid_t>()({ fid, pid }) % partitions_.size()];
   }
 
   auto BufferPoolManager::FetchPage(file_id_t fid, page_id_t pid) -> Page* {
-    std::lock_guard<std::mutex> guard(latch_);
+    auto& part = GetPartition(fid, pid);
+    std::unique_lock<std::mutex> lock(part.latch_);
 
     fid_pid_t key{ fid, pid };
-    auto it = page_frame_lookup_.find(key);
-    if (it != page_frame_lookup_.end()) {
+    auto it = part.page_frame_lookup_.find(key);
+    if (it != part.page_frame_lookup_.end()) {
       // 页面在缓冲池中
       frame_id_t frame_id = it->second;
-      Frame& frame = frames_[frame_id];
+      Frame& frame = part.frames_[frame_id];
       frame.Pin();
-      replacer_->Pin(frame_id);
+      part.replacer_->Pin(frame_id);
+      TrackRecLsn(frame);
+      auto loading = part.loading_.find(frame_id);
+      if (loading == part.loading_.end()) {
+        return frame.GetPage();
+      }
+      // 页面正在被其他线程读入，释放latch后等待
+      auto pending = loading->second;
+      lock.unlock();
+      try {
+        pending.get();
+      } catch (...) {
+        lock.lock();
+        frame.Unpin();
+        if (!frame.InUse()) {
+          part.replacer_->Unpin(frame_id);
+        }
+        throw;
+      }
       return frame.GetPage();
     }
 
     // 页面不在缓冲池中
-    frame_id_t frame_id = GetAvailableFrame();
-    UpdateFrame(frame_id, fid, pid);
-    Frame& frame = frames_[frame_id];
-    return frame.GetPage();
+    frame_id_t frame_id = GetAvailableFrame(part);
+    UpdateFrame(part, frame_id, fid, pid);
+    TrackRecLsn(part.frames_[frame_id]);
+    LoadFrame(part, lock, frame_id, fid, pid, false);
+    return part.frames_[frame_id].GetPage();
+  }
+
+  auto BufferPoolManager::PrefetchPage(file_id_t fid, page_id_t pid) -> bool {
+    auto& part = GetPartition(fid, pid);
+    std::unique_lock<std::mutex> lock(part.latch_);
+
+    fid_pid_t key{ fid, pid };
+    if (part.page_frame_lookup_.find(key) != part.page_frame_lookup_.end()) {
+      return false;
+    }
+    // never wait for a frame, read-ahead is only a hint
+    if (part.free_list_.empty() && part.replacer_->Size() == 0) {
+      return false;
+    }
+    frame_id_t frame_id = GetAvailableFrame(part);
+    Frame& frame = part.frames_[frame_id];
+    frame.Reset();
+    frame.GetPage()->SetFilePageId(fid, pid);
+    // pinned in the buffer only, so that the frame is neither evicted nor accessed in the replacer while loading
+    frame.Pin();
+    part.page_frame_lookup_[key] = frame_id;
+    try {
+      LoadFrame(part, lock, frame_id, fid, pid, true);
+    } catch (WSDBException_& e) {
+      return false;
+    }
+    return true;
+  }
+
+  auto BufferPoolManager::IsPageLoaded(file_id_t fid, page_id_t pid) -> bool {
+    auto& part = GetPartition(fid, pid);
+    std::lock_guard<std::mutex> guard(part.latch_);
+    auto it = part.page_frame_lookup_.find({ fid, pid });
+    return it != part.page_frame_lookup_.end() && part.loading_.find(it->second) == part.loading_.end();
+  }
+
+  void BufferPoolManager::PrefetchPages(file_id_t fid, page_id_t begin, page_id_t end) {
+    std::lock_guard<std::mutex> guard(prefetch_latch_);
+    for (page_id_t pid = begin; pid < end && prefetch_queue_.size() < pool_size_; pid++) {
+      prefetch_queue_.push_back({ fid, pid });
+    }
+    prefetch_cv_.notify_all();
+  }
+
+  void BufferPoolManager::PrefetchLoop() {
+    std::unique_lock<std::mutex> lock(prefetch_latch_);
+    while (true) {
+      prefetch_cv_.wait(lock, [this] { return stop_prefetch_ || !prefetch_queue_.empty(); });
+      if (stop_prefetch_) {
+        return;
+      }
+      auto key = prefetch_queue_.front();
+      prefetch_queue_.pop_front();
+      prefetching_[key.fid]++;
+      lock.unlock();
+      PrefetchPage(key.fid, key.pid);
+      lock.lock();
+      if (--prefetching_[key.fid] == 0) {
+        prefetching_.erase(key.fid);
+      }
+      prefetch_cv_.notify_all();
+    }
+  }
+
+  void BufferPoolManager::CancelPrefetch(file_id_t fid) {
+    std::unique_lock<std::mutex> lock(prefetch_latch_);
+    std::erase_if(prefetch_queue_, [fid](const fid_pid_t& key) { return key.fid == fid; });
+    prefetch_cv_.wait(lock, [this, fid] { return prefetching_.find(fid) == prefetching_.end(); });
+  }
+
+  void BufferPoolManager::LoadFrame(Partition& part, std::unique_lock<std::mutex>& lock, frame_id_t frame_id,
+    file_id_t fid, page_id_t pid, bool admit) {
+    fid_pid_t key{ fid, pid };
+    Frame& frame = part.frames_[frame_id];
+    std::promise<void> loaded;
+    part.loading_[frame_id] = loaded.get_future().share();
+    std::shared_future<void> write_back;
+    std::shared_ptr<char[]> copy;
+    lsn_t copy_rec_lsn = INVALID_LSN;
+    if (auto wb = part.writing_.find(key); wb != part.writing_.end()) {
+      write_back = wb->second.done_;
+      copy = wb->second.data_;
+      copy_rec_lsn = wb->second.rec_lsn_;
+    }
+    lock.unlock();
+
+    bool restored = false;
+    try {
+      // the page may have just been evicted, its latest version is on the way to disk
+      if (write_back.valid()) {
+        try {
+          write_back.get();
+        } catch (WSDBException_& e) {
+          // the disk holds a stale version, the copy of the evicted page comes back as a dirty page
+          WSDB_LOG_ERROR(e.what());
+          memcpy(frame.GetPage()->GetData(), copy.get(), PAGE_SIZE);
+          restored = true;
+        }
+      }
+      if (!restored) {
+        disk_manager_->ReadPageAsync(fid, pid, frame.GetPage()->GetData()).get();
+      }
+    } catch (...) {
+      lock.lock();
+      part.loading_.erase(frame_id);
+      part.page_frame_lookup_.erase(key);
+      // the frame holds no page now, it becomes a victim once the waiters are gone
+      frame.GetPage()->SetFilePageId(INVALID_FILE_ID, INVALID_PAGE_ID);
+      frame.Unpin();
+      if (!frame.InUse()) {
+        admit ? part.replacer_->Admit(frame_id) : part.replacer_->Unpin(frame_id);
+      }
+      lock.unlock();
+      loaded.set_exception(std::current_exception());
+      throw;
+    }
+    lock.lock();
+    part.loading_.erase(frame_id);
+    if (restored) {
+      frame.SetDirty(true);
+      if (copy_rec_lsn != INVALID_LSN && (frame.GetRecLsn() == INVALID_LSN || copy_rec_lsn < frame.GetRecLsn())) {
+        frame.SetRecLsn(copy_rec_lsn);
+      }
+      if (auto wb = part.writing_.find(key); wb != part.writing_.end() && wb->second.data_ == copy) {
+        part.writing_.erase(wb);
+      }
+    }
+    if (admit) {
+      // 预取的页面只有在没有其他线程使用时才交给replacer
+      frame.Unpin();
+      if (!frame.InUse()) {
+        part.replacer_->Admit(frame_id);
+      }
+    }
+    lock.unlock();
+    loaded.set_value();
   }
 
   auto BufferPoolManager::UnpinPage(file_id_t fid, page_id_t pid, bool is_dirty) -> bool {
-    std::lock_guard<std::mutex> guard(latch_);
+    auto& part = GetPartition(fid, pid);
+    std::lock_guard<std::mutex> guard(part.latch_);
 
     fid_pid_t key{ fid, pid };
-    auto it = page_frame_lookup_.find(key);
-    if (it == page_frame_lookup_.end()) {
+    auto it = part.page_frame_lookup_.find(key);
+    if (it == part.page_frame_lookup_.end()) {
       // 页面不在缓冲池中或未使用
       return false;
     }
 
     frame_id_t frame_id = it->second;
-    Frame& frame = frames_[frame_id];
+    Frame& frame = part.frames_[frame_id];
 
     if (!frame.InUse()) {
       // 帧未被使用
@@ -87,73 +292,95 @@ namespace wsdb {
     frame.Unpin();
 
     if (!frame.InUse()) {
-      replacer_->Unpin(frame_id);
+      part.replacer_->Unpin(frame_id);
     }
 
     if (is_dirty) {
       frame.SetDirty(true);
     }
+    else if (!frame.IsDirty() && !frame.InUse()) {
+      frame.SetRecLsn(INVALID_LSN);
+    }
 
     return true;
   }
 
   auto BufferPoolManager::DeletePage(file_id_t fid, page_id_t pid) -> bool {
-    std::lock_guard<std::mutex> guard(latch_);
+    auto& part = GetPartition(fid, pid);
+    std::lock_guard<std::mutex> guard(part.latch_);
 
     fid_pid_t key{ fid, pid };
-    auto it = page_frame_lookup_.find(key);
-    if (it == page_frame_lookup_.end()) {
+    auto it = part.page_frame_lookup_.find(key);
+    if (it == part.page_frame_lookup_.end()) {
       return true;
     }
 
     frame_id_t frame_id = it->second;
-    Frame& frame = frames_[frame_id];
+    Frame& frame = part.frames_[frame_id];
 
     if (frame.InUse() > 0) {
       return false;
     }
 
+    AwaitWriteBack(part, key);
     if (frame.IsDirty()) {
       // 直接执行flush逻辑，而不是调用FlushPage
+      WaitForLog(pid, frame.GetPage()->GetData());
       disk_manager_->WritePage(fid, pid, frame.GetPage()->GetData());
       frame.SetDirty(false);
     }
 
     frame.Reset();
-    free_list_.push_back(frame_id);
-    replacer_->Unpin(frame_id);
-    page_frame_lookup_.erase(it);
+    part.free_list_.push_back(frame_id);
+    part.replacer_->Unpin(frame_id);
+    part.page_frame_lookup_.erase(it);
 
     return true;
   }
 
   auto BufferPoolManager::DeleteAllPages(file_id_t fid) -> bool {
-    std::lock_guard<std::mutex> guard(latch_);
+    // pages of the file must not be brought back by read-ahead after they are deleted
+    CancelPrefetch(fid);
     bool success = true;
 
-    for (auto it = page_frame_lookup_.begin(); it != page_frame_lookup_.end();) {
-      if (it->first.fid == fid) {
-        frame_id_t frame_id = it->second;
-        Frame& frame = frames_[frame_id];
+    for (auto& part : partitions_) {
+      std::lock_guard<std::mutex> guard(part->latch_);
+      for (auto it = part->page_frame_lookup_.begin(); it != part->page_frame_lookup_.end();) {
+        if (it->first.fid == fid) {
+          frame_id_t frame_id = it->second;
+          Frame& frame = part->frames_[frame_id];
+
+          if (frame.InUse() > 0) {
+            success = false;
+            ++it;
+            continue;
+          }
 
-        if (frame.InUse() > 0) {
-          success = false;
+          AwaitWriteBack(*part, it->first);
+          if (frame.IsDirty()) {
+            WaitForLog(it->first.pid, frame.GetPage()->GetData());
+            disk_manager_->WritePage(fid, it->first.pid, frame.GetPage()->GetData());
+            frame.SetDirty(false);
+          }
+
+          frame.Reset();
+          part->free_list_.push_back(frame_id);
+          part->replacer_->Unpin(frame_id);
+          it = part->page_frame_lookup_.erase(it);
+        }
+        else {
           ++it;
-          continue;
         }
-
-        if (frame.IsDirty()) {
-          disk_manager_->WritePage(fid, it->first.pid, frame.GetPage()->GetData());
-          frame.SetDirty(false);
+      }
+      // the file may be closed right after, write-backs of evicted pages must not outlive it
+      std::vector<fid_pid_t> keys;
+      for (const auto& [key, write_back] : part->writing_) {
+        if (key.fid == fid) {
+          keys.push_back(key);
         }
-
-        frame.Reset();
-        free_list_.push_back(frame_id);
-        replacer_->Unpin(frame_id);
-        it = page_frame_lookup_.erase(it);
       }
-      else {
-        ++it;
+      for (const auto& key : keys) {
+        SettleWriteBack(*part, key);
       }
     }
 
@@ -161,101 +388,339 @@ namespace wsdb {
   }
 
   auto BufferPoolManager::FlushPage(file_id_t fid, page_id_t pid) -> bool {
-    std::lock_guard<std::mutex> guard(latch_);
+    auto& part = GetPartition(fid, pid);
+    std::lock_guard<std::mutex> guard(part.latch_);
 
     fid_pid_t key{ fid, pid };
-    auto it = page_frame_lookup_.find(key);
-    if (it == page_frame_lookup_.end()) {
+    auto it = part.page_frame_lookup_.find(key);
+    if (it == part.page_frame_lookup_.end()) {
       // 页面不在缓冲池中
       return false;
     }
 
     frame_id_t frame_id = it->second;
-    Frame& frame = frames_[frame_id];
+    Frame& frame = part.frames_[frame_id];
 
     if (frame.IsDirty()) {
+      AwaitWriteBack(part, key);
+      WaitForLog(pid, frame.GetPage()->GetData());
       disk_manager_->WritePage(fid, pid, frame.GetPage()->GetData());
       frame.SetDirty(false);
+      // whoever has the page pinned may change it further
+      frame.SetRecLsn(frame.InUse() ? NextLsn() : INVALID_LSN);
     }
 
     return true;
   }
 
   auto BufferPoolManager::FlushAllPages(file_id_t fid) -> bool {
-    std::lock_guard<std::mutex> guard(latch_);
     bool success = true;
 
-    for (const auto& entry : page_frame_lookup_) {
-      if (entry.first.fid == fid) {
-        frame_id_t frame_id = entry.second;
-        Frame& frame = frames_[frame_id];
-
-        if (frame.IsDirty()) {
-          // 直接执行flush逻辑
-          disk_manager_->WritePage(fid, entry.first.pid, frame.GetPage()->GetData());
-          frame.SetDirty(false);
+    for (auto& part : partitions_) {
+      std::lock_guard<std::mutex> guard(part->latch_);
+      std::vector<std::future<void>> writes;
+      for (const auto& entry : part->page_frame_lookup_) {
+        if (entry.first.fid == fid) {
+          frame_id_t frame_id = entry.second;
+          Frame& frame = part->frames_[frame_id];
+
+          if (frame.IsDirty()) {
+            // 直接执行flush逻辑，同一分区的写请求一起提交
+            AwaitWriteBack(*part, entry.first);
+            WaitForLog(entry.first.pid, frame.GetPage()->GetData());
+            writes.push_back(disk_manager_->WritePageAsync(fid, entry.first.pid, frame.GetPage()->GetData()));
+            frame.SetDirty(false);
+            frame.SetRecLsn(frame.InUse() ? NextLsn() : INVALID_LSN);
+          }
         }
       }
+      for (auto& write : writes) {
+        write.get();
+      }
     }
 
     return success;
   }
 
-  auto BufferPoolManager::GetAvailableFrame() -> frame_id_t {
-    if (!free_list_.empty()) {
-      frame_id_t frame_id = free_list_.front();
-      free_list_.pop_front();
+  auto BufferPoolManager::GetAvailableFrame(Partition& part) -> frame_id_t {
+    if (!part.free_list_.empty()) {
+      frame_id_t frame_id = part.free_list_.front();
+      part.free_list_.pop_front();
       return frame_id;
     }
-    else {
-      frame_id_t frame_id;
-      if (replacer_->Victim(&frame_id)) {
-        Frame& frame = frames_[frame_id];
-        //在lookup中查找fid_pid_t
-
-        for (const auto& entry : page_frame_lookup_) {
-          if (entry.second == frame_id) {
-            // 找到对应的{fid,pid}
-            if (frame.IsDirty()) {
-              disk_manager_->WritePage(entry.first.fid, entry.first.pid, frame.GetPage()->GetData());
-              frame.SetDirty(false);
-            }
-            page_frame_lookup_.erase(entry.first);
-            return frame_id;
-          }
+    frame_id_t frame_id;
+    if (!part.replacer_->Victim(&frame_id)) {
+      WSDB_THROW(WSDB_NO_FREE_FRAME, "No free frame in buffer pool");
+    }
+    // the page held by the frame tells where it belongs, no need to scan the lookup table
+    Frame& frame = part.frames_[frame_id];
+    Page* page = frame.GetPage();
+    fid_pid_t victim{ page->GetFileId(), page->GetPageId() };
+    if (frame.IsDirty()) {
+      // an older version written by the cleaner must land before this one
+      AwaitWriteBack(part, victim);
+      // forget the write-backs that have finished, a failed one is retried as long as it holds the only copy
+      std::vector<fid_pid_t> finished;
+      for (const auto& [key, write_back] : part.writing_) {
+        if (write_back.done_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+          finished.push_back(key);
         }
-        return frame_id;
       }
-      else {
-        WSDB_THROW(WSDB_NO_FREE_FRAME, "No free frame in buffer pool");
+      for (const auto& key : finished) {
+        try {
+          SettleWriteBack(part, key);
+        } catch (WSDBException_& e) {
+          WSDB_LOG_ERROR(e.what());
+        }
       }
+      // write back a private copy so that the frame can be reused at once
+      WriteBack write_back{ {}, std::make_shared<char[]>(PAGE_SIZE), frame.GetRecLsn() };
+      memcpy(write_back.data_.get(), page->GetData(), PAGE_SIZE);
+      WaitForLog(victim.pid, write_back.data_.get());
+      write_back.done_ = disk_manager_->WritePageAsync(victim.fid, victim.pid, write_back.data_.get()).share();
+      part.writing_[victim] = std::move(write_back);
+      frame.SetDirty(false);
+    }
+    if (auto it = part.page_frame_lookup_.find(victim); it != part.page_frame_lookup_.end() && it->second == frame_id) {
+      part.page_frame_lookup_.erase(it);
     }
+    return frame_id;
   }
 
-  void BufferPoolManager::UpdateFrame(frame_id_t frame_id, file_id_t fid, page_id_t pid) {
-    Frame& frame = frames_[frame_id];
+  void BufferPoolManager::TrackRecLsn(Frame& frame)
+  {
+    if (frame.GetRecLsn() == INVALID_LSN) {
+      frame.SetRecLsn(NextLsn());
+    }
+  }
 
-    if (frame.IsDirty()) {
-      disk_manager_->WritePage(fid, pid, frame.GetPage()->GetData());
-      frame.SetDirty(false);
+  auto BufferPoolManager::NextLsn() const -> lsn_t
+  {
+    return log_manager_ == nullptr ? INVALID_LSN : log_manager_->GetNextLsn();
+  }
+
+  void BufferPoolManager::WaitForLog(page_id_t pid, const char* data)
+  {
+    if (log_manager_ == nullptr || pid == FILE_HEADER_PAGE_ID) {
+      return;
+    }
+    log_manager_->WaitForFlush(*reinterpret_cast<const lsn_t*>(data + PAGE_LSN_OFFSET));
+  }
+
+  void BufferPoolManager::AwaitWriteBack(Partition& part, const fid_pid_t& key) {
+    auto it = part.writing_.find(key);
+    if (it == part.writing_.end()) {
+      return;
+    }
+    try {
+      it->second.done_.get();
+    } catch (WSDBException_& e) {
+      WSDB_LOG_ERROR(e.what());
+    }
+    part.writing_.erase(it);
+  }
+
+  void BufferPoolManager::SettleWriteBack(Partition& part, const fid_pid_t& key) {
+    auto it = part.writing_.find(key);
+    if (it == part.writing_.end()) {
+      return;
+    }
+    if (!WriteBackFailed(it->second) || part.page_frame_lookup_.count(key) > 0) {
+      part.writing_.erase(it);
+      return;
+    }
+    // the copy is the only up-to-date version of the page, the entry stays until it reaches the disk
+    const char* data = it->second.data_.get();
+    disk_manager_->WritePages(key.fid, key.pid, &data, 1);
+    part.writing_.erase(it);
+  }
+
+  auto BufferPoolManager::WriteBackFailed(const WriteBack& write_back) -> bool {
+    if (write_back.done_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      return false;
+    }
+    try {
+      write_back.done_.get();
+    } catch (WSDBException_&) {
+      return true;
+    }
+    return false;
+  }
+
+  void BufferPoolManager::StartCleaner() {
+    std::lock_guard<std::mutex> guard(cleaner_latch_);
+    if (cleaner_.joinable()) {
+      return;
+    }
+    stop_cleaner_ = false;
+    cleaner_ = std::thread(&BufferPoolManager::CleanerLoop, this);
+  }
+
+  void BufferPoolManager::StopCleaner() {
+    {
+      std::lock_guard<std::mutex> guard(cleaner_latch_);
+      stop_cleaner_ = true;
+      cleaner_cv_.notify_all();
+    }
+    if (cleaner_.joinable()) {
+      cleaner_.join();
     }
+  }
+
+  void BufferPoolManager::CleanerLoop() {
+    std::unique_lock<std::mutex> lock(cleaner_latch_);
+    while (!cleaner_cv_.wait_for(
+      lock, std::chrono::milliseconds(BUFFER_POOL_CLEANER_INTERVAL_MS), [this] { return stop_cleaner_; })) {
+      lock.unlock();
+      CleanDirtyPages();
+      lock.lock();
+    }
+  }
+
+  auto BufferPoolManager::CleanDirtyPages() -> size_t {
+    // 统计脏页比例
+    size_t dirty = 0;
+    for (auto& part : partitions_) {
+      std::lock_guard<std::mutex> guard(part->latch_);
+      for (size_t i = 0; i < part->frame_num_; i++) {
+        dirty += part->frames_[i].IsDirty() ? 1 : 0;
+      }
+    }
+    auto low = static_cast<size_t>(static_cast<double>(pool_size_) * BUFFER_POOL_DIRTY_RATIO_LOW);
+    if (dirty <= low) {
+      return 0;
+    }
+    size_t budget = dirty - low;
+    if (static_cast<double>(dirty) <= static_cast<double>(pool_size_) * BUFFER_POOL_DIRTY_RATIO_HIGH) {
+      budget = std::min(budget, BUFFER_POOL_CLEANER_PAGES);
+    }
+    return WriteBackDirtyPages(budget, std::numeric_limits<lsn_t>::max());
+  }
+
+  auto BufferPoolManager::FlushPagesBefore(lsn_t lsn) -> size_t { return WriteBackDirtyPages(pool_size_, lsn); }
+
+  auto BufferPoolManager::GetMinRecLsn() -> lsn_t {
+    lsn_t min_lsn = INVALID_LSN;
+    auto update = [&min_lsn](lsn_t lsn) {
+      if (lsn != INVALID_LSN && (min_lsn == INVALID_LSN || lsn < min_lsn)) {
+        min_lsn = lsn;
+      }
+    };
+    for (auto& part : partitions_) {
+      std::lock_guard<std::mutex> guard(part->latch_);
+      for (size_t i = 0; i < part->frame_num_; i++) {
+        update(part->frames_[i].GetRecLsn());
+      }
+      // an evicted or cleaned page is not on disk until its write-back succeeds
+      for (auto& [key, write_back] : part->writing_) {
+        if (write_back.done_.wait_for(std::chrono::seconds(0)) != std::future_status::ready ||
+          WriteBackFailed(write_back)) {
+          update(write_back.rec_lsn_);
+        }
+      }
+    }
+    return min_lsn;
+  }
+
+  auto BufferPoolManager::WriteBackDirtyPages(size_t budget, lsn_t before) -> size_t {
+    // copy dirty unpinned frames, the copies are registered as write-backs so that a miss on the page waits for them
+    std::promise<void> written;
+    auto done = written.get_future().share();
+    std::vector<std::pair<fid_pid_t, std::shared_ptr<char[]>>> batch;
+    size_t share = (budget + partitions_.size() - 1) / partitions_.size();
+    for (auto& part : partitions_) {
+      std::lock_guard<std::mutex> guard(part->latch_);
+      size_t taken = 0;
+      for (size_t i = 0; i < part->frame_num_ && taken < share && batch.size() < budget; i++) {
+        Frame& frame = part->frames_[i];
+        if (!frame.IsDirty() || frame.InUse() || part->loading_.count(static_cast<frame_id_t>(i)) > 0 ||
+          frame.GetRecLsn() >= before) {
+          continue;
+        }
+        Page* page = frame.GetPage();
+        fid_pid_t key{ page->GetFileId(), page->GetPageId() };
+        AwaitWriteBack(*part, key);
+        WriteBack write_back{ done, std::make_shared<char[]>(PAGE_SIZE), frame.GetRecLsn() };
+        memcpy(write_back.data_.get(), page->GetData(), PAGE_SIZE);
+        batch.emplace_back(key, write_back.data_);
+        part->writing_[key] = std::move(write_back);
+        taken++;
+      }
+    }
+
+    // the log of all copies is synced once before any of them is written
+    lsn_t max_lsn = INVALID_LSN;
+    for (const auto& [key, data] : batch) {
+      if (key.pid != FILE_HEADER_PAGE_ID) {
+        max_lsn = std::max(max_lsn, *reinterpret_cast<const lsn_t*>(data.get() + PAGE_LSN_OFFSET));
+      }
+    }
+    if (log_manager_ != nullptr) {
+      log_manager_->WaitForFlush(max_lsn);
+    }
+
+    // write in page id order, consecutive pages of a file are coalesced into one vectored write
+    std::sort(batch.begin(), batch.end(), [](const auto& a, const auto& b) {
+      return a.first.fid < b.first.fid || (a.first.fid == b.first.fid && a.first.pid < b.first.pid);
+    });
+    try {
+      std::vector<const char*> run;
+      for (size_t i = 0; i < batch.size(); i += run.size()) {
+        run.clear();
+        run.push_back(batch[i].second.get());
+        while (i + run.size() < batch.size() && run.size() < BUFFER_POOL_CLEANER_MAX_RUN &&
+          batch[i + run.size()].first.fid == batch[i].first.fid &&
+          batch[i + run.size()].first.pid == batch[i].first.pid + static_cast<page_id_t>(run.size())) {
+          run.push_back(batch[i + run.size()].second.get());
+        }
+        disk_manager_->WritePages(batch[i].first.fid, batch[i].first.pid, run.data(), run.size());
+      }
+    } catch (WSDBException_& e) {
+      // the frames were never marked clean, they stay dirty with their rec lsn and are written again later
+      WSDB_LOG_ERROR(e.what());
+      written.set_exception(std::current_exception());
+      return 0;
+    }
+    written.set_value();
+
+    // a frame is clean only if nobody touched the page since it was copied, otherwise the newer content is still dirty
+    for (const auto& [key, data] : batch) {
+      auto& part = GetPartition(key.fid, key.pid);
+      std::lock_guard<std::mutex> guard(part.latch_);
+      auto it = part.page_frame_lookup_.find(key);
+      if (it == part.page_frame_lookup_.end()) {
+        continue;
+      }
+      Frame& frame = part.frames_[it->second];
+      if (frame.IsDirty() && !frame.InUse() && memcmp(frame.GetPage()->GetData(), data.get(), PAGE_SIZE) == 0) {
+        frame.SetDirty(false);
+        frame.SetRecLsn(INVALID_LSN);
+      }
+    }
+    return batch.size();
+  }
+
+  void BufferPoolManager::UpdateFrame(Partition& part, frame_id_t frame_id, file_id_t fid, page_id_t pid) {
+    Frame& frame = part.frames_[frame_id];
+    WSDB_ASSERT(!frame.IsDirty(), "dirty frame should be written back before reuse");
 
     frame.Reset();
 
     Page* page = frame.GetPage();
     page->SetFilePageId(fid, pid);
-    disk_manager_->ReadPage(fid, pid, page->GetData());
 
     frame.Pin();
-    replacer_->Pin(frame_id);
+    part.replacer_->Pin(frame_id);
 
-    page_frame_lookup_[{fid, pid}] = frame_id;
+    part.page_frame_lookup_[{fid, pid}] = frame_id;
   }
 
   auto BufferPoolManager::GetFrame(file_id_t fid, page_id_t pid) -> Frame*
   {
-    const auto it = page_frame_lookup_.find({ fid, pid });
-    return it == page_frame_lookup_.end() ? nullptr : &frames_[it->second];
+    auto& part = GetPartition(fid, pid);
+    std::lock_guard<std::mutex> guard(part.latch_);
+    const auto it = part.page_frame_lookup_.find({ fid, pid });
+    return it == part.page_frame_lookup_.end() ? nullptr : &part.frames_[it->second];
   }
 
 }  // namespace wsdb
@@ -24,9 +24,13 @@
 
 #include <list>
 #include <memory>
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <mutex>  // NOLINT
+#include <thread>
 #include <vector>
-#include <array>
+#include <unordered_map>
 #include "storage/disk/disk_manager.h"
 #include "log/log_manager.h"
 #include "replacer/replacer.h"
@@ -59,18 +63,31 @@ namespace wsdb {
 class BufferPoolManager
 {
 public:
-  explicit BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager = nullptr, size_t replacer_lru_k = 0);
+  /**
+   * @param disk_manager
+   * @param log_manager
+   * @param replacer_lru_k k used by LRUKReplacer
+   * @param pool_size total number of frames, evenly distributed among partitions
+   * @param num_partitions number of partitions, pages are routed to a partition by hashing fid_pid_t
+   */
+  explicit BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager = nullptr, size_t replacer_lru_k = 0,
+      size_t pool_size = BUFFER_POOL_SIZE, size_t num_partitions = BUFFER_POOL_PARTITIONS);
 
-  ~BufferPoolManager() = default;
+  /**
+   * Wait for the write-backs still in flight, their buffers are owned by the partitions
+   */
+  ~BufferPoolManager();
 
   DISABLE_COPY_MOVE_AND_ASSIGN(BufferPoolManager)
 
   /**
    * Fetch the requested page from disk.
-   * 1. grant the latch
+   * 1. locate the partition and grant its latch
    * 2. check if the page is in the frame
-   * 3. if the page is not in the frame, GetAvailableFrame and UpdateFrame
-   * 4. else pin the frame both in the buffer and the replacer and return the page
+   * 3. if the page is not in the frame, GetAvailableFrame and UpdateFrame, then release the latch and read the page,
+   *    so that misses and write-backs of other pages in the same partition can be in flight at the same time
+   * 4. else pin the frame both in the buffer and the replacer, if the page is still being read by another thread,
+   *    release the latch and wait for the read, then return the page
    * @param fid file that the page belongs to
    * @param pid page id
    * @return the page
@@ -79,7 +96,7 @@ public:
 
   /**
    * Unpin the page indicating that it can be victimized
-   * 1. grant the latch
+   * 1. locate the partition and grant its latch
    * 2. if the frame is not in the buffer or the frame is not in use, return false
    * 3. unpin the frame, after that if the frame is not in use, unpin the frame in the replacer
    * 4. set the frame dirty if the page is dirty
@@ -92,7 +109,7 @@ public:
 
   /**
    * Delete the page from the buffer pool
-   * 1. grant the latch
+   * 1. locate the partition and grant its latch
    * 2. if the page is not in the buffer, return true
    * 3. if the page is in use, return false
    * 4. flush the page to disk, reset the frame, add the frame to the free list and unpin the frame in the replacer
@@ -104,7 +121,7 @@ public:
   auto DeletePage(file_id_t fid, page_id_t pid) -> bool;
 
   /**
-   * Delete all pages belong to the file
+   * Delete all pages belong to the file, partitions are visited one by one
    * @param fid
    * @return true if all pages are deleted successfully
    */
@@ -112,7 +129,7 @@ public:
 
   /**
    * Flush the page to disk
-   * 1. grant the latch
+   * 1. locate the partition and grant its latch
    * 2. if the page is not in the buffer, return false
    * 3. flush the page to disk if the page is dirty
    * @param fid
@@ -122,49 +139,216 @@ public:
   auto FlushPage(file_id_t fid, page_id_t pid) -> bool;
 
   /**
-   * Flush all pages to disk
+   * Flush all pages to disk, partitions are visited one by one and the writes of a partition are in flight together
    * @param fid
    * @return
    */
   auto FlushAllPages(file_id_t fid) -> bool;
 
+  /**
+   * Load the page into the buffer pool without pinning it, used by read-ahead
+   * 1. locate the partition and grant its latch
+   * 2. if the page is already in the buffer, or no frame can be used without waiting, return false
+   * 3. GetAvailableFrame, pin the frame only in the buffer while the page is read after the latch is released
+   * 4. unpin the frame and admit it to the replacer, no access is recorded for the page
+   * @param fid
+   * @param pid
+   * @return true if the page is loaded
+   */
+  auto PrefetchPage(file_id_t fid, page_id_t pid) -> bool;
+
+  /**
+   * Check whether the page is in the buffer and not being read, used by read-ahead to measure how far it lags behind
+   */
+  auto IsPageLoaded(file_id_t fid, page_id_t pid) -> bool;
+
+  /**
+   * Queue pages [begin, end) of the file for the background read-ahead workers, they call PrefetchPage for each of them
+   * so that up to READ_AHEAD_WORKERS reads are in flight.
+   * Requests beyond pool size queued pages are dropped
+   * @param fid
+   * @param begin
+   * @param end
+   */
+  void PrefetchPages(file_id_t fid, page_id_t begin, page_id_t end);
+
+  /**
+   * Start the background page cleaner, every BUFFER_POOL_CLEANER_INTERVAL_MS it runs CleanDirtyPages
+   */
+  void StartCleaner();
+
+  /**
+   * Stop the background page cleaner and wait for it to exit
+   */
+  void StopCleaner();
+
+  /**
+   * One round of the page cleaner, keeps clean frames ready for eviction so that misses rarely write back a victim
+   * 1. count the dirty frames, return if no more than BUFFER_POOL_DIRTY_RATIO_LOW of the pool is dirty
+   * 2. pick dirty unpinned frames to bring the ratio down to the low mark, at most BUFFER_POOL_CLEANER_PAGES unless the
+   *    ratio is above BUFFER_POOL_DIRTY_RATIO_HIGH, copy them under the partition latch and mark them clean
+   * 3. sort the copies by (fid, pid) and write each run of consecutive pages with one vectored write
+   * @return number of pages written
+   */
+  auto CleanDirtyPages() -> size_t;
+
+  /**
+   * Write back the dirty unpinned pages whose rec lsn is less than lsn, so that a checkpoint can move the redo lsn
+   * past them
+   * @return number of pages written
+   */
+  auto FlushPagesBefore(lsn_t lsn) -> size_t;
+
+  /**
+   * Smallest rec lsn of the frames and of the write-backs in flight, redo has to start from it
+   * @return INVALID_LSN if every change is on disk
+   */
+  auto GetMinRecLsn() -> lsn_t;
+
   /**
    * Get the frame, used for test
    */
   auto GetFrame(file_id_t fid, page_id_t pid) -> Frame *;
 
+  [[nodiscard]] auto GetPoolSize() const -> size_t { return pool_size_; }
+
+  [[nodiscard]] auto GetLogManager() const -> LogManager * { return log_manager_; }
+
+  [[nodiscard]] auto GetPartitionNum() const -> size_t { return partitions_.size(); }
+
 private:
+  /**
+   * A partition is an independent small buffer pool, it owns a slice of the frames and everything needed to manage
+   * them, so that threads working on pages of different partitions never contend on the same latch.
+   * Frame ids handed to the replacer are local to the partition.
+   */
+  struct WriteBack
+  {
+    std::shared_future<void> done_;
+    std::shared_ptr<char[]>  data_;
+    lsn_t                    rec_lsn_{INVALID_LSN};
+  };
+
+  struct Partition
+  {
+    explicit Partition(size_t frame_num) : frames_(std::make_unique<Frame[]>(frame_num)), frame_num_(frame_num) {}
+
+    std::mutex                                latch_;
+    std::unique_ptr<Replacer>                 replacer_;
+    std::unique_ptr<Frame[]>                  frames_;
+    size_t                                    frame_num_;
+    std::list<frame_id_t>                     free_list_;
+    std::unordered_map<fid_pid_t, frame_id_t> page_frame_lookup_;
+    /// frames whose page is being read from disk, threads hitting such a frame wait on the future
+    std::unordered_map<frame_id_t, std::shared_future<void>> loading_;
+    /// dirty pages being written back from a private copy by eviction or the cleaner, a miss on such a page waits on
+    /// the future first and takes the copy back if the write failed
+    std::unordered_map<fid_pid_t, WriteBack> writing_;
+  };
+
   /// sub procedures used by public APIs, should not be locked by latch
 
   /**
-   * Get the available frame
+   * Route the page to its partition by hashing fid_pid_t
+   */
+  auto GetPartition(file_id_t fid, page_id_t pid) -> Partition &;
+
+  /**
+   * Get the available frame of the partition
    * 1. if the free list is not empty, get the frame id from the free list
-   * 2. else use the replacer to get the frame id
+   * 2. else use the replacer to get the frame id, if the victim is dirty, copy it and submit the write-back
+   *    asynchronously, the write-back is recorded in writing_
    * 3. if no frame can be evicted, throw WSDB_NO_FREE_FRAME
    * @return the frame id
    */
-  auto GetAvailableFrame() -> frame_id_t;
+  auto GetAvailableFrame(Partition &part) -> frame_id_t;
+
+  /**
+   * Read the page into the frame reserved by the caller, the latch is released during the read and threads hitting the
+   * frame meanwhile wait on the loading future. On failure the frame is detached from the page and the error is rethrown
+   * @param lock the latch of the partition, held on entry and released on return
+   * @param admit true if the frame is loaded by read-ahead, it is unpinned and admitted to the replacer when loaded
+   */
+  void LoadFrame(Partition &part, std::unique_lock<std::mutex> &lock, frame_id_t frame_id, file_id_t fid,
+      page_id_t pid, bool admit);
+
+  /**
+   * Write-ahead rule, block until the log is durable up to the lsn of the page data before it is written.
+   * The file header page carries no lsn
+   */
+  void WaitForLog(page_id_t pid, const char *data);
+
+  /**
+   * Changes made while the frame is pinned get lsns from the next one on, it is the rec lsn of a frame without
+   * unwritten changes
+   */
+  void TrackRecLsn(Frame &frame);
+
+  [[nodiscard]] auto NextLsn() const -> lsn_t;
+
+  /**
+   * Copy up to budget dirty unpinned frames whose rec lsn is less than before under the partition latches and write
+   * the copies, see CleanDirtyPages. A frame is marked clean only after its copy is on disk and only if the page has
+   * not changed since, so a failed write leaves the frame dirty and its rec lsn untouched
+   */
+  auto WriteBackDirtyPages(size_t budget, lsn_t before) -> size_t;
+
+  /**
+   * Wait for the write-back of the page if there is one in flight, so that writes of the same page never reorder
+   */
+  void AwaitWriteBack(Partition &part, const fid_pid_t &key);
+
+  /**
+   * Forget the finished write-back of a page. If it failed and the page is not in the pool, its copy is the only
+   * up-to-date version, so it is written again and kept with the error rethrown if that fails too
+   */
+  void SettleWriteBack(Partition &part, const fid_pid_t &key);
+
+  /// whether the write-back has finished with an error
+  static auto WriteBackFailed(const WriteBack &write_back) -> bool;
+
+  void CleanerLoop();
+
+  /**
+   * Loop of background read-ahead workers
+   */
+  void PrefetchLoop();
 
   /**
-   * Update the frame
-   * 1. if the frame is dirty, flush the page to disk
-   * 2. update the frame with the new page
-   * 3. pin the frame in the buffer and the replacer
-   * 4. update the page_frame_lookup_
+   * Drop queued read-ahead requests of the file and wait for the one being served
+   */
+  void CancelPrefetch(file_id_t fid);
+
+  /**
+   * Update the frame, the page data is read by the caller after the latch is released
+   * 1. update the frame with the new page
+   * 2. pin the frame in the buffer and the replacer
+   * 3. update the page_frame_lookup_
    * @param frame_id the frame to update
    * @param fid the file needs to be updated to the frame
    * @param pid the page needs to be updated to the frame
    */
-  void UpdateFrame(frame_id_t frame_id, file_id_t fid, page_id_t pid);
+  void UpdateFrame(Partition &part, frame_id_t frame_id, file_id_t fid, page_id_t pid);
 
 private:
-  std::mutex                                latch_;
-  DiskManager                              *disk_manager_;
-  LogManager                               *log_manager_;
-  std::unique_ptr<Replacer>                 replacer_;
-  std::array<Frame, BUFFER_POOL_SIZE>       frames_;
-  std::list<frame_id_t>                     free_list_;
-  std::unordered_map<fid_pid_t, frame_id_t> page_frame_lookup_;
+  DiskManager                            *disk_manager_;
+  LogManager                             *log_manager_;
+  size_t                                  pool_size_;
+  std::vector<std::unique_ptr<Partition>> partitions_;
+
+  /// page cleaner
+  std::thread             cleaner_;
+  std::mutex              cleaner_latch_;
+  std::condition_variable cleaner_cv_;
+  bool                    stop_cleaner_{false};
+
+  /// read-ahead
+  std::vector<std::thread>              prefetch_workers_;
+  std::mutex                            prefetch_latch_;
+  std::condition_variable               prefetch_cv_;
+  std::deque<fid_pid_t>                 prefetch_queue_;
+  std::unordered_map<file_id_t, size_t> prefetching_;  // number of requests being served per file
+  bool                                  stop_prefetch_{false};
 };
 
 }  // namespace wsdb
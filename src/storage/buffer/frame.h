@@ -41,6 +41,11 @@ public:
 
   inline void SetDirty(bool dirty) { is_dirty_ = dirty; }
 
+  /// no change of the page that is not on disk has an lsn less than rec lsn, INVALID_LSN if there is no such change
+  [[nodiscard]] inline auto GetRecLsn() const -> lsn_t { return rec_lsn_; }
+
+  inline void SetRecLsn(lsn_t rec_lsn) { rec_lsn_ = rec_lsn; }
+
   [[nodiscard]] inline auto GetPinCount() const -> int { return pin_count_; }
 
   inline void Pin() { pin_count_++; }
@@ -56,12 +61,14 @@ public:
     page_.Clear();
     is_dirty_  = false;
     pin_count_ = 0;
+    rec_lsn_   = INVALID_LSN;
   }
 
 private:
-  Page page_{};
-  bool is_dirty_{false};
-  int  pin_count_{0};
+  Page  page_{};
+  bool  is_dirty_{false};
+  int   pin_count_{0};
+  lsn_t rec_lsn_{INVALID_LSN};
 };
 
 #endif  // WSDB_FRAME_H
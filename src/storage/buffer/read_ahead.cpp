@@ -0,0 +1,68 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/16.
+//
+
+#include <algorithm>
+#include "read_ahead.h"
+
+namespace wsdb {
+
+ReadAhead::ReadAhead(BufferPoolManager *buffer_pool_manager, file_id_t fid)
+    : buffer_pool_manager_(buffer_pool_manager),
+      fid_(fid),
+      max_window_(std::clamp(buffer_pool_manager->GetPoolSize() / 4, static_cast<size_t>(1), READ_AHEAD_MAX_PAGES))
+{
+  window_ = std::min(window_, max_window_);
+}
+
+void ReadAhead::OnAccess(page_id_t pid, size_t page_num)
+{
+  std::lock_guard<std::mutex> guard(latch_);
+  if (pid == last_pid_) {
+    return;
+  }
+  if (last_pid_ != INVALID_PAGE_ID && pid == last_pid_ + 1) {
+    seq_run_++;
+  } else {
+    seq_run_  = 0;
+    window_   = std::min(READ_AHEAD_MIN_PAGES, max_window_);
+    frontier_ = pid + 1;
+  }
+  last_pid_ = pid;
+  if (seq_run_ < READ_AHEAD_TRIGGER) {
+    return;
+  }
+  if (pid >= frontier_) {
+    frontier_ = pid + 1;
+  } else if (!buffer_pool_manager_->IsPageLoaded(fid_, pid)) {
+    // the scan consumes pages faster than they are prefetched
+    window_ = std::min(window_ * 2, max_window_);
+  }
+  if (static_cast<size_t>(frontier_ - pid) > window_ / 2 + 1) {
+    return;
+  }
+  auto end = static_cast<page_id_t>(std::min(static_cast<size_t>(pid) + 1 + window_, page_num));
+  if (frontier_ < end) {
+    buffer_pool_manager_->PrefetchPages(fid_, frontier_, end);
+    frontier_ = end;
+  }
+}
+
+}  // namespace wsdb
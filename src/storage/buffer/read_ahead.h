@@ -0,0 +1,72 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/16.
+//
+
+#ifndef WSDB_READ_AHEAD_H
+#define WSDB_READ_AHEAD_H
+
+#include <mutex>  // NOLINT
+#include "buffer_pool_manager.h"
+
+namespace wsdb {
+
+/**
+ * ReadAhead watches the pages a file is accessed in, once the access turns sequential it asks the buffer pool to
+ * prefetch the pages in front of the scan in the background. The window adapts to the scan speed: it doubles every
+ * time the scan reaches a page that is requested but not loaded yet, which means prefetching lags behind, and falls
+ * back to the minimum on any random access.
+ */
+class ReadAhead
+{
+public:
+  ReadAhead(BufferPoolManager *buffer_pool_manager, file_id_t fid);
+
+  ~ReadAhead() = default;
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(ReadAhead)
+
+  /**
+   * Called before the page is fetched
+   * 1. grant the latch, repeated accesses to the last page are ignored
+   * 2. update the sequential run, reset the window on a random access, grow it if the page is requested but not loaded
+   * 3. if the run is long enough and less than half a window is requested in front of the scan, request the next
+   *    window from the buffer pool
+   * @param pid the page to be fetched
+   * @param page_num number of pages in the file, nothing beyond it is prefetched
+   */
+  void OnAccess(page_id_t pid, size_t page_num);
+
+  [[nodiscard]] auto GetWindow() const -> size_t { return window_; }
+
+private:
+  std::mutex         latch_;
+  BufferPoolManager *buffer_pool_manager_;
+  file_id_t          fid_;
+  size_t             max_window_;
+  page_id_t          last_pid_{INVALID_PAGE_ID};
+  size_t             seq_run_{0};
+  size_t             window_{READ_AHEAD_MIN_PAGES};
+  // pages before frontier_ have been requested
+  page_id_t frontier_{INVALID_PAGE_ID};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_READ_AHEAD_H
@@ -112,6 +112,23 @@ namespace wsdb {
         }
     }
 
+    void LRUKReplacer::Admit(frame_id_t frame_id) {
+        std::lock_guard<std::mutex> guard(latch_);
+        auto it = node_store_.find(frame_id);
+        if (it == node_store_.end()) {
+            // 预取的页面不记录访问历史，只记录进入时间
+            LRUKNode node(frame_id, k_);
+            node.SetAdmitTime(++cur_ts_);
+            node.SetEvictable(true);
+            node_store_[frame_id] = node;
+            ++cur_size_;
+        }
+        else if (!it->second.IsEvictable()) {
+            it->second.SetEvictable(true);
+            ++cur_size_;
+        }
+    }
+
     auto LRUKReplacer::Size() -> size_t {
         std::lock_guard<std::mutex> guard(latch_);
         return cur_size_;
@@ -43,6 +43,12 @@ namespace wsdb {
 
     void Unpin(frame_id_t frame_id) override;
 
+    /**
+     * Admit a prefetched frame with an empty history, only the admission time is kept to order it among the frames
+     * with less than k accesses, so a page that is read ahead but never used does not look like a referenced one
+     */
+    void Admit(frame_id_t frame_id) override;
+
     auto Size() -> size_t override;
 
   private:
@@ -85,7 +91,11 @@ namespace wsdb {
         if (!history_.empty()) {
           return history_.front();
         }
-        return 0;  
+        return admit_ts_;
+      }
+
+      void SetAdmitTime(timestamp_t ts) {
+        admit_ts_ = ts;
       }
 
     private:
@@ -93,6 +103,7 @@ namespace wsdb {
       frame_id_t             fid_{ INVALID_FRAME_ID };
       size_t                 k{};
       bool                   is_evictable_{};
+      timestamp_t            admit_ts_{ 0 };
     };
 
   private:
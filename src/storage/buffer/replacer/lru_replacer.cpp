@@ -77,6 +77,8 @@ void LRUReplacer::Unpin(frame_id_t frame_id) {
   }
 }
 
+void LRUReplacer::Admit(frame_id_t frame_id) { Unpin(frame_id); }
+
 auto LRUReplacer::Size() -> size_t {
   std::lock_guard<std::mutex> guard(latch_);
   return cur_size_;
@@ -70,6 +70,12 @@ public:
    */
   void Unpin(frame_id_t frame_id) override;
 
+  /**
+   * Admit a prefetched frame, it is treated as a most recently unpinned frame
+   * @param frame_id
+   */
+  void Admit(frame_id_t frame_id) override;
+
   /**
    * Get the number of elements in the replacer that can be victimized.
    * 1. grant the latch
@@ -54,6 +54,13 @@ public:
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Admits a frame whose page is loaded without being accessed, e.g. by read-ahead. The frame is evictable at once and
+   * no access is recorded for it, so prefetching does not distort the access history kept by the policy.
+   * @param frame_id the id of the frame to admit
+   */
+  virtual void Admit(frame_id_t frame_id) = 0;
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual auto Size() -> size_t = 0;
 };
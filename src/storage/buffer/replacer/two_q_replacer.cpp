@@ -0,0 +1,104 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/16.
+//
+
+#include "two_q_replacer.h"
+#include "common/config.h"
+
+namespace wsdb {
+
+auto TwoQReplacer::Victim(frame_id_t *frame_id) -> bool
+{
+  std::lock_guard<std::mutex> guard(latch_);
+  if (a1in_.empty() && am_.empty()) {
+    return false;
+  }
+  size_t kin      = std::max(static_cast<size_t>(1), nodes_.size() * REPLACER_2Q_KIN_PERCENT / 100);
+  bool   use_a1in = !a1in_.empty() && (a1in_size_ > kin || am_.empty());
+  auto  &list     = use_a1in ? a1in_ : am_;
+  *frame_id       = list.front();
+  list.pop_front();
+  if (use_a1in) {
+    a1in_size_--;
+  }
+  nodes_.erase(*frame_id);
+  return true;
+}
+
+void TwoQReplacer::Pin(frame_id_t frame_id)
+{
+  std::lock_guard<std::mutex> guard(latch_);
+  if (frame_id != last_pinned_) {
+    cur_ts_++;
+    last_pinned_ = frame_id;
+  }
+  auto [it, inserted] = nodes_.try_emplace(frame_id);
+  auto &node          = it->second;
+  if (inserted) {
+    a1in_size_++;
+  }
+  if (node.evictable_) {
+    ListOf(node.queue_).erase(node.pos_);
+    node.evictable_ = false;
+  }
+  if (node.queue_ == Queue::A1IN && node.accessed_ && cur_ts_ - node.last_access_ > REPLACER_2Q_CRP) {
+    node.queue_ = Queue::AM;
+    a1in_size_--;
+  }
+  node.accessed_    = true;
+  node.last_access_ = cur_ts_;
+}
+
+void TwoQReplacer::Unpin(frame_id_t frame_id)
+{
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = nodes_.find(frame_id);
+  if (it == nodes_.end() || it->second.evictable_) {
+    return;
+  }
+  MakeEvictable(frame_id, it->second);
+}
+
+void TwoQReplacer::Admit(frame_id_t frame_id)
+{
+  std::lock_guard<std::mutex> guard(latch_);
+  auto [it, inserted] = nodes_.try_emplace(frame_id);
+  if (inserted) {
+    a1in_size_++;
+  }
+  if (!it->second.evictable_) {
+    MakeEvictable(frame_id, it->second);
+  }
+}
+
+auto TwoQReplacer::Size() -> size_t
+{
+  std::lock_guard<std::mutex> guard(latch_);
+  return a1in_.size() + am_.size();
+}
+
+void TwoQReplacer::MakeEvictable(frame_id_t frame_id, Node &node)
+{
+  auto &list = ListOf(node.queue_);
+  node.pos_  = list.insert(list.end(), frame_id);
+  node.evictable_ = true;
+}
+
+}  // namespace wsdb
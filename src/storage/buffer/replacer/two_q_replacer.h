@@ -0,0 +1,114 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/16.
+//
+
+#ifndef WSDB_TWO_Q_REPLACER_H
+#define WSDB_TWO_Q_REPLACER_H
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include "replacer.h"
+
+namespace wsdb {
+
+/**
+ * TwoQReplacer implements a scan resistant variant of the 2Q policy on frames.
+ * A frame enters the probation queue (A1in) on its first access and is promoted to the protected queue (Am) only when it
+ * is accessed again after more than REPLACER_2Q_CRP other frames have been accessed, so the burst of pins a scan puts on
+ * each page counts as one correlated reference. Victims are taken from A1in while it holds more than
+ * REPLACER_2Q_KIN_PERCENT of the frames, a big scan therefore only recycles A1in and leaves hot pages in Am alone.
+ * Both queues are ordered by unpin time and hold evictable frames only, every operation is O(1).
+ */
+class TwoQReplacer : public Replacer
+{
+public:
+  TwoQReplacer() = default;
+
+  ~TwoQReplacer() override = default;
+
+  /**
+   * Victimize a frame
+   * 1. grant the latch
+   * 2. if A1in is over its share or Am has no evictable frame, evict the least recently unpinned frame of A1in
+   * 3. else evict the least recently unpinned frame of Am
+   * @param frame_id
+   * @return true if a victim frame was found, false otherwise
+   */
+  auto Victim(frame_id_t *frame_id) -> bool override;
+
+  /**
+   * Pin a frame and record an access
+   * 1. grant the latch, advance the clock if the frame differs from the last pinned one
+   * 2. a new frame goes to A1in, a frame in A1in re-accessed after the correlated period goes to Am
+   * 3. remove the frame from its evictable list
+   * @param frame_id
+   */
+  void Pin(frame_id_t frame_id) override;
+
+  /**
+   * Unpin a frame, append it to the evictable list of its queue
+   * @param frame_id
+   */
+  void Unpin(frame_id_t frame_id) override;
+
+  /**
+   * Admit a prefetched frame to A1in without recording an access, its first pin is not a re-reference
+   * @param frame_id
+   */
+  void Admit(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+private:
+  enum class Queue
+  {
+    A1IN,
+    AM
+  };
+
+  struct Node
+  {
+    Queue                           queue_{Queue::A1IN};
+    bool                            accessed_{false};
+    bool                            evictable_{false};
+    timestamp_t                     last_access_{0};
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  auto ListOf(Queue queue) -> std::list<frame_id_t> & { return queue == Queue::A1IN ? a1in_ : am_; }
+
+  void MakeEvictable(frame_id_t frame_id, Node &node);
+
+private:
+  std::mutex                           latch_;
+  std::unordered_map<frame_id_t, Node> nodes_;
+  // evictable frames of each queue, front is the least recently unpinned
+  std::list<frame_id_t> a1in_;
+  std::list<frame_id_t> am_;
+  // number of tracked frames in A1in, pinned ones included
+  size_t      a1in_size_{0};
+  timestamp_t cur_ts_{0};
+  frame_id_t  last_pinned_{INVALID_FRAME_ID};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_TWO_Q_REPLACER_H
@@ -21,12 +21,24 @@
 
 #include <filesystem>
 #include <fcntl.h>
+#include <climits>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <vector>
 #include "disk_manager.h"
 #include "../../common/config.h"
 #include "../../../common/error.h"
 
 namespace wsdb {
+DiskManager::DiskManager() : io_backend_(CreateIOBackend(DISK_IO_BACKEND)) {}
+
+DiskManager::~DiskManager()
+{
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+  }
+}
+
 void DiskManager::CreateFile(const std::string &fname)
 {
   if (FileExists(fname)) {
@@ -54,6 +66,7 @@ auto DiskManager::OpenFile(const std::string &fname) -> file_id_t
 {
   if (!FileExists(fname))
     WSDB_THROW(WSDB_FILE_NOT_EXISTS, fname);
+  std::lock_guard<std::mutex> guard(files_latch_);
   if (name_fid_map_.find(fname) != name_fid_map_.end()) {
     WSDB_THROW(WSDB_FILE_REOPEN, fname);
   } else {
@@ -69,6 +82,7 @@ auto DiskManager::OpenFile(const std::string &fname) -> file_id_t
 
 void DiskManager::CloseFile(file_id_t fid)
 {
+  std::lock_guard<std::mutex> guard(files_latch_);
   if (fid_name_map_.find(fid) == fid_name_map_.end()) {
     WSDB_THROW(WSDB_FILE_NOT_OPEN, fmt::format("fid: {}", fid));
   } else {
@@ -81,8 +95,8 @@ void DiskManager::CloseFile(file_id_t fid)
 void DiskManager::WritePage(file_id_t fid, page_id_t page_id, const char *data)
 {
   WSDB_ASSERT(fid_name_map_.find(fid) != fid_name_map_.end(), fmt::format("fid: {}", fid));
-  lseek(fid, static_cast<off_t>(page_id) * static_cast<off_t>(PAGE_SIZE), SEEK_SET);
-  if (write(fid, data, PAGE_SIZE) != PAGE_SIZE) {
+  // positional write, pages of the same file may be written by different buffer pool partitions concurrently
+  if (pwrite(fid, data, PAGE_SIZE, static_cast<off_t>(page_id) * static_cast<off_t>(PAGE_SIZE)) != PAGE_SIZE) {
     WSDB_THROW(
         WSDB_FILE_WRITE_ERROR, fmt::format("fid: {}, page_id: {}", fid, page_id));
   }
@@ -91,13 +105,48 @@ void DiskManager::WritePage(file_id_t fid, page_id_t page_id, const char *data)
 void DiskManager::ReadPage(file_id_t fid, page_id_t page_id, char *data)
 {
   WSDB_ASSERT(fid_name_map_.find(fid) != fid_name_map_.end(), fmt::format("fid: {}", fid));
-  lseek(fid, static_cast<off_t>(page_id) * static_cast<off_t>(PAGE_SIZE), SEEK_SET);
-  if (read(fid, data, PAGE_SIZE) < 0) {
+  if (pread(fid, data, PAGE_SIZE, static_cast<off_t>(page_id) * static_cast<off_t>(PAGE_SIZE)) < 0) {
     WSDB_THROW(
         WSDB_FILE_READ_ERROR, fmt::format("fid: {}, page_id: {}", fid, page_id));
   }
 }
 
+void DiskManager::WritePages(file_id_t fid, page_id_t first_page_id, const char *const *pages, size_t page_num)
+{
+  WSDB_ASSERT(fid_name_map_.find(fid) != fid_name_map_.end(), fmt::format("fid: {}", fid));
+  WSDB_ASSERT(page_num <= IOV_MAX, fmt::format("too many pages in one write: {}", page_num));
+  std::vector<iovec> iov(page_num);
+  for (size_t i = 0; i < page_num; ++i) {
+    iov[i].iov_base = const_cast<char *>(pages[i]);
+    iov[i].iov_len  = PAGE_SIZE;
+  }
+  auto ret = pwritev(fid,
+      iov.data(),
+      static_cast<int>(page_num),
+      static_cast<off_t>(first_page_id) * static_cast<off_t>(PAGE_SIZE));
+  if (ret != static_cast<ssize_t>(page_num * PAGE_SIZE)) {
+    WSDB_THROW(WSDB_FILE_WRITE_ERROR,
+        fmt::format("fid: {}, page_id: {}, page_num: {}", fid, first_page_id, page_num));
+  }
+}
+
+auto DiskManager::WritePageAsync(file_id_t fid, page_id_t page_id, const char *data) -> std::future<void>
+{
+  WSDB_ASSERT(fid_name_map_.find(fid) != fid_name_map_.end(), fmt::format("fid: {}", fid));
+  return io_backend_->Submit(IOType::WRITE,
+      fid,
+      const_cast<char *>(data),
+      PAGE_SIZE,
+      static_cast<off_t>(page_id) * static_cast<off_t>(PAGE_SIZE));
+}
+
+auto DiskManager::ReadPageAsync(file_id_t fid, page_id_t page_id, char *data) -> std::future<void>
+{
+  WSDB_ASSERT(fid_name_map_.find(fid) != fid_name_map_.end(), fmt::format("fid: {}", fid));
+  return io_backend_->Submit(
+      IOType::READ, fid, data, PAGE_SIZE, static_cast<off_t>(page_id) * static_cast<off_t>(PAGE_SIZE));
+}
+
 void DiskManager::ReadFile(file_id_t fid, char *data, size_t size, size_t offset, int type)
 {
   WSDB_ASSERT(fid_name_map_.find(fid) != fid_name_map_.end(), "File not Opened");
@@ -117,12 +166,76 @@ void DiskManager::WriteFile(file_id_t fid, const char *data, size_t size, int ty
   }
 }
 
-void DiskManager::WriteLog(const std::string &log_file, const std::string &log_string) {}
+void DiskManager::SyncDataFiles()
+{
+  std::lock_guard<std::mutex> guard(files_latch_);
+  for (const auto &[fid, fname] : fid_name_map_) {
+    if (fdatasync(fid) < 0) {
+      WSDB_THROW(WSDB_FILE_WRITE_ERROR, fname);
+    }
+  }
+}
 
-void DiskManager::ReadLog(const std::string &log_file, std::string &log_string) {}
+void DiskManager::WriteLog(const std::string &log_file, const std::string &log_string)
+{
+  // the log is only appended, keep it open between flushes
+  if (log_fd_ < 0 || log_name_ != log_file) {
+    if (log_fd_ >= 0) {
+      close(log_fd_);
+    }
+    log_fd_ = open(log_file.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (log_fd_ < 0) {
+      WSDB_THROW(WSDB_FILE_NOT_OPEN, log_file);
+    }
+    log_name_ = log_file;
+  }
+  size_t written = 0;
+  while (written < log_string.size()) {
+    auto ret = write(log_fd_, log_string.data() + written, log_string.size() - written);
+    if (ret < 0) {
+      WSDB_THROW(WSDB_FILE_WRITE_ERROR, log_file);
+    }
+    written += ret;
+  }
+  if (fdatasync(log_fd_) < 0) {
+    WSDB_THROW(WSDB_FILE_WRITE_ERROR, log_file);
+  }
+}
+
+void DiskManager::ReadLog(const std::string &log_file, std::string &log_string, size_t offset)
+{
+  log_string.clear();
+  if (!FileExists(log_file)) {
+    return;
+  }
+  std::ifstream file(log_file, std::ios::binary);
+  if (!file) {
+    WSDB_THROW(WSDB_FILE_READ_ERROR, log_file);
+  }
+  file.seekg(static_cast<std::streamoff>(offset));
+  log_string.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void DiskManager::WriteFileAtomic(const std::string &fname, const std::string &data)
+{
+  auto tmp_name = fname + TMP_SUFFIX;
+  int  fd       = open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    WSDB_THROW(WSDB_FILE_NOT_OPEN, tmp_name);
+  }
+  if (write(fd, data.data(), data.size()) != static_cast<ssize_t>(data.size()) || fsync(fd) < 0) {
+    close(fd);
+    WSDB_THROW(WSDB_FILE_WRITE_ERROR, tmp_name);
+  }
+  close(fd);
+  if (rename(tmp_name.c_str(), fname.c_str()) < 0) {
+    WSDB_THROW(WSDB_FILE_WRITE_ERROR, fname);
+  }
+}
 
 auto DiskManager::GetFileId(const std::string &fname) -> file_id_t
 {
+  std::lock_guard<std::mutex> guard(files_latch_);
   auto it = name_fid_map_.find(fname);
   if (it != name_fid_map_.end()) {
     return it->second;
@@ -133,6 +246,7 @@ auto DiskManager::GetFileId(const std::string &fname) -> file_id_t
 
 auto DiskManager::GetFileName(file_id_t fid) -> std::string
 {
+  std::lock_guard<std::mutex> guard(files_latch_);
   auto it = fid_name_map_.find(fid);
   if (it != fid_name_map_.end()) {
     return it->second;
@@ -25,16 +25,18 @@
 #include <iostream>
 #include <fstream>
 #include <future>
+#include <mutex>
 #include <unordered_map>
 #include "common/types.h"
+#include "io_backend.h"
 
 namespace wsdb {
 class DiskManager
 {
 public:
-  DiskManager() = default;
+  DiskManager();
 
-  ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
    * Create a file named file_name and close it immediately
@@ -62,10 +64,34 @@ public:
    */
   void CloseFile(file_id_t fid);
 
+  /**
+   * Write the page synchronously, positional io is used so it is safe to call from different threads
+   */
   void WritePage(file_id_t fid, page_id_t page_id, const char *data);
 
+  /**
+   * Read the page synchronously, positional io is used so it is safe to call from different threads
+   */
   void ReadPage(file_id_t fid, page_id_t page_id, char *data);
 
+  /**
+   * Write page_num consecutive pages starting from first_page_id with a single vectored positional write,
+   * the pages are not required to be contiguous in memory
+   */
+  virtual void WritePages(file_id_t fid, page_id_t first_page_id, const char *const *pages, size_t page_num);
+
+  /**
+   * Submit the page write to the io backend, data must stay untouched until the future is ready
+   * @return future that rethrows WSDB_FILE_WRITE_ERROR on get() if the write failed
+   */
+  virtual auto WritePageAsync(file_id_t fid, page_id_t page_id, const char *data) -> std::future<void>;
+
+  /**
+   * Submit the page read to the io backend, data must stay valid until the future is ready
+   * @return future that rethrows WSDB_FILE_READ_ERROR on get() if the read failed
+   */
+  auto ReadPageAsync(file_id_t fid, page_id_t page_id, char *data) -> std::future<void>;
+
   void ReadFile(file_id_t fid, char *data, size_t size, size_t offset, int type);
 
   /**
@@ -77,9 +103,28 @@ public:
    */
   void WriteFile(file_id_t fid, const char *data, size_t size, int type);
 
+  /**
+   * Flush the data of every open table and index file to the device. Pages are written with positional io and may
+   * still sit in the page cache, a checkpoint calls this before it moves the redo lsn past their records
+   */
+  virtual void SyncDataFiles();
+
+  /**
+   * Append log_string to the log file and sync it, the file is created on the first write and kept open.
+   * Only the flusher of the log manager writes the log
+   */
   void WriteLog(const std::string &log_file, const std::string &log_string);
 
-  void ReadLog(const std::string &log_file, std::string &log_string);
+  /**
+   * Read the log file from offset to the end, log_string is empty if there is no log yet
+   */
+  void ReadLog(const std::string &log_file, std::string &log_string, size_t offset = 0);
+
+  /**
+   * Replace the content of the file through a synced temporary file and a rename, so that a crash leaves either the
+   * old or the new content
+   */
+  static void WriteFileAtomic(const std::string &fname, const std::string &data);
 
   auto GetFileId(const std::string &fname) -> file_id_t;
 
@@ -88,8 +133,12 @@ public:
   static auto FileExists(const std::string &fname) -> bool;
 
 private:
+  std::unique_ptr<IOBackend>                 io_backend_;
+  std::mutex                                 files_latch_;  // guards the file maps against a concurrent sync
   std::unordered_map<std::string, file_id_t> name_fid_map_;
   std::unordered_map<file_id_t, std::string> fid_name_map_;
+  int                                        log_fd_{-1};
+  std::string                                log_name_;
 };
 
 }  // namespace wsdb
@@ -0,0 +1,259 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/16.
+//
+
+#include <cstring>
+#include <vector>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "io_backend.h"
+#include "common/config.h"
+#include "../../../common/error.h"
+
+namespace wsdb {
+
+static auto IOError(IOType type, int fd, off_t offset, const std::string &reason) -> std::exception_ptr
+{
+  auto msg = fmt::format("fd: {}, offset: {}, {}", fd, offset, reason);
+  if (type == IOType::READ) {
+    return std::make_exception_ptr(WSDBException_(WSDB_FILE_READ_ERROR, "IOBackend", "Submit", msg));
+  }
+  return std::make_exception_ptr(WSDBException_(WSDB_FILE_WRITE_ERROR, "IOBackend", "Submit", msg));
+}
+
+auto PosixIOBackend::Submit(IOType type, int fd, char *buf, size_t size, off_t offset) -> std::future<void>
+{
+  std::promise<void> promise;
+  ssize_t            ret = type == IOType::READ ? pread(fd, buf, size, offset) : pwrite(fd, buf, size, offset);
+  if (ret < 0) {
+    promise.set_exception(IOError(type, fd, offset, strerror(errno)));
+  } else if (type == IOType::WRITE && static_cast<size_t>(ret) != size) {
+    promise.set_exception(IOError(type, fd, offset, "short write"));
+  } else {
+    promise.set_value();
+  }
+  return promise.get_future();
+}
+
+/// io_uring
+
+static auto IOUringSetup(unsigned entries, io_uring_params *p) -> int
+{
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+static auto IOUringEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) -> int
+{
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+static auto IOUringRegister(int fd, unsigned opcode, void *arg, unsigned nr_args) -> int
+{
+  return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+/**
+ * io_uring_setup succeeds on 5.1, but IORING_OP_READ/WRITE only exist since 5.6 and older kernels fail them with
+ * EINVAL at completion. The probe itself also arrived in 5.6, so a failed probe means the opcodes are missing too
+ */
+static auto SupportsReadWrite(int ring_fd) -> bool
+{
+  constexpr unsigned PROBE_OPS = 256;
+  std::vector<char>  buf(sizeof(io_uring_probe) + PROBE_OPS * sizeof(io_uring_probe_op), 0);
+  auto              *probe = reinterpret_cast<io_uring_probe *>(buf.data());
+  if (IOUringRegister(ring_fd, IORING_REGISTER_PROBE, probe, PROBE_OPS) < 0) {
+    return false;
+  }
+  auto supported = [probe](unsigned op) {
+    return op <= probe->last_op && op < probe->ops_len && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+  };
+  return supported(IORING_OP_READ) && supported(IORING_OP_WRITE);
+}
+
+// user data of the nop request used to wake up and stop the reaper
+static constexpr uint64_t STOP_USER_DATA = 0;
+
+IOUringBackend::IOUringBackend(unsigned depth) : depth_(depth)
+{
+  io_uring_params params{};
+  int             fd = IOUringSetup(depth, &params);
+  if (fd < 0) {
+    return;
+  }
+  if (!SupportsReadWrite(fd)) {
+    close(fd);
+    return;
+  }
+  sq_len_   = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_len_   = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  sqes_len_ = params.sq_entries * sizeof(io_uring_sqe);
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_len_ = cq_len_ = std::max(sq_len_, cq_len_);
+  }
+  sq_ptr_ = mmap(nullptr, sq_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ptr_ == MAP_FAILED) {
+    close(fd);
+    return;
+  }
+  cq_ptr_ = single_mmap
+                ? sq_ptr_
+                : mmap(nullptr, cq_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+  void *sqes = mmap(nullptr, sqes_len_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (cq_ptr_ == MAP_FAILED || sqes == MAP_FAILED) {
+    munmap(sq_ptr_, sq_len_);
+    if (!single_mmap && cq_ptr_ != MAP_FAILED) {
+      munmap(cq_ptr_, cq_len_);
+    }
+    if (sqes != MAP_FAILED) {
+      munmap(sqes, sqes_len_);
+    }
+    close(fd);
+    return;
+  }
+  auto *sq  = static_cast<char *>(sq_ptr_);
+  auto *cq  = static_cast<char *>(cq_ptr_);
+  sq_head_  = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_  = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_  = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  sqes_     = static_cast<io_uring_sqe *>(sqes);
+  cq_head_  = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_  = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_  = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_     = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  // never let more requests in flight than the submission queue can hold, the completion queue is at least as large
+  depth_   = params.sq_entries;
+  ring_fd_ = fd;
+  reaper_  = std::thread(&IOUringBackend::ReapLoop, this);
+}
+
+IOUringBackend::~IOUringBackend()
+{
+  if (ring_fd_ < 0) {
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(submit_latch_);
+    // the stop request also occupies a slot
+    slot_cv_.wait(lock, [this] { return in_flight_ < depth_; });
+    in_flight_++;
+    PushSqe(IORING_OP_NOP, -1, nullptr, 0, 0, STOP_USER_DATA);
+  }
+  reaper_.join();
+  munmap(sqes_, sqes_len_);
+  if (cq_ptr_ != sq_ptr_) {
+    munmap(cq_ptr_, cq_len_);
+  }
+  munmap(sq_ptr_, sq_len_);
+  close(ring_fd_);
+}
+
+auto IOUringBackend::PushSqe(uint8_t opcode, int fd, char *buf, size_t size, off_t offset, uint64_t user_data) -> int
+{
+  unsigned tail  = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  auto    &sqe   = sqes_[index];
+  memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode     = opcode;
+  sqe.fd         = fd;
+  sqe.addr       = reinterpret_cast<uint64_t>(buf);
+  sqe.len        = static_cast<uint32_t>(size);
+  sqe.off        = static_cast<uint64_t>(offset);
+  sqe.user_data  = user_data;
+  sq_array_[index] = index;
+  // the kernel must see the sqe before the new tail
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  // also submit the sqes left behind by a previously failed enter
+  unsigned to_submit = tail + 1 - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  int      ret;
+  do {
+    ret = IOUringEnter(ring_fd_, to_submit, 0, 0);
+  } while (ret < 0 && errno == EINTR);
+  return ret;
+}
+
+auto IOUringBackend::Submit(IOType type, int fd, char *buf, size_t size, off_t offset) -> std::future<void>
+{
+  auto *req   = new Request{type, fd, offset, size, {}};
+  auto  fut   = req->promise_.get_future();
+  auto opcode = static_cast<uint8_t>(type == IOType::READ ? IORING_OP_READ : IORING_OP_WRITE);
+  std::unique_lock<std::mutex> lock(submit_latch_);
+  slot_cv_.wait(lock, [this] { return in_flight_ < depth_; });
+  in_flight_++;
+  if (PushSqe(opcode, fd, buf, size, offset, reinterpret_cast<uint64_t>(req)) < 0) {
+    // the sqe stays in the ring and is submitted by the next enter, the request is completed by the reaper then
+    WSDB_LOG_ERROR(fmt::format("io_uring_enter failed: {}", strerror(errno)));
+  }
+  return fut;
+}
+
+void IOUringBackend::ReapLoop()
+{
+  bool stop = false;
+  while (!stop) {
+    if (IOUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+      WSDB_LOG_ERROR(fmt::format("io_uring_enter failed: {}", strerror(errno)));
+    }
+    unsigned head     = *cq_head_;
+    unsigned tail     = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    unsigned finished = 0;
+    for (; head != tail; ++head, ++finished) {
+      auto &cqe = cqes_[head & *cq_mask_];
+      if (cqe.user_data == STOP_USER_DATA) {
+        stop = true;
+        continue;
+      }
+      auto *req = reinterpret_cast<Request *>(cqe.user_data);
+      if (cqe.res < 0) {
+        req->promise_.set_exception(IOError(req->type_, req->fd_, req->offset_, strerror(-cqe.res)));
+      } else if (req->type_ == IOType::WRITE && static_cast<size_t>(cqe.res) != req->size_) {
+        req->promise_.set_exception(IOError(req->type_, req->fd_, req->offset_, "short write"));
+      } else {
+        req->promise_.set_value();
+      }
+      delete req;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    if (finished > 0) {
+      std::lock_guard<std::mutex> lock(submit_latch_);
+      in_flight_ -= finished;
+      slot_cv_.notify_all();
+    }
+  }
+}
+
+auto CreateIOBackend(const std::string &name, unsigned depth) -> std::unique_ptr<IOBackend>
+{
+  if (name == "IOUring") {
+    auto backend = std::make_unique<IOUringBackend>(depth);
+    if (backend->Valid()) {
+      return backend;
+    }
+    WSDB_LOG("io_uring is not available, fall back to pread/pwrite");
+  } else if (name != "PosixIO") {
+    WSDB_FETAL("Unknown disk io backend: " + name);
+  }
+  return std::make_unique<PosixIOBackend>();
+}
+
+}  // namespace wsdb
@@ -0,0 +1,155 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/16.
+//
+
+#ifndef WSDB_IO_BACKEND_H
+#define WSDB_IO_BACKEND_H
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <sys/types.h>
+#include "common/config.h"
+#include "common/types.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace wsdb {
+
+enum class IOType
+{
+  READ,
+  WRITE
+};
+
+/**
+ * IOBackend executes positional reads and writes of a whole buffer and reports completion through a future,
+ * the future carries a WSDBException_ if the request fails.
+ * All backends are thread safe: requests never touch the shared file offset.
+ */
+class IOBackend
+{
+public:
+  IOBackend()          = default;
+  virtual ~IOBackend() = default;
+
+  DISABLE_COPY_MOVE_AND_ASSIGN(IOBackend)
+
+  /**
+   * Submit a request, buf must stay valid until the returned future is ready
+   * @param type read or write
+   * @param fd file descriptor
+   * @param buf
+   * @param size number of bytes, a write is failed if not all bytes are written,
+   * a short read is allowed since pages beyond the end of file are read as zeros
+   * @param offset position in the file
+   */
+  virtual auto Submit(IOType type, int fd, char *buf, size_t size, off_t offset) -> std::future<void> = 0;
+};
+
+/**
+ * Fallback backend, executes pread/pwrite in the caller's thread and returns a ready future
+ */
+class PosixIOBackend : public IOBackend
+{
+public:
+  PosixIOBackend() = default;
+
+  ~PosixIOBackend() override = default;
+
+  auto Submit(IOType type, int fd, char *buf, size_t size, off_t offset) -> std::future<void> override;
+};
+
+/**
+ * Backend built on raw io_uring system calls, so there is no dependency on liburing.
+ * Submitters push sqes under a latch, a reaper thread waits for cqes and fulfills the promises.
+ * At most depth requests are in flight, further submitters block until some request completes.
+ */
+class IOUringBackend : public IOBackend
+{
+public:
+  explicit IOUringBackend(unsigned depth);
+
+  ~IOUringBackend() override;
+
+  /**
+   * @return false if the kernel refused to set up the ring (too old, or forbidden by seccomp) or does not support
+   * IORING_OP_READ/IORING_OP_WRITE (before 5.6)
+   */
+  [[nodiscard]] auto Valid() const -> bool { return ring_fd_ >= 0; }
+
+  auto Submit(IOType type, int fd, char *buf, size_t size, off_t offset) -> std::future<void> override;
+
+private:
+  struct Request
+  {
+    IOType             type_;
+    int                fd_;
+    off_t              offset_;
+    size_t             size_;
+    std::promise<void> promise_;
+  };
+
+  /**
+   * fill one sqe and notify the kernel, should be called with submit_latch_ held
+   */
+  auto PushSqe(uint8_t opcode, int fd, char *buf, size_t size, off_t offset, uint64_t user_data) -> int;
+
+  void ReapLoop();
+
+private:
+  int      ring_fd_{-1};
+  unsigned depth_;
+  // submission queue
+  void         *sq_ptr_{nullptr};
+  size_t        sq_len_{0};
+  unsigned     *sq_head_{nullptr};
+  unsigned     *sq_tail_{nullptr};
+  unsigned     *sq_mask_{nullptr};
+  unsigned     *sq_array_{nullptr};
+  io_uring_sqe *sqes_{nullptr};
+  size_t        sqes_len_{0};
+  // completion queue
+  void         *cq_ptr_{nullptr};
+  size_t        cq_len_{0};
+  unsigned     *cq_head_{nullptr};
+  unsigned     *cq_tail_{nullptr};
+  unsigned     *cq_mask_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+
+  std::mutex              submit_latch_;
+  std::condition_variable slot_cv_;
+  unsigned                in_flight_{0};
+  std::thread             reaper_;
+};
+
+/**
+ * Create the backend named by DISK_IO_BACKEND, fall back to PosixIOBackend if io_uring can not be used
+ * @param depth max number of requests in flight of the io_uring backend
+ */
+auto CreateIOBackend(const std::string &name, unsigned depth = DISK_IO_DEPTH) -> std::unique_ptr<IOBackend>;
+
+}  // namespace wsdb
+
+#endif  // WSDB_IO_BACKEND_H
@@ -28,13 +28,23 @@
 
 namespace wsdb {
 
-enum class IndexType
+/**
+ * Iterate over the rids of index entries in key order
+ */
+class IndexIterator
 {
-  NONE,
-  BPTREE,
-  HASH,
+public:
+  virtual ~IndexIterator() = default;
+
+  [[nodiscard]] virtual auto IsEnd() const -> bool = 0;
+
+  [[nodiscard]] virtual auto GetRID() const -> RID = 0;
+
+  virtual void Next() = 0;
 };
 
+DEFINE_UNIQUE_PTR(IndexIterator);
+
 class Index
 {
 public:
@@ -55,9 +65,43 @@ public:
 
   virtual void Delete(const Record &key, const RID &rid) = 0;
 
+  /**
+   * Find the rids of all entries with the given key
+   * @param key
+   * @return
+   */
+  virtual auto Search(const Record &key) -> std::vector<RID> = 0;
+
+  /**
+   * Iterate over the entries with low <= key <= high in key order, only the first low_field_num key fields of low and
+   * the first high_field_num key fields of high are compared, a bound comparing no field is unbounded
+   * @param low
+   * @param low_field_num
+   * @param high
+   * @param high_field_num
+   * @return
+   */
+  virtual auto Scan(const Record &low, size_t low_field_num, const Record &high, size_t high_field_num)
+      -> IndexIteratorUptr
+  {
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, "range scan");
+  }
+
+  /**
+   * Insert a batch of entries sorted by key, indexes that keep keys in order can override it to build their pages
+   * bottom-up instead of descending from the root for every key
+   * @param entries
+   */
+  virtual void BulkInsert(const std::vector<std::pair<Record, RID>> &entries)
+  {
+    for (const auto &[key, rid] : entries) {
+      Insert(key, rid);
+    }
+  }
+
   [[nodiscard]] auto GetIndexType() const -> IndexType { return index_type_; }
 
-private:
+protected:
   DiskManager       *disk_manager_;
   BufferPoolManager *buffer_pool_manager_;
   IndexType          index_type_;
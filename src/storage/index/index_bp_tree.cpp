@@ -21,15 +21,572 @@
 
 #include "index_bp_tree.h"
 
+#include <algorithm>
+#include <numeric>
+
+#define BPTREE_META_PAGE_ID 1
+#define BPTREE_META_ROOT_OFFSET PAGE_HEADER_SIZE
+#define BPTREE_META_PAGE_NUM_OFFSET (BPTREE_META_ROOT_OFFSET + sizeof(page_id_t))
+
+#define BPTREE_NODE_LEVEL_OFFSET PAGE_HEADER_SIZE
+#define BPTREE_NODE_SIZE_OFFSET (BPTREE_NODE_LEVEL_OFFSET + sizeof(uint32_t))
+#define BPTREE_NODE_NEXT_OFFSET (BPTREE_NODE_SIZE_OFFSET + sizeof(uint32_t))
+#define BPTREE_NODE_HEADER_SIZE (BPTREE_NODE_NEXT_OFFSET + sizeof(page_id_t))
+
 namespace wsdb {
 
-// FIXME: BPTreeIndex initializer should include more BPTree parameters, like order, etc.
+/// store v big-endian with the sign bit flipped, so memcmp orders the encoded ids numerically
+static void EncodeId(int32_t v, char *out)
+{
+  auto u = static_cast<uint32_t>(v) ^ 0x80000000U;
+  for (int i = 3; i >= 0; --i) {
+    out[i] = static_cast<char>(u & 0xFF);
+    u >>= 8;
+  }
+}
+
+static auto DecodeId(const char *in) -> int32_t
+{
+  uint32_t u = 0;
+  for (int i = 0; i < 4; ++i) {
+    u = (u << 8) | static_cast<uint8_t>(in[i]);
+  }
+  return static_cast<int32_t>(u ^ 0x80000000U);
+}
+
 BPTreeIndex::BPTreeIndex(
     DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, idx_id_t index_id, RecordSchema *key_schema)
-    : Index(disk_manager, buffer_pool_manager, IndexType::BPTREE, index_id, key_schema)
+    : Index(disk_manager, buffer_pool_manager, IndexType::BPTREE, index_id, key_schema),
+      encoder_(key_schema, key_schema),
+      key_size_(encoder_.GetKeySize()),
+      entry_size_(key_size_ + sizeof(page_id_t) + sizeof(slot_id_t)),
+      leaf_max_((PAGE_SIZE - BPTREE_NODE_HEADER_SIZE) / entry_size_),
+      internal_max_((PAGE_SIZE - BPTREE_NODE_HEADER_SIZE) / (entry_size_ + sizeof(page_id_t)))
+{
+  // a split must leave at least two slots on both sides
+  if (internal_max_ < 4) {
+    WSDB_THROW(WSDB_RECLEN_ERROR, fmt::format("index key of {} bytes is too long", key_size_));
+  }
+  LoadMeta();
+}
+
+void BPTreeIndex::Insert(const Record &key, const RID &rid)
+{
+  std::vector<char> entry(entry_size_);
+  EncodeEntry(key, rid, entry.data());
+  if (!InsertOptimistic(entry.data())) {
+    InsertPessimistic(entry.data());
+  }
+}
+
+void BPTreeIndex::Delete(const Record &key, const RID &rid)
+{
+  std::vector<char> entry(entry_size_);
+  EncodeEntry(key, rid, entry.data());
+  root_latch_.lock_shared();
+  if (root_ == INVALID_PAGE_ID) {
+    root_latch_.unlock_shared();
+    return;
+  }
+  // nodes never merge, so only the leaf is written
+  auto page = buffer_pool_manager_->FetchPage(index_id_, root_);
+  GetLevel(page) == 0 ? page->WLatch() : page->RLatch();
+  root_latch_.unlock_shared();
+  while (GetLevel(page) > 0) {
+    auto child = buffer_pool_manager_->FetchPage(index_id_, InternalChild(page, ChildOf(page, entry.data())));
+    GetLevel(page) == 1 ? child->WLatch() : child->RLatch();
+    page->RUnlatch();
+    Unpin(page, false);
+    page = child;
+  }
+  auto size = GetSize(page);
+  auto pos  = LeafLowerBound(page, entry.data(), entry_size_);
+  bool hit  = pos < size && memcmp(LeafEntry(page, pos), entry.data(), entry_size_) == 0;
+  if (hit) {
+    memmove(LeafEntry(page, pos), LeafEntry(page, pos + 1), (size - pos - 1) * entry_size_);
+    SetHeader(page, 0, size - 1, GetNext(page));
+  }
+  page->WUnlatch();
+  Unpin(page, hit);
+}
+
+auto BPTreeIndex::Search(const Record &key) -> std::vector<RID>
+{
+  auto             enc = encoder_.Encode(key);
+  std::vector<RID> rids;
+  for (BPTreeIterator iter(this, enc, enc); !iter.IsEnd(); iter.Next()) {
+    rids.push_back(iter.GetRID());
+  }
+  return rids;
+}
+
+auto BPTreeIndex::Scan(const Record &low, size_t low_field_num, const Record &high, size_t high_field_num)
+    -> IndexIteratorUptr
+{
+  auto low_key  = encoder_.Encode(low);
+  auto high_key = encoder_.Encode(high);
+  low_key.resize(encoder_.GetPrefixSize(low_field_num));
+  high_key.resize(encoder_.GetPrefixSize(high_field_num));
+  return std::make_unique<BPTreeIterator>(this, std::move(low_key), std::move(high_key));
+}
+
+void BPTreeIndex::BulkInsert(const std::vector<std::pair<Record, RID>> &entries)
+{
+  {
+    std::unique_lock lock(root_latch_);
+    if (root_ == INVALID_PAGE_ID) {
+      // entries are sorted by key but ties are not sorted by rid, so sort the encoded entries again
+      std::vector<char> raw(entries.size() * entry_size_);
+      for (size_t i = 0; i < entries.size(); ++i) {
+        EncodeEntry(entries[i].first, entries[i].second, raw.data() + i * entry_size_);
+      }
+      std::vector<size_t> order(entries.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::sort(order.begin(), order.end(), [this, &raw](size_t lhs, size_t rhs) {
+        return memcmp(raw.data() + lhs * entry_size_, raw.data() + rhs * entry_size_, entry_size_) < 0;
+      });
+      std::vector<char> sorted;
+      sorted.reserve(raw.size());
+      for (auto i : order) {
+        auto entry = raw.data() + i * entry_size_;
+        if (!sorted.empty() && memcmp(sorted.data() + sorted.size() - entry_size_, entry, entry_size_) == 0) {
+          continue;
+        }
+        sorted.insert(sorted.end(), entry, entry + entry_size_);
+      }
+      Build(sorted.data(), sorted.size() / entry_size_);
+      return;
+    }
+  }
+  Index::BulkInsert(entries);
+}
+
+auto BPTreeIndex::GetHeight() -> size_t
+{
+  std::shared_lock lock(root_latch_);
+  if (root_ == INVALID_PAGE_ID) {
+    return 0;
+  }
+  auto page   = buffer_pool_manager_->FetchPage(index_id_, root_);
+  auto height = GetLevel(page) + 1;
+  Unpin(page, false);
+  return height;
+}
+
+auto BPTreeIndex::GetLevel(Page *page) -> uint32_t
+{
+  return *reinterpret_cast<uint32_t *>(page->GetData() + BPTREE_NODE_LEVEL_OFFSET);
+}
+
+auto BPTreeIndex::GetSize(Page *page) -> uint32_t
+{
+  return *reinterpret_cast<uint32_t *>(page->GetData() + BPTREE_NODE_SIZE_OFFSET);
+}
+
+auto BPTreeIndex::GetNext(Page *page) -> page_id_t
+{
+  return *reinterpret_cast<page_id_t *>(page->GetData() + BPTREE_NODE_NEXT_OFFSET);
+}
+
+void BPTreeIndex::SetHeader(Page *page, uint32_t level, uint32_t size, page_id_t next)
+{
+  *reinterpret_cast<uint32_t *>(page->GetData() + BPTREE_NODE_LEVEL_OFFSET) = level;
+  *reinterpret_cast<uint32_t *>(page->GetData() + BPTREE_NODE_SIZE_OFFSET)  = size;
+  *reinterpret_cast<page_id_t *>(page->GetData() + BPTREE_NODE_NEXT_OFFSET) = next;
+}
+
+auto BPTreeIndex::LeafEntry(Page *page, size_t i) const -> char *
+{
+  return page->GetData() + BPTREE_NODE_HEADER_SIZE + i * entry_size_;
+}
+
+auto BPTreeIndex::InternalEntry(Page *page, size_t i) const -> char *
+{
+  return page->GetData() + BPTREE_NODE_HEADER_SIZE + i * (entry_size_ + sizeof(page_id_t));
+}
+
+auto BPTreeIndex::InternalChild(Page *page, size_t i) const -> page_id_t
+{
+  page_id_t child;
+  memcpy(&child, InternalEntry(page, i) + entry_size_, sizeof(page_id_t));
+  return child;
+}
+
+void BPTreeIndex::SetInternalChild(Page *page, size_t i, page_id_t child) const
+{
+  memcpy(InternalEntry(page, i) + entry_size_, &child, sizeof(page_id_t));
+}
+
+void BPTreeIndex::EncodeEntry(const Record &key, const RID &rid, char *out) const
 {
-  WSDB_THROW(WSDB_NOT_IMPLEMENTED, "");
+  encoder_.Encode(key, out);
+  EncodeId(rid.PageID(), out + key_size_);
+  EncodeId(rid.SlotID(), out + key_size_ + sizeof(page_id_t));
 }
-void BPTreeIndex::Insert(const Record &key, const RID &rid) {}
-void BPTreeIndex::Delete(const Record &key, const RID &rid) {}
-}  // namespace wsdb
\ No newline at end of file
+
+auto BPTreeIndex::DecodeRID(const char *entry) const -> RID
+{
+  return {DecodeId(entry + key_size_), DecodeId(entry + key_size_ + sizeof(page_id_t))};
+}
+
+auto BPTreeIndex::LeafLowerBound(Page *page, const char *target, size_t len) const -> size_t
+{
+  size_t lo = 0;
+  size_t hi = GetSize(page);
+  while (lo < hi) {
+    auto mid = (lo + hi) / 2;
+    if (memcmp(LeafEntry(page, mid), target, len) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+auto BPTreeIndex::ChildFor(Page *page, const char *target, size_t len) const -> size_t
+{
+  // entries under the children before the first separator not less than target are all less than it
+  size_t lo = 1;
+  size_t hi = GetSize(page);
+  while (lo < hi) {
+    auto mid = (lo + hi) / 2;
+    if (memcmp(InternalEntry(page, mid), target, len) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo - 1;
+}
+
+auto BPTreeIndex::ChildOf(Page *page, const char *entry) const -> size_t
+{
+  size_t lo = 1;
+  size_t hi = GetSize(page);
+  while (lo < hi) {
+    auto mid = (lo + hi) / 2;
+    if (memcmp(InternalEntry(page, mid), entry, entry_size_) <= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo - 1;
+}
+
+auto BPTreeIndex::FindLeafRead(const char *target, size_t len) -> Page *
+{
+  root_latch_.lock_shared();
+  if (root_ == INVALID_PAGE_ID) {
+    root_latch_.unlock_shared();
+    return nullptr;
+  }
+  auto page = buffer_pool_manager_->FetchPage(index_id_, root_);
+  page->RLatch();
+  root_latch_.unlock_shared();
+  while (GetLevel(page) > 0) {
+    auto child = buffer_pool_manager_->FetchPage(index_id_, InternalChild(page, ChildFor(page, target, len)));
+    child->RLatch();
+    page->RUnlatch();
+    Unpin(page, false);
+    page = child;
+  }
+  return page;
+}
+
+auto BPTreeIndex::InsertOptimistic(const char *entry) -> bool
+{
+  root_latch_.lock_shared();
+  if (root_ == INVALID_PAGE_ID) {
+    root_latch_.unlock_shared();
+    return false;
+  }
+  // the level of the root cannot change while root_latch_ is held, and a node at level 1 has leaves as children
+  auto page = buffer_pool_manager_->FetchPage(index_id_, root_);
+  GetLevel(page) == 0 ? page->WLatch() : page->RLatch();
+  root_latch_.unlock_shared();
+  while (GetLevel(page) > 0) {
+    auto child = buffer_pool_manager_->FetchPage(index_id_, InternalChild(page, ChildOf(page, entry)));
+    GetLevel(page) == 1 ? child->WLatch() : child->RLatch();
+    page->RUnlatch();
+    Unpin(page, false);
+    page = child;
+  }
+  auto size = GetSize(page);
+  if (size >= leaf_max_) {
+    page->WUnlatch();
+    Unpin(page, false);
+    return false;
+  }
+  auto pos = LeafLowerBound(page, entry, entry_size_);
+  if (pos < size && memcmp(LeafEntry(page, pos), entry, entry_size_) == 0) {
+    page->WUnlatch();
+    Unpin(page, false);
+    return true;
+  }
+  memmove(LeafEntry(page, pos + 1), LeafEntry(page, pos), (size - pos) * entry_size_);
+  memcpy(LeafEntry(page, pos), entry, entry_size_);
+  SetHeader(page, 0, size + 1, GetNext(page));
+  page->WUnlatch();
+  Unpin(page, true);
+  return true;
+}
+
+void BPTreeIndex::InsertPessimistic(const char *entry)
+{
+  root_latch_.lock();
+  bool root_locked = true;
+  if (root_ == INVALID_PAGE_ID) {
+    auto leaf = NewPage();
+    SetHeader(leaf, 0, 1, INVALID_PAGE_ID);
+    memcpy(LeafEntry(leaf, 0), entry, entry_size_);
+    root_ = leaf->GetPageId();
+    StoreMeta();
+    Unpin(leaf, true);
+    root_latch_.unlock();
+    return;
+  }
+  std::vector<Page *> path;
+  auto                page = buffer_pool_manager_->FetchPage(index_id_, root_);
+  page->WLatch();
+  while (true) {
+    path.push_back(page);
+    auto level = GetLevel(page);
+    // a node with a free slot absorbs a split below it, so nothing above it changes
+    if (GetSize(page) < (level == 0 ? leaf_max_ : internal_max_)) {
+      ReleasePath(path, path.size() - 1, false);
+      if (root_locked) {
+        root_latch_.unlock();
+        root_locked = false;
+      }
+    }
+    if (level == 0) {
+      break;
+    }
+    page = buffer_pool_manager_->FetchPage(index_id_, InternalChild(page, ChildOf(page, entry)));
+    page->WLatch();
+  }
+
+  auto leaf = path.back();
+  auto size = GetSize(leaf);
+  auto pos  = LeafLowerBound(leaf, entry, entry_size_);
+  if (pos < size && memcmp(LeafEntry(leaf, pos), entry, entry_size_) == 0) {
+    ReleasePath(path, path.size(), false);
+  } else if (size < leaf_max_) {
+    memmove(LeafEntry(leaf, pos + 1), LeafEntry(leaf, pos), (size - pos) * entry_size_);
+    memcpy(LeafEntry(leaf, pos), entry, entry_size_);
+    SetHeader(leaf, 0, size + 1, GetNext(leaf));
+    ReleasePath(path, path.size(), true);
+  } else {
+    // split the leaf, the left half keeps the smaller entries
+    std::vector<char> buf((size + 1) * entry_size_);
+    memcpy(buf.data(), LeafEntry(leaf, 0), pos * entry_size_);
+    memcpy(buf.data() + pos * entry_size_, entry, entry_size_);
+    memcpy(buf.data() + (pos + 1) * entry_size_, LeafEntry(leaf, pos), (size - pos) * entry_size_);
+    auto left_num  = (size + 1) / 2;
+    auto right_num = size + 1 - left_num;
+    auto right     = NewPage();
+    SetHeader(right, 0, right_num, GetNext(leaf));
+    memcpy(LeafEntry(right, 0), buf.data() + left_num * entry_size_, right_num * entry_size_);
+    memcpy(LeafEntry(leaf, 0), buf.data(), left_num * entry_size_);
+    // the right leaf is complete before it is linked, so iterators following the link never see it half written
+    SetHeader(leaf, 0, left_num, right->GetPageId());
+    InsertIntoParent(path, path.size() - 1, LeafEntry(right, 0), right->GetPageId());
+    Unpin(right, true);
+    ReleasePath(path, path.size(), true);
+  }
+  if (root_locked) {
+    root_latch_.unlock();
+  }
+}
+
+void BPTreeIndex::InsertIntoParent(std::vector<Page *> &path, size_t depth, const char *sep, page_id_t right)
+{
+  auto node = path[depth];
+  if (depth == 0) {
+    // only a node that may split is kept on the path, so path[0] is the root and root_latch_ is still held
+    WSDB_ASSERT(node->GetPageId() == root_, "split a node without its parent");
+    auto root = NewPage();
+    SetHeader(root, GetLevel(node) + 1, 2, INVALID_PAGE_ID);
+    SetInternalChild(root, 0, node->GetPageId());
+    memcpy(InternalEntry(root, 1), sep, entry_size_);
+    SetInternalChild(root, 1, right);
+    root_ = root->GetPageId();
+    StoreMeta();
+    Unpin(root, true);
+    return;
+  }
+  auto   parent    = path[depth - 1];
+  auto   size      = GetSize(parent);
+  auto   pos       = ChildOf(parent, sep) + 1;
+  size_t slot_size = entry_size_ + sizeof(page_id_t);
+  if (size < internal_max_) {
+    memmove(InternalEntry(parent, pos + 1), InternalEntry(parent, pos), (size - pos) * slot_size);
+    memcpy(InternalEntry(parent, pos), sep, entry_size_);
+    SetInternalChild(parent, pos, right);
+    SetHeader(parent, GetLevel(parent), size + 1, INVALID_PAGE_ID);
+    return;
+  }
+  // split the parent, the separator of the first child of the right half moves up
+  std::vector<char> buf((size + 1) * slot_size);
+  memcpy(buf.data(), InternalEntry(parent, 0), pos * slot_size);
+  memcpy(buf.data() + pos * slot_size, sep, entry_size_);
+  memcpy(buf.data() + pos * slot_size + entry_size_, &right, sizeof(page_id_t));
+  memcpy(buf.data() + (pos + 1) * slot_size, InternalEntry(parent, pos), (size - pos) * slot_size);
+  auto left_num  = (size + 1) / 2;
+  auto right_num = size + 1 - left_num;
+  auto sibling   = NewPage();
+  SetHeader(sibling, GetLevel(parent), right_num, INVALID_PAGE_ID);
+  memcpy(InternalEntry(sibling, 0), buf.data() + left_num * slot_size, right_num * slot_size);
+  memcpy(InternalEntry(parent, 0), buf.data(), left_num * slot_size);
+  SetHeader(parent, GetLevel(parent), left_num, INVALID_PAGE_ID);
+  InsertIntoParent(path, depth - 1, InternalEntry(sibling, 0), sibling->GetPageId());
+  Unpin(sibling, true);
+}
+
+void BPTreeIndex::ReleasePath(std::vector<Page *> &path, size_t num, bool dirty)
+{
+  for (size_t i = 0; i < num; ++i) {
+    path[i]->WUnlatch();
+    Unpin(path[i], dirty);
+  }
+  path.erase(path.begin(), path.begin() + static_cast<long>(num));
+}
+
+auto BPTreeIndex::NewPage() -> Page *
+{
+  auto page_id = page_num_.fetch_add(1);
+  StoreMeta();
+  return buffer_pool_manager_->FetchPage(index_id_, page_id);
+}
+
+void BPTreeIndex::Unpin(Page *page, bool dirty) { buffer_pool_manager_->UnpinPage(index_id_, page->GetPageId(), dirty); }
+
+void BPTreeIndex::LoadMeta()
+{
+  auto meta     = buffer_pool_manager_->FetchPage(index_id_, BPTREE_META_PAGE_ID);
+  auto page_num = *reinterpret_cast<page_id_t *>(meta->GetData() + BPTREE_META_PAGE_NUM_OFFSET);
+  Unpin(meta, false);
+  if (page_num == 0) {
+    // a fresh index, page 0 is the file header and page 1 the meta page
+    root_     = INVALID_PAGE_ID;
+    page_num_ = BPTREE_META_PAGE_ID + 1;
+    StoreMeta();
+    return;
+  }
+  page_num_ = page_num;
+  meta      = buffer_pool_manager_->FetchPage(index_id_, BPTREE_META_PAGE_ID);
+  root_     = *reinterpret_cast<page_id_t *>(meta->GetData() + BPTREE_META_ROOT_OFFSET);
+  Unpin(meta, false);
+}
+
+void BPTreeIndex::StoreMeta()
+{
+  std::lock_guard lock(meta_latch_);
+  auto            meta = buffer_pool_manager_->FetchPage(index_id_, BPTREE_META_PAGE_ID);
+  *reinterpret_cast<page_id_t *>(meta->GetData() + BPTREE_META_ROOT_OFFSET)     = root_;
+  *reinterpret_cast<page_id_t *>(meta->GetData() + BPTREE_META_PAGE_NUM_OFFSET) = page_num_;
+  Unpin(meta, true);
+}
+
+void BPTreeIndex::Build(const char *entries, size_t num)
+{
+  if (num == 0) {
+    return;
+  }
+  // (smallest entry, page) of every node of the level being built
+  std::vector<std::pair<const char *, page_id_t>> level;
+  Page                                           *prev = nullptr;
+  for (size_t i = 0; i < num; i += leaf_max_) {
+    auto cnt  = std::min(leaf_max_, num - i);
+    auto leaf = NewPage();
+    SetHeader(leaf, 0, cnt, INVALID_PAGE_ID);
+    memcpy(LeafEntry(leaf, 0), entries + i * entry_size_, cnt * entry_size_);
+    if (prev != nullptr) {
+      SetHeader(prev, 0, GetSize(prev), leaf->GetPageId());
+      Unpin(prev, true);
+    }
+    prev = leaf;
+    level.emplace_back(entries + i * entry_size_, leaf->GetPageId());
+  }
+  Unpin(prev, true);
+  for (uint32_t height = 1; level.size() > 1; ++height) {
+    std::vector<std::pair<const char *, page_id_t>> upper;
+    for (size_t i = 0; i < level.size(); i += internal_max_) {
+      auto cnt  = std::min(internal_max_, level.size() - i);
+      auto node = NewPage();
+      SetHeader(node, height, cnt, INVALID_PAGE_ID);
+      for (size_t j = 0; j < cnt; ++j) {
+        memcpy(InternalEntry(node, j), level[i + j].first, entry_size_);
+        SetInternalChild(node, j, level[i + j].second);
+      }
+      upper.emplace_back(level[i].first, node->GetPageId());
+      Unpin(node, true);
+    }
+    level = std::move(upper);
+  }
+  root_ = level[0].second;
+  StoreMeta();
+}
+
+BPTreeIterator::BPTreeIterator(BPTreeIndex *index, std::string low, std::string high)
+    : index_(index), high_(std::move(high))
+{
+  auto leaf = index_->FindLeafRead(low.data(), low.size());
+  if (leaf == nullptr) {
+    return;
+  }
+  LoadLeaf(leaf, index_->LeafLowerBound(leaf, low.data(), low.size()));
+  if (rids_.empty()) {
+    Advance();
+  }
+}
+
+void BPTreeIterator::Next()
+{
+  if (++pos_ < rids_.size()) {
+    return;
+  }
+  rids_.clear();
+  pos_ = 0;
+  Advance();
+}
+
+void BPTreeIterator::LoadLeaf(Page *leaf, size_t begin)
+{
+  rids_.clear();
+  pos_      = 0;
+  next_     = index_->GetNext(leaf);
+  auto size = BPTreeIndex::GetSize(leaf);
+  for (auto i = begin; i < size; ++i) {
+    auto entry = index_->LeafEntry(leaf, i);
+    if (memcmp(entry, high_.data(), high_.size()) > 0) {
+      next_ = INVALID_PAGE_ID;
+      break;
+    }
+    rids_.push_back(index_->DecodeRID(entry));
+    last_.assign(entry, index_->entry_size_);
+  }
+  leaf->RUnlatch();
+  index_->Unpin(leaf, false);
+}
+
+void BPTreeIterator::Advance()
+{
+  while (rids_.empty() && next_ != INVALID_PAGE_ID) {
+    auto leaf = index_->buffer_pool_manager_->FetchPage(index_->index_id_, next_);
+    leaf->RLatch();
+    size_t begin = 0;
+    if (!last_.empty()) {
+      // entries up to the last one returned may have moved here by a split since the previous leaf was read
+      begin = index_->LeafLowerBound(leaf, last_.data(), last_.size());
+      if (begin < BPTreeIndex::GetSize(leaf) && memcmp(index_->LeafEntry(leaf, begin), last_.data(), last_.size()) == 0) {
+        begin++;
+      }
+    }
+    LoadLeaf(leaf, begin);
+  }
+}
+
+}  // namespace wsdb
@@ -19,22 +19,164 @@
 // Created by ziqi on 2024/7/28.
 //
 
+/**
+ * @brief A B+tree index stored in pages of the buffer pool
+ *
+ * Keys are normalized with KeyEncoder and followed by the rid, so every entry is unique even if keys are duplicated
+ * and all comparisons are memcmp. Page 0 of the file is the file header written by the IndexManager, page 1 keeps the
+ * root and the number of pages, nodes start from page 2:
+ * | page header | level | size | next | slots |
+ * a leaf is at level 0 and its slots are entries, next links the leaves from left to right. An internal node has size
+ * children and its slots are (entry, child) pairs, the entry of slot 0 is unused and the entry of slot i is the
+ * smallest entry under child i.
+ *
+ * Threads descend with latch crabbing. Readers couple read latches from the root to the leaf, writers first do the
+ * same and take a write latch on the leaf only, if the leaf would split they retry holding write latches from the
+ * root and release the ancestors whenever a node cannot split. Deleted entries leave their nodes underfull instead of
+ * merging them, so a delete never goes beyond the leaf
+ */
+
 #ifndef WSDB_INDEX_BP_TREE_H
 #define WSDB_INDEX_BP_TREE_H
 
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
 #include "index_abstract.h"
+#include "system/handle/key_encoder.h"
 
 namespace wsdb {
+
 class BPTreeIndex : public Index
 {
 public:
+  BPTreeIndex(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, idx_id_t index_id, RecordSchema *key_schema);
+
   void Insert(const Record &key, const RID &rid) override;
 
   void Delete(const Record &key, const RID &rid) override;
 
+  auto Search(const Record &key) -> std::vector<RID> override;
 
-  BPTreeIndex(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, idx_id_t index_id, RecordSchema *key_schema);
+  auto Scan(const Record &low, size_t low_field_num, const Record &high, size_t high_field_num)
+      -> IndexIteratorUptr override;
+
+  /// build the tree bottom-up if it is empty, otherwise insert the entries one by one
+  void BulkInsert(const std::vector<std::pair<Record, RID>> &entries) override;
+
+  [[nodiscard]] auto GetHeight() -> size_t;
+
+private:
+  friend class BPTreeIterator;
+
+  [[nodiscard]] static auto GetLevel(Page *page) -> uint32_t;
+
+  [[nodiscard]] static auto GetSize(Page *page) -> uint32_t;
+
+  [[nodiscard]] static auto GetNext(Page *page) -> page_id_t;
+
+  static void SetHeader(Page *page, uint32_t level, uint32_t size, page_id_t next);
+
+  [[nodiscard]] auto LeafEntry(Page *page, size_t i) const -> char *;
+
+  [[nodiscard]] auto InternalEntry(Page *page, size_t i) const -> char *;
+
+  [[nodiscard]] auto InternalChild(Page *page, size_t i) const -> page_id_t;
+
+  void SetInternalChild(Page *page, size_t i, page_id_t child) const;
+
+  /// encode the key and the rid into an entry
+  void EncodeEntry(const Record &key, const RID &rid, char *out) const;
+
+  [[nodiscard]] auto DecodeRID(const char *entry) const -> RID;
+
+  /// first slot of the leaf whose entry is not less than target on len bytes
+  [[nodiscard]] auto LeafLowerBound(Page *page, const char *target, size_t len) const -> size_t;
+
+  /// child to descend into when looking for the first entry not less than target on len bytes
+  [[nodiscard]] auto ChildFor(Page *page, const char *target, size_t len) const -> size_t;
+
+  /// child that holds the entry
+  [[nodiscard]] auto ChildOf(Page *page, const char *entry) const -> size_t;
+
+  /// read latched and pinned leaf that holds the first entry not less than target on len bytes, nullptr if empty
+  auto FindLeafRead(const char *target, size_t len) -> Page *;
+
+  /// try to insert holding the write latch of the leaf only, false if the leaf is full
+  auto InsertOptimistic(const char *entry) -> bool;
+
+  void InsertPessimistic(const char *entry);
+
+  /**
+   * Insert the separator and the new right sibling of path[depth] into its parent, splitting upwards
+   * @param path write latched and pinned pages from the highest one that may change down to the leaf
+   * @param depth
+   * @param sep smallest entry under right
+   * @param right
+   */
+  void InsertIntoParent(std::vector<Page *> &path, size_t depth, const char *sep, page_id_t right);
+
+  /// unlatch and unpin the first num pages of the path
+  void ReleasePath(std::vector<Page *> &path, size_t num, bool dirty);
+
+  auto NewPage() -> Page *;
+
+  void Unpin(Page *page, bool dirty);
+
+  /// read the root and the number of pages from the meta page
+  void LoadMeta();
+
+  void StoreMeta();
+
+  /// build the tree bottom-up from entries sorted by memcmp, the tree must be empty
+  void Build(const char *entries, size_t num);
+
+private:
+  KeyEncoder encoder_;
+  size_t     key_size_;
+  size_t     entry_size_;  // key followed by the rid
+  size_t     leaf_max_;
+  size_t     internal_max_;
+
+  // guards root_, a thread holds it until the root is latched, or until it knows the root will not split
+  std::shared_mutex      root_latch_;
+  std::atomic<page_id_t> root_{INVALID_PAGE_ID};
+  std::atomic<page_id_t> page_num_{0};
+  std::mutex             meta_latch_;
 };
+
+/**
+ * Iterate over a range of the leaves, the rids of a leaf are copied under its read latch so no latch is held between
+ * calls. The next leaf is entered through the link of the previous one, skipping entries up to the last one returned
+ */
+class BPTreeIterator : public IndexIterator
+{
+public:
+  BPTreeIterator(BPTreeIndex *index, std::string low, std::string high);
+
+  [[nodiscard]] auto IsEnd() const -> bool override { return pos_ >= rids_.size(); }
+
+  [[nodiscard]] auto GetRID() const -> RID override { return rids_[pos_]; }
+
+  void Next() override;
+
+private:
+  /// copy the matching rids of the read latched leaf, the leaf is released
+  void LoadLeaf(Page *leaf, size_t begin);
+
+  /// move to the next leaf with matching rids
+  void Advance();
+
+private:
+  BPTreeIndex     *index_;
+  std::string      high_;
+  std::vector<RID> rids_;
+  size_t           pos_{0};
+  std::string      last_;  // last entry copied
+  page_id_t        next_{INVALID_PAGE_ID};
+};
+
 }  // namespace wsdb
 
 #endif  // WSDB_INDEX_BP_TREE_H
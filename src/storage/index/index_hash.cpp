@@ -21,15 +21,408 @@
 
 #include "index_hash.h"
 
+#include <bit>
+
+#define HASH_META_PAGE_ID 1
+#define HASH_META_STATE_OFFSET PAGE_HEADER_SIZE
+#define HASH_META_PAGE_NUM_OFFSET (HASH_META_STATE_OFFSET + sizeof(uint64_t))
+#define HASH_META_ENTRY_NUM_OFFSET (HASH_META_PAGE_NUM_OFFSET + sizeof(page_id_t))
+#define HASH_META_SEGMENTS_OFFSET (HASH_META_ENTRY_NUM_OFFSET + sizeof(uint64_t))
+
+#define HASH_BUCKET_LEVEL_OFFSET PAGE_HEADER_SIZE
+#define HASH_BUCKET_SIZE_OFFSET (HASH_BUCKET_LEVEL_OFFSET + sizeof(uint32_t))
+#define HASH_BUCKET_OVERFLOW_OFFSET (HASH_BUCKET_SIZE_OFFSET + sizeof(uint32_t))
+#define HASH_BUCKET_HEADER_SIZE (HASH_BUCKET_OVERFLOW_OFFSET + sizeof(page_id_t))
+
 namespace wsdb {
 
-// FIXME: HashIndex initialization should include more information, such as bucket size, etc.
+/// number of buckets at the level, i.e. the modulus of its hash function
+static auto LevelSize(uint64_t level) -> uint64_t { return HASH_INDEX_INIT_BUCKETS << level; }
+
+/// segment holding the bucket and the position of the bucket in it
+static auto SegmentOf(size_t bucket) -> std::pair<size_t, size_t>
+{
+  if (bucket < HASH_INDEX_INIT_BUCKETS) {
+    return {0, bucket};
+  }
+  auto seg = static_cast<size_t>(std::bit_width(bucket / HASH_INDEX_INIT_BUCKETS));
+  return {seg, bucket - (HASH_INDEX_INIT_BUCKETS << (seg - 1))};
+}
+
+static auto SegmentSize(size_t seg) -> size_t
+{
+  return seg == 0 ? HASH_INDEX_INIT_BUCKETS : HASH_INDEX_INIT_BUCKETS << (seg - 1);
+}
+
 HashIndex::HashIndex(
     DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, idx_id_t index_id, RecordSchema *key_schema)
-    : Index(disk_manager, buffer_pool_manager, IndexType::HASH, index_id, key_schema)
+    : Index(disk_manager, buffer_pool_manager, IndexType::HASH, index_id, key_schema),
+      encoder_(key_schema, key_schema),
+      key_size_(encoder_.GetKeySize()),
+      entry_size_(key_size_ + sizeof(page_id_t) + sizeof(slot_id_t)),
+      bucket_max_((PAGE_SIZE - HASH_BUCKET_HEADER_SIZE) / entry_size_)
 {
-  WSDB_THROW(WSDB_NOT_IMPLEMENTED, "");
+  if (bucket_max_ < 2) {
+    WSDB_THROW(WSDB_RECLEN_ERROR, fmt::format("index key of {} bytes is too long", key_size_));
+  }
+  for (auto &seg : segments_) {
+    seg = INVALID_PAGE_ID;
+  }
+  LoadMeta();
 }
-void HashIndex::Insert(const Record &key, const RID &rid) {}
-void HashIndex::Delete(const Record &key, const RID &rid) {}
-}  // namespace wsdb
\ No newline at end of file
+
+void HashIndex::Insert(const Record &key, const RID &rid)
+{
+  std::vector<char> entry(entry_size_);
+  encoder_.Encode(key, entry.data());
+  auto page_id = rid.PageID();
+  auto slot_id = rid.SlotID();
+  memcpy(entry.data() + key_size_, &page_id, sizeof(page_id_t));
+  memcpy(entry.data() + key_size_ + sizeof(page_id_t), &slot_id, sizeof(slot_id_t));
+
+  auto primary = LatchBucket(Hash(entry.data()), true);
+  auto page    = primary;
+  // append to the first page of the chain with a free slot, or to a new page at the end
+  while (GetSize(page) == bucket_max_) {
+    auto next  = GetOverflow(page);
+    bool dirty = false;
+    if (next == INVALID_PAGE_ID) {
+      auto overflow = NewPage();
+      SetHeader(overflow, 0, 0, INVALID_PAGE_ID);
+      SetHeader(page, GetLocalLevel(page), GetSize(page), overflow->GetPageId());
+      next  = overflow->GetPageId();
+      dirty = true;
+      Unpin(overflow, true);
+    }
+    if (page != primary) {
+      Unpin(page, dirty);
+    }
+    page = buffer_pool_manager_->FetchPage(index_id_, next);
+  }
+  auto size = GetSize(page);
+  memcpy(Entry(page, size), entry.data(), entry_size_);
+  SetHeader(page, GetLocalLevel(page), size + 1, GetOverflow(page));
+  if (page != primary) {
+    Unpin(page, true);
+  }
+  primary->WUnlatch();
+  Unpin(primary, true);
+  entry_num_++;
+  MaybeSplit();
+}
+
+void HashIndex::Delete(const Record &key, const RID &rid)
+{
+  std::vector<char> entry(entry_size_);
+  encoder_.Encode(key, entry.data());
+  auto page_id = rid.PageID();
+  auto slot_id = rid.SlotID();
+  memcpy(entry.data() + key_size_, &page_id, sizeof(page_id_t));
+  memcpy(entry.data() + key_size_ + sizeof(page_id_t), &slot_id, sizeof(slot_id_t));
+
+  auto primary = LatchBucket(Hash(entry.data()), true);
+  auto page    = primary;
+  bool found   = false;
+  while (true) {
+    auto size = GetSize(page);
+    for (size_t i = 0; i < size; ++i) {
+      if (memcmp(Entry(page, i), entry.data(), entry_size_) == 0) {
+        // the last entry of the page takes the place of the deleted one
+        memmove(Entry(page, i), Entry(page, size - 1), entry_size_);
+        SetHeader(page, GetLocalLevel(page), size - 1, GetOverflow(page));
+        found = true;
+        break;
+      }
+    }
+    auto next = GetOverflow(page);
+    if (page != primary) {
+      Unpin(page, found);
+    }
+    if (found || next == INVALID_PAGE_ID) {
+      break;
+    }
+    page = buffer_pool_manager_->FetchPage(index_id_, next);
+  }
+  primary->WUnlatch();
+  Unpin(primary, found);
+  if (found) {
+    entry_num_--;
+  }
+}
+
+auto HashIndex::Search(const Record &key) -> std::vector<RID>
+{
+  auto             enc     = encoder_.Encode(key);
+  auto             primary = LatchBucket(Hash(enc.data()), false);
+  auto             page    = primary;
+  std::vector<RID> rids;
+  while (true) {
+    for (size_t i = 0; i < GetSize(page); ++i) {
+      auto entry = Entry(page, i);
+      if (memcmp(entry, enc.data(), key_size_) == 0) {
+        page_id_t page_id = INVALID_PAGE_ID;
+        slot_id_t slot_id = INVALID_SLOT_ID;
+        memcpy(&page_id, entry + key_size_, sizeof(page_id_t));
+        memcpy(&slot_id, entry + key_size_ + sizeof(page_id_t), sizeof(slot_id_t));
+        rids.emplace_back(page_id, slot_id);
+      }
+    }
+    auto next = GetOverflow(page);
+    if (page != primary) {
+      Unpin(page, false);
+    }
+    if (next == INVALID_PAGE_ID) {
+      break;
+    }
+    page = buffer_pool_manager_->FetchPage(index_id_, next);
+  }
+  primary->RUnlatch();
+  Unpin(primary, false);
+  return rids;
+}
+
+auto HashIndex::Scan(const Record &low, size_t low_field_num, const Record &high, size_t high_field_num)
+    -> IndexIteratorUptr
+{
+  auto field_num = key_schema_->GetFieldCount();
+  if (low_field_num < field_num || high_field_num < field_num) {
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, "range scan on a hash index");
+  }
+  // different bounds come from contradicting equalities, no key lies between them
+  if (encoder_.Encode(low) != encoder_.Encode(high)) {
+    return std::make_unique<HashIterator>(std::vector<RID>{});
+  }
+  return std::make_unique<HashIterator>(Search(low));
+}
+
+auto HashIndex::GetBucketNum() const -> size_t
+{
+  auto state = state_.load();
+  return LevelSize(state >> 32) + (state & 0xFFFFFFFFU);
+}
+
+auto HashIndex::GetLocalLevel(Page *page) -> uint32_t
+{
+  return *reinterpret_cast<uint32_t *>(page->GetData() + HASH_BUCKET_LEVEL_OFFSET);
+}
+
+auto HashIndex::GetSize(Page *page) -> uint32_t
+{
+  return *reinterpret_cast<uint32_t *>(page->GetData() + HASH_BUCKET_SIZE_OFFSET);
+}
+
+auto HashIndex::GetOverflow(Page *page) -> page_id_t
+{
+  return *reinterpret_cast<page_id_t *>(page->GetData() + HASH_BUCKET_OVERFLOW_OFFSET);
+}
+
+void HashIndex::SetHeader(Page *page, uint32_t local_level, uint32_t size, page_id_t overflow)
+{
+  *reinterpret_cast<uint32_t *>(page->GetData() + HASH_BUCKET_LEVEL_OFFSET)     = local_level;
+  *reinterpret_cast<uint32_t *>(page->GetData() + HASH_BUCKET_SIZE_OFFSET)      = size;
+  *reinterpret_cast<page_id_t *>(page->GetData() + HASH_BUCKET_OVERFLOW_OFFSET) = overflow;
+}
+
+auto HashIndex::Entry(Page *page, size_t i) const -> char *
+{
+  return page->GetData() + HASH_BUCKET_HEADER_SIZE + i * entry_size_;
+}
+
+auto HashIndex::Hash(const char *key) const -> uint64_t
+{
+  // FNV-1a followed by the finalizer of murmur3, the low bits select the bucket so they must depend on every byte.
+  // the hash is stored implicitly in the file, std::hash is not guaranteed to be stable
+  uint64_t h = 0xCBF29CE484222325ULL;
+  for (size_t i = 0; i < key_size_; ++i) {
+    h = (h ^ static_cast<uint8_t>(key[i])) * 0x100000001B3ULL;
+  }
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+auto HashIndex::BucketOf(uint64_t hash, uint64_t state) -> size_t
+{
+  auto level  = state >> 32;
+  auto next   = state & 0xFFFFFFFFU;
+  auto bucket = hash % LevelSize(level);
+  if (bucket < next) {
+    bucket = hash % LevelSize(level + 1);
+  }
+  return bucket;
+}
+
+auto HashIndex::BucketPage(size_t bucket) const -> page_id_t
+{
+  auto [seg, pos] = SegmentOf(bucket);
+  return segments_[seg].load() + static_cast<page_id_t>(pos);
+}
+
+auto HashIndex::LatchBucket(uint64_t hash, bool exclusive) -> Page *
+{
+  while (true) {
+    auto bucket = BucketOf(hash, state_.load());
+    auto page   = buffer_pool_manager_->FetchPage(index_id_, BucketPage(bucket));
+    exclusive ? page->WLatch() : page->RLatch();
+    // the bucket holds the keys whose hash modulo its level size is the bucket, unless it was split after the state
+    // was read
+    if (hash % LevelSize(GetLocalLevel(page)) == bucket) {
+      return page;
+    }
+    exclusive ? page->WUnlatch() : page->RUnlatch();
+    Unpin(page, false);
+  }
+}
+
+void HashIndex::Split()
+{
+  auto state = state_.load();
+  auto level = state >> 32;
+  auto next  = state & 0xFFFFFFFFU;
+  auto old_b = next;
+  auto new_b = next + LevelSize(level);
+  auto seg   = SegmentOf(new_b).first;
+  if (segments_[seg] == INVALID_PAGE_ID) {
+    segments_[seg] = page_num_.fetch_add(static_cast<page_id_t>(SegmentSize(seg)));
+  }
+  auto old_primary = buffer_pool_manager_->FetchPage(index_id_, BucketPage(old_b));
+  old_primary->WLatch();
+  auto new_primary = buffer_pool_manager_->FetchPage(index_id_, BucketPage(new_b));
+  new_primary->WLatch();
+  SetHeader(new_primary, level + 1, 0, INVALID_PAGE_ID);
+
+  // collect the chain of the old bucket
+  std::vector<char> entries;
+  for (auto page = old_primary;;) {
+    entries.insert(entries.end(), Entry(page, 0), Entry(page, GetSize(page)));
+    auto overflow = GetOverflow(page);
+    if (page != old_primary) {
+      Unpin(page, false);
+    }
+    if (overflow == INVALID_PAGE_ID) {
+      break;
+    }
+    page = buffer_pool_manager_->FetchPage(index_id_, overflow);
+  }
+  // refill both chains, the old one keeps its pages even if they end up empty
+  auto fill = [this](Page *primary, const std::vector<const char *> &moved, bool reuse) {
+    auto   page = primary;
+    size_t i    = 0;
+    while (true) {
+      auto cnt = std::min(bucket_max_, moved.size() - i);
+      for (size_t j = 0; j < cnt; ++j) {
+        memcpy(Entry(page, j), moved[i + j], entry_size_);
+      }
+      i += cnt;
+      auto overflow = GetOverflow(page);
+      if (i < moved.size() && overflow == INVALID_PAGE_ID) {
+        WSDB_ASSERT(!reuse, "entries do not fit into the chain they came from");
+        auto new_page = NewPage();
+        SetHeader(new_page, 0, 0, INVALID_PAGE_ID);
+        overflow = new_page->GetPageId();
+        Unpin(new_page, true);
+      }
+      SetHeader(page, GetLocalLevel(page), cnt, overflow);
+      if (page != primary) {
+        Unpin(page, true);
+      }
+      if (overflow == INVALID_PAGE_ID || (i == moved.size() && !reuse)) {
+        break;
+      }
+      page = buffer_pool_manager_->FetchPage(index_id_, overflow);
+    }
+  };
+  std::vector<const char *> stay;
+  std::vector<const char *> move;
+  for (size_t off = 0; off < entries.size(); off += entry_size_) {
+    auto entry = entries.data() + off;
+    (Hash(entry) % LevelSize(level + 1) == old_b ? stay : move).push_back(entry);
+  }
+  SetHeader(old_primary, level + 1, GetSize(old_primary), GetOverflow(old_primary));
+  fill(old_primary, stay, true);
+  fill(new_primary, move, false);
+
+  // publish the new bucket, from now on keys that moved are looked up there
+  next++;
+  if (next == LevelSize(level)) {
+    level++;
+    next = 0;
+  }
+  state_ = level << 32 | next;
+  StoreMeta();
+  new_primary->WUnlatch();
+  Unpin(new_primary, true);
+  old_primary->WUnlatch();
+  Unpin(old_primary, true);
+}
+
+void HashIndex::MaybeSplit()
+{
+  auto over_loaded = [this] {
+    return static_cast<double>(entry_num_) > HASH_INDEX_MAX_LOAD * static_cast<double>(GetBucketNum() * bucket_max_);
+  };
+  if (!over_loaded()) {
+    return;
+  }
+  // a thread that finds another one splitting goes on, the load is checked again by the next insert
+  std::unique_lock lock(split_latch_, std::try_to_lock);
+  if (lock.owns_lock() && over_loaded()) {
+    Split();
+  }
+}
+
+auto HashIndex::NewPage() -> Page *
+{
+  auto page_id = page_num_.fetch_add(1);
+  StoreMeta();
+  return buffer_pool_manager_->FetchPage(index_id_, page_id);
+}
+
+void HashIndex::Unpin(Page *page, bool dirty) { buffer_pool_manager_->UnpinPage(index_id_, page->GetPageId(), dirty); }
+
+void HashIndex::LoadMeta()
+{
+  auto meta     = buffer_pool_manager_->FetchPage(index_id_, HASH_META_PAGE_ID);
+  auto page_num = *reinterpret_cast<page_id_t *>(meta->GetData() + HASH_META_PAGE_NUM_OFFSET);
+  if (page_num != 0) {
+    state_     = *reinterpret_cast<uint64_t *>(meta->GetData() + HASH_META_STATE_OFFSET);
+    page_num_  = page_num;
+    entry_num_ = *reinterpret_cast<uint64_t *>(meta->GetData() + HASH_META_ENTRY_NUM_OFFSET);
+    auto segs  = reinterpret_cast<page_id_t *>(meta->GetData() + HASH_META_SEGMENTS_OFFSET);
+    for (size_t i = 0; i < SEGMENT_NUM; ++i) {
+      segments_[i] = segs[i];
+    }
+    Unpin(meta, false);
+    return;
+  }
+  Unpin(meta, false);
+  // a fresh index, page 0 is the file header, page 1 the meta page and the initial buckets follow
+  state_       = 0;
+  segments_[0] = HASH_META_PAGE_ID + 1;
+  page_num_    = static_cast<page_id_t>(segments_[0] + SegmentSize(0));
+  for (size_t b = 0; b < HASH_INDEX_INIT_BUCKETS; ++b) {
+    auto page = buffer_pool_manager_->FetchPage(index_id_, BucketPage(b));
+    SetHeader(page, 0, 0, INVALID_PAGE_ID);
+    Unpin(page, true);
+  }
+  StoreMeta();
+}
+
+void HashIndex::StoreMeta()
+{
+  std::lock_guard lock(meta_latch_);
+  auto            meta = buffer_pool_manager_->FetchPage(index_id_, HASH_META_PAGE_ID);
+  *reinterpret_cast<uint64_t *>(meta->GetData() + HASH_META_STATE_OFFSET)     = state_;
+  *reinterpret_cast<page_id_t *>(meta->GetData() + HASH_META_PAGE_NUM_OFFSET) = page_num_;
+  *reinterpret_cast<uint64_t *>(meta->GetData() + HASH_META_ENTRY_NUM_OFFSET) = entry_num_;
+  auto segs = reinterpret_cast<page_id_t *>(meta->GetData() + HASH_META_SEGMENTS_OFFSET);
+  for (size_t i = 0; i < SEGMENT_NUM; ++i) {
+    segs[i] = segments_[i];
+  }
+  Unpin(meta, true);
+}
+
+}  // namespace wsdb
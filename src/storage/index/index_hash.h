@@ -19,10 +19,33 @@
 // Created by ziqi on 2024/7/28.
 //
 
+/**
+ * @brief A linear hashing index stored in pages of the buffer pool
+ *
+ * Keys are normalized with KeyEncoder and hashed on their bytes, an entry is the key followed by the rid. Page 0 of the
+ * file is the file header written by the IndexManager, page 1 keeps the split state, the number of pages and entries
+ * and where the bucket segments start. Bucket b is the primary page of a chain of overflow pages:
+ * | page header | local level | size | overflow | entries |
+ * The table grows one bucket at a time, when the entries fill more than HASH_INDEX_MAX_LOAD of the primary pages the
+ * bucket at the split pointer moves half of its entries to a new bucket, so a split only latches the two buckets it
+ * touches. Primary pages are reserved in segments of doubling size and found by arithmetic, a lookup reads the primary
+ * page and its overflow pages, nothing else.
+ *
+ * Readers and writers take no latch but the one of the primary page, which also covers its overflow pages. The
+ * bucket of a key is computed from an atomic copy of the split state; a bucket records the level it was last split
+ * at, so a thread that read the state right before a split notices the key moved away and starts over. Deleted
+ * entries never merge buckets
+ */
+
 #ifndef WSDB_INDEX_HASH_H
 #define WSDB_INDEX_HASH_H
 
+#include <array>
+#include <atomic>
+#include <mutex>
+
 #include "index_abstract.h"
+#include "system/handle/key_encoder.h"
 
 namespace wsdb {
 
@@ -34,6 +57,86 @@ public:
   void Insert(const Record &key, const RID &rid) override;
 
   void Delete(const Record &key, const RID &rid) override;
+
+  auto Search(const Record &key) -> std::vector<RID> override;
+
+  /// only equal bounds on all the key fields are supported, i.e. a point lookup
+  auto Scan(const Record &low, size_t low_field_num, const Record &high, size_t high_field_num)
+      -> IndexIteratorUptr override;
+
+  [[nodiscard]] auto GetBucketNum() const -> size_t;
+
+private:
+  // segment 0 holds the initial buckets, segment k > 0 as many buckets as exist before it, 30 segments cover more
+  // buckets than pages can be addressed
+  static constexpr size_t SEGMENT_NUM = 30;
+
+  [[nodiscard]] static auto GetLocalLevel(Page *page) -> uint32_t;
+
+  [[nodiscard]] static auto GetSize(Page *page) -> uint32_t;
+
+  [[nodiscard]] static auto GetOverflow(Page *page) -> page_id_t;
+
+  static void SetHeader(Page *page, uint32_t local_level, uint32_t size, page_id_t overflow);
+
+  [[nodiscard]] auto Entry(Page *page, size_t i) const -> char *;
+
+  [[nodiscard]] auto Hash(const char *key) const -> uint64_t;
+
+  /// bucket of the hash under the split state
+  [[nodiscard]] static auto BucketOf(uint64_t hash, uint64_t state) -> size_t;
+
+  [[nodiscard]] auto BucketPage(size_t bucket) const -> page_id_t;
+
+  /// pinned primary page of the bucket that holds the hash, read or write latched
+  auto LatchBucket(uint64_t hash, bool exclusive) -> Page *;
+
+  /// split the bucket at the split pointer, the caller holds split_latch_
+  void Split();
+
+  /// split if the load is too high and no other thread is splitting
+  void MaybeSplit();
+
+  auto NewPage() -> Page *;
+
+  void Unpin(Page *page, bool dirty);
+
+  void LoadMeta();
+
+  void StoreMeta();
+
+private:
+  KeyEncoder encoder_;
+  size_t     key_size_;
+  size_t     entry_size_;  // key followed by the rid
+  size_t     bucket_max_;
+
+  // level << 32 | split pointer, buckets below the pointer are already split at this level
+  std::atomic<uint64_t>                           state_{0};
+  std::array<std::atomic<page_id_t>, SEGMENT_NUM> segments_;
+  std::atomic<page_id_t>                          page_num_{0};
+  std::atomic<size_t>                             entry_num_{0};  // only drives splits, stored when the meta changes
+  std::mutex                                      split_latch_;
+  std::mutex                                      meta_latch_;
+};
+
+/**
+ * The rids found by a point lookup
+ */
+class HashIterator : public IndexIterator
+{
+public:
+  explicit HashIterator(std::vector<RID> rids) : rids_(std::move(rids)) {}
+
+  [[nodiscard]] auto IsEnd() const -> bool override { return pos_ >= rids_.size(); }
+
+  [[nodiscard]] auto GetRID() const -> RID override { return rids_[pos_]; }
+
+  void Next() override { pos_++; }
+
+private:
+  std::vector<RID> rids_;
+  size_t           pos_{0};
 };
 
 }  // namespace wsdb
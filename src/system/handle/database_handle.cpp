@@ -21,6 +21,8 @@
 
 #include "database_handle.h"
 
+#include <algorithm>
+
 namespace wsdb {
 DatabaseHandle::DatabaseHandle(
     std::string db_name, DiskManager *disk_manager, TableManager *tbl_mgr, IndexManager *idx_mgr)
@@ -76,19 +78,12 @@ void DatabaseHandle::Open()
     IndexType index_type;
     disk_manager_->ReadFile(db_fd, reinterpret_cast<char *>(&index_type), sizeof(IndexType), 0, SEEK_CUR);
     // create index handle
-    // TODO: remove try catch below if IndexManager and indexes are implemented
-    try {
-      auto idx_hdl                    = idx_mgr_->OpenIndex(db_name_, index_name, index_type);
-      indexes_[idx_hdl->GetIndexId()] = std::move(idx_hdl);
-      // update tab_idx_map_
-      auto table_id = indexes_[idx_hdl->GetIndexId()]->GetTableId();
-      if (tab_idx_map_.find(table_id) == tab_idx_map_.end())
-        tab_idx_map_[table_id] = std::list<idx_id_t>();
-      tab_idx_map_[table_id].push_back(idx_hdl->GetIndexId());
-    } catch (WSDBException_ &e) {
-      if (e.type_ != WSDB_NOT_IMPLEMENTED)
-        throw;
-    }
+    auto idx_hdl       = idx_mgr_->OpenIndex(db_name_, index_name, index_type);
+    auto index_id      = idx_hdl->GetIndexId();
+    auto table_id      = idx_hdl->GetTableId();
+    indexes_[index_id] = std::move(idx_hdl);
+    // update tab_idx_map_
+    tab_idx_map_[table_id].push_back(index_id);
   }
   disk_manager_->CloseFile(db_fd);
 }
@@ -115,6 +110,13 @@ void DatabaseHandle::Close()
   tab_idx_map_.clear();
 }
 
+void DatabaseHandle::FlushTableHeaders()
+{
+  for (auto &table : tables_) {
+    tbl_mgr_->FlushTableHeader(*table.second);
+  }
+}
+
 void DatabaseHandle::FlushMeta()
 {
   /**
@@ -163,6 +165,7 @@ void DatabaseHandle::CreateTable(
   tbl_mgr_->CreateTable(db_name_, tab_name, rec_schema, storage_model);
   auto tbl_hdl                   = tbl_mgr_->OpenTable(db_name_, tab_name, storage_model);
   tables_[tbl_hdl->GetTableId()] = std::move(tbl_hdl);
+  TouchSchema(tab_name);
 
   FlushMeta();
 }
@@ -175,23 +178,94 @@ void DatabaseHandle::DropTable(const std::string &tab_name)
   TableManager::DropTable(db_name_, tab_name);
   tables_.erase(tid);
   for (auto &idx_id : tab_idx_map_[tid]) {
-    auto index = indexes_[idx_id].get();
+    auto index      = indexes_[idx_id].get();
+    auto index_name = index->GetIndexName();
     idx_mgr_->CloseIndex(*index);
-    idx_mgr_->DropIndex(db_name_, index->GetIndexName());
+    IndexManager::DropIndex(db_name_, index_name);
     indexes_.erase(idx_id);
   }
   tab_idx_map_.erase(tid);
+  TouchSchema(tab_name);
   FlushMeta();
 }
 
 void DatabaseHandle::CreateIndex(const std::string &tab_name, const RecordSchema &key_schema, IndexType idx_type)
 {
-  WSDB_THROW(WSDB_NOT_IMPLEMENTED, "");
+  auto tab = GetTable(tab_name);
+  if (tab == nullptr) {
+    WSDB_THROW(WSDB_TABLE_MISS, tab_name);
+  }
+  std::vector<std::string> col_names;
+  for (const auto &field : key_schema.GetFields()) {
+    col_names.push_back(field.field_.field_name_);
+  }
+  auto idx_name = GetIndexName(tab_name, col_names);
+  idx_mgr_->CreateIndex(db_name_, idx_name, tab_name, key_schema, idx_type);
+  auto idx_hdl = idx_mgr_->OpenIndex(db_name_, idx_name, idx_type);
+  // index the records already in the table, they reach the index sorted so a b+tree is built bottom-up
+  std::vector<RecordUptr> records;
+  for (auto rid = tab->GetFirstRID(); rid != INVALID_RID; rid = tab->GetNextRID(rid)) {
+    records.push_back(tab->GetRecord(rid));
+  }
+  idx_hdl->InsertRecords(records);
+  auto idx_id = idx_hdl->GetIndexId();
+  indexes_[idx_id] = std::move(idx_hdl);
+  tab_idx_map_[tab->GetTableId()].push_back(idx_id);
+  TouchSchema(tab_name);
+
+  FlushMeta();
 }
 
 void DatabaseHandle::DropIndex(const std::string &idx_name)
 {
-  WSDB_THROW(WSDB_NOT_IMPLEMENTED, "");
+  auto it = std::find_if(
+      indexes_.begin(), indexes_.end(), [&idx_name](const auto &index) { return index.second->GetIndexName() == idx_name; });
+  if (it == indexes_.end()) {
+    WSDB_THROW(WSDB_FILE_NOT_EXISTS, idx_name);
+  }
+  auto idx_id = it->first;
+  auto tid    = it->second->GetTableId();
+  idx_mgr_->CloseIndex(*it->second);
+  IndexManager::DropIndex(db_name_, idx_name);
+  indexes_.erase(it);
+  tab_idx_map_[tid].remove(idx_id);
+  TouchSchema(tables_[tid]->GetTableName());
+
+  FlushMeta();
+}
+
+void DatabaseHandle::AnalyzeTable(const std::string &tab_name)
+{
+  auto tab = GetTable(tab_name);
+  if (tab == nullptr) {
+    WSDB_THROW(WSDB_TABLE_MISS, tab_name);
+  }
+  tab->Analyze();
+  tbl_mgr_->WriteStatistics(db_name_, *tab);
+  // plans kept by prepared statements are optimized again with the new statistics
+  TouchSchema(tab_name);
+}
+
+void DatabaseHandle::RebuildIndexes(const std::string &tab_name)
+{
+  // the key fields are copied since dropping the index frees its schema
+  std::vector<std::tuple<std::string, std::vector<RTField>, IndexType>> idx_defs;
+  for (auto idx : GetIndexes(tab_name)) {
+    idx_defs.emplace_back(idx->GetIndexName(), idx->GetKeySchema().GetFields(), idx->GetIndexType());
+  }
+  for (auto &[idx_name, key_fields, idx_type] : idx_defs) {
+    DropIndex(idx_name);
+    CreateIndex(tab_name, RecordSchema(key_fields), idx_type);
+  }
+}
+
+auto DatabaseHandle::GetIndexName(const std::string &tab_name, const std::vector<std::string> &col_names) -> std::string
+{
+  auto idx_name = tab_name;
+  for (const auto &col_name : col_names) {
+    idx_name += "_" + col_name;
+  }
+  return idx_name;
 }
 
 auto DatabaseHandle::GetTable(const std::string &tab_name) -> TableHandle *
@@ -238,4 +312,17 @@ auto DatabaseHandle::GetIndexes(const std::string &tab_name) -> std::list<IndexH
   return GetIndexes(tid);
 }
 
+auto DatabaseHandle::GetSchemaVersion(const std::string &tab_name) -> uint64_t
+{
+  std::unique_lock lock(version_latch_);
+  auto             it = schema_versions_.find(tab_name);
+  return it == schema_versions_.end() ? 0 : it->second;
+}
+
+void DatabaseHandle::TouchSchema(const std::string &tab_name)
+{
+  std::unique_lock lock(version_latch_);
+  schema_versions_[tab_name] = next_version_++;
+}
+
 }  // namespace wsdb
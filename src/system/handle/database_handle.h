@@ -42,14 +42,39 @@ public:
 
   void FlushMeta();
 
+  /// write the headers of the open tables, the header of a table is otherwise only written when it is closed
+  void FlushTableHeaders();
+
   void CreateTable(const std::string &tab_name, const RecordSchema &rec_schema, StorageModel storage_model);
 
   void DropTable(const std::string &tab_name);
 
+  /**
+   * Create an index on the table and fill it with the records in the table
+   * @param tab_name
+   * @param key_schema key fields, each is a field of the table
+   * @param idx_type
+   */
   void CreateIndex(const std::string &tab_name, const RecordSchema &key_schema, IndexType idx_type);
 
   void DropIndex(const std::string &idx_name);
 
+  /**
+   * Collect the statistics of the table for the optimizer and write them to disk
+   * @param tab_name
+   */
+  void AnalyzeTable(const std::string &tab_name);
+
+  /**
+   * Build the indexes of the table again from its records, changes of indexes are not logged so recovery rebuilds
+   * the indexes of the tables it touches
+   * @param tab_name
+   */
+  void RebuildIndexes(const std::string &tab_name);
+
+  /// name of the index on the columns of the table
+  static auto GetIndexName(const std::string &tab_name, const std::vector<std::string> &col_names) -> std::string;
+
   [[nodiscard]] auto GetName() const -> std::string { return db_name_; }
 
   auto GetTable(const std::string &tab_name) -> TableHandle *;
@@ -66,6 +91,9 @@ public:
 
   auto GetAllTables() -> std::unordered_map<table_id_t, std::unique_ptr<TableHandle>> & { return tables_; }
 
+  /// changes whenever the table or its indexes are created or dropped, plans kept across statements check it
+  auto GetSchemaVersion(const std::string &tab_name) -> uint64_t;
+
   ~DatabaseHandle() = default;
 
 public:
@@ -83,6 +111,12 @@ private:
   std::unordered_map<table_id_t, std::unique_ptr<TableHandle>> tables_;
   std::unordered_map<idx_id_t, std::unique_ptr<IndexHandle>>   indexes_;
   std::unordered_map<table_id_t, std::list<idx_id_t>>          tab_idx_map_;
+
+  void TouchSchema(const std::string &tab_name);
+
+  std::mutex                                version_latch_;  // protects the schema versions
+  uint64_t                                  next_version_{1};
+  std::unordered_map<std::string, uint64_t> schema_versions_;
 };
 }  // namespace wsdb
 
@@ -21,26 +21,24 @@
 
 #include "index_handle.h"
 
+#include <algorithm>
+
 namespace wsdb {
 IndexHandle::IndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, table_id_t tid,
-    idx_id_t iid, IndexType index_type)
+    idx_id_t iid, RecordSchemaUptr key_schema, IndexType index_type)
     : disk_manager_(disk_manager),
       buffer_pool_manager_(buffer_pool_manager),
       table_id_(tid),
       index_id_(iid),
-      index_(nullptr)
+      index_(nullptr),
+      key_schema_(std::move(key_schema))
 {
-  // FIXME: index information should be parsed here, not just pass the index id into the index
-  // TODO(ziqi): parse index information from FILE_HEADER_PAGE here, including index key schema, index specific
-  // information, etc.
   switch (index_type) {
     case IndexType::BPTREE: {
-      // bpt_param = ParseBPTreeIndex();
       index_ = new BPTreeIndex(disk_manager, buffer_pool_manager, iid, key_schema_.get());
       break;
     }
     case IndexType::HASH: {
-      // hash_param = ParseHashIndex();
       index_ = new HashIndex(disk_manager, buffer_pool_manager, iid, key_schema_.get());
       break;
     }
@@ -48,11 +46,33 @@ IndexHandle::IndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_po
   }
 }
 
-void IndexHandle::InsertRecord(const Record &rec) {}
+void IndexHandle::InsertRecord(const Record &rec) { index_->Insert(Record(key_schema_.get(), rec), rec.GetRID()); }
+
+void IndexHandle::InsertRecords(const std::vector<RecordUptr> &recs)
+{
+  std::vector<std::pair<Record, RID>> entries;
+  entries.reserve(recs.size());
+  for (const auto &rec : recs) {
+    entries.emplace_back(Record(key_schema_.get(), *rec), rec->GetRID());
+  }
+  std::sort(entries.begin(), entries.end(), [](const auto &lhs, const auto &rhs) {
+    return Record::Compare(lhs.first, rhs.first) < 0;
+  });
+  index_->BulkInsert(entries);
+}
 
-void IndexHandle::DeleteRecord(const Record &rec) {}
+void IndexHandle::DeleteRecord(const Record &rec) { index_->Delete(Record(key_schema_.get(), rec), rec.GetRID()); }
 
-void IndexHandle::UpdateRecord(const Record &old_rec, const Record &new_rec) {}
+void IndexHandle::UpdateRecord(const Record &old_rec, const Record &new_rec)
+{
+  Record old_key(key_schema_.get(), old_rec);
+  Record new_key(key_schema_.get(), new_rec);
+  if (Record::Compare(old_key, new_key) == 0 && old_rec.GetRID() == new_rec.GetRID()) {
+    return;
+  }
+  index_->Delete(old_key, old_rec.GetRID());
+  index_->Insert(new_key, new_rec.GetRID());
+}
 
 IndexHandle::~IndexHandle() { delete index_; }
 }  // namespace wsdb
\ No newline at end of file
@@ -28,7 +28,7 @@ class IndexHandle
 {
 public:
   IndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, table_id_t tid, idx_id_t iid,
-      IndexType index_type);
+      RecordSchemaUptr key_schema, IndexType index_type);
 
   ~IndexHandle();
 
@@ -38,6 +38,13 @@ public:
    */
   void InsertRecord(const Record &rec);
 
+  /**
+   * insert a batch of records into the index, keys are sorted before they reach the index so that it can be built in
+   * key order, rids are recorded in the records
+   * @param recs
+   */
+  void InsertRecords(const std::vector<RecordUptr> &recs);
+
   /**
    * delete the record from the index
    * @param rec
@@ -61,8 +68,7 @@ public:
 
   auto GetIndexName() const -> const std::string
   {
-    auto file_name = disk_manager_->GetFileName(index_id_);
-    return file_name.substr(0, file_name.size() - IDX_SUFFIX.size());
+    return OBJNAME_FROM_FILENAME(disk_manager_->GetFileName(index_id_));
   }
 
   auto GetKeySchema() const -> const RecordSchema & { return *key_schema_; }
@@ -0,0 +1,140 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/26.
+//
+
+#include "key_encoder.h"
+#include <algorithm>
+#include <bit>
+
+namespace wsdb {
+
+/// store v big-endian so that memcmp orders unsigned values numerically
+static void StoreBigEndian(uint32_t v, char *out)
+{
+  for (int i = 3; i >= 0; --i) {
+    out[i] = static_cast<char>(v & 0xFF);
+    v >>= 8;
+  }
+}
+
+static auto EncodeInt(int32_t v) -> uint32_t { return static_cast<uint32_t>(v) ^ 0x80000000U; }
+
+static auto EncodeFloat(float v) -> uint32_t
+{
+  // -0.0 equals 0.0
+  auto bits = std::bit_cast<uint32_t>(v == 0.0F ? 0.0F : v);
+  return (bits & 0x80000000U) != 0 ? ~bits : bits ^ 0x80000000U;
+}
+
+KeyEncoder::KeyEncoder(
+    const RecordSchema *schema, const RecordSchema *key_schema, bool is_desc, const RecordSchema *other_key_schema)
+    : is_desc_(is_desc)
+{
+  WSDB_ASSERT(other_key_schema == nullptr || other_key_schema->GetFieldCount() == key_schema->GetFieldCount(),
+      "key field count mismatch");
+  for (size_t i = 0; i < key_schema->GetFieldCount(); ++i) {
+    auto idx = schema->GetRTFieldIndex(key_schema->GetFieldAt(i));
+    WSDB_ASSERT(idx != schema->GetFieldCount(), "key field not found");
+    auto    &field = schema->GetFieldAt(idx).field_;
+    KeyField key{idx, field.field_type_, false, schema->GetFieldOffset(idx), field.field_size_, 0};
+    switch (key.type_) {
+      case TYPE_BOOL: key.key_size_ = 1; break;
+      case TYPE_INT:
+      case TYPE_FLOAT: key.key_size_ = 4; break;
+      case TYPE_STRING: key.key_size_ = key.size_; break;
+      default: WSDB_THROW(WSDB_TYPE_MISSMATCH, fmt::format("cannot sort by {}", FieldTypeToString(key.type_)));
+    }
+    if (other_key_schema != nullptr) {
+      auto &other = other_key_schema->GetFieldAt(i).field_;
+      // reject incomparable keys like ValueRef::Compare does
+      ValueRef::CheckTypes(ValueRef::Null(key.type_), ValueRef::Null(other.field_type_));
+      key.as_float_ = key.type_ != other.field_type_;
+      if (key.type_ == TYPE_STRING) {
+        key.key_size_ = std::max(key.key_size_, other.field_size_);
+      }
+    }
+    key_size_ += 1 + key.key_size_;
+    fields_.push_back(key);
+  }
+}
+
+void KeyEncoder::Encode(const char *null_map, const char *data, char *out) const
+{
+  auto begin = out;
+  for (const auto &key : fields_) {
+    if (BitMap::GetBit(null_map, key.idx_)) {
+      std::memset(out, 0, 1 + key.key_size_);
+      out += 1 + key.key_size_;
+      continue;
+    }
+    *out++   = 1;
+    auto val = ValueRef::FromMem(key.type_, data + key.off_, key.size_);
+    if (key.as_float_) {
+      StoreBigEndian(EncodeFloat(val.GetNumber()), out);
+    } else {
+      switch (key.type_) {
+        case TYPE_BOOL: *out = static_cast<char>(val.GetBool() ? 1 : 0); break;
+        case TYPE_INT: StoreBigEndian(EncodeInt(val.GetInt()), out); break;
+        case TYPE_FLOAT: StoreBigEndian(EncodeFloat(val.GetFloat()), out); break;
+        default: {
+          // strings never contain '\0', so padding with it keeps a prefix before any longer string
+          auto str = val.GetString();
+          std::memcpy(out, str.data(), str.size());
+          std::memset(out + str.size(), 0, key.key_size_ - str.size());
+        }
+      }
+    }
+    out += key.key_size_;
+  }
+  if (is_desc_) {
+    for (auto p = begin; p != out; ++p) {
+      *p = static_cast<char>(~*p);
+    }
+  }
+}
+
+auto KeyEncoder::Encode(const Record &rec) const -> std::string
+{
+  std::string key(key_size_, '\0');
+  Encode(rec, key.data());
+  return key;
+}
+
+auto KeyEncoder::GetPrefixSize(size_t field_num) const -> size_t
+{
+  WSDB_ASSERT(field_num <= fields_.size(), fmt::format("{} > {}", field_num, fields_.size()));
+  size_t size = 0;
+  for (size_t i = 0; i < field_num; ++i) {
+    size += 1 + fields_[i].key_size_;
+  }
+  return size;
+}
+
+auto KeyEncoder::Prefix(const char *key) const -> uint64_t
+{
+  uint64_t prefix = 0;
+  auto     bytes  = std::min<size_t>(key_size_, sizeof(uint64_t));
+  for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+    prefix = (prefix << 8) | (i < bytes ? static_cast<uint8_t>(key[i]) : 0);
+  }
+  return prefix;
+}
+
+}  // namespace wsdb
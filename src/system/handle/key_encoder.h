@@ -0,0 +1,101 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/26.
+//
+
+/**
+ * @brief Normalized sort keys, the key fields of a record are encoded into a byte string that compares with memcmp the
+ * way the record compares on those fields with Record::Compare
+ *
+ * Every key field takes a fixed number of bytes: a flag byte, 0 for null and 1 otherwise, so null sorts first,
+ * followed by the value. Ints are stored big-endian with the sign bit flipped, floats big-endian with the sign bit
+ * flipped for positive numbers and all bits flipped for negative ones, bools as one byte and strings as their bytes
+ * padded with '\0' up to the field size. A descending key has all its bytes inverted
+ */
+
+#ifndef WSDB_KEY_ENCODER_H
+#define WSDB_KEY_ENCODER_H
+
+#include <cstring>
+#include "record_handle.h"
+
+namespace wsdb {
+
+class KeyEncoder
+{
+public:
+  KeyEncoder() = delete;
+
+  /**
+   * @param schema schema of the records to encode
+   * @param key_schema key fields, each must be a field of schema
+   * @param is_desc invert the order of every key field
+   * @param other_key_schema key fields of the records the keys are compared with, e.g. the other side of a join. The
+   * n-th key field is encoded as float if one of the two is float and the other int, and strings are padded to the
+   * longer field, so keys of both sides can be compared with each other
+   */
+  KeyEncoder(const RecordSchema *schema, const RecordSchema *key_schema, bool is_desc = false,
+      const RecordSchema *other_key_schema = nullptr);
+
+  [[nodiscard]] auto GetKeySize() const -> size_t { return key_size_; }
+
+  /// bytes taken by the first field_num key fields, comparing that many bytes compares the keys on those fields only
+  [[nodiscard]] auto GetPrefixSize(size_t field_num) const -> size_t;
+
+  /**
+   * Encode the key of a record given by its null map and data
+   * @param out at least GetKeySize() bytes
+   */
+  void Encode(const char *null_map, const char *data, char *out) const;
+
+  void Encode(const Record &rec, char *out) const { Encode(rec.GetNullMap(), rec.GetData(), out); }
+
+  [[nodiscard]] auto Encode(const Record &rec) const -> std::string;
+
+  /// three-way comparison of two encoded keys
+  [[nodiscard]] auto Compare(const char *lhs, const char *rhs) const -> int
+  {
+    return std::memcmp(lhs, rhs, key_size_);
+  }
+
+  /**
+   * The first 8 bytes of an encoded key as an integer, keys with different prefixes compare like their prefixes, so
+   * most comparisons of a sort need a single integer compare
+   */
+  [[nodiscard]] auto Prefix(const char *key) const -> uint64_t;
+
+private:
+  struct KeyField
+  {
+    size_t    idx_;  // index in the record schema, also the bit in the null map
+    FieldType type_;
+    bool      as_float_;
+    size_t    off_;       // offset of the field in the record data
+    size_t    size_;      // size of the field in the record data
+    size_t    key_size_;  // bytes of the value in the key, excluding the null flag
+  };
+
+  std::vector<KeyField> fields_;
+  bool                  is_desc_;
+  size_t                key_size_{0};
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_KEY_ENCODER_H
@@ -36,6 +36,10 @@ void PageHandle::WriteSlot(size_t slot_id, const char *null_map, const char *dat
 
 void PageHandle::ReadSlot(size_t slot_id, char *null_map, char *data) { WSDB_THROW(WSDB_EXCEPTION_EMPTY, ""); }
 auto PageHandle::ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr { WSDB_THROW(WSDB_EXCEPTION_EMPTY, ""); }
+void PageHandle::ReadColumns(const std::vector<size_t> &field_idx, ColumnBatch &batch)
+{
+  WSDB_THROW(WSDB_EXCEPTION_EMPTY, "");
+}
 
 NAryPageHandle::NAryPageHandle(const TableHeader *tab_hdr, Page *page)
     : PageHandle(
@@ -151,4 +155,27 @@ auto PAXPageHandle::ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr
   
   return std::make_unique<Chunk>(chunk_schema, std::move(col_arrs));
 }
+
+void PAXPageHandle::ReadColumns(const std::vector<size_t> &field_idx, ColumnBatch &batch)
+{
+  size_t slot_num = tab_hdr_->rec_per_page_;
+  batch.slot_num_ = slot_num;
+  batch.valid_.resize(slot_num);
+  for (size_t slot_id = 0; slot_id < slot_num; slot_id++) {
+    batch.valid_[slot_id] = BitMap::GetBit(bitmap_, slot_id) ? 1 : 0;
+  }
+  batch.nulls_.resize(field_idx.size());
+  batch.cols_.resize(field_idx.size());
+  for (size_t i = 0; i < field_idx.size(); i++) {
+    auto   idx        = field_idx[i];
+    size_t field_size = schema_->GetFieldAt(idx).field_.field_size_;
+    // 每一列在页内连续存放，整列拷贝即可
+    batch.cols_[i].resize(slot_num * field_size);
+    memcpy(batch.cols_[i].data(), slots_mem_ + offsets_[idx], slot_num * field_size);
+    batch.nulls_[i].resize(slot_num);
+    for (size_t slot_id = 0; slot_id < slot_num; slot_id++) {
+      batch.nulls_[i][slot_id] = BitMap::GetBit(slots_mem_ + slot_id * tab_hdr_->nullmap_size_, idx) ? 1 : 0;
+    }
+  }
+}
 }  // namespace wsdb
@@ -27,6 +27,20 @@
 #include "record_handle.h"
 
 namespace wsdb {
+
+/**
+ * Raw columns of a pax page copied out of the buffer pool, values of a column are stored back to back and indexed by
+ * slot id. A slot holds a record only if its valid flag is set, values of null or empty slots are unspecified.
+ * Buffers are reused when the batch is refilled from another page
+ */
+struct ColumnBatch
+{
+  size_t                            slot_num_{0};
+  std::vector<uint8_t>              valid_;
+  std::vector<std::vector<uint8_t>> nulls_;
+  std::vector<std::vector<char>>    cols_;
+};
+
 class PageHandle
 {
 public:
@@ -47,6 +61,13 @@ public:
 
   virtual auto ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr;
 
+  /**
+   * Copy raw columns of the page into the batch
+   * @param field_idx indexes of the requested fields in the table schema
+   * @param batch
+   */
+  virtual void ReadColumns(const std::vector<size_t> &field_idx, ColumnBatch &batch);
+
   virtual ~PageHandle() = default;
 
   [[nodiscard]] auto GetPage() -> Page * { return page_; }
@@ -98,6 +119,8 @@ public:
 
   auto ReadChunk(const RecordSchema *chunk_schema) -> ChunkUptr override;
 
+  void ReadColumns(const std::vector<size_t> &field_idx, ColumnBatch &batch) override;
+
 private:
   const RecordSchema        *schema_;
   const std::vector<size_t> &offsets_;
@@ -21,6 +21,8 @@
 
 #include "record_handle.h"
 #include <cstring>
+#include <numeric>
+#include <string_view>
 #include <utility>
 
 namespace wsdb {
@@ -319,7 +321,8 @@ auto Record::Hash() const -> size_t
         hash ^= std::hash<float>{}(*reinterpret_cast<const float *>(data_ + schema_->offsets_[i]));
         break;
       case FieldType::TYPE_STRING:
-        hash ^= std::hash<std::string>{}(std::string(data_ + schema_->offsets_[i], field.field_.field_size_));
+        hash ^= std::hash<std::string_view>{}(
+            std::string_view(data_ + schema_->offsets_[i], field.field_.field_size_));
         break;
       default: WSDB_FETAL("Unsupported field type to hash");
     }
@@ -338,32 +341,41 @@ auto Record::GetValueAt(size_t index) const -> ValueSptr
       field.field_.field_type_, data_ + schema_->offsets_[index], field.field_.field_size_);
 }
 
+auto Record::GetValueRefAt(size_t index) const -> ValueRef
+{
+  WSDB_ASSERT(index < schema_->GetFieldCount(), "Index out of range");
+  auto &field = schema_->GetFieldAt(index);
+  if (BitMap::GetBit(nullmap_, index)) {
+    return ValueRef::Null(field.field_.field_type_);
+  }
+  return ValueRef::FromMem(field.field_.field_type_, data_ + schema_->offsets_[index], field.field_.field_size_);
+}
+
 auto Record::Compare(const wsdb::Record &lrec, const wsdb::Record &rrec) -> int
 {
   // compare two records,
   //  WSDB_ASSERT(Record, Compare, lrec.GetSchema() == rrec.GetSchema(), "Schema mismatch");
   // more loose assert to support two similar records
   WSDB_ASSERT(lrec.GetSchema()->GetFieldCount() == rrec.GetSchema()->GetFieldCount(), "field count mismatch");
+  // sort and join call this for every pair of keys, so read the fields in place instead of creating values
   for (size_t i = 0; i < lrec.GetSchema()->GetFieldCount(); ++i) {
-    auto lval = lrec.GetValueAt(i);
-    auto rval = rrec.GetValueAt(i);
-    if (lval->IsNull() && rval->IsNull()) {
-      continue;
-    }
-    if (lval->IsNull() || rval->IsNull()) {
-      return lval->IsNull() ? -1 : 1;
-    }
-    if (*lval < *rval) {
-      return -1;
-    }
-    if (*lval > *rval) {
-      return 1;
+    auto cmp = ValueRef::Compare(lrec.GetValueRefAt(i), rrec.GetValueRefAt(i));
+    if (cmp != 0) {
+      return cmp < 0 ? -1 : 1;
     }
   }
   return 0;
 }
 
 Chunk::Chunk(const RecordSchema *schema, std::vector<ArrayValueSptr> cols) : schema_(schema), cols_(std::move(cols))
+{
+  WSDB_ASSERT(schema_->GetFieldCount() == cols_.size(), "Field count mismatch");
+  sel_.resize(GetRowCount());
+  std::iota(sel_.begin(), sel_.end(), 0);
+}
+
+Chunk::Chunk(const RecordSchema *schema, std::vector<ArrayValueSptr> cols, std::vector<size_t> sel)
+    : schema_(schema), cols_(std::move(cols)), sel_(std::move(sel))
 {
   WSDB_ASSERT(schema_->GetFieldCount() == cols_.size(), "Field count mismatch");
 }
@@ -381,4 +393,47 @@ Chunk &Chunk::operator=(wsdb::Chunk &&chunk) noexcept = default;
 auto Chunk::GetCol(int index) -> ArrayValueSptr { return cols_[index]; }
 
 auto Chunk::GetColCount() -> size_t { return cols_.size(); }
+
+auto Chunk::GetRowCount() const -> size_t { return cols_.empty() ? 0 : cols_[0]->GetValueNum(); }
+
+auto Chunk::GetValueAt(size_t col, size_t row) const -> const ValueSptr &
+{
+  WSDB_ASSERT(col < cols_.size() && row < GetRowCount(), "Index out of range");
+  return cols_[col]->Get()[row];
+}
+
+auto Chunk::GetRecord(size_t row) const -> RecordUptr
+{
+  std::vector<ValueSptr> values;
+  values.reserve(cols_.size());
+  for (const auto &col : cols_) {
+    values.push_back(col->Get()[row]);
+  }
+  return std::make_unique<Record>(schema_, values, INVALID_RID);
+}
+
+void Chunk::Append(const Chunk &other)
+{
+  WSDB_ASSERT(other.cols_.size() == cols_.size(), "Field count mismatch");
+  // drop the unselected rows first so that the columns only grow by what is appended
+  if (sel_.size() != GetRowCount()) {
+    for (auto &col : cols_) {
+      std::vector<ValueSptr> values;
+      values.reserve(sel_.size());
+      for (auto row : sel_) {
+        values.push_back(col->Get()[row]);
+      }
+      col = ValueFactory::CreateArrayValue(values);
+    }
+    std::iota(sel_.begin(), sel_.end(), 0);
+  }
+  for (size_t i = 0; i < cols_.size(); ++i) {
+    for (auto row : other.sel_) {
+      cols_[i]->Append(other.cols_[i]->Get()[row]);
+    }
+  }
+  for (size_t i = sel_.size(); i < GetRowCount(); ++i) {
+    sel_.push_back(i);
+  }
+}
 }  // namespace wsdb
\ No newline at end of file
@@ -165,6 +165,14 @@ public:
 
   [[nodiscard]] auto GetValueAt(size_t index) const -> ValueSptr;
 
+  /**
+   * Get a field without allocating, strings in the returned value point into this record, so the value must not
+   * outlive the record
+   * @param index
+   * @return
+   */
+  [[nodiscard]] auto GetValueRefAt(size_t index) const -> ValueRef;
+
   /// Get the schema of this record
   [[nodiscard]] auto GetSchema() const -> const RecordSchema * { return schema_; }
 
@@ -181,13 +189,30 @@ private:
   RID                 rid_{};
 };
 
+/**
+ * Chunk is a batch of rows stored by column, the selection vector lists the rows that are still alive, so operators
+ * like filter and limit can drop rows without touching the columns
+ */
 class Chunk
 {
 public:
   Chunk() = delete;
 
+  /**
+   * Generate a chunk with all rows selected
+   * @param schema
+   * @param cols columns with the same number of values
+   */
   Chunk(const RecordSchema *schema, std::vector<ArrayValueSptr> cols);
 
+  /**
+   * Generate a chunk with part of the rows selected
+   * @param schema
+   * @param cols
+   * @param sel selected row indexes in ascending order
+   */
+  Chunk(const RecordSchema *schema, std::vector<ArrayValueSptr> cols, std::vector<size_t> sel);
+
   ~Chunk();
 
   Chunk(const Chunk &chunk);
@@ -202,9 +227,37 @@ public:
 
   auto GetColCount() -> size_t;
 
+  [[nodiscard]] auto GetSchema() const -> const RecordSchema * { return schema_; }
+
+  /// number of rows stored in the columns, including the unselected ones
+  [[nodiscard]] auto GetRowCount() const -> size_t;
+
+  /// number of selected rows
+  [[nodiscard]] auto GetSelCount() const -> size_t { return sel_.size(); }
+
+  [[nodiscard]] auto GetSel() const -> const std::vector<size_t> & { return sel_; }
+
+  void SetSel(std::vector<size_t> sel) { sel_ = std::move(sel); }
+
+  [[nodiscard]] auto GetValueAt(size_t col, size_t row) const -> const ValueSptr &;
+
+  /**
+   * Materialize a row as a record under the chunk schema
+   * @param row index of the row in the columns, not in the selection vector
+   */
+  [[nodiscard]] auto GetRecord(size_t row) const -> RecordUptr;
+
+  /**
+   * Append the selected rows of another chunk of the same schema, the appended rows are all selected. The columns of
+   * this chunk are modified in place, so they must not be shared with other chunks
+   * @param other
+   */
+  void Append(const Chunk &other);
+
 private:
   const RecordSchema         *schema_;
   std::vector<ArrayValueSptr> cols_;
+  std::vector<size_t>         sel_;
 };
 
 }  // namespace wsdb
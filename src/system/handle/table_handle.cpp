@@ -20,8 +20,16 @@
  //
 
 #include "table_handle.h"
+#include "concurrency/txn_manager.h"
 namespace wsdb {
 
+  /// transaction whose snapshot the calling thread reads and writes, none once the transaction has ended
+  static auto RunningTxn() -> Transaction*
+  {
+    auto txn = TxnManager::GetTransaction();
+    return txn != nullptr && txn->IsRunning() ? txn : nullptr;
+  }
+
   TableHandle::TableHandle(DiskManager* disk_manager, BufferPoolManager* buffer_pool_manager, table_id_t table_id,
     TableHeader& hdr, RecordSchemaUptr& schema, StorageModel storage_model)
     : tab_hdr_(hdr),
@@ -29,7 +37,9 @@ namespace wsdb {
     disk_manager_(disk_manager),
     buffer_pool_manager_(buffer_pool_manager),
     schema_(std::move(schema)),
-    storage_model_(storage_model)
+    storage_model_(storage_model),
+    read_ahead_(buffer_pool_manager, table_id),
+    versions_(std::make_shared<VersionStore>([this](Transaction* txn, const WriteRecord& write) { UndoWrite(txn, write); }))
   {
     // set table id for table handle;
     schema_->SetTableId(table_id_);
@@ -46,60 +56,120 @@ namespace wsdb {
     }
   }
 
+  TableHandle::~TableHandle() { versions_->Detach(); }
+
   auto TableHandle::GetRecord(const RID& rid) -> RecordUptr
   {
     // 获取页面句柄
     auto page_handle = FetchPageHandle(rid.PageID());
-    // 检查槽位是否有记录
-    if (!BitMap::GetBit(page_handle->GetBitmap(), rid.SlotID())) {
-      buffer_pool_manager_->UnpinPage(table_id_, rid.PageID(), false);
-      WSDB_THROW(WSDB_RECORD_MISS, fmt::format("Record not found at RID: (page_id={}, slot_id={})", rid.PageID(), rid.SlotID()));
-    }
     auto nullmap = std::make_unique<char[]>(tab_hdr_.nullmap_size_);
     auto data = std::make_unique<char[]>(tab_hdr_.rec_size_);
-    page_handle->ReadSlot(rid.SlotID(), nullmap.get(), data.get());
+    // 检查槽位是否有记录
+    bool used = BitMap::GetBit(page_handle->GetBitmap(), rid.SlotID());
+    if (used) {
+      page_handle->ReadSlot(rid.SlotID(), nullmap.get(), data.get());
+    }
     buffer_pool_manager_->UnpinPage(table_id_, rid.PageID(), false);
-
+    // 先读页面再查版本链，事务看到的不是页面中的版本时以版本链为准
+    auto txn = RunningTxn();
+    std::string image;
+    if (txn != nullptr && versions_->GetVisible(txn, rid, image)) {
+      used = !image.empty();
+      if (used) {
+        memcpy(nullmap.get(), image.data(), tab_hdr_.nullmap_size_);
+        memcpy(data.get(), image.data() + tab_hdr_.nullmap_size_, tab_hdr_.rec_size_);
+      }
+    }
+    if (!used) {
+      WSDB_THROW(WSDB_RECORD_MISS, fmt::format("Record not found at RID: (page_id={}, slot_id={})", rid.PageID(), rid.SlotID()));
+    }
     return std::make_unique<Record>(schema_.get(), nullmap.get(), data.get(), rid);
   }
 
   auto TableHandle::GetChunk(page_id_t pid, const RecordSchema* chunk_schema) -> ChunkUptr 
   {
-    // 获取页面句柄
-    auto page_handle = FetchPageHandle(pid);
+    read_ahead_.OnAccess(pid, tab_hdr_.page_num_);
     // 使用页面句柄读取数据块
-    auto chunk = page_handle->ReadChunk(chunk_schema);
-    // 解除页面固定
-    buffer_pool_manager_->UnpinPage(table_id_, pid, false);
+    ChunkUptr chunk;
+    ReadVisiblePage(pid, [&](PageHandle& page_handle) { chunk = page_handle.ReadChunk(chunk_schema); });
     return chunk;
   }
 
+  void TableHandle::GetColumnBatch(page_id_t pid, const std::vector<size_t>& field_idx, ColumnBatch& batch)
+  {
+    read_ahead_.OnAccess(pid, tab_hdr_.page_num_);
+    ReadVisiblePage(pid, [&](PageHandle& page_handle) { page_handle.ReadColumns(field_idx, batch); });
+  }
+
   auto TableHandle::InsertRecord(const Record& record) -> RID
   {
+    LockForWrite(INVALID_RID);
     // 创建或获取有空闲槽位的页面句柄
     auto page_handle = CreatePageHandle();
     // 获取空闲槽位
-    auto slot_id = BitMap::FindFirst(page_handle->GetBitmap(), tab_hdr_.rec_per_page_, 0, false);
+    auto slot_id = FindFreeSlot(*page_handle, 0);
+    if (slot_id == tab_hdr_.rec_per_page_) {
+      // 空槽位都还可能被回滚的事务写回，换一个新页面
+      buffer_pool_manager_->UnpinPage(table_id_, page_handle->GetPage()->GetPageId(), false);
+      page_handle = CreateNewPageHandle();
+      slot_id = 0;
+    }
+    auto rid = RID(page_handle->GetPage()->GetPageId(), static_cast<slot_id_t>(slot_id));
+    BeginWrite(rid, {});
     // 写入记录
     page_handle->WriteSlot(slot_id, record.GetNullMap(), record.GetData(), false);
     // 更新位图和页面头信息
     BitMap::SetBit(page_handle->GetBitmap(), slot_id, true);
     tab_hdr_.rec_num_++;
-    auto rid = RID(page_handle->GetPage()->GetPageId(), slot_id);
+    AppendLog(TxnManager::GetTransaction(), LogType::INSERT, page_handle->GetPage(), static_cast<slot_id_t>(slot_id), {},
+      MakeImage(record.GetNullMap(), record.GetData()));
     // 检查页面是否已满
     if (BitMap::FindFirst(page_handle->GetBitmap(), tab_hdr_.rec_per_page_, 0, false) == tab_hdr_.rec_per_page_) {
-      // 更新表头的第一个空闲页面 ID 和当前页面的下一个页面 ID
-      tab_hdr_.first_free_page_ = page_handle->GetPage()->GetNextFreePageId();
-      page_handle->GetPage()->SetNextFreePageId(INVALID_PAGE_ID);
+      UnlinkFreePage(page_handle->GetPage());
     }
     buffer_pool_manager_->UnpinPage(table_id_, page_handle->GetPage()->GetPageId(), true);
     return rid;
   }
 
+  void TableHandle::InsertRecords(const std::vector<RecordUptr>& records)
+  {
+    auto txn = TxnManager::GetTransaction();
+    LockForWrite(INVALID_RID);
+    size_t next = 0;
+    while (next < records.size()) {
+      // 每个页面只获取一次，尽量写满
+      auto page_handle = CreatePageHandle();
+      auto slot_id = FindFreeSlot(*page_handle, 0);
+      if (slot_id == tab_hdr_.rec_per_page_) {
+        buffer_pool_manager_->UnpinPage(table_id_, page_handle->GetPage()->GetPageId(), false);
+        page_handle = CreateNewPageHandle();
+        slot_id = 0;
+      }
+      auto page_id = page_handle->GetPage()->GetPageId();
+      while (slot_id < tab_hdr_.rec_per_page_ && next < records.size()) {
+        auto& record = records[next++];
+        BeginWrite(RID(page_id, static_cast<slot_id_t>(slot_id)), {});
+        page_handle->WriteSlot(slot_id, record->GetNullMap(), record->GetData(), false);
+        BitMap::SetBit(page_handle->GetBitmap(), slot_id, true);
+        AppendLog(txn, LogType::INSERT, page_handle->GetPage(), static_cast<slot_id_t>(slot_id), {},
+          MakeImage(record->GetNullMap(), record->GetData()));
+        record->SetRID(RID(page_id, slot_id));
+        tab_hdr_.rec_num_++;
+        slot_id = FindFreeSlot(*page_handle, slot_id + 1);
+      }
+      // 页面已满，从空闲链表中移除
+      if (BitMap::FindFirst(page_handle->GetBitmap(), tab_hdr_.rec_per_page_, 0, false) == tab_hdr_.rec_per_page_) {
+        UnlinkFreePage(page_handle->GetPage());
+      }
+      buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+    }
+  }
+
   void TableHandle::InsertRecord(const RID& rid, const Record& record) {
     if (rid.PageID() == INVALID_PAGE_ID) {
       WSDB_THROW(WSDB_PAGE_MISS, fmt::format("Record not found at RID: (page_id={}, slot_id={})", rid.PageID(), rid.SlotID()));
     }
+    LockForWrite(rid);
 
     // 获取页面句柄
     auto page_handle = FetchPageHandle(rid.PageID());
@@ -109,6 +179,7 @@ namespace wsdb {
       buffer_pool_manager_->UnpinPage(table_id_, rid.PageID(), false);
       WSDB_THROW(WSDB_RECORD_EXISTS, fmt::format("Record already exists at RID: (page_id={}, slot_id={})", rid.PageID(), rid.SlotID()));
     }
+    BeginWrite(rid, {});
 
     // 写入记录
     page_handle->WriteSlot(rid.SlotID(), record.GetNullMap(), record.GetData(), false);
@@ -116,11 +187,12 @@ namespace wsdb {
     // 更新位图和记录数
     BitMap::SetBit(page_handle->GetBitmap(), rid.SlotID(), true);
     tab_hdr_.rec_num_++;
+    AppendLog(TxnManager::GetTransaction(), LogType::INSERT, page_handle->GetPage(), rid.SlotID(), {},
+      MakeImage(record.GetNullMap(), record.GetData()));
 
     // 检查页面是否已满
     if (BitMap::FindFirst(page_handle->GetBitmap(), tab_hdr_.rec_per_page_, 0, false) == tab_hdr_.rec_per_page_) {
-      tab_hdr_.first_free_page_ = page_handle->GetPage()->GetNextFreePageId();
-      page_handle->GetPage()->SetNextFreePageId(INVALID_PAGE_ID);
+      UnlinkFreePage(page_handle->GetPage());
     }
 
     buffer_pool_manager_->UnpinPage(table_id_, rid.PageID(), true);
@@ -128,44 +200,229 @@ namespace wsdb {
 
   void TableHandle::DeleteRecord(const RID& rid)
   {
+    LockForWrite(rid);
     // 获取页面句柄
     auto page_handle = FetchPageHandle(rid.PageID());
     // 检查槽位是否有记录
     if (!BitMap::GetBit(page_handle->GetBitmap(), rid.SlotID())) {
       buffer_pool_manager_->UnpinPage(table_id_, rid.PageID(), false);
+      CheckConflict(rid);
       WSDB_THROW(WSDB_RECORD_MISS, fmt::format("Record not found at RID: (page_id={}, slot_id={})", rid.PageID(), rid.SlotID()));
     }
+    auto before = ReadImage(*page_handle, rid.SlotID());
+    BeginWrite(rid, before);
     // 更新位图和页面头信息
-    BitMap::SetBit(page_handle->GetBitmap(), rid.SlotID(), false);
-    tab_hdr_.rec_num_--;
-    // 检查页面是否未满
-    if (BitMap::FindFirst(page_handle->GetBitmap(), tab_hdr_.rec_per_page_, 0, false) < tab_hdr_.rec_per_page_) {
-      page_handle->GetPage()->SetNextFreePageId(tab_hdr_.first_free_page_);
-      tab_hdr_.first_free_page_ = rid.PageID();
-    }
+    ReleaseSlot(*page_handle, rid.SlotID());
+    AppendLog(TxnManager::GetTransaction(), LogType::DELETE, page_handle->GetPage(), rid.SlotID(), std::move(before), {});
     buffer_pool_manager_->UnpinPage(table_id_, rid.PageID(), true);
   }
 
   void TableHandle::UpdateRecord(const RID& rid, const Record& record)
   {
+    LockForWrite(rid);
     // 获取页面句柄
     auto page_handle = FetchPageHandle(rid.PageID());
     // 检查槽位是否有记录
     if (!BitMap::GetBit(page_handle->GetBitmap(), rid.SlotID())) {
       buffer_pool_manager_->UnpinPage(table_id_, rid.PageID(), false);
+      CheckConflict(rid);
       WSDB_THROW(WSDB_RECORD_MISS, fmt::format("Record not found at RID: (page_id={}, slot_id={})", rid.PageID(), rid.SlotID()));
     }
     // 写入新记录
+    auto before = ReadImage(*page_handle, rid.SlotID());
+    BeginWrite(rid, before);
     page_handle->WriteSlot(rid.SlotID(), record.GetNullMap(), record.GetData(), true);
+    AppendLog(TxnManager::GetTransaction(), LogType::UPDATE, page_handle->GetPage(), rid.SlotID(), std::move(before),
+      MakeImage(record.GetNullMap(), record.GetData()));
     buffer_pool_manager_->UnpinPage(table_id_, rid.PageID(), true);
   }
 
+  auto TableHandle::RecoverSlot(page_id_t page_id, slot_id_t slot_id, const std::string& image, lsn_t lsn) -> bool
+  {
+    auto page_handle = FetchPageHandle(page_id);
+    auto page = page_handle->GetPage();
+    // 页面已经包含这条日志的修改
+    if (page->GetLsn() >= lsn) {
+      buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+      return false;
+    }
+    if (slot_id == INVALID_SLOT_ID) {
+      memset(page->GetData(), 0, PAGE_SIZE);
+      page->SetNextFreePageId(INVALID_PAGE_ID);
+    }
+    else if (image.empty()) {
+      BitMap::SetBit(page_handle->GetBitmap(), slot_id, false);
+    }
+    else {
+      WSDB_ASSERT(image.size() == tab_hdr_.nullmap_size_ + tab_hdr_.rec_size_, "log image does not match the table");
+      bool update = BitMap::GetBit(page_handle->GetBitmap(), slot_id);
+      page_handle->WriteSlot(slot_id, image.data(), image.data() + tab_hdr_.nullmap_size_, update);
+      BitMap::SetBit(page_handle->GetBitmap(), slot_id, true);
+    }
+    page->SetLsn(lsn);
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+    return true;
+  }
+
+  void TableHandle::RebuildHeader(size_t page_num)
+  {
+    tab_hdr_.page_num_ = std::max(tab_hdr_.page_num_, page_num);
+    tab_hdr_.rec_num_ = 0;
+    tab_hdr_.first_free_page_ = INVALID_PAGE_ID;
+    // 从后向前遍历，空闲链表按页号递增
+    for (auto page_id = static_cast<page_id_t>(tab_hdr_.page_num_) - 1; page_id > FILE_HEADER_PAGE_ID; page_id--) {
+      auto page_handle = FetchPageHandle(page_id);
+      auto full = BitMap::FindFirst(page_handle->GetBitmap(), tab_hdr_.rec_per_page_, 0, false) == tab_hdr_.rec_per_page_;
+      for (size_t slot_id = 0; slot_id < tab_hdr_.rec_per_page_; slot_id++) {
+        tab_hdr_.rec_num_ += BitMap::GetBit(page_handle->GetBitmap(), slot_id) ? 1 : 0;
+      }
+      page_handle->GetPage()->SetNextFreePageId(full ? INVALID_PAGE_ID : tab_hdr_.first_free_page_);
+      if (!full) {
+        tab_hdr_.first_free_page_ = page_id;
+      }
+      buffer_pool_manager_->UnpinPage(table_id_, page_id, true);
+    }
+  }
+
   auto TableHandle::FetchPageHandle(page_id_t page_id) -> PageHandleUptr
   {
     auto page = buffer_pool_manager_->FetchPage(table_id_, page_id);
     return WrapPageHandle(page);
   }
 
+  void TableHandle::ReadVisiblePage(page_id_t page_id, const std::function<void(PageHandle&)>& read)
+  {
+    auto page_handle = FetchPageHandle(page_id);
+    read(*page_handle);
+    auto txn = RunningTxn();
+    // 先读页面再查版本链，读之后才开始的写入不影响读到的内容
+    if (txn == nullptr || !versions_->HasVersions(page_id)) {
+      buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+      return;
+    }
+    // 页面有其他版本，在副本上换成事务看到的版本后重新读
+    auto copy = std::make_unique<Page>();
+    copy->SetFilePageId(table_id_, page_id);
+    memcpy(copy->GetData(), page_handle->GetPage()->GetData(), PAGE_SIZE);
+    buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
+    std::vector<std::pair<slot_id_t, std::string>> images;
+    versions_->GetVisible(txn, page_id, images);
+    auto copy_handle = WrapPageHandle(copy.get());
+    for (auto& [slot_id, image] : images) {
+      if (image.empty()) {
+        BitMap::SetBit(copy_handle->GetBitmap(), slot_id, false);
+        continue;
+      }
+      bool update = BitMap::GetBit(copy_handle->GetBitmap(), slot_id);
+      copy_handle->WriteSlot(slot_id, image.data(), image.data() + tab_hdr_.nullmap_size_, update);
+      BitMap::SetBit(copy_handle->GetBitmap(), slot_id, true);
+    }
+    read(*copy_handle);
+  }
+
+  auto TableHandle::FindFreeSlot(PageHandle& page_handle, size_t slot_id) -> size_t
+  {
+    auto page_id = page_handle.GetPage()->GetPageId();
+    slot_id = BitMap::FindFirst(page_handle.GetBitmap(), tab_hdr_.rec_per_page_, slot_id, false);
+    // 有版本链的空槽位可能被回滚的事务写回，不能复用
+    while (slot_id < tab_hdr_.rec_per_page_ && versions_->IsVersioned(RID(page_id, static_cast<slot_id_t>(slot_id)))) {
+      slot_id = BitMap::FindFirst(page_handle.GetBitmap(), tab_hdr_.rec_per_page_, slot_id + 1, false);
+    }
+    return slot_id;
+  }
+
+  void TableHandle::ReleaseSlot(PageHandle& page_handle, slot_id_t slot_id)
+  {
+    // 只有已满的页面不在空闲链表中
+    bool full = BitMap::FindFirst(page_handle.GetBitmap(), tab_hdr_.rec_per_page_, 0, false) == tab_hdr_.rec_per_page_;
+    BitMap::SetBit(page_handle.GetBitmap(), slot_id, false);
+    tab_hdr_.rec_num_--;
+    if (full) {
+      page_handle.GetPage()->SetNextFreePageId(tab_hdr_.first_free_page_);
+      tab_hdr_.first_free_page_ = page_handle.GetPage()->GetPageId();
+    }
+  }
+
+  void TableHandle::UnlinkFreePage(Page* page)
+  {
+    auto page_id = page->GetPageId();
+    auto next = page->GetNextFreePageId();
+    page->SetNextFreePageId(INVALID_PAGE_ID);
+    if (tab_hdr_.first_free_page_ == page_id) {
+      tab_hdr_.first_free_page_ = next;
+      return;
+    }
+    // 插入总是使用链表头部的页面，只有按 rid 插入和回滚才需要找前驱页面
+    auto prev_id = tab_hdr_.first_free_page_;
+    while (prev_id != INVALID_PAGE_ID) {
+      auto prev = buffer_pool_manager_->FetchPage(table_id_, prev_id);
+      auto prev_next = prev->GetNextFreePageId();
+      if (prev_next == page_id) {
+        prev->SetNextFreePageId(next);
+        buffer_pool_manager_->UnpinPage(table_id_, prev_id, true);
+        return;
+      }
+      buffer_pool_manager_->UnpinPage(table_id_, prev_id, false);
+      prev_id = prev_next;
+    }
+  }
+
+  void TableHandle::LockForWrite(const RID& rid)
+  {
+    auto txn = RunningTxn();
+    if (txn == nullptr || txn->GetLockManager() == nullptr) {
+      return;
+    }
+    // 在固定页面之前加锁，等待锁时不占用缓冲池
+    if (rid == INVALID_RID) {
+      txn->GetLockManager()->LockTable(txn, LockMode::INTENTION_EXCLUSIVE, table_id_);
+    }
+    else {
+      txn->GetLockManager()->LockRow(txn, LockMode::EXCLUSIVE, table_id_, rid);
+    }
+  }
+
+  void TableHandle::BeginWrite(const RID& rid, std::string before)
+  {
+    auto txn = RunningTxn();
+    if (txn != nullptr && !versions_->BeginWrite(txn, rid, std::move(before))) {
+      buffer_pool_manager_->UnpinPage(table_id_, rid.PageID(), false);
+      WSDB_THROW(WSDB_TXN_ABORTED, fmt::format("Write conflict at RID: (page_id={}, slot_id={})", rid.PageID(), rid.SlotID()));
+    }
+  }
+
+  void TableHandle::CheckConflict(const RID& rid)
+  {
+    auto txn = RunningTxn();
+    if (txn != nullptr && versions_->IsConflict(txn, rid)) {
+      WSDB_THROW(WSDB_TXN_ABORTED, fmt::format("Write conflict at RID: (page_id={}, slot_id={})", rid.PageID(), rid.SlotID()));
+    }
+  }
+
+  void TableHandle::UndoWrite(Transaction* txn, const WriteRecord& write)
+  {
+    auto page_handle = FetchPageHandle(write.rid_.PageID());
+    auto slot_id = write.rid_.SlotID();
+    bool used = BitMap::GetBit(page_handle->GetBitmap(), slot_id);
+    if (write.before_.empty()) {
+      if (used) {
+        ReleaseSlot(*page_handle, slot_id);
+      }
+    }
+    else {
+      page_handle->WriteSlot(slot_id, write.before_.data(), write.before_.data() + tab_hdr_.nullmap_size_, used);
+      if (!used) {
+        BitMap::SetBit(page_handle->GetBitmap(), slot_id, true);
+        tab_hdr_.rec_num_++;
+        if (BitMap::FindFirst(page_handle->GetBitmap(), tab_hdr_.rec_per_page_, 0, false) == tab_hdr_.rec_per_page_) {
+          UnlinkFreePage(page_handle->GetPage());
+        }
+      }
+    }
+    AppendLog(txn, LogType::CLR, page_handle->GetPage(), slot_id, {}, write.before_, write.prev_lsn_);
+    buffer_pool_manager_->UnpinPage(table_id_, write.rid_.PageID(), true);
+  }
+
   auto TableHandle::CreatePageHandle() -> PageHandleUptr
   {
     if (tab_hdr_.first_free_page_ == INVALID_PAGE_ID) {
@@ -183,6 +440,8 @@ auto TableHandle::CreateNewPageHandle() -> PageHandleUptr
   auto pg_hdl = WrapPageHandle(page);
   page->SetNextFreePageId(tab_hdr_.first_free_page_);
   tab_hdr_.first_free_page_ = page_id;
+  // redo extends the table by this page before replaying the records written into it
+  AppendLog(TxnManager::GetTransaction(), LogType::NEW_PAGE, page, INVALID_SLOT_ID, {}, {});
   return pg_hdl;
 }
 
@@ -195,6 +454,40 @@ auto TableHandle::CreateNewPageHandle() -> PageHandleUptr
     }
   }
 
+  auto TableHandle::MakeImage(const char* null_map, const char* data) const -> std::string
+  {
+    std::string image(null_map, tab_hdr_.nullmap_size_);
+    image.append(data, tab_hdr_.rec_size_);
+    return image;
+  }
+
+  auto TableHandle::ReadImage(PageHandle& page_handle, slot_id_t slot_id) const -> std::string
+  {
+    std::string image(tab_hdr_.nullmap_size_ + tab_hdr_.rec_size_, '\0');
+    page_handle.ReadSlot(slot_id, image.data(), image.data() + tab_hdr_.nullmap_size_);
+    return image;
+  }
+
+  void TableHandle::AppendLog(Transaction* txn, LogType type, Page* page, slot_id_t slot_id, std::string before,
+    std::string after, lsn_t undo_next_lsn)
+  {
+    auto log_manager = buffer_pool_manager_->GetLogManager();
+    if (log_manager == nullptr || txn == nullptr) {
+      return;
+    }
+    // 页面仍被固定，脏页写回前日志一定已经写到这条记录
+    LogRecord rec(type, txn->GetTxnId(), txn->GetPrevLsn());
+    rec.file_name_ = disk_manager_->GetFileName(table_id_);
+    rec.page_id_ = page->GetPageId();
+    rec.slot_id_ = slot_id;
+    rec.before_ = std::move(before);
+    rec.after_ = std::move(after);
+    rec.undo_next_lsn_ = undo_next_lsn;
+    auto lsn = log_manager->AppendLogRecord(rec);
+    txn->SetPrevLsn(lsn);
+    page->SetLsn(lsn);
+  }
+
   auto TableHandle::GetTableId() const -> table_id_t { return table_id_; }
 
   auto TableHandle::GetTableHeader() const -> const TableHeader& { return tab_hdr_; }
@@ -209,17 +502,19 @@ auto TableHandle::CreateNewPageHandle() -> PageHandleUptr
 
   auto TableHandle::GetStorageModel() const -> StorageModel { return storage_model_; }
 
+  auto TableHandle::GetVersionStore() const -> VersionStore* { return versions_.get(); }
+
   auto TableHandle::GetFirstRID() -> RID
   {
     auto page_id = FILE_HEADER_PAGE_ID + 1;
     while (page_id < static_cast<page_id_t>(tab_hdr_.page_num_)) {
-      auto pg_hdl = FetchPageHandle(page_id);
-      auto id = BitMap::FindFirst(pg_hdl->GetBitmap(), tab_hdr_.rec_per_page_, 0, true);
+      read_ahead_.OnAccess(page_id, tab_hdr_.page_num_);
+      size_t id;
+      ReadVisiblePage(page_id,
+        [&](PageHandle& pg_hdl) { id = BitMap::FindFirst(pg_hdl.GetBitmap(), tab_hdr_.rec_per_page_, 0, true); });
       if (id != tab_hdr_.rec_per_page_) {
-        buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
         return { page_id, static_cast<slot_id_t>(id) };
       }
-      buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
       page_id++;
     }
     return INVALID_RID;
@@ -230,15 +525,16 @@ auto TableHandle::CreateNewPageHandle() -> PageHandleUptr
     auto page_id = rid.PageID();
     auto slot_id = rid.SlotID();
     while (page_id < static_cast<page_id_t>(tab_hdr_.page_num_)) {
-      auto pg_hdl = FetchPageHandle(page_id);
-      slot_id = static_cast<slot_id_t>(BitMap::FindFirst(pg_hdl->GetBitmap(), tab_hdr_.rec_per_page_, slot_id + 1, true));
+      read_ahead_.OnAccess(page_id, tab_hdr_.page_num_);
+      auto from = slot_id + 1;
+      ReadVisiblePage(page_id, [&](PageHandle& pg_hdl) {
+        slot_id = static_cast<slot_id_t>(BitMap::FindFirst(pg_hdl.GetBitmap(), tab_hdr_.rec_per_page_, from, true));
+      });
       if (slot_id == static_cast<slot_id_t>(tab_hdr_.rec_per_page_)) {
-        buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
         page_id++;
         slot_id = -1;
       }
       else {
-        buffer_pool_manager_->UnpinPage(table_id_, page_id, false);
         return { page_id, static_cast<slot_id_t>(slot_id) };
       }
     }
@@ -250,4 +546,26 @@ auto TableHandle::CreateNewPageHandle() -> PageHandleUptr
     return schema_->HasField(table_id_, field_name);
   }
 
+  void TableHandle::Analyze()
+  {
+    StatisticsCollector collector(schema_.get());
+    for (auto rid = GetFirstRID(); rid != INVALID_RID; rid = GetNextRID(rid)) {
+      collector.Add(*GetRecord(rid));
+    }
+    SetStatistics(collector.Build());
+  }
+
+  auto TableHandle::GetStatistics() const -> std::shared_ptr<const TableStatistics>
+  {
+    std::lock_guard<std::mutex> guard(stats_latch_);
+    return stats_;
+  }
+
+  void TableHandle::SetStatistics(std::shared_ptr<const TableStatistics> stats)
+  {
+    // 优化器可能正在使用旧的统计信息，替换指针即可
+    std::lock_guard<std::mutex> guard(stats_latch_);
+    stats_ = std::move(stats);
+  }
+
 }  // namespace wsdb
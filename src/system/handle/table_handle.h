@@ -21,12 +21,17 @@
 
 #ifndef WSDB_TABLE_HANDLE_H
 #define WSDB_TABLE_HANDLE_H
+#include <functional>
 #include <utility>
 
 #include "../../../common/micro.h"
 #include "common/page.h"
 #include "storage/storage.h"
+#include "storage/buffer/read_ahead.h"
+#include "log/log_record.h"
+#include "concurrency/version_store.h"
 #include "page_handle.h"
+#include "table_statistics.h"
 
 namespace wsdb {
 
@@ -41,30 +46,42 @@ public:
   TableHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, table_id_t table_id, TableHeader &hdr,
       RecordSchemaUptr &schema, StorageModel storage_model);
 
+  ~TableHandle();
+
   /**
-   * Get a record by rid
+   * Get a record by rid, as the transaction of the calling thread sees it
    * 1. fetch the page handle by rid
-   * 2. check if there is a record in the slot using bitmap, if not, unpin the page and throw WSDB_RECORD_MISS
-   * 3. read the record from the slot using page handle
-   * 4. unpin the page
+   * 2. read the record from the slot using page handle if the bitmap shows one
+   * 3. unpin the page
+   * 4. if the transaction sees another version of the slot, take the record from the version store instead
+   * 5. if there is no record for the transaction, throw WSDB_RECORD_MISS
    * @param rid
    * @return record
    */
   auto GetRecord(const RID &rid) -> RecordUptr;
 
   /**
-   * Get a chunk in page using record schema indicating which columns should be loaded
+   * Get a chunk in page using record schema indicating which columns should be loaded, the scans below read the
+   * page as the transaction of the calling thread sees it
    * @param pid
    * @param chunk_schema
    * @return
    */
   auto GetChunk(page_id_t pid, const RecordSchema *chunk_schema) -> ChunkUptr;
 
+  /**
+   * Copy raw columns of a page into the batch, only available in pax model
+   * @param pid
+   * @param field_idx indexes of the requested fields in the table schema
+   * @param batch
+   */
+  void GetColumnBatch(page_id_t pid, const std::vector<size_t> &field_idx, ColumnBatch &batch);
+
   /**
    * Insert a record into the table
    * 1. create a page handle using CreatePageHandle
-   * 2. get an empty slot in the page
-   * 3. write the record into the slot
+   * 2. get an empty slot in the page without older versions, create a new page if there is none
+   * 3. record the write in the version store and write the record into the slot
    * 4. update the bitmap and the number of records in the page header
    * 5. if the page is full after inserting the record, update the first free page id in the file header and set the
    * next page id of the current page
@@ -84,27 +101,65 @@ public:
    */
   void InsertRecord(const RID &rid, const Record &record);
 
+  /**
+   * Insert a batch of records, each page is filled up before moving to the next one, so the page is pinned, searched
+   * and unpinned once per page instead of once per record
+   * 1. create a page handle using CreatePageHandle
+   * 2. write records into the empty slots of the page in order and update the bitmap
+   * 3. if the page is full, update the first free page id in the file header and set the next page id of the page
+   * 4. unpin the page and repeat until all records are written
+   * @param records rids of the inserted records are set in place
+   */
+  void InsertRecords(const std::vector<RecordUptr> &records);
+
   /**
    * Delete the record by rid
-   * 1. if the slot is empty, unpin the page and throw WSDB_RECORD_MISS
-   * 2. update the bitmap and the number of records in the page header
-   * 3. if the page is not full after deleting the record, update the first free page id in the file header and the next
-   * page id in the page header
-   * 4. unpin the page
+   * 1. if the slot is empty, unpin the page and throw WSDB_RECORD_MISS, or WSDB_TXN_ABORTED if the record was deleted
+   * by a transaction the calling one does not see
+   * 2. record the write in the version store, throw WSDB_TXN_ABORTED if another transaction has changed the slot
+   * 3. update the bitmap and the number of records in the page header
+   * 4. if the page was full before deleting the record, push it to the front of the free page list
+   * 5. unpin the page
    * @param rid
    */
   void DeleteRecord(const RID &rid);
 
   /**
    * Update the record by rid
-   * 1. if the slot is empty, unpin the page and throw WSDB_RECORD_MISS
-   * 2. write slot
-   * 3. unpin the page
+   * 1. if the slot is empty, unpin the page and throw WSDB_RECORD_MISS or WSDB_TXN_ABORTED as in DeleteRecord
+   * 2. record the write in the version store, throw WSDB_TXN_ABORTED if another transaction has changed the slot
+   * 3. write slot
+   * 4. unpin the page
    * @param rid
    * @param record
    */
   void UpdateRecord(const RID &rid, const Record &record);
 
+  /**
+   * Bring a slot to the image of a log record during recovery, the page is left alone if its lsn shows that the
+   * record is already applied. The table header is not touched so that pages can be recovered in parallel
+   * 1. fetch the page, if its lsn is not less than lsn, unpin it and return
+   * 2. if slot id is INVALID_SLOT_ID, the page is created by the record, clear it
+   * 3. if the image is empty, clear the bit of the slot, otherwise write the image into the slot and set the bit
+   * 4. set the lsn of the page and unpin it
+   * @param page_id
+   * @param slot_id
+   * @param image null map followed by the data, see LogRecord
+   * @param lsn lsn of the record
+   * @return whether the page is changed
+   */
+  auto RecoverSlot(page_id_t page_id, slot_id_t slot_id, const std::string &image, lsn_t lsn) -> bool;
+
+  /**
+   * Rebuild the table header from the pages after recovery, the header on disk is only written when the table is
+   * closed and may be stale after a crash
+   * 1. extend the number of pages to page num if the log shows more pages than the header
+   * 2. count the records in the bitmaps
+   * 3. link the pages that are not full into the free page list in page id order
+   * @param page_num
+   */
+  void RebuildHeader(size_t page_num);
+
   [[nodiscard]] auto GetTableId() const -> table_id_t;
 
   [[nodiscard]] auto GetTableHeader() const -> const TableHeader &;
@@ -115,12 +170,25 @@ public:
 
   [[nodiscard]] auto GetStorageModel() const -> StorageModel;
 
+  [[nodiscard]] auto GetVersionStore() const -> VersionStore *;
+
   [[nodiscard]] auto GetFirstRID() -> RID;
 
   [[nodiscard]] auto GetNextRID(const RID &rid) -> RID;
 
   [[nodiscard]] auto HasField(const std::string &field_name) const -> bool;
 
+  /**
+   * Collect the statistics of the records the transaction of the calling thread sees, the optimizer estimates the
+   * plans on the table with them from then on
+   */
+  void Analyze();
+
+  /// statistics of the last analysis, nullptr if the table has never been analyzed
+  [[nodiscard]] auto GetStatistics() const -> std::shared_ptr<const TableStatistics>;
+
+  void SetStatistics(std::shared_ptr<const TableStatistics> stats);
+
 private:
   /**
    * Fetch the page handle by page id
@@ -129,6 +197,14 @@ private:
    */
   auto FetchPageHandle(page_id_t page_id) -> PageHandleUptr;
 
+  /**
+   * Read a page as the transaction of the calling thread sees it. read is run on the pinned page first, if some slots
+   * of the page have version chains it is run again on a copy of the page holding the versions the transaction sees.
+   * Writers record a slot in the version store before they change it, so checking the store after the read covers
+   * every change the first read may have caught halfway
+   */
+  void ReadVisiblePage(page_id_t page_id, const std::function<void(PageHandle &)> &read);
+
   /**
    * Create a page handle that has at least one empty slot
    * @return
@@ -148,6 +224,54 @@ private:
    */
   auto WrapPageHandle(Page *page) -> PageHandleUptr;
 
+  /**
+   * First empty slot from slot id on that has no version chain
+   * @return rec_per_page if there is none
+   */
+  auto FindFreeSlot(PageHandle &page_handle, size_t slot_id) -> size_t;
+
+  /// clear the bit of a slot, the page goes back to the free page list if it was full
+  void ReleaseSlot(PageHandle &page_handle, slot_id_t slot_id);
+
+  /// take a page that has become full out of the free page list
+  void UnlinkFreePage(Page *page);
+
+  /**
+   * Lock the row in X mode for the transaction of the calling thread, or the table in IX mode if rid is INVALID_RID as
+   * new rows are not visible to others before the commit anyway. Readers take no locks, they read their snapshot
+   */
+  void LockForWrite(const RID &rid);
+
+  /**
+   * Record a write of the transaction of the calling thread in the version store before the slot is changed, the page
+   * is unpinned and WSDB_TXN_ABORTED is thrown if it conflicts with another transaction
+   */
+  void BeginWrite(const RID &rid, std::string before);
+
+  /// throw WSDB_TXN_ABORTED if the transaction of the calling thread can not change the slot
+  void CheckConflict(const RID &rid);
+
+  /**
+   * Bring a slot back to the image it had before the write and log a compensation record for the transaction, called
+   * by the version store when the transaction is rolled back
+   */
+  void UndoWrite(Transaction *txn, const WriteRecord &write);
+
+  /**
+   * Image of a record in the log, the null map followed by the data
+   */
+  auto MakeImage(const char *null_map, const char *data) const -> std::string;
+
+  auto ReadImage(PageHandle &page_handle, slot_id_t slot_id) const -> std::string;
+
+  /**
+   * Log the change of the pinned page for the transaction and set the lsn of the page, nothing is logged if there is
+   * no log manager or no transaction
+   * @param undo_next_lsn for CLR only, the next record of the transaction to undo
+   */
+  void AppendLog(Transaction *txn, LogType type, Page *page, slot_id_t slot_id, std::string before, std::string after,
+      lsn_t undo_next_lsn = INVALID_LSN);
+
 private:
   TableHeader tab_hdr_;
   table_id_t  table_id_;
@@ -158,6 +282,16 @@ private:
   RecordSchemaUptr schema_;
   StorageModel     storage_model_;
 
+  // prefetches pages in front of sequential scans
+  ReadAhead read_ahead_;
+
+  // older versions of the records for snapshot reads, shared with the write sets of running transactions
+  std::shared_ptr<VersionStore> versions_;
+
+  // replaced as a whole by ANALYZE while plans may still be estimated with the old statistics
+  mutable std::mutex                     stats_latch_;
+  std::shared_ptr<const TableStatistics> stats_;
+
   /// field below is available when storage model is pax
   // field offsets is the offset of each field stored in page
   // pax model is stored like below, field_offset can be calculated by Record Schema
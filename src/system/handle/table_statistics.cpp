@@ -0,0 +1,279 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "table_statistics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace wsdb {
+
+template <typename T>
+static void Put(std::string &buf, T value)
+{
+  buf.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static auto Get(const char *&pos, const char *end, T &value) -> bool
+{
+  if (static_cast<size_t>(end - pos) < sizeof(T)) {
+    return false;
+  }
+  memcpy(&value, pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+auto TableStatistics::Selectivity(size_t col, CompOp op, const Value &value) const -> double
+{
+  if (col >= columns_.size() || rec_num_ == 0 || op == OP_IN || op == OP_RNG) {
+    return -1;
+  }
+  const auto &stats = columns_[col];
+  if ((stats.type_ == TYPE_STRING) != (value.GetType() == TYPE_STRING)) {
+    return -1;
+  }
+  // the placeholders of a prepared statement are planned as nulls, their values are not known yet
+  if (value.IsNull()) {
+    return -1;
+  }
+  double non_null = static_cast<double>(rec_num_ - stats.null_num_) / static_cast<double>(rec_num_);
+  if (stats.ndv_ == 0) {
+    return 0;
+  }
+  auto key = ToKey(ValueRef::FromValue(value));
+  switch (op) {
+    case OP_EQ: return key < stats.min_ || key > stats.max_ ? 0 : non_null / static_cast<double>(stats.ndv_);
+    case OP_NE: return non_null * (1 - 1.0 / static_cast<double>(stats.ndv_));
+    case OP_LT:
+    case OP_LE: return non_null * FractionLE(stats, key);
+    case OP_GT:
+    case OP_GE: return non_null * (1 - FractionLE(stats, key));
+    default: return -1;
+  }
+}
+
+auto TableStatistics::ToKey(const ValueRef &value) -> double
+{
+  switch (value.GetType()) {
+    case FieldType::TYPE_BOOL: return value.GetBool() ? 1 : 0;
+    case FieldType::TYPE_INT: return value.GetInt();
+    case FieldType::TYPE_FLOAT: return value.GetFloat();
+    case FieldType::TYPE_STRING: {
+      // the prefix read as a big-endian number keeps the order of the strings and fits into the mantissa
+      auto     str = value.GetString();
+      uint64_t key = 0;
+      for (size_t i = 0; i < STATS_KEY_PREFIX; ++i) {
+        key = key << 8 | (i < str.size() ? static_cast<uint8_t>(str[i]) : 0);
+      }
+      return static_cast<double>(key);
+    }
+    default: return 0;
+  }
+}
+
+void TableStatistics::SerializeTo(std::string &buf) const
+{
+  Put(buf, static_cast<uint64_t>(rec_num_));
+  Put(buf, static_cast<uint64_t>(columns_.size()));
+  for (const auto &col : columns_) {
+    Put(buf, static_cast<uint32_t>(col.type_));
+    Put(buf, static_cast<uint64_t>(col.ndv_));
+    Put(buf, static_cast<uint64_t>(col.null_num_));
+    Put(buf, col.min_);
+    Put(buf, col.max_);
+    Put(buf, static_cast<uint64_t>(col.bounds_.size()));
+    for (auto bound : col.bounds_) {
+      Put(buf, bound);
+    }
+  }
+}
+
+auto TableStatistics::DeserializeFrom(const std::string &data, size_t col_num) -> bool
+{
+  const char *pos = data.data();
+  const char *end = data.data() + data.size();
+  uint64_t    rec_num;
+  uint64_t    num;
+  if (!Get(pos, end, rec_num) || !Get(pos, end, num) || num != col_num) {
+    return false;
+  }
+  rec_num_ = rec_num;
+  columns_.assign(col_num, {});
+  for (auto &col : columns_) {
+    uint32_t type;
+    uint64_t ndv;
+    uint64_t null_num;
+    uint64_t bucket_num;
+    if (!Get(pos, end, type) || !Get(pos, end, ndv) || !Get(pos, end, null_num) || !Get(pos, end, col.min_) ||
+        !Get(pos, end, col.max_) || !Get(pos, end, bucket_num) || bucket_num > STATS_HISTOGRAM_BUCKETS) {
+      return false;
+    }
+    col.type_     = static_cast<FieldType>(type);
+    col.ndv_      = ndv;
+    col.null_num_ = null_num;
+    col.bounds_.resize(bucket_num);
+    for (auto &bound : col.bounds_) {
+      if (!Get(pos, end, bound)) {
+        return false;
+      }
+    }
+  }
+  return pos == end;
+}
+
+auto TableStatistics::FractionLE(const ColumnStatistics &col, double key) -> double
+{
+  if (col.bounds_.empty() || key < col.min_) {
+    return 0;
+  }
+  if (key >= col.max_) {
+    return 1;
+  }
+  // every bucket holds the same share of the values, which are assumed to be spread evenly inside the bucket. A
+  // frequent value ends several buckets, all of them lie below the key
+  auto   it     = std::upper_bound(col.bounds_.begin(), col.bounds_.end(), key);
+  auto   bucket = static_cast<size_t>(it - col.bounds_.begin());
+  if (bucket == col.bounds_.size()) {
+    return 1;
+  }
+  double lo     = bucket == 0 ? col.min_ : col.bounds_[bucket - 1];
+  double hi     = col.bounds_[bucket];
+  double inside = hi > lo ? (key - lo) / (hi - lo) : 0;
+  return (static_cast<double>(bucket) + inside) / static_cast<double>(col.bounds_.size());
+}
+
+void DistinctCounter::Add(size_t hash)
+{
+  if (registers_.empty()) {
+    exact_.insert(hash);
+    if (exact_.size() <= STATS_NDV_EXACT_LIMIT) {
+      return;
+    }
+    registers_.assign(size_t{1} << STATS_NDV_SKETCH_BITS, 0);
+    for (auto h : exact_) {
+      AddToSketch(h);
+    }
+    exact_ = {};
+    return;
+  }
+  AddToSketch(hash);
+}
+
+void DistinctCounter::AddToSketch(uint64_t hash)
+{
+  // std::hash of an integer may be the identity, mix the bits so that both the register and the rank are uniform
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  auto idx  = hash >> (64 - STATS_NDV_SKETCH_BITS);
+  auto rest = hash << STATS_NDV_SKETCH_BITS;
+  auto rank = static_cast<uint8_t>(std::min<int>(std::countl_zero(rest), 64 - STATS_NDV_SKETCH_BITS) + 1);
+  registers_[idx] = std::max(registers_[idx], rank);
+}
+
+auto DistinctCounter::Count() const -> size_t
+{
+  if (registers_.empty()) {
+    return exact_.size();
+  }
+  auto   m     = static_cast<double>(registers_.size());
+  double sum   = 0;
+  size_t zeros = 0;
+  for (auto reg : registers_) {
+    sum += std::ldexp(1.0, -reg);
+    zeros += reg == 0 ? 1 : 0;
+  }
+  double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+  // linear counting is more accurate while many registers are still empty
+  if (estimate <= 2.5 * m && zeros > 0) {
+    estimate = m * std::log(m / static_cast<double>(zeros));
+  }
+  return static_cast<size_t>(std::llround(estimate));
+}
+
+StatisticsCollector::StatisticsCollector(const RecordSchema *schema)
+    : schema_(schema),
+      null_num_(schema->GetFieldCount(), 0),
+      min_(schema->GetFieldCount(), 0),
+      max_(schema->GetFieldCount(), 0),
+      samples_(schema->GetFieldCount()),
+      distinct_(schema->GetFieldCount())
+{}
+
+void StatisticsCollector::Add(const Record &record)
+{
+  rec_num_++;
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    auto value = record.GetValueRefAt(i);
+    if (value.IsNull()) {
+      null_num_[i]++;
+      continue;
+    }
+    auto key  = TableStatistics::ToKey(value);
+    auto seen = rec_num_ - null_num_[i];
+    min_[i]   = seen == 1 ? key : std::min(min_[i], key);
+    max_[i]   = seen == 1 ? key : std::max(max_[i], key);
+    // reservoir sampling, the value replaces a random one of the sample with probability STATS_SAMPLE_SIZE / seen
+    if (samples_[i].size() < STATS_SAMPLE_SIZE) {
+      samples_[i].push_back(key);
+    } else if (auto pos = std::uniform_int_distribution<size_t>(0, seen - 1)(rng_); pos < STATS_SAMPLE_SIZE) {
+      samples_[i][pos] = key;
+    }
+    distinct_[i].Add(value.GetType() == FieldType::TYPE_STRING ? std::hash<std::string_view>()(value.GetString())
+                                                               : std::hash<double>()(key));
+  }
+}
+
+auto StatisticsCollector::Build() -> std::shared_ptr<TableStatistics>
+{
+  auto stats      = std::make_shared<TableStatistics>();
+  stats->rec_num_ = rec_num_;
+  stats->columns_.resize(schema_->GetFieldCount());
+  for (size_t i = 0; i < schema_->GetFieldCount(); ++i) {
+    auto &col     = stats->columns_[i];
+    auto &keys    = samples_[i];
+    col.type_     = schema_->GetFieldAt(i).field_.field_type_;
+    col.null_num_ = null_num_[i];
+    if (keys.empty()) {
+      continue;
+    }
+    // a sketch may overshoot, a column never has more distinct values than it has values
+    col.ndv_ = std::min(distinct_[i].Count(), rec_num_ - null_num_[i]);
+    col.min_ = min_[i];
+    col.max_ = max_[i];
+    std::sort(keys.begin(), keys.end());
+    // bucket b ends at the key of rank (b + 1) * n / buckets, so buckets differ by at most one value in depth
+    auto bucket_num = std::min(STATS_HISTOGRAM_BUCKETS, keys.size());
+    col.bounds_.reserve(bucket_num);
+    for (size_t b = 0; b < bucket_num; ++b) {
+      col.bounds_.push_back(keys[(b + 1) * keys.size() / bucket_num - 1]);
+    }
+    // the sample may miss the largest value
+    col.bounds_.back() = col.max_;
+    keys.clear();
+    keys.shrink_to_fit();
+  }
+  return stats;
+}
+
+}  // namespace wsdb
@@ -0,0 +1,127 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#ifndef WSDB_TABLE_STATISTICS_H
+#define WSDB_TABLE_STATISTICS_H
+
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "common/config.h"
+#include "common/value.h"
+#include "record_handle.h"
+
+namespace wsdb {
+
+/**
+ * Statistics of a column, values are ordered through ToKey so that strings get a range and a histogram as well
+ */
+struct ColumnStatistics
+{
+  FieldType type_{TYPE_NULL};
+  size_t    ndv_{0};       // number of distinct non-null values
+  size_t    null_num_{0};  // number of nulls
+  double    min_{0};
+  double    max_{0};
+  // equi-depth histogram, bucket i holds about the same number of non-null values in (bounds_[i - 1], bounds_[i]],
+  // the first bucket starts at min_ and the last one ends at max_
+  std::vector<double> bounds_;
+};
+
+/**
+ * Statistics of a table collected by ANALYZE, the optimizer estimates the rows a plan produces from them. They are a
+ * snapshot of the table at the time of the analysis, so selectivities are applied to the current number of records
+ */
+class TableStatistics
+{
+public:
+  TableStatistics() = default;
+
+  /**
+   * Fraction of the rows of the table for which "column op value" holds
+   * @param col index of the column in the table schema
+   * @param op
+   * @param value
+   * @return negative if the statistics can not tell, e.g. for IN, for values of another type or for null
+   */
+  [[nodiscard]] auto Selectivity(size_t col, CompOp op, const Value &value) const -> double;
+
+  /// position of a value in the order of its column, strings are ordered by their first STATS_KEY_PREFIX bytes
+  static auto ToKey(const ValueRef &value) -> double;
+
+  void SerializeTo(std::string &buf) const;
+
+  /// @return false if data does not hold statistics of a table with col_num columns
+  auto DeserializeFrom(const std::string &data, size_t col_num) -> bool;
+
+public:
+  size_t                        rec_num_{0};  // number of records at the time of the analysis
+  std::vector<ColumnStatistics> columns_;
+
+private:
+  /// fraction of the non-null values of the column not greater than key
+  static auto FractionLE(const ColumnStatistics &col, double key) -> double;
+};
+
+/**
+ * Counts the distinct hashes it is given, exactly while there are at most STATS_NDV_EXACT_LIMIT of them and with a
+ * HyperLogLog sketch after that, the error of the estimate is about 1.04 / sqrt(2^STATS_NDV_SKETCH_BITS)
+ */
+class DistinctCounter
+{
+public:
+  void Add(size_t hash);
+
+  [[nodiscard]] auto Count() const -> size_t;
+
+private:
+  void AddToSketch(uint64_t hash);
+
+private:
+  std::unordered_set<size_t> exact_;
+  std::vector<uint8_t>       registers_;  // empty while the count is exact
+};
+
+/**
+ * Builds the statistics of a table from its records in one pass. Min and max are tracked exactly, the histograms come
+ * from a reservoir sample of every column, so the memory is bounded whatever the size of the table
+ */
+class StatisticsCollector
+{
+public:
+  explicit StatisticsCollector(const RecordSchema *schema);
+
+  void Add(const Record &record);
+
+  auto Build() -> std::shared_ptr<TableStatistics>;
+
+private:
+  const RecordSchema              *schema_;
+  size_t                           rec_num_{0};
+  std::vector<size_t>              null_num_;
+  std::vector<double>              min_;
+  std::vector<double>              max_;
+  std::vector<std::vector<double>> samples_;   // at most STATS_SAMPLE_SIZE keys of every column
+  std::vector<DistinctCounter>     distinct_;  // hashes of the values
+  std::mt19937_64                  rng_;       // fixed seed, the same table always gets the same statistics
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_TABLE_STATISTICS_H
@@ -20,26 +20,82 @@
 //
 
 #include "index_manager.h"
+#include "common/meta.h"
 
 namespace wsdb {
 void IndexManager::CreateIndex(const std::string &db_name, const std::string &index_name,
-    const wsdb::RecordSchema &schema, wsdb::IndexType index_type)
+    const std::string &table_name, const wsdb::RecordSchema &schema, IndexType index_type)
 {
-  WSDB_THROW(WSDB_NOT_IMPLEMENTED, "");
+  // 1. create and open index file
+  DiskManager::CreateFile(FILE_NAME(db_name, index_name, IDX_SUFFIX));
+  auto index_file = disk_manager_->OpenFile(FILE_NAME(db_name, index_name, IDX_SUFFIX));
+  // 2. write index header, table name and key fields to the zero page
+  // field_name1:field_type1:field_size1:field_name2:field_type2:field_size2:...
+  IndexHeader header;
+  header.field_num_    = schema.GetFieldCount();
+  header.tab_name_len_ = table_name.size();
+  disk_manager_->WriteFile(index_file, reinterpret_cast<const char *>(&header), sizeof(IndexHeader), SEEK_SET);
+  disk_manager_->WriteFile(index_file, table_name.c_str(), table_name.size(), SEEK_CUR);
+  for (size_t i = 0; i < schema.GetFieldCount(); ++i) {
+    const FieldSchema &field = schema.GetFieldAt(i).field_;
+    disk_manager_->WriteFile(index_file, field.field_name_.c_str(), field.field_name_.size() + 1, SEEK_CUR);
+    disk_manager_->WriteFile(index_file, reinterpret_cast<const char *>(&field.field_type_), sizeof(FieldType), SEEK_CUR);
+    disk_manager_->WriteFile(index_file, reinterpret_cast<const char *>(&field.field_size_), sizeof(size_t), SEEK_CUR);
+  }
+  // 3. leave a zeroed page for the meta information of the index
+  std::vector<char> empty_page(PAGE_SIZE, 0);
+  disk_manager_->WritePage(index_file, FILE_HEADER_PAGE_ID + 1, empty_page.data());
+  // 4. close index file
+  disk_manager_->CloseFile(index_file);
 }
 
 void IndexManager::DropIndex(const std::string &db_name, const std::string &index_name)
 {
-  WSDB_THROW(WSDB_NOT_IMPLEMENTED, "");
+  DiskManager::DestroyFile(FILE_NAME(db_name, index_name, IDX_SUFFIX));
 }
+
 IndexHandleUptr IndexManager::OpenIndex(const std::string &db_name, const std::string &index_name, IndexType index_type)
 {
-  WSDB_THROW(WSDB_NOT_IMPLEMENTED, "");
+  auto index_file    = disk_manager_->OpenFile(FILE_NAME(db_name, index_name, IDX_SUFFIX));
+  auto file_hdr_data = new char[PAGE_SIZE];
+  disk_manager_->ReadPage(index_file, FILE_HEADER_PAGE_ID, file_hdr_data);
+  IndexHeader header;
+  char       *cursor = file_hdr_data;
+  memcpy(&header, cursor, sizeof(IndexHeader));
+  cursor += sizeof(IndexHeader);
+  std::string table_name(cursor, header.tab_name_len_);
+  cursor += header.tab_name_len_;
+  auto table_id = disk_manager_->GetFileId(FILE_NAME(db_name, table_name, TAB_SUFFIX));
+  if (table_id == INVALID_TABLE_ID) {
+    delete[] file_hdr_data;
+    disk_manager_->CloseFile(index_file);
+    WSDB_THROW(WSDB_TABLE_MISS, table_name);
+  }
+  std::vector<RTField> fields;
+  fields.reserve(header.field_num_);
+  for (size_t i = 0; i < header.field_num_; ++i) {
+    FieldSchema field;
+    field.field_name_ = cursor;
+    cursor += field.field_name_.size() + 1;
+    field.field_type_ = *reinterpret_cast<FieldType *>(cursor);
+    cursor += sizeof(FieldType);
+    field.field_size_ = *reinterpret_cast<size_t *>(cursor);
+    cursor += sizeof(size_t);
+    fields.push_back({.field_ = field});
+  }
+  auto key_schema = std::make_unique<RecordSchema>(fields);
+  key_schema->SetTableId(table_id);
+  delete[] file_hdr_data;
+  return std::make_unique<IndexHandle>(
+      disk_manager_, buffer_pool_manager_, table_id, index_file, std::move(key_schema), index_type);
 }
 
 void IndexManager::CloseIndex(const IndexHandle &index_handle)
 {
-  WSDB_THROW(WSDB_NOT_IMPLEMENTED, "");
+  // the header never changes after creation, the index keeps its meta information in its pages
+  buffer_pool_manager_->FlushAllPages(index_handle.GetIndexId());
+  buffer_pool_manager_->DeleteAllPages(index_handle.GetIndexId());
+  disk_manager_->CloseFile(index_handle.GetIndexId());
 }
 
 }  // namespace wsdb
@@ -35,11 +35,22 @@ public:
 
   ~IndexManager() = default;
 
-  void CreateIndex(
-      const std::string &db_name, const std::string &index_name, const RecordSchema &schema, IndexType index_type);
+  /**
+   * Create the index file, the header page records the indexed table and the key fields
+   * @param db_name
+   * @param index_name
+   * @param table_name
+   * @param schema key fields, each is a field of the table
+   * @param index_type
+   */
+  void CreateIndex(const std::string &db_name, const std::string &index_name, const std::string &table_name,
+      const RecordSchema &schema, IndexType index_type);
 
-  void DropIndex(const std::string &db_name, const std::string &index_name);
+  static void DropIndex(const std::string &db_name, const std::string &index_name);
 
+  /**
+   * Open the index of a table that is already open, key fields are bound to the id of the table
+   */
   IndexHandleUptr OpenIndex(const std::string &db_name, const std::string &index_name, IndexType index_type);
 
   void CloseIndex(const IndexHandle &index_handle);
@@ -0,0 +1,118 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/30.
+//
+
+#include "prepared_statement.h"
+
+namespace wsdb {
+
+PreparedStatement::PreparedStatement(
+    std::shared_ptr<ast::TreeNode> ast, std::vector<std::shared_ptr<ast::ParamLit>> params)
+    : ast_(std::move(ast)), params_(std::move(params))
+{}
+
+auto PreparedStatement::IsPreparable(const std::shared_ptr<ast::TreeNode> &ast) -> bool
+{
+  return std::dynamic_pointer_cast<ast::SelectStmt>(ast) != nullptr ||
+         std::dynamic_pointer_cast<ast::InsertStmt>(ast) != nullptr ||
+         std::dynamic_pointer_cast<ast::UpdateStmt>(ast) != nullptr ||
+         std::dynamic_pointer_cast<ast::DeleteStmt>(ast) != nullptr;
+}
+
+void PreparedStatement::SetPlan(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db)
+{
+  std::vector<std::string> tables;
+  CollectTables(plan, tables);
+  tables_.clear();
+  for (auto &tab : tables) {
+    auto version = db->GetSchemaVersion(tab);
+    tables_.emplace_back(std::move(tab), version);
+  }
+  plan_ = std::move(plan);
+  db_   = db;
+}
+
+auto PreparedStatement::IsStale(DatabaseHandle *db) const -> bool
+{
+  if (plan_ == nullptr || db != db_) {
+    return true;
+  }
+  return std::any_of(tables_.begin(), tables_.end(), [db](const auto &tab) {
+    return db->GetSchemaVersion(tab.first) != tab.second;
+  });
+}
+
+void PreparedStatement::Bind(const std::vector<ValueSptr> &values)
+{
+  if (values.size() != params_.size()) {
+    WSDB_THROW(WSDB_INVALID_SQL, fmt::format("expect {} parameters, got {}", params_.size(), values.size()));
+  }
+  for (size_t i = 0; i < params_.size(); ++i) {
+    auto &slot = params_[i]->slot_;
+    WSDB_ASSERT(slot != nullptr, fmt::format("parameter {} is not planned", i));
+    auto value = ValueFactory::CastTo(values[i], slot->GetType());
+    // the slot is shared by the plan nodes, so it is overwritten instead of replaced
+    switch (slot->GetType()) {
+      case TYPE_INT: *std::static_pointer_cast<IntValue>(slot) = *std::static_pointer_cast<IntValue>(value); break;
+      case TYPE_FLOAT:
+        *std::static_pointer_cast<FloatValue>(slot) = *std::static_pointer_cast<FloatValue>(value);
+        break;
+      case TYPE_BOOL: *std::static_pointer_cast<BoolValue>(slot) = *std::static_pointer_cast<BoolValue>(value); break;
+      case TYPE_STRING:
+        *std::static_pointer_cast<StringValue>(slot) = *std::static_pointer_cast<StringValue>(value);
+        break;
+      default: WSDB_THROW(WSDB_UNSUPPORTED_OP, fmt::format("parameter of type {}", FieldTypeToString(slot->GetType())));
+    }
+  }
+}
+
+void PreparedStatement::CollectTables(const std::shared_ptr<AbstractPlan> &plan, std::vector<std::string> &tables)
+{
+  if (const auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+    tables.push_back(scan->table_name_);
+  } else if (const auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
+    tables.push_back(idx_scan->table_name_);
+  } else if (const auto insert = std::dynamic_pointer_cast<InsertPlan>(plan)) {
+    tables.push_back(insert->table_name_);
+  } else if (const auto update = std::dynamic_pointer_cast<UpdatePlan>(plan)) {
+    tables.push_back(update->table_name_);
+    CollectTables(update->child_, tables);
+  } else if (const auto del = std::dynamic_pointer_cast<DeletePlan>(plan)) {
+    tables.push_back(del->table_name_);
+    CollectTables(del->child_, tables);
+  } else if (const auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+    CollectTables(filter->child_, tables);
+  } else if (const auto sort = std::dynamic_pointer_cast<SortPlan>(plan)) {
+    CollectTables(sort->child_, tables);
+  } else if (const auto top_n = std::dynamic_pointer_cast<TopNPlan>(plan)) {
+    CollectTables(top_n->child_, tables);
+  } else if (const auto proj = std::dynamic_pointer_cast<ProjectPlan>(plan)) {
+    CollectTables(proj->child_, tables);
+  } else if (const auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+    CollectTables(join->left_, tables);
+    CollectTables(join->right_, tables);
+  } else if (const auto agg = std::dynamic_pointer_cast<AggregatePlan>(plan)) {
+    CollectTables(agg->child_, tables);
+  } else if (const auto lim = std::dynamic_pointer_cast<LimitPlan>(plan)) {
+    CollectTables(lim->child_, tables);
+  }
+}
+
+}  // namespace wsdb
@@ -0,0 +1,74 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/30.
+//
+
+/**
+ * @brief A statement parsed, planned and optimized once and executed many times. The placeholders of the statement
+ * are values shared by every node of the plan that uses them, so binding a parameter sets the value in place and the
+ * plan only has to be translated before each execution. The plan is made again when a table it uses is created,
+ * dropped or gets an index
+ */
+
+#ifndef WSDB_PREPARED_STATEMENT_H
+#define WSDB_PREPARED_STATEMENT_H
+
+#include "parser/ast.h"
+#include "plan/plan.h"
+#include "handle/database_handle.h"
+
+namespace wsdb {
+
+class PreparedStatement
+{
+public:
+  PreparedStatement(std::shared_ptr<ast::TreeNode> ast, std::vector<std::shared_ptr<ast::ParamLit>> params);
+
+  /// only queries and dml statements are prepared, other statements do not benefit from a cached plan
+  static auto IsPreparable(const std::shared_ptr<ast::TreeNode> &ast) -> bool;
+
+  [[nodiscard]] auto GetAST() const -> const std::shared_ptr<ast::TreeNode> & { return ast_; }
+
+  [[nodiscard]] auto GetParamCount() const -> size_t { return params_.size(); }
+
+  [[nodiscard]] auto GetPlan() const -> const std::shared_ptr<AbstractPlan> & { return plan_; }
+
+  /// keep the optimized plan made for db, remembering the versions of the tables it uses
+  void SetPlan(std::shared_ptr<AbstractPlan> plan, DatabaseHandle *db);
+
+  /// whether the plan has to be made again before running on db
+  auto IsStale(DatabaseHandle *db) const -> bool;
+
+  /// set the placeholders to the values, numbers are cast to the type the placeholder expects
+  void Bind(const std::vector<ValueSptr> &values);
+
+private:
+  static void CollectTables(const std::shared_ptr<AbstractPlan> &plan, std::vector<std::string> &tables);
+
+  std::shared_ptr<ast::TreeNode>              ast_;
+  std::vector<std::shared_ptr<ast::ParamLit>> params_;
+  std::shared_ptr<AbstractPlan>               plan_;
+  DatabaseHandle                             *db_{nullptr};
+  // tables used by the plan and their schema versions when it was made
+  std::vector<std::pair<std::string, uint64_t>> tables_;
+};
+
+}  // namespace wsdb
+
+#endif  // WSDB_PREPARED_STATEMENT_H
@@ -49,8 +49,12 @@ void SystemManager::Init()
   planner_             = std::make_unique<Planner>();
   executor_            = std::make_unique<Executor>();
   optimizer_           = std::make_unique<Optimizer>();
-  txn_manager_         = std::make_unique<TxnManager>(log_manager_.get());
+  lock_manager_        = std::make_unique<LockManager>();
+  txn_manager_         = std::make_unique<TxnManager>(log_manager_.get(), lock_manager_.get());
   net_controller_      = std::make_unique<NetController>();
+  buffer_pool_manager_->StartCleaner();
+  txn_manager_->StartGarbageCollector();
+  lock_manager_->StartDeadlockDetector();
 
   // first check TMP_DIR
   if (!std::filesystem::exists(TMP_DIR)) {
@@ -87,12 +91,52 @@ void SystemManager::DropDatabase(const std::string &db_name) { WSDB_THROW(WSDB_N
 
 void SystemManager::Recover()
 {
+  // a transaction may have changed several databases, it is aborted once all of them are rolled back
+  recovery_->AnalyzeLog();
   for (auto &db : databases_) {
     recovery_->SetDBHandle(db.second.get());
-    recovery_->AnalyzeLog();
     recovery_->Redo();
     recovery_->Undo();
   }
+  recovery_->AbortLosers();
+  // the log in front of the restart is not needed by the next one
+  Checkpoint();
+}
+
+void SystemManager::Checkpoint()
+{
+  auto meta_lsn = log_manager_->GetNextLsn();
+  for (auto &db : databases_) {
+    db.second->FlushTableHeaders();
+  }
+  recovery_->Checkpoint(meta_lsn);
+}
+
+void SystemManager::CheckpointLoop()
+{
+  std::unique_lock<std::mutex> lock(checkpointer_latch_);
+  while (!checkpointer_cv_.wait_for(
+      lock, std::chrono::milliseconds(CHECKPOINT_INTERVAL_MS), [this] { return stop_checkpointer_; })) {
+    lock.unlock();
+    try {
+      Checkpoint();
+    } catch (WSDBException_ &e) {
+      WSDB_LOG_ERROR(e.what());
+    }
+    lock.lock();
+  }
+}
+
+void SystemManager::StopCheckpointer()
+{
+  {
+    std::lock_guard<std::mutex> guard(checkpointer_latch_);
+    stop_checkpointer_ = true;
+    checkpointer_cv_.notify_all();
+  }
+  if (checkpointer_.joinable()) {
+    checkpointer_.join();
+  }
 }
 
 void SystemManager::SIGINTHandler(int sig)
@@ -100,6 +144,9 @@ void SystemManager::SIGINTHandler(int sig)
   // flush all the logs into disk
   WSDB_LOG("Received SIGINT signal, exiting the system...");
   is_running_ = false;
+  StopCheckpointer();
+  txn_manager_->StopGarbageCollector();
+  lock_manager_->StopDeadlockDetector();
   log_manager_->FlushLog();
   WSDB_LOG("Log flushed successfully.");
   net_controller_->Close();
@@ -107,6 +154,8 @@ void SystemManager::SIGINTHandler(int sig)
   for (auto &db : databases_) {
     db.second->Close();
   }
+  // every page is written, the next start has nothing to recover
+  Checkpoint();
 }
 
 void SystemManager::Run()
@@ -118,23 +167,49 @@ void SystemManager::Run()
   signal(SIGKILL, sig_func);
   // recover the system
   Recover();
+  checkpointer_ = std::thread(&SystemManager::CheckpointLoop, this);
   // start the server
   if (net_controller_->Listen() < 0) {
     WSDB_LOG("ERROR on init server socket");
     return;
   }
   WSDB_LOG("Server listening on port " + std::to_string(net::SERVER_PORT));
+  auto worker_num = SERVER_WORKER_NUM == 0 ? std::max(1u, std::thread::hardware_concurrency()) : SERVER_WORKER_NUM;
+  for (size_t i = 0; i < worker_num; ++i) {
+    workers_.emplace_back(&SystemManager::WorkerLoop, this);
+  }
+  std::vector<int> ready_fds;
   while (is_running_) {
-    auto client_sock = net_controller_->Accept();
-    if (client_sock < 0) {
-      WSDB_LOG("ERROR on accept");
+    if (net_controller_->Wait(ready_fds, SERVER_POLL_INTERVAL_MS) < 0) {
+      WSDB_LOG("ERROR on wait");
       continue;
     }
-    // create a new thread to handle the client
-    std::thread([client_sock]() {
-      SystemManager::GetInstance()->ClientHandler(client_sock);
-      close(client_sock);
-    }).detach();
+    if (ready_fds.empty()) {
+      continue;
+    }
+    std::unique_lock lock(worker_latch_);
+    for (auto fd : ready_fds) {
+      auto &session = sessions_[fd];
+      if (session == nullptr) {
+        WSDB_LOG(fmt::format("Client {} connected", fd));
+        session = std::make_unique<ClientSession>(this, fd);
+      }
+      ready_clients_.push_back(fd);
+    }
+    worker_cv_.notify_all();
+  }
+  // let the workers finish the statements they are running
+  {
+    std::unique_lock lock(worker_latch_);
+    stop_workers_ = true;
+    worker_cv_.notify_all();
+  }
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  StopCheckpointer();
+  while (!sessions_.empty()) {
+    CloseClient(sessions_.begin()->first);
   }
   // close the server
   net_controller_->Close();
@@ -143,27 +218,89 @@ void SystemManager::Run()
   // exit the system
   WSDB_LOG("Bye!");
 }
-void SystemManager::ClientHandler(int client_fd)
+
+void SystemManager::WorkerLoop()
+{
+  std::unique_lock lock(worker_latch_);
+  while (true) {
+    worker_cv_.wait(lock, [this] { return stop_workers_ || !ready_clients_.empty(); });
+    if (stop_workers_) {
+      return;
+    }
+    auto fd = ready_clients_.front();
+    ready_clients_.pop_front();
+    // the session is only erased by the worker serving it
+    auto &session = *sessions_[fd];
+    lock.unlock();
+    // statements of a session only run with its own transaction, prepare and close-stmt run without any
+    TxnManager::ClearTransaction();
+    auto keep = ClientHandler(session);
+    // the transaction of the session is freed when the session is closed, possibly by another worker
+    TxnManager::ClearTransaction();
+    if (keep) {
+      net_controller_->Rearm(fd);
+    } else {
+      CloseClient(fd);
+    }
+    lock.lock();
+  }
+}
+
+void SystemManager::CloseClient(int client_fd)
+{
+  std::unique_ptr<ClientSession> session;
+  {
+    std::unique_lock lock(worker_latch_);
+    auto             it = sessions_.find(client_fd);
+    if (it == sessions_.end()) {
+      return;
+    }
+    session = std::move(it->second);
+    sessions_.erase(it);
+  }
+  net_controller_->Remove(client_fd);
+  // the changes of an unfinished transaction are rolled back and its locks released while its tables are still open
+  txn_manager_->Abort(session->txn_.GetTxnId());
+  if (session->context_.db_ != nullptr) {
+    session->context_.db_->Close();
+  }
+  // the fd may be reused by a new connection from now on
+  close(client_fd);
+}
+
+auto SystemManager::ClientHandler(ClientSession &session) -> bool
 {
-  // handle the client
   // 1. read the request
   // 2. parse the request
   // 3. execute the request
   // 4. send the response
-  // 5. close the connection
-  WSDB_LOG(fmt::format("Client {} connected", client_fd));
-  // 1. read the request
-  Transaction txn{};
-  Context     context(&txn, log_manager_.get(), nullptr, net_controller_.get(), client_fd);
-  while (is_running_) {
-    try {
-      auto sql = net_controller_->ReadSQL(client_fd);
+  auto  client_fd = session.context_.client_fd_;
+  auto &txn       = session.txn_;
+  auto &context   = session.context_;
+  try {
+    auto req = net_controller_->ReadRequest(client_fd);
+    if (req.type_ == net::NET_PKG_PREPARE) {
+      WSDB_LOG(fmt::format("Client {} prepared: {}", client_fd, req.sql_));
+      DoPrepare(session, req.sql_);
+      return is_running_;
+    } else if (req.type_ == net::NET_PKG_CLOSE_STMT) {
+      session.prepared_.erase(req.stmt_id_);
+      net_controller_->SendOK(client_fd);
+      return is_running_;
+    } else if (req.type_ == net::NET_PKG_EXECUTE) {
+      txn_manager_->SetTransaction(&txn);
+      DoExecute(session, req);
+    } else {
+      auto &sql = req.sql_;
+      if (sql.empty()) {
+        return true;
+      }
       WSDB_LOG(fmt::format("Client {} sent: {}", client_fd, sql));
       if (sql == "exit;") {
-        break;
+        return false;
       } else if (sql == "shutdown;") {
         is_running_ = false;
-        break;
+        return false;
       }
       txn_manager_->SetTransaction(&txn);
       auto gm_tree = parser_->Parse(sql);
@@ -176,26 +313,68 @@ void SystemManager::ClientHandler(int client_fd)
         auto exec_tree = executor_->Translate(plan, context.db_);
         executor_->Execute(exec_tree, &context);
       }
-      // commit transaction if this is a single sql statement
-      if (!txn.IsExplicit()) {
-        txn_manager_->Commit(txn.GetTxnId());
-      }
-    } catch (WSDBException_ &e) {
-      if (e.type_ == WSDB_CLIENT_DOWN) {
-        WSDB_LOG(fmt::format("Client {} disconnected", client_fd));
-        break;
-      } else if (e.type_ == WSDB_TXN_ABORTED) {
-        txn_manager_->Abort(txn.GetTxnId());
-      } else {
-        WSDB_LOG_ERROR(e.what());
-        net_controller_->SendError(client_fd, e.short_what());
-      }
     }
-  }  // end of client while loop
-  net_controller_->Remove(client_fd);
-  if (context.db_ != nullptr) {
-    context.db_->Close();
+    // commit transaction if this is a single sql statement
+    if (!txn.IsExplicit()) {
+      txn_manager_->Commit(txn.GetTxnId());
+    }
+  } catch (WSDBException_ &e) {
+    if (e.type_ == WSDB_CLIENT_DOWN) {
+      WSDB_LOG(fmt::format("Client {} disconnected", client_fd));
+      return false;
+    }
+    // a failed single statement leaves no changes behind, a write conflict ends the whole transaction
+    if (e.type_ == WSDB_TXN_ABORTED || !txn.IsExplicit()) {
+      txn_manager_->Abort(txn.GetTxnId());
+    }
+    WSDB_LOG_ERROR(e.what());
+    try {
+      net_controller_->SendError(client_fd, e.short_what());
+    } catch (WSDBException_ &) {
+      return false;
+    }
+  }
+  return is_running_;
+}
+
+void SystemManager::DoPrepare(ClientSession &session, const std::string &sql)
+{
+  std::vector<std::shared_ptr<ast::ParamLit>> params;
+  auto                                        ast = parser_->Parse(sql, params);
+  if (!PreparedStatement::IsPreparable(ast)) {
+    WSDB_THROW(WSDB_UNSUPPORTED_OP, "only select, insert, update and delete can be prepared");
+  }
+  auto stmt = std::make_unique<PreparedStatement>(ast, std::move(params));
+  PlanPrepared(*stmt, &session.context_);
+  auto stmt_id               = session.next_stmt_id_++;
+  auto param_num             = static_cast<uint32_t>(stmt->GetParamCount());
+  session.prepared_[stmt_id] = std::move(stmt);
+  net_controller_->SendPrepared(session.context_.client_fd_, stmt_id, param_num);
+}
+
+void SystemManager::DoExecute(ClientSession &session, const ClientRequest &req)
+{
+  auto it = session.prepared_.find(req.stmt_id_);
+  if (it == session.prepared_.end()) {
+    WSDB_THROW(WSDB_INVALID_SQL, fmt::format("unknown prepared statement {}", req.stmt_id_));
+  }
+  auto &stmt = *it->second;
+  auto *ctx  = &session.context_;
+  if (stmt.IsStale(ctx->db_)) {
+    PlanPrepared(stmt, ctx);
+  }
+  stmt.Bind(req.params_);
+  auto exec_tree = executor_->Translate(stmt.GetPlan(), ctx->db_);
+  executor_->Execute(exec_tree, ctx);
+}
+
+void SystemManager::PlanPrepared(PreparedStatement &stmt, Context *ctx)
+{
+  if (ctx->db_ == nullptr) {
+    WSDB_THROW(WSDB_DB_NOT_OPEN, "");
   }
+  auto plan = planner_->PlanAST(stmt.GetAST(), ctx->db_);
+  stmt.SetPlan(optimizer_->Optimize(plan, ctx->db_), ctx->db_);
 }
 
 bool SystemManager::DoDBPlan(const std::shared_ptr<AbstractPlan> &plan, Context *ctx)
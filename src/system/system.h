@@ -31,6 +31,14 @@
 #include "log/recovery.h"
 #include "concurrency/txn_manager.h"
 #include "handle/database_handle.h"
+#include "context.h"
+#include "prepared_statement.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 namespace wsdb {
 
@@ -61,10 +69,50 @@ private:
 
   void SIGINTHandler(int sig);
 
-  void ClientHandler(int client_fd);
+  /// per connection state kept between the statements of a client, which may be run by different workers
+  struct ClientSession
+  {
+    explicit ClientSession(SystemManager *sys, int client_fd)
+        : context_(&txn_, sys->log_manager_.get(), nullptr, sys->net_controller_.get(), client_fd)
+    {}
+
+    Transaction txn_{};
+    Context     context_;
+    // statements prepared by the client, by the id it executes them with
+    std::unordered_map<uint32_t, std::unique_ptr<PreparedStatement>> prepared_;
+    uint32_t                                                         next_stmt_id_{1};
+  };
+
+  /// take ready clients from the queue and serve one statement of each
+  void WorkerLoop();
+
+  /**
+   * read and run the next statement of the client
+   * @return false if the client left and the connection should be closed
+   */
+  auto ClientHandler(ClientSession &session) -> bool;
+
+  void CloseClient(int client_fd);
+
+  /// parse, plan and optimize a statement with placeholders and keep it in the session
+  void DoPrepare(ClientSession &session, const std::string &sql);
+
+  /// bind the parameters and run the prepared statement, it is planned again if a table it uses has changed
+  void DoExecute(ClientSession &session, const ClientRequest &req);
+
+  /// plan and optimize the statement for the database the session uses
+  void PlanPrepared(PreparedStatement &stmt, Context *ctx);
 
   void Recover();
 
+  /// write the headers of the open tables and take a fuzzy checkpoint, see Recovery::Checkpoint
+  void Checkpoint();
+
+  /// take a checkpoint every CHECKPOINT_INTERVAL_MS until the system stops
+  void CheckpointLoop();
+
+  void StopCheckpointer();
+
 public:
   // The only instance of the SystemManager
   static SystemManager *GetInstance()
@@ -84,10 +132,27 @@ private:
   std::unique_ptr<Planner>           planner_;
   std::unique_ptr<Executor>          executor_;
   std::unique_ptr<Optimizer>         optimizer_;
+  std::unique_ptr<LockManager>       lock_manager_;
   std::unique_ptr<TxnManager>        txn_manager_;
   std::unique_ptr<NetController>     net_controller_;
 
-  bool                  is_running_{false};  // indicates whether the system is running
+  std::atomic<bool> is_running_{false};  // indicates whether the system is running
+
+  // clients are multiplexed by the network loop in Run, a client with input is queued for the workers. a connection
+  // is not watched while queued or served, so a client is served by one worker at a time and goes back to the end of
+  // the queue after each statement
+  std::vector<std::thread>                                workers_;
+  std::mutex                                              worker_latch_;  // protects ready_clients_ and sessions_
+  std::condition_variable                                 worker_cv_;
+  std::deque<int>                                         ready_clients_;
+  std::unordered_map<int, std::unique_ptr<ClientSession>> sessions_;
+  bool                                                    stop_workers_{false};
+
+  // checkpoints bound the part of the log read on restart
+  std::thread             checkpointer_;
+  std::mutex              checkpointer_latch_;
+  std::condition_variable checkpointer_cv_;
+  bool                    stop_checkpointer_{false};
 
   std::unordered_map<std::string, std::unique_ptr<DatabaseHandle>> databases_;
 };
@@ -54,6 +54,9 @@ void TableManager::CreateTable(
 void TableManager::DropTable(const std::string &db_name, const std::string &table_name)
 {
   DiskManager::DestroyFile(FILE_NAME(db_name, table_name, TAB_SUFFIX));
+  if (DiskManager::FileExists(FILE_NAME(db_name, table_name, STAT_SUFFIX))) {
+    DiskManager::DestroyFile(FILE_NAME(db_name, table_name, STAT_SUFFIX));
+  }
 }
 
 TableHandleUptr TableManager::OpenTable(
@@ -83,7 +86,16 @@ TableHandleUptr TableManager::OpenTable(
   }
   schema = std::make_unique<RecordSchema>(fields);
   delete[] file_hdr_data;
-  return std::make_unique<TableHandle>(disk_manager_, buffer_pool_manager_, table_file, header, schema, storage_model);
+  auto table =
+      std::make_unique<TableHandle>(disk_manager_, buffer_pool_manager_, table_file, header, schema, storage_model);
+  // statistics are kept next to the table file, a table that has never been analyzed has none
+  std::string stats_data;
+  disk_manager_->ReadLog(FILE_NAME(db_name, table_name, STAT_SUFFIX), stats_data);
+  auto stats = std::make_shared<TableStatistics>();
+  if (!stats_data.empty() && stats->DeserializeFrom(stats_data, table->GetSchema().GetFieldCount())) {
+    table->SetStatistics(std::move(stats));
+  }
+  return table;
 }
 
 void TableManager::CloseTable(const std::string &db_name, const TableHandle &table_handle)
@@ -98,6 +110,24 @@ void TableManager::CloseTable(const std::string &db_name, const TableHandle &tab
   disk_manager_->CloseFile(table_handle.GetTableId());
 }
 
+void TableManager::FlushTableHeader(const TableHandle &table_handle)
+{
+  // copy the header first, it keeps changing while records are inserted
+  TableHeader header = table_handle.GetTableHeader();
+  WriteTableHeader(table_handle.GetTableId(), header, table_handle.GetSchema());
+}
+
+void TableManager::WriteStatistics(const std::string &db_name, const TableHandle &table_handle)
+{
+  auto stats = table_handle.GetStatistics();
+  if (stats == nullptr) {
+    return;
+  }
+  std::string data;
+  stats->SerializeTo(data);
+  DiskManager::WriteFileAtomic(FILE_NAME(db_name, table_handle.GetTableName(), STAT_SUFFIX), data);
+}
+
 void TableManager::WriteTableHeader(table_id_t tid, const TableHeader &header, const RecordSchema &schema)
 {
   disk_manager_->WriteFile(tid, reinterpret_cast<const char *>(&header), sizeof(TableHeader), SEEK_SET);
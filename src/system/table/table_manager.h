@@ -44,6 +44,19 @@ public:
 
   void CloseTable(const std::string &db_name, const TableHandle &table_handle);
 
+  /**
+   * Write the table header to the zero page while the table stays open, used by checkpoints
+   * @param table_handle
+   */
+  void FlushTableHeader(const TableHandle &table_handle);
+
+  /**
+   * Write the statistics of the table next to the table file, they are read back when the table is opened
+   * @param db_name
+   * @param table_handle
+   */
+  void WriteStatistics(const std::string &db_name, const TableHandle &table_handle);
+
   auto GetTableId(const std::string &db_name, const std::string &table_name) -> table_id_t;
 
 private:
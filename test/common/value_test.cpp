@@ -0,0 +1,107 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/18.
+//
+
+#include "common/value.h"
+#include "system/handle/record_handle.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+auto MakeField(const std::string &name, FieldType type, size_t size) -> RTField
+{
+  RTField f;
+  f.field_.field_name_ = name;
+  f.field_.field_type_ = type;
+  f.field_.field_size_ = size;
+  return f;
+}
+
+// ValueRef should agree with the operators of Value on every pair of values
+TEST(ValueRefTest, MatchesValue)
+{
+  std::vector<ValueSptr> ints{ValueFactory::CreateIntValue(-3),
+      ValueFactory::CreateIntValue(0),
+      ValueFactory::CreateIntValue(7),
+      ValueFactory::CreateNullValue(TYPE_INT)};
+  std::vector<ValueSptr> floats{ValueFactory::CreateFloatValue(-3.5),
+      ValueFactory::CreateFloatValue(0),
+      ValueFactory::CreateFloatValue(7),
+      ValueFactory::CreateNullValue(TYPE_FLOAT)};
+  std::vector<ValueSptr> strs{ValueFactory::CreateStringValue("", 0),
+      ValueFactory::CreateStringValue("ab", 2),
+      ValueFactory::CreateStringValue("abc", 3),
+      ValueFactory::CreateStringValue("b", 1),
+      ValueFactory::CreateNullValue(TYPE_STRING)};
+  std::vector<CompOp> ops{OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE};
+  auto check = [&ops](const std::vector<ValueSptr> &values) {
+    for (const auto &l : values) {
+      for (const auto &r : values) {
+        auto lref = ValueRef::FromValue(*l);
+        auto rref = ValueRef::FromValue(*r);
+        std::vector<bool> expected{*l == *r, *l != *r, *l < *r, *l <= *r, *l > *r, *l >= *r};
+        for (size_t i = 0; i < ops.size(); ++i) {
+          ASSERT_EQ(ValueRef::Eval(ops[i], lref, rref), expected[i]) << l->ToString() << " " << r->ToString();
+        }
+      }
+    }
+  };
+  check(ints);
+  check(floats);
+  check(strs);
+  // int and float are compared as float
+  ASSERT_TRUE(ValueRef::Eval(OP_LT, ValueRef::Int(-4), ValueRef::Float(-3.5)));
+  ASSERT_TRUE(ValueRef::Eval(OP_EQ, ValueRef::Float(7), ValueRef::Int(7)));
+  ASSERT_THROW(ValueRef::Eval(OP_EQ, ValueRef::Int(1), ValueRef::String("1")), WSDBException_);
+  // round trip through an owning value
+  for (const auto &v : strs) {
+    auto copy = ValueRef::FromValue(*v).ToValue();
+    ASSERT_TRUE(*copy == *v);
+  }
+}
+
+TEST(ValueRefTest, RecordFields)
+{
+  RecordSchema schema({MakeField("id", TYPE_INT, 4), MakeField("name", TYPE_STRING, 8)});
+  // a string filling the whole field has no terminating '\0' inside the record
+  Record full(&schema, {ValueFactory::CreateIntValue(1), ValueFactory::CreateStringValue("abcdefgh", 8)}, INVALID_RID);
+  Record part(&schema, {ValueFactory::CreateIntValue(1), ValueFactory::CreateStringValue("abc", 3)}, INVALID_RID);
+  Record null(
+      &schema, {ValueFactory::CreateNullValue(TYPE_INT), ValueFactory::CreateStringValue("abc", 3)}, INVALID_RID);
+  ASSERT_EQ(full.GetValueRefAt(1).GetString(), "abcdefgh");
+  ASSERT_EQ(part.GetValueRefAt(1).GetString(), "abc");
+  ASSERT_EQ(full.GetValueRefAt(0).GetInt(), 1);
+  ASSERT_TRUE(null.GetValueRefAt(0).IsNull());
+  ASSERT_EQ(full.GetValueRefAt(1).ToValue()->ToString(), "abcdefgh");
+  // nulls sort first
+  ASSERT_GT(Record::Compare(full, part), 0);
+  ASSERT_LT(Record::Compare(part, full), 0);
+  ASSERT_LT(Record::Compare(null, part), 0);
+  ASSERT_EQ(Record::Compare(part, part), 0);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
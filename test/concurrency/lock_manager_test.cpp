@@ -0,0 +1,257 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "../config.h"
+#include "concurrency/txn_manager.h"
+#include "system/table/table_manager.h"
+
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <optional>
+#include <thread>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class LockManagerTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    lock_manager_ = std::make_unique<LockManager>();
+    txn_manager_  = std::make_unique<TxnManager>(nullptr, lock_manager_.get());
+  }
+
+  auto Begin() -> Transaction *
+  {
+    auto txn = &txns_.emplace_back();
+    txn_manager_->SetTransaction(txn);
+    return txn;
+  }
+
+  static auto HeldMode(Transaction *txn, table_id_t table_id, const RID &rid = INVALID_RID) -> std::optional<LockMode>
+  {
+    auto it = txn->GetLocks().find({table_id, rid});
+    if (it == txn->GetLocks().end())
+      return std::nullopt;
+    return it->second;
+  }
+
+  /// whether the lock taken by the thread is still waiting after a while
+  static auto IsWaiting(std::future<void> &lock) -> bool
+  {
+    return lock.wait_for(std::chrono::milliseconds(100)) == std::future_status::timeout;
+  }
+
+  /// a deadlock that is never resolved fails the test instead of hanging the whole suite
+  static void WaitOrDie(std::future<void> &future, const std::string &what)
+  {
+    if (future.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+      std::cerr << what << " is still blocked, the deadlock was not resolved" << std::endl;
+      std::_Exit(EXIT_FAILURE);
+    }
+  }
+
+  std::unique_ptr<LockManager> lock_manager_;
+  std::unique_ptr<TxnManager>  txn_manager_;
+  std::deque<Transaction>      txns_;
+};
+
+TEST_F(LockManagerTest, Compatibility)
+{
+  using enum LockMode;
+  // rows: held, columns: requested, in the order of the enum
+  const bool matrix[5][5] = {
+      {true, true, true, true, false},
+      {true, true, false, false, false},
+      {true, false, true, false, false},
+      {true, false, false, false, false},
+      {false, false, false, false, false},
+  };
+  for (int held = 0; held < 5; ++held)
+    for (int requested = 0; requested < 5; ++requested)
+      ASSERT_EQ(LockManager::IsCompatible(static_cast<LockMode>(held), static_cast<LockMode>(requested)),
+          matrix[held][requested]);
+
+  auto t1 = Begin();
+  auto t2 = Begin();
+  lock_manager_->LockTable(t1, INTENTION_SHARED, 0);
+  lock_manager_->LockTable(t2, INTENTION_EXCLUSIVE, 0);
+  // IS and IX together make SIX, which covers S
+  lock_manager_->LockTable(t1, INTENTION_EXCLUSIVE, 1);
+  lock_manager_->LockTable(t1, SHARED, 1);
+  ASSERT_EQ(HeldMode(t1, 1), SHARED_INTENTION_EXCLUSIVE);
+  lock_manager_->LockTable(t1, SHARED, 1);
+  ASSERT_EQ(HeldMode(t1, 1), SHARED_INTENTION_EXCLUSIVE);
+  auto lock = std::async(std::launch::async, [&] { lock_manager_->LockTable(t2, INTENTION_SHARED, 1); });
+  lock.get();
+  auto blocked = std::async(std::launch::async, [&] { lock_manager_->LockTable(t2, INTENTION_EXCLUSIVE, 1); });
+  ASSERT_TRUE(IsWaiting(blocked));
+  txn_manager_->Commit(t1->GetTxnId());
+  blocked.get();
+  ASSERT_EQ(HeldMode(t2, 1), INTENTION_EXCLUSIVE);
+  ASSERT_TRUE(t1->GetLocks().empty());
+  txn_manager_->Commit(t2->GetTxnId());
+}
+
+TEST_F(LockManagerTest, RowLocksAndUpgrade)
+{
+  RID  rid{1, 0};
+  auto t1 = Begin();
+  auto t2 = Begin();
+  // the row lock takes the intention lock on its table
+  lock_manager_->LockRow(t1, LockMode::SHARED, 0, rid);
+  lock_manager_->LockRow(t2, LockMode::SHARED, 0, rid);
+  ASSERT_EQ(HeldMode(t1, 0), LockMode::INTENTION_SHARED);
+  ASSERT_EQ(HeldMode(t1, 0, rid), LockMode::SHARED);
+  ASSERT_THROW(lock_manager_->LockRow(t1, LockMode::INTENTION_SHARED, 0, rid), WSDBException_);
+
+  auto upgrade = std::async(std::launch::async, [&] { lock_manager_->LockRow(t1, LockMode::EXCLUSIVE, 0, rid); });
+  ASSERT_TRUE(IsWaiting(upgrade));
+  // a new reader queues behind the upgrade
+  auto t3     = Begin();
+  auto reader = std::async(std::launch::async, [&] { lock_manager_->LockRow(t3, LockMode::SHARED, 0, rid); });
+  ASSERT_TRUE(IsWaiting(reader));
+  txn_manager_->Commit(t2->GetTxnId());
+  upgrade.get();
+  ASSERT_EQ(HeldMode(t1, 0), LockMode::INTENTION_EXCLUSIVE);
+  ASSERT_EQ(HeldMode(t1, 0, rid), LockMode::EXCLUSIVE);
+  ASSERT_TRUE(IsWaiting(reader));
+  txn_manager_->Commit(t1->GetTxnId());
+  reader.get();
+  ASSERT_EQ(HeldMode(t3, 0, rid), LockMode::SHARED);
+  txn_manager_->Commit(t3->GetTxnId());
+}
+
+TEST_F(LockManagerTest, TwoPhase)
+{
+  auto t1 = Begin();
+  lock_manager_->LockRow(t1, LockMode::EXCLUSIVE, 0, {1, 0});
+  ASSERT_THROW(lock_manager_->UnlockTable(t1, 0), WSDBException_);
+  // an intention lock can be dropped while growing, a row lock ends the growing phase
+  lock_manager_->LockTable(t1, LockMode::INTENTION_SHARED, 1);
+  lock_manager_->UnlockTable(t1, 1);
+  ASSERT_EQ(t1->GetState(), TxnState::GROWING);
+  lock_manager_->UnlockRow(t1, 0, {1, 0});
+  ASSERT_EQ(t1->GetState(), TxnState::SHIRNKING);
+  ASSERT_THROW(lock_manager_->LockRow(t1, LockMode::SHARED, 0, {1, 1}), WSDBException_);
+  txn_manager_->Abort(t1->GetTxnId());
+  ASSERT_TRUE(t1->GetLocks().empty());
+}
+
+TEST_F(LockManagerTest, DeadlockDetection)
+{
+  lock_manager_->StartDeadlockDetector();
+  RID  r1{1, 0}, r2{1, 1}, r3{1, 2};
+  auto t1 = Begin();
+  auto t2 = Begin();
+  auto t3 = Begin();
+  lock_manager_->LockRow(t1, LockMode::EXCLUSIVE, 0, r1);
+  lock_manager_->LockRow(t2, LockMode::EXCLUSIVE, 0, r2);
+  lock_manager_->LockRow(t3, LockMode::EXCLUSIVE, 0, r3);
+  // t1 -> t2 -> t3 -> t1, the youngest one is the victim
+  auto w1 = std::async(std::launch::async, [&] { lock_manager_->LockRow(t1, LockMode::EXCLUSIVE, 0, r2); });
+  auto w2 = std::async(std::launch::async, [&] { lock_manager_->LockRow(t2, LockMode::SHARED, 0, r3); });
+  auto w3 = std::async(std::launch::async, [&] { lock_manager_->LockRow(t3, LockMode::SHARED, 0, r1); });
+  try {
+    w3.get();
+    FAIL() << "the youngest transaction was not aborted";
+  } catch (WSDBException_ &e) {
+    ASSERT_EQ(e.type_, WSDB_TXN_ABORTED);
+  }
+  ASSERT_EQ(t3->GetState(), TxnState::ABORTED);
+  txn_manager_->Abort(t3->GetTxnId());
+  w2.get();
+  ASSERT_TRUE(IsWaiting(w1));
+  txn_manager_->Commit(t2->GetTxnId());
+  w1.get();
+  ASSERT_EQ(t1->GetState(), TxnState::GROWING);
+  txn_manager_->Commit(t1->GetTxnId());
+  lock_manager_->StopDeadlockDetector();
+}
+
+TEST_F(LockManagerTest, TableWriters)
+{
+  const std::string table_name = "lock_manager_test_table";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  auto disk_manager        = std::make_unique<DiskManager>();
+  auto buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::vector<RTField> fields(1);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  table_manager->CreateTable(TEST_DIR, table_name, RecordSchema(fields), NARY_MODEL);
+  auto tbl         = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  auto make_record = [&](int id) {
+    return Record(&tbl->GetSchema(), std::vector<ValueSptr>{ValueFactory::CreateIntValue(id)}, INVALID_RID);
+  };
+  auto id_of = [&](const RID &rid) { return *reinterpret_cast<const int *>(tbl->GetRecord(rid)->GetData()); };
+
+  auto setup = Begin();
+  RID  r1    = tbl->InsertRecord(make_record(1));
+  RID  r2    = tbl->InsertRecord(make_record(2));
+  txn_manager_->Commit(setup->GetTxnId());
+
+  // two writers update the rows crosswise, the younger one is aborted and its change rolled back. t1 holds r1 before
+  // t2 starts, so t2 always ends up waiting for it
+  lock_manager_->StartDeadlockDetector();
+  auto t1 = Begin();
+  auto t2 = &txns_.emplace_back();
+  tbl->UpdateRecord(r1, make_record(11));
+  std::promise<void> t2_ready;
+  auto               t2_locked = t2_ready.get_future();
+  auto               writer    = std::async(std::launch::async, [&] {
+    txn_manager_->SetTransaction(t2);
+    tbl->UpdateRecord(r2, make_record(20));
+    t2_ready.set_value();
+    try {
+      tbl->UpdateRecord(r1, make_record(10));
+    } catch (WSDBException_ &e) {
+      txn_manager_->Abort(t2->GetTxnId());
+      throw;
+    }
+  });
+  WaitOrDie(t2_locked, "t2 updating r2");
+  auto t1_update = std::async(std::launch::async, [&] {
+    txn_manager_->SetTransaction(t1);
+    tbl->UpdateRecord(r2, make_record(21));
+  });
+  WaitOrDie(t1_update, "t1 updating r2");
+  WaitOrDie(writer, "t2 updating r1");
+  t1_update.get();
+  ASSERT_THROW(writer.get(), WSDBException_);
+  ASSERT_EQ(t2->GetState(), TxnState::ABORTED);
+  txn_manager_->Commit(t1->GetTxnId());
+  lock_manager_->StopDeadlockDetector();
+
+  Begin();
+  ASSERT_EQ(id_of(r1), 11);
+  ASSERT_EQ(id_of(r2), 21);
+  ASSERT_EQ(tbl->GetTableHeader().rec_num_, 2);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
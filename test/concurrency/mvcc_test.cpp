@@ -0,0 +1,335 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "../config.h"
+#include "concurrency/txn_manager.h"
+#include "system/table/table_manager.h"
+
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <thread>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class MVCCTest : public ::testing::TestWithParam<StorageModel>
+{
+protected:
+  void SetUp() override
+  {
+    if (!std::filesystem::exists(TEST_DIR))
+      std::filesystem::create_directory(TEST_DIR);
+    for (const auto &file : {FILE_NAME(TEST_DIR, table_name_, TAB_SUFFIX), log_file_})
+      if (std::filesystem::exists(file))
+        std::filesystem::remove(file);
+    disk_manager_        = std::make_unique<DiskManager>();
+    log_manager_         = std::make_unique<LogManager>(disk_manager_.get(), log_file_);
+    buffer_pool_manager_ = std::make_unique<BufferPoolManager>(disk_manager_.get(), log_manager_.get());
+    table_manager_       = std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    txn_manager_         = std::make_unique<TxnManager>(log_manager_.get());
+    std::vector<RTField> fields(2);
+    fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+    fields[1].field_ = {.field_name_ = "name", .field_size_ = 16, .field_type_ = TYPE_STRING};
+    table_manager_->CreateTable(TEST_DIR, table_name_, RecordSchema(fields), GetParam());
+    tbl_ = table_manager_->OpenTable(TEST_DIR, table_name_, GetParam());
+  }
+
+  void TearDown() override
+  {
+    table_manager_->CloseTable(TEST_DIR, *tbl_);
+    tbl_ = nullptr;
+    table_manager_->DropTable(TEST_DIR, table_name_);
+  }
+
+  /// start a new transaction, the following calls run in it until another one is switched to
+  auto Begin() -> Transaction *
+  {
+    auto txn = &txns_.emplace_back();
+    txn_manager_->SetTransaction(txn);
+    return txn;
+  }
+
+  void Switch(Transaction *txn) { txn_manager_->SetTransaction(txn); }
+
+  void Commit(Transaction *txn) { txn_manager_->Commit(txn->GetTxnId()); }
+
+  void Abort(Transaction *txn) { txn_manager_->Abort(txn->GetTxnId()); }
+
+  auto MakeRecord(int id, int version) -> RecordUptr
+  {
+    char name[16]{};
+    fmt::format_to_n(name, sizeof(name) - 1, "v{}-{}", version, id);
+    return std::make_unique<Record>(&tbl_->GetSchema(),
+        std::vector<ValueSptr>{ValueFactory::CreateIntValue(id), ValueFactory::CreateStringValue(name, sizeof(name))},
+        INVALID_RID);
+  }
+
+  static auto DataOf(const Record &rec) -> std::string { return {rec.GetData(), rec.GetSchema()->GetRecordLength()}; }
+
+  void Insert(int from, int to, int version, std::map<int, std::string> &rows)
+  {
+    for (int id = from; id < to; ++id) {
+      auto rec  = MakeRecord(id, version);
+      rids_[id] = tbl_->InsertRecord(*rec);
+      rows[id]  = DataOf(*rec);
+    }
+  }
+
+  void Update(int id, int version, std::map<int, std::string> &rows)
+  {
+    auto rec = MakeRecord(id, version);
+    tbl_->UpdateRecord(rids_[id], *rec);
+    rows[id] = DataOf(*rec);
+  }
+
+  /// id -> data of every row the current transaction sees, read record by record
+  auto ReadTable() -> std::map<int, std::string>
+  {
+    std::map<int, std::string> rows;
+    for (auto rid = tbl_->GetFirstRID(); rid != INVALID_RID; rid = tbl_->GetNextRID(rid)) {
+      auto rec                                             = tbl_->GetRecord(rid);
+      rows[*reinterpret_cast<const int *>(rec->GetData())] = DataOf(*rec);
+    }
+    return rows;
+  }
+
+  /// ids of the rows the current transaction sees, read page by page in the pax model
+  auto ReadIds() -> std::multiset<int>
+  {
+    std::multiset<int> ids;
+    auto               page_num = static_cast<page_id_t>(tbl_->GetTableHeader().page_num_);
+    for (page_id_t pid = FILE_HEADER_PAGE_ID + 1; pid < page_num; ++pid) {
+      ColumnBatch batch;
+      tbl_->GetColumnBatch(pid, {0}, batch);
+      for (size_t slot_id = 0; slot_id < batch.slot_num_; ++slot_id)
+        if (batch.valid_[slot_id])
+          ids.insert(reinterpret_cast<const int *>(batch.cols_[0].data())[slot_id]);
+      // the chunk of the page holds the same rows
+      auto chunk = tbl_->GetChunk(pid, &tbl_->GetSchema());
+      EXPECT_EQ(chunk->GetRowCount(), std::count(batch.valid_.begin(), batch.valid_.end(), 1));
+    }
+    return ids;
+  }
+
+  static auto IdsOf(const std::map<int, std::string> &rows) -> std::multiset<int>
+  {
+    std::multiset<int> ids;
+    for (auto &[id, data] : rows)
+      ids.insert(id);
+    return ids;
+  }
+
+  /// check what the current transaction sees through every read path of the table
+  void ExpectRows(const std::map<int, std::string> &rows)
+  {
+    ASSERT_EQ(ReadTable(), rows);
+    if (GetParam() == PAX_MODEL) {
+      ASSERT_EQ(ReadIds(), IdsOf(rows));
+    }
+  }
+
+  auto CountLog(LogType type) -> size_t
+  {
+    std::vector<LogRecord> recs;
+    log_manager_->FlushLog();
+    log_manager_->ReadLog(recs);
+    return std::count_if(recs.begin(), recs.end(), [type](const auto &rec) { return rec.type_ == type; });
+  }
+
+  const std::string                  table_name_ = "mvcc_table";
+  const std::string                  log_file_   = TEST_DIR + "/mvcc_test.log";
+  std::unique_ptr<DiskManager>       disk_manager_;
+  std::unique_ptr<LogManager>        log_manager_;
+  std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+  std::unique_ptr<TableManager>      table_manager_;
+  std::unique_ptr<TxnManager>        txn_manager_;
+  TableHandleUptr                    tbl_;
+  std::deque<Transaction>            txns_;
+  std::unordered_map<int, RID>       rids_;
+};
+
+TEST_P(MVCCTest, SnapshotRead)
+{
+  const int                  n = 1000;
+  std::map<int, std::string> before;
+  auto                       txn = Begin();
+  Insert(0, n, 0, before);
+  Commit(txn);
+
+  auto reader = Begin();
+  ExpectRows(before);
+  // the writer updates, deletes and inserts rows while the reader is running
+  auto writer = Begin();
+  auto after  = before;
+  for (int id = 0; id < 100; ++id)
+    Update(id, 1, after);
+  for (int id = 100; id < 200; ++id) {
+    tbl_->DeleteRecord(rids_[id]);
+    after.erase(id);
+  }
+  Insert(n, n + 300, 1, after);
+  ExpectRows(after);
+
+  // the reader sees neither the uncommitted nor the committed changes
+  Switch(reader);
+  ExpectRows(before);
+  Switch(writer);
+  Commit(writer);
+  Switch(reader);
+  ExpectRows(before);
+  ASSERT_THROW(tbl_->GetRecord(rids_[n]), WSDBException_);
+  ASSERT_EQ(DataOf(*tbl_->GetRecord(rids_[150])), before[150]);
+  Commit(reader);
+
+  // transactions starting after the commit see the changes
+  Begin();
+  ExpectRows(after);
+  ASSERT_EQ(tbl_->GetTableHeader().rec_num_, n + 200);
+}
+
+TEST_P(MVCCTest, WriteConflict)
+{
+  std::map<int, std::string> rows;
+  auto                       txn = Begin();
+  Insert(0, 10, 0, rows);
+  Commit(txn);
+
+  auto old_reader = Begin();
+  auto first      = Begin();
+  Update(0, 1, rows);
+  // the row is being changed by a running transaction
+  auto second = Begin();
+  try {
+    Update(0, 2, rows);
+    FAIL() << "conflicting update succeeded";
+  } catch (WSDBException_ &e) {
+    ASSERT_EQ(e.type_, WSDB_TXN_ABORTED);
+  }
+  ASSERT_THROW(tbl_->DeleteRecord(rids_[0]), WSDBException_);
+  Abort(second);
+  ASSERT_EQ(second->GetState(), TxnState::ABORTED);
+  Switch(first);
+  Update(0, 3, rows);
+  tbl_->DeleteRecord(rids_[1]);
+  Commit(first);
+
+  // the row was changed after the snapshot of the old transaction, and it can not delete a row it still sees
+  Switch(old_reader);
+  ASSERT_THROW(Update(0, 4, rows), WSDBException_);
+  try {
+    tbl_->DeleteRecord(rids_[1]);
+    FAIL() << "deleting a row deleted after the snapshot succeeded";
+  } catch (WSDBException_ &e) {
+    ASSERT_EQ(e.type_, WSDB_TXN_ABORTED);
+  }
+  Abort(old_reader);
+
+  auto last = Begin();
+  Update(0, 5, rows);
+  rows.erase(1);
+  Commit(last);
+  Begin();
+  ExpectRows(rows);
+}
+
+TEST_P(MVCCTest, Rollback)
+{
+  const int                  n = 500;
+  std::map<int, std::string> rows;
+  auto                       txn = Begin();
+  Insert(0, n, 0, rows);
+  Commit(txn);
+  auto hdr = tbl_->GetTableHeader();
+
+  // the loser fills new pages, and changes and deletes committed rows, some of them several times
+  auto loser   = Begin();
+  auto changed = rows;
+  Insert(n, 3 * n, 1, changed);
+  for (int id = 0; id < n; id += 3) {
+    Update(id, 1, changed);
+    Update(id, 2, changed);
+  }
+  for (int id = 1; id < n; id += 3) {
+    tbl_->DeleteRecord(rids_[id]);
+    changed.erase(id);
+  }
+  for (int id = n; id < 2 * n; id += 2) {
+    tbl_->DeleteRecord(rids_[id]);
+    changed.erase(id);
+  }
+  ExpectRows(changed);
+  auto writes = loser->GetWriteSet().size();
+  Abort(loser);
+
+  Begin();
+  ExpectRows(rows);
+  ASSERT_EQ(tbl_->GetTableHeader().rec_num_, hdr.rec_num_);
+  // every change is compensated
+  ASSERT_EQ(CountLog(LogType::CLR), writes);
+  ASSERT_EQ(CountLog(LogType::ABORT), 1);
+
+  // once the chains are collected the freed slots are reused before new pages are made
+  txn_manager_->CollectGarbage();
+  ASSERT_EQ(tbl_->GetVersionStore()->GetChainNum(), 0);
+  auto page_num = tbl_->GetTableHeader().page_num_;
+  Insert(n, 3 * n, 3, rows);
+  ASSERT_EQ(tbl_->GetTableHeader().page_num_, page_num);
+  ExpectRows(rows);
+}
+
+TEST_P(MVCCTest, GarbageCollection)
+{
+  const int                  n = 200;
+  std::map<int, std::string> rows;
+  auto                       txn = Begin();
+  Insert(0, n, 0, rows);
+  Commit(txn);
+
+  auto reader = Begin();
+  auto before = rows;
+  for (int version = 1; version <= 3; ++version) {
+    txn = Begin();
+    for (int id = 0; id < n; ++id)
+      Update(id, version, rows);
+    Commit(txn);
+  }
+  // the chains of the first insert are collected, the updates are still needed by the reader
+  txn_manager_->CollectGarbage();
+  ASSERT_EQ(tbl_->GetVersionStore()->GetChainNum(), n);
+  Switch(reader);
+  ExpectRows(before);
+  Commit(reader);
+
+  // the watermark passes the last commit, no version is left
+  txn_manager_->StartGarbageCollector();
+  for (int i = 0; i < 100 && tbl_->GetVersionStore()->GetChainNum() > 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(MVCC_GC_INTERVAL_MS));
+  txn_manager_->StopGarbageCollector();
+  ASSERT_EQ(tbl_->GetVersionStore()->GetChainNum(), 0);
+  Begin();
+  ExpectRows(rows);
+}
+
+INSTANTIATE_TEST_SUITE_P(StorageModels, MVCCTest, ::testing::Values(NARY_MODEL, PAX_MODEL));
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
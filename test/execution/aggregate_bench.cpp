@@ -0,0 +1,133 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+
+//
+// Created by ziqi on 2024/10/16.
+//
+
+#include "../config.h"
+#include "execution/executor_aggregate.h"
+#include "execution/executor_aggregate_vec.h"
+#include "execution/executor_seqscan.h"
+#include "storage/storage.h"
+#include "system/handle/table_handle.h"
+#include "system/table/table_manager.h"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+[[maybe_unused]] constexpr int    BENCH_ROWS      = 10000000;
+[[maybe_unused]] constexpr int    BENCH_GROUPS    = 1000;
+[[maybe_unused]] constexpr size_t BENCH_POOL_SIZE = 1024;
+
+static auto MakeField(const std::string &name, FieldType type, size_t size, AggType agg = AGG_NONE) -> RTField
+{
+  RTField f;
+  f.field_.field_name_ = name;
+  f.field_.field_type_ = type;
+  f.field_.field_size_ = size;
+  f.is_agg_            = agg != AGG_NONE;
+  f.agg_type_          = agg;
+  return f;
+}
+
+/**
+ * Drain the executor and return the elapsed seconds and the number of output rows
+ */
+static auto RunAggregate(const AbstractExecutorUptr &exec) -> std::pair<double, size_t>
+{
+  auto   begin = std::chrono::steady_clock::now();
+  size_t rows  = 0;
+  for (exec->Init(); !exec->IsEnd(); exec->Next()) {
+    rows++;
+  }
+  auto end = std::chrono::steady_clock::now();
+  return {std::chrono::duration<double>(end - begin).count(), rows};
+}
+
+TEST(AggregateBench, RowVsColumn)
+{
+  DiskManager       disk_manager;
+  BufferPoolManager buffer_pool_manager(&disk_manager, nullptr, REPLACER_LRU_K, BENCH_POOL_SIZE);
+  TableManager      table_manager(&disk_manager, &buffer_pool_manager);
+  std::string       table_name = "aggregate_bench";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  RecordSchema schema({MakeField("id", TYPE_INT, 4),
+      MakeField("grp", TYPE_INT, 4),
+      MakeField("qty", TYPE_INT, 4),
+      MakeField("price", TYPE_FLOAT, 4)});
+  table_manager.CreateTable(TEST_DIR, table_name, schema, PAX_MODEL);
+  auto tab = table_manager.OpenTable(TEST_DIR, table_name, PAX_MODEL);
+  for (int i = 0; i < BENCH_ROWS; ++i) {
+    std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i),
+        ValueFactory::CreateIntValue(i % BENCH_GROUPS),
+        ValueFactory::CreateIntValue(i % 97),
+        ValueFactory::CreateFloatValue(static_cast<float>(i % 1000) / 8)};
+    tab->InsertRecord(Record(&tab->GetSchema(), values, INVALID_RID));
+  }
+  auto tid = tab->GetTableId();
+  auto agg_schema = [tid]() {
+    std::vector<RTField> fields{MakeField("", TYPE_INT, 4, AGG_COUNT_STAR),
+        MakeField("qty", TYPE_INT, 4, AGG_SUM),
+        MakeField("price", TYPE_FLOAT, 4, AGG_AVG),
+        MakeField("price", TYPE_FLOAT, 4, AGG_MAX)};
+    for (size_t i = 1; i < fields.size(); ++i) {
+      fields[i].field_.table_id_ = tid;
+    }
+    return std::make_unique<RecordSchema>(fields);
+  };
+  auto group_schema = [tid, &tab](bool grouped) {
+    std::vector<RTField> fields;
+    if (grouped) {
+      fields.push_back(tab->GetSchema().GetFieldByName(tid, "grp"));
+    }
+    return std::make_unique<RecordSchema>(fields);
+  };
+  for (bool grouped : {false, true}) {
+    auto [row_sec, row_num] = RunAggregate(std::make_unique<AggregateExecutor>(
+        std::make_unique<SeqScanExecutor>(tab.get()), agg_schema(), group_schema(grouped)));
+    auto [col_sec, col_num] =
+        RunAggregate(std::make_unique<AggregateExecutorVec>(tab.get(), agg_schema(), group_schema(grouped)));
+    ASSERT_EQ(row_num, col_num);
+    std::cout << fmt::format("rows: {}, groups: {:>4}, AggregateExecutor: {:.3f}s, AggregateExecutorVec: {:.3f}s, "
+                             "speedup: {:.1f}x",
+                     BENCH_ROWS,
+                     row_num,
+                     row_sec,
+                     col_sec,
+                     row_sec / col_sec)
+              << std::endl;
+  }
+  table_manager.CloseTable(TEST_DIR, *tab);
+  table_manager.DropTable(TEST_DIR, table_name);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,316 @@
+//
+// Created by ziqi on 2024/10/16.
+//
+
+#include "../config.h"
+#include "common/condition.h"
+#include "execution/executor_aggregate.h"
+#include "execution/executor_aggregate_vec.h"
+#include "execution/executor_filter.h"
+#include "execution/executor_limit.h"
+#include "execution/executor_projection.h"
+#include "execution/executor_seqscan.h"
+#include "expr/compiled_condition.h"
+#include "expr/condition_expr.h"
+#include "storage/storage.h"
+#include "system/handle/table_handle.h"
+#include "system/table/table_manager.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+auto MakeField(const std::string &name, FieldType type, size_t size) -> RTField
+{
+  RTField f;
+  f.field_.field_name_ = name;
+  f.field_.field_type_ = type;
+  f.field_.field_size_ = size;
+  return f;
+}
+
+auto RecordToString(const Record &rec) -> std::string
+{
+  std::string str;
+  for (size_t i = 0; i < rec.GetSchema()->GetFieldCount(); ++i) {
+    str += rec.GetValueAt(i)->ToString() + "|";
+  }
+  return str;
+}
+
+// drain an executor through the interface it is built for
+auto Collect(const AbstractExecutorUptr &exec) -> std::vector<std::string>
+{
+  std::vector<std::string> rows;
+  exec->Init();
+  if (exec->IsVectorized()) {
+    for (auto chunk = exec->NextChunk(); chunk != nullptr; chunk = exec->NextChunk()) {
+      for (auto row : chunk->GetSel()) {
+        rows.push_back(RecordToString(*chunk->GetRecord(row)));
+      }
+    }
+  } else {
+    for (; !exec->IsEnd(); exec->Next()) {
+      rows.push_back(RecordToString(*exec->GetRecord()));
+    }
+  }
+  return rows;
+}
+
+class VecExecutorTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    disk_manager_        = std::make_unique<DiskManager>();
+    buffer_pool_manager_ = std::make_unique<BufferPoolManager>(disk_manager_.get(), nullptr);
+    table_manager_       = std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    if (!std::filesystem::exists(TEST_DIR))
+      std::filesystem::create_directory(TEST_DIR);
+    if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name_, TAB_SUFFIX)))
+      std::filesystem::remove(FILE_NAME(TEST_DIR, table_name_, TAB_SUFFIX));
+    RecordSchema schema({MakeField("id", TYPE_INT, 4),
+        MakeField("grp", TYPE_INT, 4),
+        MakeField("val", TYPE_FLOAT, 4),
+        MakeField("name", TYPE_STRING, 8)});
+    table_manager_->CreateTable(TEST_DIR, table_name_, schema, PAX_MODEL);
+    tab_hdl_ = table_manager_->OpenTable(TEST_DIR, table_name_, PAX_MODEL);
+    tab_     = tab_hdl_.get();
+    for (int i = 0; i < REC_NUM; ++i) {
+      std::vector<ValueSptr> values;
+      values.push_back(ValueFactory::CreateIntValue(i));
+      values.push_back(ValueFactory::CreateIntValue(i % 7));
+      // leave some nulls to check that aggregates skip them
+      if (i % 5 == 0) {
+        values.push_back(ValueFactory::CreateNullValue(TYPE_FLOAT));
+      } else {
+        values.push_back(ValueFactory::CreateFloatValue(static_cast<float>(i % 100) / 4));
+      }
+      auto name = fmt::format("n{}", i % 13);
+      values.push_back(ValueFactory::CreateStringValue(name.c_str(), name.size()));
+      tab_->InsertRecord(Record(&tab_->GetSchema(), values, INVALID_RID));
+    }
+    // punch some holes so that pages are not full
+    for (auto rid = tab_->GetFirstRID(); rid != INVALID_RID; rid = tab_->GetNextRID(rid)) {
+      if (rid.SlotID() % 3 == 0) {
+        tab_->DeleteRecord(rid);
+      }
+    }
+  }
+
+  void TearDown() override
+  {
+    table_manager_->CloseTable(TEST_DIR, *tab_);
+    table_manager_->DropTable(TEST_DIR, table_name_);
+  }
+
+  auto Field(const std::string &name) -> RTField
+  {
+    return tab_->GetSchema().GetFieldByName(tab_->GetTableId(), name);
+  }
+
+  auto AggField(const std::string &name, AggType type) -> RTField
+  {
+    RTField f;
+    if (type != AGG_COUNT_STAR) {
+      f = Field(name);
+    }
+    f.is_agg_   = true;
+    f.agg_type_ = type;
+    if (type == AGG_COUNT || type == AGG_COUNT_STAR) {
+      f.field_.field_type_ = TYPE_INT;
+      f.field_.field_size_ = sizeof(int);
+    }
+    return f;
+  }
+
+  auto Scan(bool vectorized) -> AbstractExecutorUptr { return std::make_unique<SeqScanExecutor>(tab_, vectorized); }
+
+  auto Filter(AbstractExecutorUptr child, const ConditionVec &conds) -> AbstractExecutorUptr
+  {
+    return std::make_unique<FilterExecutor>(
+        std::move(child),
+        [conds](const Record &rec) { return ConditionExpr::Eval(conds, rec); },
+        [conds](Chunk &chunk) { ConditionExpr::Eval(conds, chunk); });
+  }
+
+  static constexpr int REC_NUM = 5000;
+
+  std::unique_ptr<DiskManager>       disk_manager_;
+  std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+  std::unique_ptr<TableManager>      table_manager_;
+  TableHandleUptr                    tab_hdl_;
+  TableHandle                       *tab_{nullptr};
+  std::string                        table_name_ = "executor_vec";
+};
+
+TEST_F(VecExecutorTest, ScanFilterProject)
+{
+  SUB_TEST(SeqScan)
+  {
+    auto row = Collect(Scan(false));
+    auto vec = Collect(Scan(true));
+    ASSERT_EQ(row.size(), tab_->GetTableHeader().rec_num_);
+    ASSERT_EQ(row, vec);
+  }
+  SUB_TEST(Filter)
+  {
+    ValueSptr    lo = ValueFactory::CreateIntValue(3);
+    ValueSptr    hi = ValueFactory::CreateFloatValue(10.5);
+    ConditionVec conds{Condition(OP_GE, Field("grp"), lo), Condition(OP_LT, Field("val"), hi)};
+    auto         row = Collect(Filter(Scan(false), conds));
+    auto         vec = Collect(Filter(Scan(true), conds));
+    ASSERT_FALSE(row.empty());
+    ASSERT_EQ(row, vec);
+    // column to column comparison
+    ConditionVec col_conds{Condition(OP_GT, Field("id"), Field("grp"))};
+    ASSERT_EQ(Collect(Filter(Scan(false), col_conds)), Collect(Filter(Scan(true), col_conds)));
+  }
+  SUB_TEST(Projection)
+  {
+    auto make = [this](bool vectorized) -> AbstractExecutorUptr {
+      auto proj = std::make_unique<RecordSchema>(std::vector<RTField>{Field("name"), Field("id")});
+      return std::make_unique<ProjectionExecutor>(Scan(vectorized), std::move(proj));
+    };
+    ASSERT_EQ(Collect(make(false)), Collect(make(true)));
+  }
+  SUB_TEST(Limit)
+  {
+    for (int limit : {0, 1, 100, static_cast<int>(CHUNK_SIZE) + 1, REC_NUM * 2}) {
+      auto row = Collect(std::make_unique<LimitExecutor>(Scan(false), limit));
+      auto vec = Collect(std::make_unique<LimitExecutor>(Scan(true), limit));
+      ASSERT_EQ(row, vec);
+      ASSERT_EQ(vec.size(), std::min(static_cast<size_t>(limit), tab_->GetTableHeader().rec_num_));
+    }
+  }
+}
+
+TEST_F(VecExecutorTest, CompiledCondition)
+{
+  auto compiled = [this](bool vectorized, const ConditionVec &conds) -> AbstractExecutorUptr {
+    auto cond = std::make_shared<CompiledCondition>(conds, &tab_->GetSchema());
+    return std::make_unique<FilterExecutor>(
+        Scan(vectorized),
+        [cond](const Record &rec) { return cond->Eval(rec); },
+        [cond](Chunk &chunk) { cond->Eval(chunk); });
+  };
+  ValueSptr    three = ValueFactory::CreateIntValue(3);
+  ValueSptr    half  = ValueFactory::CreateFloatValue(10.5);
+  ValueSptr    n4    = ValueFactory::CreateStringValue("n4", 2);
+  ValueSptr    null  = ValueFactory::CreateNullValue(TYPE_FLOAT);
+  ValueSptr    in = ValueFactory::CreateArrayValue({ValueFactory::CreateIntValue(1), ValueFactory::CreateIntValue(5)});
+  std::vector<ConditionVec> cases{{Condition(OP_GE, Field("grp"), three), Condition(OP_LT, Field("val"), half)},
+      {Condition(OP_NE, Field("val"), three)},
+      {Condition(OP_LE, Field("name"), n4), Condition(OP_GT, Field("id"), Field("grp"))},
+      {Condition(OP_EQ, Field("val"), Field("val"))},
+      {Condition(OP_EQ, Field("val"), null)},
+      {Condition(OP_IN, Field("grp"), in), Condition(OP_NE, Field("name"), n4)}};
+  for (const auto &conds : cases) {
+    auto expected = Collect(Filter(Scan(false), conds));
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(Collect(compiled(false, conds)), expected);
+    ASSERT_EQ(Collect(compiled(true, conds)), expected);
+  }
+  // the term that rejects more rows moves to the front once pass rates are observed
+  ValueSptr         zero    = ValueFactory::CreateIntValue(0);
+  ValueSptr         hundred = ValueFactory::CreateIntValue(100);
+  CompiledCondition cond(
+      {Condition(OP_GE, Field("id"), zero), Condition(OP_LT, Field("id"), hundred)}, &tab_->GetSchema());
+  ASSERT_EQ(cond.GetOrder(), (std::vector<size_t>{0, 1}));
+  auto scan = Scan(true);
+  scan->Init();
+  for (auto chunk = scan->NextChunk(); chunk != nullptr; chunk = scan->NextChunk()) {
+    cond.Eval(*chunk);
+  }
+  ASSERT_EQ(cond.GetOrder(), (std::vector<size_t>{1, 0}));
+}
+
+TEST_F(VecExecutorTest, Aggregate)
+{
+  auto make = [this](bool vectorized, std::vector<RTField> groups, const ConditionVec &conds) -> AbstractExecutorUptr {
+    std::vector<RTField> aggs{AggField("", AGG_COUNT_STAR),
+        AggField("val", AGG_COUNT),
+        AggField("val", AGG_SUM),
+        AggField("val", AGG_AVG),
+        AggField("id", AGG_MAX),
+        AggField("name", AGG_MIN)};
+    AbstractExecutorUptr child = Scan(vectorized);
+    if (!conds.empty()) {
+      child = Filter(std::move(child), conds);
+    }
+    return std::make_unique<AggregateExecutor>(std::move(child),
+        std::make_unique<RecordSchema>(aggs),
+        std::make_unique<RecordSchema>(std::move(groups)));
+  };
+  SUB_TEST(GroupBy)
+  {
+    auto row = Collect(make(false, {Field("grp")}, {}));
+    auto vec = Collect(make(true, {Field("grp")}, {}));
+    ASSERT_EQ(row.size(), 7);
+    std::sort(row.begin(), row.end());
+    std::sort(vec.begin(), vec.end());
+    ASSERT_EQ(row, vec);
+  }
+  SUB_TEST(NoGroupBy)
+  {
+    auto row = Collect(make(false, {}, {}));
+    auto vec = Collect(make(true, {}, {}));
+    ASSERT_EQ(row.size(), 1);
+    ASSERT_EQ(row, vec);
+    ASSERT_EQ(row[0].substr(0, row[0].find('|')), std::to_string(tab_->GetTableHeader().rec_num_));
+  }
+  SUB_TEST(EmptyInput)
+  {
+    ValueSptr    never = ValueFactory::CreateIntValue(-1);
+    ConditionVec conds{Condition(OP_EQ, Field("grp"), never)};
+    // without group by an empty input still yields one row of zero counts and nulls
+    auto row = Collect(make(false, {}, conds));
+    ASSERT_EQ(row, Collect(make(true, {}, conds)));
+    ASSERT_EQ(row, std::vector<std::string>{"0|0|(null)|(null)|(null)|(null)|"});
+    ASSERT_TRUE(Collect(make(false, {Field("grp")}, conds)).empty());
+    ASSERT_TRUE(Collect(make(true, {Field("grp")}, conds)).empty());
+  }
+}
+
+TEST_F(VecExecutorTest, AggregateOnColumns)
+{
+  auto aggs = [this]() {
+    return std::make_unique<RecordSchema>(std::vector<RTField>{AggField("", AGG_COUNT_STAR),
+        AggField("val", AGG_COUNT),
+        AggField("name", AGG_COUNT),
+        AggField("val", AGG_SUM),
+        AggField("id", AGG_SUM),
+        AggField("val", AGG_AVG),
+        AggField("id", AGG_AVG),
+        AggField("val", AGG_MIN),
+        AggField("id", AGG_MAX)});
+  };
+  // group fields of every type, including a nullable one
+  std::vector<std::vector<RTField>> group_sets{{}, {Field("grp")}, {Field("name"), Field("grp")}, {Field("val")}};
+  for (const auto &groups : group_sets) {
+    auto expected = Collect(std::make_unique<AggregateExecutor>(
+        Scan(false), aggs(), std::make_unique<RecordSchema>(groups)));
+    ASSERT_TRUE(AggregateExecutorVec::IsSupported(tab_, *aggs(), RecordSchema(groups)));
+    for (bool vectorized : {false, true}) {
+      auto actual = Collect(std::make_unique<AggregateExecutorVec>(
+          tab_, aggs(), std::make_unique<RecordSchema>(groups), vectorized));
+      std::sort(expected.begin(), expected.end());
+      std::sort(actual.begin(), actual.end());
+      ASSERT_EQ(expected, actual);
+    }
+  }
+  // min and max of strings are left to the record based executor
+  RecordSchema str_min({AggField("name", AGG_MIN)});
+  ASSERT_FALSE(AggregateExecutorVec::IsSupported(tab_, str_min, RecordSchema(std::vector<RTField>{})));
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
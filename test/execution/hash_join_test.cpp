@@ -0,0 +1,206 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/22.
+//
+
+#include "../config.h"
+#include "execution/executor_join_hash.h"
+#include "execution/executor_seqscan.h"
+#include "storage/storage.h"
+#include "system/handle/table_handle.h"
+#include "system/table/table_manager.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+auto MakeField(const std::string &name, FieldType type, size_t size) -> RTField
+{
+  RTField f;
+  f.field_.field_name_ = name;
+  f.field_.field_type_ = type;
+  f.field_.field_size_ = size;
+  return f;
+}
+
+auto RecordToString(const Record &rec) -> std::string
+{
+  std::string str;
+  for (size_t i = 0; i < rec.GetSchema()->GetFieldCount(); ++i) {
+    str += rec.GetValueAt(i)->ToString() + "|";
+  }
+  return str;
+}
+
+class HashJoinTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    disk_manager_        = std::make_unique<DiskManager>();
+    buffer_pool_manager_ = std::make_unique<BufferPoolManager>(disk_manager_.get(), nullptr);
+    table_manager_       = std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    if (!std::filesystem::exists(TEST_DIR))
+      std::filesystem::create_directory(TEST_DIR);
+    // left(id, k, f), right(k, name, f): k joins k, left.k also joins right.f as int against float
+    left_  = CreateTable("hash_join_left",
+        {MakeField("id", TYPE_INT, 4), MakeField("k", TYPE_INT, 4), MakeField("f", TYPE_FLOAT, 4)});
+    right_ = CreateTable("hash_join_right",
+        {MakeField("k", TYPE_INT, 4), MakeField("name", TYPE_STRING, 8), MakeField("f", TYPE_FLOAT, 4)});
+    for (int i = 0; i < LEFT_NUM; ++i) {
+      std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i),
+          i % 11 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(i % 500),
+          ValueFactory::CreateFloatValue(static_cast<float>(i % 7))};
+      left_->InsertRecord(Record(&left_->GetSchema(), values, INVALID_RID));
+    }
+    for (int i = 0; i < RIGHT_NUM; ++i) {
+      auto                   name = fmt::format("r{}", i);
+      std::vector<ValueSptr> values{
+          i % 13 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue(i % 700),
+          ValueFactory::CreateStringValue(name.c_str(), name.size()),
+          ValueFactory::CreateFloatValue(static_cast<float>(i % 300))};
+      right_->InsertRecord(Record(&right_->GetSchema(), values, INVALID_RID));
+    }
+  }
+
+  void TearDown() override
+  {
+    for (auto &[name, hdl] : tables_) {
+      table_manager_->CloseTable(TEST_DIR, *hdl);
+      table_manager_->DropTable(TEST_DIR, name);
+    }
+  }
+
+  auto CreateTable(const std::string &name, std::vector<RTField> fields) -> TableHandle *
+  {
+    if (std::filesystem::exists(FILE_NAME(TEST_DIR, name, TAB_SUFFIX)))
+      std::filesystem::remove(FILE_NAME(TEST_DIR, name, TAB_SUFFIX));
+    table_manager_->CreateTable(TEST_DIR, name, RecordSchema(std::move(fields)), NARY_MODEL);
+    tables_.emplace_back(name, table_manager_->OpenTable(TEST_DIR, name, NARY_MODEL));
+    return tables_.back().second.get();
+  }
+
+  static auto Field(TableHandle *tab, const std::string &name) -> RTField
+  {
+    return tab->GetSchema().GetFieldByName(tab->GetTableId(), name);
+  }
+
+  static auto Collect(AbstractExecutor &exec) -> std::vector<std::string>
+  {
+    std::vector<std::string> rows;
+    for (exec.Init(); !exec.IsEnd(); exec.Next()) {
+      rows.push_back(RecordToString(*exec.GetRecord()));
+    }
+    return rows;
+  }
+
+  // nested loop over the whole tables as the reference, null keys match each other like Record::Compare
+  auto Expected(JoinType type, const std::string &lkey, const std::string &rkey) -> std::vector<std::string>
+  {
+    std::vector<std::string> rows;
+    auto                     lidx = left_->GetSchema().GetFieldIndex(left_->GetTableId(), lkey);
+    auto                     ridx = right_->GetSchema().GetFieldIndex(right_->GetTableId(), rkey);
+    RecordSchema             out_schema([this]() {
+      auto fields = left_->GetSchema().GetFields();
+      fields.insert(fields.end(), right_->GetSchema().GetFields().begin(), right_->GetSchema().GetFields().end());
+      return fields;
+    }());
+    Record                  null_right(&right_->GetSchema());
+    std::vector<RecordUptr> right_recs;
+    for (auto rrid = right_->GetFirstRID(); rrid != INVALID_RID; rrid = right_->GetNextRID(rrid)) {
+      right_recs.push_back(right_->GetRecord(rrid));
+    }
+    for (auto lrid = left_->GetFirstRID(); lrid != INVALID_RID; lrid = left_->GetNextRID(lrid)) {
+      auto lrec    = left_->GetRecord(lrid);
+      bool matched = false;
+      for (const auto &rrec : right_recs) {
+        if (ValueRef::Compare(lrec->GetValueRefAt(lidx), rrec->GetValueRefAt(ridx)) == 0) {
+          matched = true;
+          rows.push_back(RecordToString(Record(&out_schema, *lrec, *rrec)));
+        }
+      }
+      if (!matched && type == OUTER_JOIN) {
+        rows.push_back(RecordToString(Record(&out_schema, *lrec, null_right)));
+      }
+    }
+    return rows;
+  }
+
+  auto MakeJoin(JoinType type, const std::string &lkey, const std::string &rkey, bool build_left, size_t budget)
+      -> std::unique_ptr<HashJoinExecutor>
+  {
+    return std::make_unique<HashJoinExecutor>(type,
+        std::make_unique<SeqScanExecutor>(left_),
+        std::make_unique<SeqScanExecutor>(right_),
+        std::make_unique<RecordSchema>(std::vector<RTField>{Field(left_, lkey)}),
+        std::make_unique<RecordSchema>(std::vector<RTField>{Field(right_, rkey)}),
+        build_left,
+        budget);
+  }
+
+  static constexpr int LEFT_NUM  = 3000;
+  static constexpr int RIGHT_NUM = 2000;
+
+  std::unique_ptr<DiskManager>                            disk_manager_;
+  std::unique_ptr<BufferPoolManager>                      buffer_pool_manager_;
+  std::unique_ptr<TableManager>                           table_manager_;
+  std::vector<std::pair<std::string, TableHandleUptr>>    tables_;
+  TableHandle                                            *left_{nullptr};
+  TableHandle                                            *right_{nullptr};
+};
+
+TEST_F(HashJoinTest, InnerAndOuter)
+{
+  for (auto [lkey, rkey] : {std::pair<std::string, std::string>{"k", "k"}, {"k", "f"}}) {
+    for (auto type : {INNER_JOIN, OUTER_JOIN}) {
+      auto expected = Expected(type, lkey, rkey);
+      ASSERT_FALSE(expected.empty());
+      // probing with the left side in memory keeps the order of a nested loop join
+      auto join = MakeJoin(type, lkey, rkey, false, HASH_JOIN_BUFFER_SIZE);
+      ASSERT_EQ(Collect(*join), expected);
+      ASSERT_FALSE(join->IsPartitioned());
+      std::sort(expected.begin(), expected.end());
+      for (bool build_left : {false, true}) {
+        // a tiny budget forces both inputs into partitions
+        for (size_t budget : {HASH_JOIN_BUFFER_SIZE, static_cast<size_t>(4096)}) {
+          join        = MakeJoin(type, lkey, rkey, build_left, budget);
+          auto actual = Collect(*join);
+          ASSERT_EQ(join->IsPartitioned(), budget != HASH_JOIN_BUFFER_SIZE);
+          std::sort(actual.begin(), actual.end());
+          ASSERT_EQ(actual, expected) << lkey << " " << rkey << " " << type << " " << build_left << " " << budget;
+        }
+      }
+    }
+  }
+  // partition files are cleaned up
+  for (const auto &entry : std::filesystem::directory_iterator(TMP_DIR)) {
+    ASSERT_EQ(entry.path().filename().string().find("hash_join_"), std::string::npos);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
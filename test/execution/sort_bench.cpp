@@ -0,0 +1,131 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/24.
+//
+
+#include "execution/executor_sort.h"
+
+#include <chrono>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+[[maybe_unused]] constexpr size_t BENCH_ROWS        = 100000000;
+[[maybe_unused]] constexpr size_t BENCH_BUFFER_SIZE = 16 * 1024 * 1024;
+
+static auto MakeField(const std::string &name, FieldType type, size_t size) -> RTField
+{
+  RTField f;
+  f.field_.field_name_ = name;
+  f.field_.field_type_ = type;
+  f.field_.field_size_ = size;
+  return f;
+}
+
+/**
+ * Produce rows (key, id) with pseudo random keys without touching the disk, so the bench only measures the sort
+ */
+class GenerateExecutor : public AbstractExecutor
+{
+public:
+  explicit GenerateExecutor(size_t rows) : AbstractExecutor(Basic), rows_(rows)
+  {
+    out_schema_ = std::make_unique<RecordSchema>(
+        std::vector<RTField>{MakeField("key", TYPE_INT, 4), MakeField("id", TYPE_INT, 4)});
+  }
+
+  void Init() override
+  {
+    row_  = 0;
+    seed_ = 42;
+    Generate();
+  }
+
+  void Next() override
+  {
+    row_++;
+    Generate();
+  }
+
+  [[nodiscard]] auto IsEnd() const -> bool override { return row_ >= rows_; }
+
+private:
+  void Generate()
+  {
+    if (row_ >= rows_) {
+      record_ = nullptr;
+      return;
+    }
+    seed_      = seed_ * 6364136223846793005ULL + 1442695040888963407ULL;
+    char nullmap[BITMAP_SIZE(2)]{};
+    int  data[2]{static_cast<int>(seed_ >> 33), static_cast<int>(row_)};
+    record_ = std::make_unique<Record>(out_schema_.get(), nullmap, reinterpret_cast<char *>(data), INVALID_RID);
+  }
+
+  size_t   rows_;
+  size_t   row_{0};
+  uint64_t seed_{42};
+};
+
+/**
+ * Drain the sort, check the output order and return the elapsed seconds
+ */
+static auto RunSort(size_t worker_num) -> double
+{
+  auto child      = std::make_unique<GenerateExecutor>(BENCH_ROWS);
+  auto key_schema = std::make_unique<RecordSchema>(std::vector<RTField>{child->GetOutSchema()->GetFieldAt(0)});
+  SortExecutor sort(std::move(child), std::move(key_schema), false, BENCH_BUFFER_SIZE, worker_num);
+  auto         begin = std::chrono::steady_clock::now();
+  size_t       rows  = 0;
+  int          last  = std::numeric_limits<int>::min();
+  for (sort.Init(); !sort.IsEnd(); sort.Next()) {
+    auto key = sort.GetRecord()->GetValueRefAt(0).GetInt();
+    EXPECT_LE(last, key);
+    last = key;
+    rows++;
+  }
+  auto end = std::chrono::steady_clock::now();
+  EXPECT_EQ(rows, BENCH_ROWS);
+  EXPECT_TRUE(sort.IsMergeSort());
+  return std::chrono::duration<double>(end - begin).count();
+}
+
+TEST(SortBench, ExternalSort)
+{
+  auto single   = RunSort(1);
+  auto parallel = RunSort(SORT_WORKER_NUM);
+  std::cout << fmt::format("rows: {}, buffer: {}MB, 1 worker: {:.3f}s, {} workers: {:.3f}s, speedup: {:.1f}x",
+                   BENCH_ROWS,
+                   BENCH_BUFFER_SIZE / 1024 / 1024,
+                   single,
+                   SORT_WORKER_NUM,
+                   parallel,
+                   single / parallel)
+            << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
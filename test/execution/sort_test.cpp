@@ -0,0 +1,188 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/24.
+//
+
+#include "../config.h"
+#include "execution/executor_seqscan.h"
+#include "execution/executor_sort.h"
+#include "execution/executor_topn.h"
+#include "storage/storage.h"
+#include "system/handle/table_handle.h"
+#include "system/table/table_manager.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+constexpr int SORT_ROWS = 20000;
+
+auto MakeField(const std::string &name, FieldType type, size_t size) -> RTField
+{
+  RTField f;
+  f.field_.field_name_ = name;
+  f.field_.field_type_ = type;
+  f.field_.field_size_ = size;
+  return f;
+}
+
+auto RecordToString(const Record &rec) -> std::string
+{
+  std::string str;
+  for (size_t i = 0; i < rec.GetSchema()->GetFieldCount(); ++i) {
+    str += rec.GetValueAt(i)->ToString() + "|";
+  }
+  return str;
+}
+
+class SortTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    disk_manager_        = std::make_unique<DiskManager>();
+    buffer_pool_manager_ = std::make_unique<BufferPoolManager>(disk_manager_.get(), nullptr);
+    table_manager_       = std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    if (!std::filesystem::exists(TEST_DIR))
+      std::filesystem::create_directory(TEST_DIR);
+    if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name_, TAB_SUFFIX)))
+      std::filesystem::remove(FILE_NAME(TEST_DIR, table_name_, TAB_SUFFIX));
+    table_manager_->CreateTable(TEST_DIR,
+        table_name_,
+        RecordSchema({MakeField("id", TYPE_INT, 4),
+            MakeField("k", TYPE_INT, 4),
+            MakeField("f", TYPE_FLOAT, 4),
+            MakeField("name", TYPE_STRING, 8)}),
+        NARY_MODEL);
+    tab_ = table_manager_->OpenTable(TEST_DIR, table_name_, NARY_MODEL);
+    // k has many duplicates so the output order of equal keys checks stability, some k are null
+    for (int i = 0; i < SORT_ROWS; ++i) {
+      auto                   name = fmt::format("n{}", (i * 7919) % 1000);
+      std::vector<ValueSptr> values{ValueFactory::CreateIntValue(i),
+          i % 17 == 0 ? ValueFactory::CreateNullValue(TYPE_INT) : ValueFactory::CreateIntValue((i * 31) % 1000 - 500),
+          ValueFactory::CreateFloatValue(static_cast<float>((i * 13) % 101) / 4),
+          ValueFactory::CreateStringValue(name.c_str(), name.size())};
+      tab_->InsertRecord(Record(&tab_->GetSchema(), values, INVALID_RID));
+    }
+  }
+
+  void TearDown() override
+  {
+    table_manager_->CloseTable(TEST_DIR, *tab_);
+    table_manager_->DropTable(TEST_DIR, table_name_);
+  }
+
+  auto KeySchema(const std::vector<std::string> &names) -> RecordSchemaUptr
+  {
+    std::vector<RTField> fields;
+    for (const auto &name : names) {
+      fields.push_back(tab_->GetSchema().GetFieldByName(tab_->GetTableId(), name));
+    }
+    return std::make_unique<RecordSchema>(fields);
+  }
+
+  // stable sort of the whole table in memory as the reference
+  auto Expected(const std::vector<std::string> &keys, bool is_desc) -> std::vector<std::string>
+  {
+    auto                key_schema = KeySchema(keys);
+    std::vector<Record> recs;
+    SeqScanExecutor     scan(tab_.get());
+    for (scan.Init(); !scan.IsEnd(); scan.Next()) {
+      recs.push_back(std::move(*scan.GetRecord()));
+    }
+    std::stable_sort(recs.begin(), recs.end(), [&](const Record &lhs, const Record &rhs) {
+      auto cmp = Record::Compare(Record(key_schema.get(), lhs), Record(key_schema.get(), rhs));
+      return is_desc ? cmp > 0 : cmp < 0;
+    });
+    std::vector<std::string> rows;
+    for (const auto &rec : recs) {
+      rows.push_back(RecordToString(rec));
+    }
+    return rows;
+  }
+
+  std::unique_ptr<DiskManager>       disk_manager_;
+  std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+  std::unique_ptr<TableManager>      table_manager_;
+  std::string                        table_name_ = "sort_test";
+  TableHandleUptr                    tab_;
+};
+
+TEST_F(SortTest, MatchesStableSort)
+{
+  std::vector<std::vector<std::string>> key_sets{{"k"}, {"name", "k"}, {"f", "id"}};
+  // the default buffer sorts in memory, 16KB spill hundreds of runs and take more than one merge pass
+  for (const auto &keys : key_sets) {
+    for (bool is_desc : {false, true}) {
+      auto        expected = Expected(keys, is_desc);
+      std::string key_names;
+      for (const auto &key : keys) {
+        key_names += key + " ";
+      }
+      for (size_t buffer_size : {SORT_BUFFER_SIZE, static_cast<size_t>(16 * 1024)}) {
+        for (size_t worker_num : {static_cast<size_t>(1), SORT_WORKER_NUM}) {
+          SortExecutor sort(
+              std::make_unique<SeqScanExecutor>(tab_.get()), KeySchema(keys), is_desc, buffer_size, worker_num);
+          // run twice to check that Init restarts the sort
+          for (int round = 0; round < 2; ++round) {
+            std::vector<std::string> rows;
+            for (sort.Init(); !sort.IsEnd(); sort.Next()) {
+              rows.push_back(RecordToString(*sort.GetRecord()));
+            }
+            ASSERT_EQ(sort.IsMergeSort(), buffer_size != SORT_BUFFER_SIZE);
+            ASSERT_EQ(rows, expected) << fmt::format("keys: {}, desc: {}, buffer: {}, workers: {}",
+                key_names, is_desc, buffer_size, worker_num);
+          }
+        }
+      }
+    }
+  }
+}
+
+// a top-n returns the prefix of the stable sort, equal keys included
+TEST_F(SortTest, TopNMatchesSortLimit)
+{
+  std::vector<std::vector<std::string>> key_sets{{"k"}, {"name", "k"}};
+  for (const auto &keys : key_sets) {
+    for (bool is_desc : {false, true}) {
+      auto expected = Expected(keys, is_desc);
+      for (size_t limit : {0, 1, 50, SORT_ROWS - 1, SORT_ROWS, SORT_ROWS + 1}) {
+        TopNExecutor top_n(std::make_unique<SeqScanExecutor>(tab_.get()), KeySchema(keys), is_desc, limit);
+        std::vector<std::string> rows;
+        for (top_n.Init(); !top_n.IsEnd(); top_n.Next()) {
+          rows.push_back(RecordToString(*top_n.GetRecord()));
+        }
+        auto num = std::min(limit, expected.size());
+        ASSERT_EQ(rows, std::vector<std::string>(expected.begin(), expected.begin() + static_cast<ptrdiff_t>(num)))
+            << fmt::format("keys: {}, desc: {}, limit: {}", keys.front(), is_desc, limit);
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
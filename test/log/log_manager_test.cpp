@@ -0,0 +1,235 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "../config.h"
+#include "concurrency/txn_manager.h"
+#include "log/log_manager.h"
+#include "storage/buffer/buffer_pool_manager.h"
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class LogManagerTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    if (!std::filesystem::exists(TEST_DIR))
+      std::filesystem::create_directory(TEST_DIR);
+    if (std::filesystem::exists(log_file_))
+      std::filesystem::remove(log_file_);
+    disk_manager_ = std::make_unique<DiskManager>();
+    log_manager_  = std::make_unique<LogManager>(disk_manager_.get(), log_file_);
+  }
+
+  /// all records in the log file
+  auto ReadAll() -> std::vector<LogRecord>
+  {
+    std::string log;
+    disk_manager_->ReadLog(log_file_, log);
+    std::vector<LogRecord> recs;
+    for (size_t offset = 0; offset < log.size();) {
+      LogRecord rec;
+      auto      size = rec.DeserializeFrom(log.data() + offset, log.size() - offset);
+      EXPECT_GT(size, 0);
+      if (size == 0)
+        break;
+      offset += size;
+      recs.push_back(std::move(rec));
+    }
+    return recs;
+  }
+
+  static auto MakeInsert(txn_id_t txn_id, lsn_t prev_lsn, page_id_t page_id, slot_id_t slot_id) -> LogRecord
+  {
+    LogRecord rec(LogType::INSERT, txn_id, prev_lsn);
+    rec.file_name_ = "db/t.tab";
+    rec.page_id_   = page_id;
+    rec.slot_id_   = slot_id;
+    rec.after_     = std::string(32, static_cast<char>('a' + slot_id % 26));
+    return rec;
+  }
+
+  const std::string            log_file_ = TEST_DIR + "/log_manager_test.log";
+  std::unique_ptr<DiskManager> disk_manager_;
+  std::unique_ptr<LogManager>  log_manager_;
+};
+
+TEST_F(LogManagerTest, ConcurrentAppend)
+{
+  const int                thread_num = 8;
+  const int                per_thread = 2000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([this, t] {
+      lsn_t prev = INVALID_LSN;
+      for (int i = 0; i < per_thread; ++i) {
+        auto rec = MakeInsert(t, prev, t, i);
+        auto lsn = log_manager_->AppendLogRecord(rec);
+        ASSERT_GT(lsn, prev);
+        prev = lsn;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log_manager_->FlushLog();
+  ASSERT_EQ(log_manager_->GetFlushedLsn(), thread_num * per_thread);
+
+  // lsns follow the order of the file, and the records of each thread are chained in the order they were appended
+  auto recs = ReadAll();
+  ASSERT_EQ(recs.size(), thread_num * per_thread);
+  std::vector<lsn_t> last(thread_num, INVALID_LSN);
+  std::vector<int>   count(thread_num, 0);
+  for (size_t i = 0; i < recs.size(); ++i) {
+    auto &rec = recs[i];
+    ASSERT_EQ(rec.lsn_, static_cast<lsn_t>(i + 1));
+    ASSERT_EQ(rec.type_, LogType::INSERT);
+    ASSERT_EQ(rec.prev_lsn_, last[rec.txn_id_]);
+    ASSERT_EQ(rec.slot_id_, count[rec.txn_id_]);
+    ASSERT_EQ(rec.file_name_, "db/t.tab");
+    ASSERT_EQ(rec.after_, std::string(32, static_cast<char>('a' + rec.slot_id_ % 26)));
+    ASSERT_TRUE(rec.before_.empty());
+    last[rec.txn_id_] = rec.lsn_;
+    count[rec.txn_id_]++;
+  }
+}
+
+TEST_F(LogManagerTest, GroupCommit)
+{
+  const int                thread_num = 16;
+  const int                per_thread = 50;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([this, t] {
+      for (int i = 0; i < per_thread; ++i) {
+        auto      rec = MakeInsert(t, INVALID_LSN, t, i);
+        auto      lsn = log_manager_->AppendLogRecord(rec);
+        LogRecord commit(LogType::COMMIT, t, lsn);
+        lsn = log_manager_->AppendLogRecord(commit);
+        log_manager_->WaitForFlush(lsn);
+        // the commit is durable once the wait returns
+        ASSERT_GE(log_manager_->GetFlushedLsn(), lsn);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto recs = ReadAll();
+  ASSERT_EQ(recs.size(), 2 * thread_num * per_thread);
+  size_t commits = 0;
+  for (auto &rec : recs) {
+    commits += rec.type_ == LogType::COMMIT ? 1 : 0;
+  }
+  ASSERT_EQ(commits, thread_num * per_thread);
+}
+
+TEST_F(LogManagerTest, Reopen)
+{
+  for (int i = 0; i < 100; ++i) {
+    auto rec = MakeInsert(7, INVALID_LSN, 1, i);
+    log_manager_->AppendLogRecord(rec);
+  }
+  log_manager_.reset();
+  // a torn record at the tail is cut off when the log is opened again
+  auto size = std::filesystem::file_size(log_file_);
+  {
+    std::string   torn;
+    auto          rec = MakeInsert(7, INVALID_LSN, 1, 100);
+    std::ofstream file(log_file_, std::ios::binary | std::ios::app);
+    rec.SerializeTo(torn);
+    file.write(torn.data(), static_cast<std::streamsize>(torn.size() / 2));
+  }
+  disk_manager_ = std::make_unique<DiskManager>();
+  log_manager_  = std::make_unique<LogManager>(disk_manager_.get(), log_file_);
+  ASSERT_EQ(std::filesystem::file_size(log_file_), size);
+  ASSERT_EQ(log_manager_->GetFlushedLsn(), 100);
+  ASSERT_EQ(log_manager_->GetMaxTxnId(), 7);
+  auto rec = MakeInsert(8, INVALID_LSN, 1, 0);
+  ASSERT_EQ(log_manager_->AppendLogRecord(rec), 101);
+  log_manager_->FlushLog();
+  auto recs = ReadAll();
+  ASSERT_EQ(recs.size(), 101);
+  ASSERT_EQ(recs.back().txn_id_, 8);
+}
+
+TEST_F(LogManagerTest, WriteAheadRule)
+{
+  const std::string file_name = TEST_DIR + "/log_manager_test.tab";
+  if (DiskManager::FileExists(file_name))
+    DiskManager::DestroyFile(file_name);
+  DiskManager::CreateFile(file_name);
+  auto              fid = disk_manager_->OpenFile(file_name);
+  BufferPoolManager bpm(disk_manager_.get(), log_manager_.get(), 0, 2, 1);
+  // every page is changed by a record that is not flushed yet, evicting it has to flush the log first
+  std::vector<lsn_t> lsns;
+  for (page_id_t pid = 1; pid <= 8; ++pid) {
+    auto page = bpm.FetchPage(fid, pid);
+    auto rec  = MakeInsert(1, INVALID_LSN, pid, 0);
+    page->SetLsn(log_manager_->AppendLogRecord(rec));
+    lsns.push_back(page->GetLsn());
+    bpm.UnpinPage(fid, pid, true);
+    if (pid > 2) {
+      ASSERT_GE(log_manager_->GetFlushedLsn(), lsns[pid - 3]);
+    }
+  }
+  bpm.FlushAllPages(fid);
+  ASSERT_GE(log_manager_->GetFlushedLsn(), lsns.back());
+  bpm.DeleteAllPages(fid);
+  disk_manager_->CloseFile(fid);
+  DiskManager::DestroyFile(file_name);
+}
+
+TEST_F(LogManagerTest, TxnCommit)
+{
+  TxnManager  txn_manager(log_manager_.get());
+  Transaction txn;
+  txn_manager.SetTransaction(&txn);
+  ASSERT_EQ(TxnManager::GetTransaction(), &txn);
+  ASSERT_EQ(txn.GetState(), TxnState::GROWING);
+  // a read only transaction writes no log
+  txn_manager.Commit(txn.GetTxnId());
+  ASSERT_EQ(txn.GetState(), TxnState::COMMITTED);
+  ASSERT_TRUE(ReadAll().empty());
+
+  txn_manager.SetTransaction(&txn);
+  ASSERT_EQ(txn.GetState(), TxnState::GROWING);
+  auto rec = MakeInsert(txn.GetTxnId(), txn.GetPrevLsn(), 1, 0);
+  txn.SetPrevLsn(log_manager_->AppendLogRecord(rec));
+  txn_manager.Commit(txn.GetTxnId());
+  ASSERT_EQ(txn.GetState(), TxnState::COMMITTED);
+  // commit returns after its record is durable
+  ASSERT_GE(log_manager_->GetFlushedLsn(), txn.GetPrevLsn());
+  auto recs = ReadAll();
+  ASSERT_EQ(recs.size(), 2);
+  ASSERT_EQ(recs[1].type_, LogType::COMMIT);
+  ASSERT_EQ(recs[1].prev_lsn_, recs[0].lsn_);
+  ASSERT_EQ(recs[1].txn_id_, txn.GetTxnId());
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,402 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "../config.h"
+#include "concurrency/txn_manager.h"
+#include "log/recovery.h"
+
+#include <deque>
+#include <filesystem>
+#include <map>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+/// remembers where the master record and the buffer pool stood whenever the data files were synced
+class SyncRecordingDiskManager : public DiskManager
+{
+public:
+  void SyncDataFiles() override
+  {
+    syncs_.emplace_back(log_manager_->GetRedoLsn(), buffer_pool_manager_->GetMinRecLsn());
+    DiskManager::SyncDataFiles();
+  }
+
+  LogManager                          *log_manager_{nullptr};
+  BufferPoolManager                   *buffer_pool_manager_{nullptr};
+  std::vector<std::pair<lsn_t, lsn_t>> syncs_;  // redo lsn of the master record, min rec lsn of the pool
+};
+
+class RecoveryTest : public ::testing::Test
+{
+protected:
+  /// what a running system keeps in memory, it is dropped without closing the database to simulate a crash
+  struct Instance
+  {
+    explicit Instance(const std::string &db_name, std::unique_ptr<DiskManager> disk_manager = nullptr)
+    {
+      disk_manager_ = disk_manager != nullptr ? std::move(disk_manager) : std::make_unique<DiskManager>();
+      log_manager_  = std::make_unique<LogManager>(disk_manager_.get(), "recovery_test.log");
+      // the pool is much smaller than the table so that uncommitted changes are written back by eviction
+      buffer_pool_manager_ = std::make_unique<BufferPoolManager>(disk_manager_.get(), log_manager_.get(), 0, 16, 1);
+      table_manager_       = std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get());
+      index_manager_       = std::make_unique<IndexManager>(disk_manager_.get(), buffer_pool_manager_.get());
+      db_ = std::make_unique<DatabaseHandle>(db_name, disk_manager_.get(), table_manager_.get(), index_manager_.get());
+      txn_manager_ = std::make_unique<TxnManager>(log_manager_.get());
+      recovery_    = std::make_unique<Recovery>(disk_manager_.get(), buffer_pool_manager_.get());
+    }
+
+    void Open()
+    {
+      if (db_->ref_cnt_++ == 0)
+        db_->Open();
+    }
+
+    /// what the system does on start, for this database and the others given
+    void Recover(const std::vector<DatabaseHandle *> &others = {})
+    {
+      recovery_->AnalyzeLog();
+      recovery_->SetDBHandle(db_.get());
+      recovery_->Redo();
+      recovery_->Undo();
+      for (auto db : others) {
+        recovery_->SetDBHandle(db);
+        recovery_->Redo();
+        recovery_->Undo();
+      }
+      recovery_->AbortLosers();
+    }
+
+    /// what the checkpointer of the system does
+    void Checkpoint()
+    {
+      auto meta_lsn = log_manager_->GetNextLsn();
+      db_->FlushTableHeaders();
+      recovery_->Checkpoint(meta_lsn);
+    }
+
+    std::unique_ptr<DiskManager>       disk_manager_;
+    std::unique_ptr<LogManager>        log_manager_;
+    std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+    std::unique_ptr<TableManager>      table_manager_;
+    std::unique_ptr<IndexManager>      index_manager_;
+    std::unique_ptr<DatabaseHandle>    db_;
+    std::unique_ptr<TxnManager>        txn_manager_;
+    std::unique_ptr<Recovery>          recovery_;
+  };
+
+  void SetUp() override
+  {
+    for (const auto &file : {db_name_, std::string("recovery_test.log"), std::string("recovery_test.log.ckpt")})
+      if (std::filesystem::exists(file))
+        std::filesystem::remove_all(file);
+    std::filesystem::create_directory(db_name_);
+    DiskManager::CreateFile(FILE_NAME(db_name_, db_name_, DB_SUFFIX));
+    inst_ = std::make_unique<Instance>(db_name_);
+    inst_->Open();
+    std::vector<RTField> fields(2);
+    fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+    fields[1].field_ = {.field_name_ = "name", .field_size_ = 16, .field_type_ = TYPE_STRING};
+    inst_->db_->CreateTable(table_name_, RecordSchema(fields), NARY_MODEL);
+  }
+
+  void TearDown() override
+  {
+    inst_->db_->Close();
+    inst_.reset();
+  }
+
+  /// drop everything in memory and start again from the files
+  void Crash() { inst_ = std::make_unique<Instance>(db_name_); }
+
+  /// restart after a crash and open the database
+  void Restart()
+  {
+    Crash();
+    inst_->Recover();
+    inst_->Open();
+  }
+
+  auto Table() -> TableHandle * { return inst_->db_->GetTable(table_name_); }
+
+  /// run the following changes in a new transaction
+  auto Begin() -> Transaction *
+  {
+    auto txn = &txns_.emplace_back();
+    inst_->txn_manager_->SetTransaction(txn);
+    return txn;
+  }
+
+  void Commit(Transaction *txn) { inst_->txn_manager_->Commit(txn->GetTxnId()); }
+
+  auto MakeRecord(int id, int version) -> RecordUptr
+  {
+    char name[16]{};
+    fmt::format_to_n(name, sizeof(name) - 1, "v{}-{}", version, id);
+    return std::make_unique<Record>(&Table()->GetSchema(),
+        std::vector<ValueSptr>{ValueFactory::CreateIntValue(id), ValueFactory::CreateStringValue(name, sizeof(name))},
+        INVALID_RID);
+  }
+
+  static auto DataOf(const Record &rec) -> std::string
+  {
+    return {rec.GetData(), rec.GetSchema()->GetRecordLength()};
+  }
+
+  /// insert rows and remember what the table should hold if the transaction commits
+  void Insert(int from, int to, int version, std::map<int, std::string> *rows)
+  {
+    for (int id = from; id < to; ++id) {
+      auto rec  = MakeRecord(id, version);
+      rids_[id] = Table()->InsertRecord(*rec);
+      if (rows != nullptr)
+        (*rows)[id] = DataOf(*rec);
+    }
+  }
+
+  /// id -> data of every row in the table
+  auto ReadTable(TableHandle *tab = nullptr) -> std::map<int, std::string>
+  {
+    tab = tab == nullptr ? Table() : tab;
+    std::map<int, std::string> rows;
+    for (auto rid = tab->GetFirstRID(); rid != INVALID_RID; rid = tab->GetNextRID(rid)) {
+      auto rec                                           = tab->GetRecord(rid);
+      rows[*reinterpret_cast<const int *>(rec->GetData())] = DataOf(*rec);
+    }
+    return rows;
+  }
+
+  auto CountLog(LogType type) -> size_t
+  {
+    std::vector<LogRecord> recs;
+    inst_->log_manager_->ReadLog(recs);
+    return std::count_if(recs.begin(), recs.end(), [type](const auto &rec) { return rec.type_ == type; });
+  }
+
+  const std::string               db_name_    = "recovery_db";
+  const std::string               table_name_ = "recovery_table";
+  std::unique_ptr<Instance>       inst_;
+  std::deque<Transaction>         txns_;
+  std::unordered_map<int, RID>    rids_;
+};
+
+TEST_F(RecoveryTest, RedoAndUndo)
+{
+  const int n = 3000;
+  RecordSchema key_schema({Table()->GetSchema().GetFieldAt(0)});
+  inst_->db_->CreateIndex(table_name_, key_schema, IndexType::BPTREE);
+  std::map<int, std::string> rows;
+  auto                       committed = Begin();
+  Insert(0, n, 0, &rows);
+  Commit(committed);
+
+  // the loser inserts rows, deletes and updates committed ones, and never commits
+  Begin();
+  Insert(n, n + 1000, 0, nullptr);
+  for (int id = 0; id < 100; ++id)
+    Table()->DeleteRecord(rids_[id]);
+  for (int id = 100; id < 200; ++id)
+    Table()->UpdateRecord(rids_[id], *MakeRecord(id, 1));
+  inst_->log_manager_->FlushLog();
+
+  Restart();
+  ASSERT_EQ(ReadTable(), rows);
+  ASSERT_EQ(Table()->GetTableHeader().rec_num_, n);
+  // the index is built again from the recovered rows
+  auto index = inst_->db_->GetIndexes(table_name_).front();
+  for (int id = 0; id < n + 1000; id += 7) {
+    Record key(&index->GetKeySchema(), std::vector<ValueSptr>{ValueFactory::CreateIntValue(id)}, INVALID_RID);
+    auto   rids = index->GetIndex()->Search(key);
+    ASSERT_EQ(rids.size(), id < n ? 1 : 0);
+    if (id < n) {
+      ASSERT_EQ(DataOf(*Table()->GetRecord(rids[0])), rows[id]);
+    }
+  }
+  // the rebuilt free page list takes new rows
+  auto txn = Begin();
+  Insert(n + 1000, n + 1500, 2, &rows);
+  Commit(txn);
+  ASSERT_EQ(ReadTable(), rows);
+  ASSERT_EQ(Table()->GetTableHeader().rec_num_, n + 500);
+}
+
+TEST_F(RecoveryTest, CrashDuringRecovery)
+{
+  const int                  n = 2000;
+  std::map<int, std::string> rows;
+  auto                       committed = Begin();
+  Insert(0, n, 0, &rows);
+  Commit(committed);
+  Begin();
+  Insert(n, n + 500, 0, nullptr);
+  for (int id = 0; id < 300; ++id)
+    Table()->UpdateRecord(rids_[id], *MakeRecord(id, 1));
+  inst_->log_manager_->FlushLog();
+
+  // crash again right after redo, the pages it has written carry the lsns of the records already applied
+  Crash();
+  inst_->recovery_->AnalyzeLog();
+  inst_->recovery_->SetDBHandle(inst_->db_.get());
+  inst_->recovery_->Redo();
+  inst_->buffer_pool_manager_->CleanDirtyPages();
+
+  // the loser is rolled back exactly once, however often recovery runs
+  Restart();
+  ASSERT_EQ(ReadTable(), rows);
+  inst_->db_->Close();
+  Restart();
+  ASSERT_EQ(ReadTable(), rows);
+  ASSERT_EQ(Table()->GetTableHeader().rec_num_, n);
+  ASSERT_EQ(CountLog(LogType::ABORT), 1);
+  ASSERT_EQ(CountLog(LogType::CLR), 800);
+}
+
+TEST_F(RecoveryTest, Checkpoint)
+{
+  const int                  n = 2000;
+  std::map<int, std::string> rows;
+  auto                       txn = Begin();
+  Insert(0, n, 0, &rows);
+  Commit(txn);
+  inst_->Checkpoint();
+  txn = Begin();
+  Insert(n, 2 * n, 0, &rows);
+  Commit(txn);
+  // a checkpoint writes the pages dirtied before the previous one, after two in a row restart skips all rows so far
+  inst_->Checkpoint();
+  inst_->Checkpoint();
+  txn = Begin();
+  Insert(2 * n, 3 * n, 0, &rows);
+  for (int id = 0; id < n; id += 2)
+    Table()->UpdateRecord(rids_[id], *MakeRecord(id, 1));
+  Commit(txn);
+  for (int id = 0; id < n; id += 2)
+    rows[id] = DataOf(*MakeRecord(id, 1));
+
+  Crash();
+  ASSERT_GT(inst_->log_manager_->GetRedoLsn(), 2 * n);
+  std::vector<LogRecord> recs;
+  inst_->log_manager_->ReadLog(recs);
+  ASSERT_LT(recs.size(), 2 * n);
+  inst_->Recover();
+  inst_->Open();
+  ASSERT_EQ(ReadTable(), rows);
+  ASSERT_EQ(Table()->GetTableHeader().rec_num_, 3 * n);
+}
+
+TEST_F(RecoveryTest, TwoDatabases)
+{
+  const int         n          = 1000;
+  const std::string other_name = "recovery_db2";
+  if (std::filesystem::exists(other_name))
+    std::filesystem::remove_all(other_name);
+  std::filesystem::create_directory(other_name);
+  DiskManager::CreateFile(FILE_NAME(other_name, other_name, DB_SUFFIX));
+  auto make_other = [&] {
+    return std::make_unique<DatabaseHandle>(
+        other_name, inst_->disk_manager_.get(), inst_->table_manager_.get(), inst_->index_manager_.get());
+  };
+  auto other = make_other();
+  other->ref_cnt_++;
+  other->Open();
+  other->CreateTable(table_name_, Table()->GetSchema(), NARY_MODEL);
+  auto other_table = [&] { return other->GetTable(table_name_); };
+
+  std::map<int, std::string>   rows;
+  std::map<int, std::string>   other_rows;
+  std::unordered_map<int, RID> other_rids;
+  auto                         committed = Begin();
+  Insert(0, n, 0, &rows);
+  for (int id = 0; id < n; ++id) {
+    auto rec       = MakeRecord(id, 0);
+    other_rids[id] = other_table()->InsertRecord(*rec);
+    other_rows[id] = DataOf(*rec);
+  }
+  Commit(committed);
+  // the loser changes both databases in turn after it has used the second one
+  Begin();
+  for (int id = 0; id < 200; ++id) {
+    Insert(n + id, n + id + 1, 0, nullptr);
+    other_table()->InsertRecord(*MakeRecord(n + id, 0));
+    Table()->UpdateRecord(rids_[id], *MakeRecord(id, 1));
+    other_table()->UpdateRecord(other_rids[id], *MakeRecord(id, 1));
+  }
+  inst_->log_manager_->FlushLog();
+
+  // crash after the first database is rolled back and before the loser is aborted, its CLRs must not hide the
+  // records of the second database from the next restart
+  Crash();
+  other = make_other();
+  inst_->recovery_->AnalyzeLog();
+  inst_->recovery_->SetDBHandle(inst_->db_.get());
+  inst_->recovery_->Redo();
+  inst_->recovery_->Undo();
+
+  Crash();
+  other = make_other();
+  inst_->Recover({other.get()});
+  inst_->Open();
+  other->ref_cnt_++;
+  other->Open();
+  ASSERT_EQ(ReadTable(), rows);
+  ASSERT_EQ(ReadTable(other_table()), other_rows);
+  ASSERT_EQ(other_table()->GetTableHeader().rec_num_, n);
+  ASSERT_EQ(CountLog(LogType::ABORT), 1);
+  other->Close();
+  other.reset();
+  std::filesystem::remove_all(other_name);
+}
+
+TEST_F(RecoveryTest, CheckpointSyncsDataFiles)
+{
+  const int n = 2000;
+  inst_->db_->Close();
+  auto disk_manager              = std::make_unique<SyncRecordingDiskManager>();
+  auto recorder                  = disk_manager.get();
+  inst_                          = std::make_unique<Instance>(db_name_, std::move(disk_manager));
+  recorder->log_manager_         = inst_->log_manager_.get();
+  recorder->buffer_pool_manager_ = inst_->buffer_pool_manager_.get();
+  inst_->Open();
+  auto txn = Begin();
+  Insert(0, n, 0, nullptr);
+  Commit(txn);
+  inst_->Checkpoint();
+  auto first_checkpoint_lsn = inst_->log_manager_->GetNextLsn();
+  auto redo_lsn             = inst_->log_manager_->GetRedoLsn();
+  txn                       = Begin();
+  Insert(n, 2 * n, 0, nullptr);
+  Commit(txn);
+  inst_->Checkpoint();
+
+  // every checkpoint syncs once, after the pages dirtied before the previous checkpoint are written and before the
+  // master record moves
+  ASSERT_EQ(recorder->syncs_.size(), 2);
+  auto [sync_redo_lsn, sync_rec_lsn] = recorder->syncs_[1];
+  ASSERT_EQ(sync_redo_lsn, redo_lsn);
+  ASSERT_TRUE(sync_rec_lsn == INVALID_LSN || sync_rec_lsn >= first_checkpoint_lsn);
+  ASSERT_GT(inst_->log_manager_->GetRedoLsn(), redo_lsn);
+}
+
+int main(int argc, char **argv)
+{
+  // the database is a directory in the working directory
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  std::filesystem::current_path(TEST_DIR);
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,337 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/28.
+//
+
+#include "net/net_controller.h"
+
+#include <algorithm>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+auto MakeField(const std::string &name, FieldType type, size_t size) -> RTField
+{
+  RTField f;
+  f.field_.field_name_ = name;
+  f.field_.field_type_ = type;
+  f.field_.field_size_ = size;
+  return f;
+}
+
+// records are batched into few packages and arrive complete and in order, followed by the end package
+TEST(NetControllerTest, BatchedRecords)
+{
+  constexpr int REC_NUM = 100000;
+  int           fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  RecordSchema schema({MakeField("id", TYPE_INT, 4), MakeField("name", TYPE_STRING, 16)});
+  NetController controller;
+  std::thread   server([&]() {
+    controller.SendRecHeader(fds[0], &schema);
+    for (int i = 0; i < REC_NUM; ++i) {
+      auto   name = fmt::format("name{}", i);
+      Record rec(&schema,
+          {ValueFactory::CreateIntValue(i), ValueFactory::CreateStringValue(name.c_str(), name.size())},
+          INVALID_RID);
+      controller.SendRec(fds[0], &rec);
+    }
+    controller.SendRecFinish(fds[0]);
+    controller.Remove(fds[0]);
+  });
+  auto        pkg     = std::make_unique<net::NetPkg>();
+  size_t      pkg_num = 0;
+  std::string body;
+  ASSERT_GT(net::ReadNetPkg(fds[1], *pkg), 0);
+  ASSERT_EQ(pkg->type_, net::NET_PKG_REC_HEADER);
+  ASSERT_EQ(std::string(pkg->buf_, pkg->len_), "id\tname\t");
+  while (true) {
+    ASSERT_GT(net::ReadNetPkg(fds[1], *pkg), 0);
+    if (pkg->type_ == net::NET_PKG_REC_END) {
+      break;
+    }
+    ASSERT_EQ(pkg->type_, net::NET_PKG_REC_BODY);
+    // a package holds whole records
+    ASSERT_EQ(pkg->buf_[pkg->len_ - 1], '\0');
+    body.append(pkg->buf_, pkg->len_);
+    pkg_num++;
+  }
+  server.join();
+  std::string expected;
+  for (int i = 0; i < REC_NUM; ++i) {
+    expected += fmt::format("{}\tname{}\t", i, i);
+    expected += '\0';
+  }
+  ASSERT_EQ(body, expected);
+  // far fewer packages than records, batches may still be cut short by the flush interval
+  ASSERT_LT(pkg_num, static_cast<size_t>(REC_NUM / 100));
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// a partial batch is sent once it is due even if no more records follow
+TEST(NetControllerTest, PartialBatchDeadline)
+{
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  RecordSchema  schema({MakeField("id", TYPE_INT, 4)});
+  NetController controller;
+  controller.SendRecHeader(fds[0], &schema);
+  Record rec(&schema, {ValueFactory::CreateIntValue(7)}, INVALID_RID);
+  controller.SendRec(fds[0], &rec);
+
+  auto pkg = std::make_unique<net::NetPkg>();
+  ASSERT_GT(net::ReadNetPkg(fds[1], *pkg), 0);
+  ASSERT_EQ(pkg->type_, net::NET_PKG_REC_HEADER);
+  struct pollfd pfd
+  {
+    fds[1], POLLIN, 0
+  };
+  ASSERT_EQ(poll(&pfd, 1, 100 * net::NET_FLUSH_INTERVAL_MS), 1);
+  ASSERT_GT(net::ReadNetPkg(fds[1], *pkg), 0);
+  ASSERT_EQ(pkg->type_, net::NET_PKG_REC_BODY);
+  ASSERT_EQ(std::string(pkg->buf_, pkg->len_), std::string("7\t") + '\0');
+
+  controller.SendRecFinish(fds[0]);
+  ASSERT_GT(net::ReadNetPkg(fds[1], *pkg), 0);
+  ASSERT_EQ(pkg->type_, net::NET_PKG_REC_END);
+  controller.Remove(fds[0]);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// the client switches to the binary format, records and chunks arrive as column blocks holding the same values
+TEST(NetControllerTest, BinaryBlocks)
+{
+  constexpr int REC_NUM = 20000;
+  int           fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  RecordSchema schema({MakeField("id", TYPE_INT, 4),
+      MakeField("score", TYPE_FLOAT, 4),
+      MakeField("flag", TYPE_BOOL, 1),
+      MakeField("name", TYPE_STRING, 16)});
+  auto make_values = [&schema](int i) -> std::vector<ValueSptr> {
+    auto name = fmt::format("name{}", i);
+    if (i % 7 == 0) {
+      return {ValueFactory::CreateIntValue(i),
+          ValueFactory::CreateNullValue(TYPE_FLOAT),
+          ValueFactory::CreateNullValue(TYPE_BOOL),
+          ValueFactory::CreateNullValue(TYPE_STRING)};
+    }
+    return {ValueFactory::CreateIntValue(i),
+        ValueFactory::CreateFloatValue(static_cast<float>(i) / 4),
+        ValueFactory::CreateBoolValue(i % 2 == 0),
+        ValueFactory::CreateStringValue(name.c_str(), name.size())};
+  };
+  auto to_text = [](const std::vector<ValueSptr> &values) {
+    std::string text;
+    for (const auto &v : values) {
+      text += v->ToString();
+      text += '\t';
+    }
+    return text;
+  };
+  // the chunk holds the next REC_NUM rows, every third one is selected
+  std::vector<ArrayValueSptr> cols;
+  for (size_t c = 0; c < schema.GetFieldCount(); ++c) {
+    cols.push_back(ValueFactory::CreateArrayValue());
+  }
+  std::vector<size_t> sel;
+  for (int i = 0; i < REC_NUM; ++i) {
+    auto values = make_values(REC_NUM + i);
+    for (size_t c = 0; c < values.size(); ++c) {
+      cols[c]->Append(values[c]);
+    }
+    if (i % 3 == 0) {
+      sel.push_back(i);
+    }
+  }
+  Chunk chunk(&schema, cols, sel);
+
+  NetController controller;
+  std::thread   server([&]() {
+    // the format is set before the query is sent, which reads as an empty query
+    std::string sql;
+    while (sql.empty()) {
+      sql = controller.ReadSQL(fds[0]);
+    }
+    ASSERT_EQ(sql, "select;");
+    controller.SendRecHeader(fds[0], &schema);
+    for (int i = 0; i < REC_NUM; ++i) {
+      Record rec(&schema, make_values(i), INVALID_RID);
+      controller.SendRec(fds[0], &rec);
+    }
+    controller.SendChunk(fds[0], chunk);
+    controller.SendRecFinish(fds[0]);
+    controller.Remove(fds[0]);
+  });
+  auto pkg     = std::make_unique<net::NetPkg>();
+  pkg->type_   = net::NET_PKG_SET_FORMAT;
+  pkg->len_    = 1;
+  pkg->buf_[0] = static_cast<char>(net::NET_FORMAT_BINARY);
+  ASSERT_GT(net::WriteNetPkg(fds[1], *pkg), 0);
+  ASSERT_GT(net::ReadNetPkg(fds[1], *pkg), 0);
+  ASSERT_EQ(pkg->type_, net::NET_PKG_OK);
+  pkg->type_ = net::NET_PKG_QUERY;
+  pkg->len_  = 7;
+  memcpy(pkg->buf_, "select;", 7);
+  ASSERT_GT(net::WriteNetPkg(fds[1], *pkg), 0);
+
+  ASSERT_GT(net::ReadNetPkg(fds[1], *pkg), 0);
+  ASSERT_EQ(pkg->type_, net::NET_PKG_REC_HEADER);
+  std::vector<std::string> records;
+  size_t                   pkg_num = 0;
+  while (true) {
+    ASSERT_GT(net::ReadNetPkg(fds[1], *pkg), 0);
+    if (pkg->type_ == net::NET_PKG_REC_END) {
+      break;
+    }
+    ASSERT_EQ(pkg->type_, net::NET_PKG_REC_BLOCK);
+    ASSERT_TRUE(net::DecodeRecBlock(*pkg, records));
+    pkg_num++;
+  }
+  server.join();
+  std::vector<std::string> expected_records;
+  for (int i = 0; i < REC_NUM; ++i) {
+    expected_records.push_back(to_text(make_values(i)));
+  }
+  for (auto row : sel) {
+    expected_records.push_back(to_text(make_values(REC_NUM + static_cast<int>(row))));
+  }
+  ASSERT_EQ(records.size(), expected_records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    ASSERT_EQ(records[i], expected_records[i]) << "row " << i;
+  }
+  ASSERT_LT(pkg_num, expected_records.size() / 100);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// prepare, execute and close requests are read with their statement and parameters
+TEST(NetControllerTest, PreparedStatementRequests)
+{
+  int fds[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  NetController controller;
+  auto          pkg = std::make_unique<net::NetPkg>();
+
+  std::string sql = "select * from t where id = ? and name = ?;";
+  pkg->type_      = net::NET_PKG_PREPARE;
+  pkg->len_       = sql.size();
+  memcpy(pkg->buf_, sql.c_str(), sql.size());
+  ASSERT_GT(net::WriteNetPkg(fds[1], *pkg), 0);
+  auto req = controller.ReadRequest(fds[0]);
+  ASSERT_EQ(req.type_, net::NET_PKG_PREPARE);
+  ASSERT_EQ(req.sql_, sql);
+  controller.SendPrepared(fds[0], 7, 2);
+  ASSERT_GT(net::ReadNetPkg(fds[1], *pkg), 0);
+  ASSERT_EQ(pkg->type_, net::NET_PKG_PREPARED);
+  ASSERT_EQ(pkg->len_, 2 * sizeof(uint32_t));
+  uint32_t ids[2];
+  memcpy(ids, pkg->buf_, sizeof(ids));
+  ASSERT_EQ(ids[0], 7u);
+  ASSERT_EQ(ids[1], 2u);
+
+  int32_t       id = 42;
+  net::NetParam int_param{net::NET_COL_INT, false, std::string(reinterpret_cast<char *>(&id), sizeof(id))};
+  net::NetParam str_param{net::NET_COL_STRING, false, "alice"};
+  net::NetParam null_param{net::NET_COL_FLOAT, true, ""};
+  ASSERT_TRUE(net::EncodeExecute(*pkg, 7, {int_param, str_param, null_param}));
+  ASSERT_GT(net::WriteNetPkg(fds[1], *pkg), 0);
+  req = controller.ReadRequest(fds[0]);
+  ASSERT_EQ(req.type_, net::NET_PKG_EXECUTE);
+  ASSERT_EQ(req.stmt_id_, 7u);
+  ASSERT_EQ(req.params_.size(), 3u);
+  ASSERT_EQ(*req.params_[0], *ValueFactory::CreateIntValue(42));
+  ASSERT_EQ(*req.params_[1], *ValueFactory::CreateStringValue("alice", 5));
+  ASSERT_EQ(req.params_[2]->GetType(), TYPE_FLOAT);
+  ASSERT_TRUE(req.params_[2]->IsNull());
+
+  // a truncated package is rejected
+  ASSERT_TRUE(net::EncodeExecute(*pkg, 7, {int_param}));
+  pkg->len_ -= 1;
+  ASSERT_GT(net::WriteNetPkg(fds[1], *pkg), 0);
+  ASSERT_THROW(controller.ReadRequest(fds[0]), WSDBException_);
+
+  pkg->type_ = net::NET_PKG_CLOSE_STMT;
+  pkg->len_  = sizeof(uint32_t);
+  memcpy(pkg->buf_, &ids[0], sizeof(uint32_t));
+  ASSERT_GT(net::WriteNetPkg(fds[1], *pkg), 0);
+  req = controller.ReadRequest(fds[0]);
+  ASSERT_EQ(req.type_, net::NET_PKG_CLOSE_STMT);
+  ASSERT_EQ(req.stmt_id_, 7u);
+  controller.Remove(fds[0]);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// a watched client is reported once when it has input, and again only after it is rearmed
+TEST(NetControllerTest, WaitReadyClients)
+{
+  constexpr int CLIENT_NUM = 8;
+  NetController controller;
+  int           fds[CLIENT_NUM][2];
+  for (auto &fd : fds) {
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fd), 0);
+    controller.Watch(fd[0]);
+  }
+  std::vector<int> ready;
+  ASSERT_EQ(controller.Wait(ready, 0), 0);
+
+  auto pkg   = std::make_unique<net::NetPkg>();
+  pkg->type_ = net::NET_PKG_QUERY;
+  pkg->len_  = 5;
+  memcpy(pkg->buf_, "exit;", 5);
+  ASSERT_GT(net::WriteNetPkg(fds[1][1], *pkg), 0);
+  ASSERT_GT(net::WriteNetPkg(fds[5][1], *pkg), 0);
+  ASSERT_EQ(controller.Wait(ready, 1000), 2);
+  std::sort(ready.begin(), ready.end());
+  ASSERT_EQ(ready, std::vector<int>({fds[1][0], fds[5][0]}));
+  // still readable, but not watched until rearmed
+  ASSERT_EQ(controller.Wait(ready, 0), 0);
+  ASSERT_EQ(controller.ReadSQL(fds[1][0]), "exit;");
+  controller.Rearm(fds[1][0]);
+  controller.Rearm(fds[5][0]);
+  ASSERT_EQ(controller.Wait(ready, 1000), 1);
+  ASSERT_EQ(ready[0], fds[5][0]);
+
+  // a client that hangs up is reported so that it can be closed
+  close(fds[2][1]);
+  ASSERT_EQ(controller.Wait(ready, 1000), 1);
+  ASSERT_EQ(ready[0], fds[2][0]);
+  ASSERT_THROW(controller.ReadSQL(fds[2][0]), WSDBException_);
+  for (int i = 0; i < CLIENT_NUM; ++i) {
+    controller.Remove(fds[i][0]);
+    close(fds[i][0]);
+    if (i != 2) {
+      close(fds[i][1]);
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
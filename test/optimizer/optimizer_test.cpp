@@ -0,0 +1,307 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "../config.h"
+#include "optimizer/optimizer.h"
+
+#include <filesystem>
+#include <set>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class OptimizerTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    if (std::filesystem::exists(db_name_))
+      std::filesystem::remove_all(db_name_);
+    std::filesystem::create_directory(db_name_);
+    DiskManager::CreateFile(FILE_NAME(db_name_, db_name_, DB_SUFFIX));
+    disk_manager_        = std::make_unique<DiskManager>();
+    buffer_pool_manager_ = std::make_unique<BufferPoolManager>(disk_manager_.get(), nullptr);
+    table_manager_       = std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    index_manager_       = std::make_unique<IndexManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    db_ = std::make_unique<DatabaseHandle>(db_name_, disk_manager_.get(), table_manager_.get(), index_manager_.get());
+    db_->ref_cnt_++;
+    db_->Open();
+  }
+
+  void TearDown() override
+  {
+    db_->Close();
+    std::filesystem::remove_all(db_name_);
+  }
+
+  /// a table of rows (id, k) with id = i and k = i % k_mod, analyzed unless told otherwise
+  void MakeTable(const std::string &name, int rows, int k_mod, bool analyze = true)
+  {
+    std::vector<RTField> fields(2);
+    fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+    fields[1].field_ = {.field_name_ = "k", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+    db_->CreateTable(name, RecordSchema(fields), NARY_MODEL);
+    auto tab = db_->GetTable(name);
+    for (int i = 0; i < rows; ++i) {
+      Record rec(&tab->GetSchema(),
+          std::vector<ValueSptr>{ValueFactory::CreateIntValue(i), ValueFactory::CreateIntValue(i % k_mod)},
+          INVALID_RID);
+      tab->InsertRecord(rec);
+    }
+    if (analyze) {
+      db_->AnalyzeTable(name);
+    }
+  }
+
+  auto Col(const std::string &tab_name, const std::string &field_name) -> RTField
+  {
+    for (const auto &field : db_->GetTable(tab_name)->GetSchema().GetFields()) {
+      if (field.field_.field_name_ == field_name) {
+        return field;
+      }
+    }
+    ADD_FAILURE() << "no column " << tab_name << "." << field_name;
+    return {};
+  }
+
+  static auto Eq(const RTField &l, const RTField &r) -> Condition { return {OP_EQ, l, r}; }
+
+  auto Filter(const std::string &tab_name, CompOp op, const std::string &field_name, int val)
+      -> std::shared_ptr<AbstractPlan>
+  {
+    ValueSptr    rval = ValueFactory::CreateIntValue(val);
+    ConditionVec conds{Condition(op, Col(tab_name, field_name), rval)};
+    return std::make_shared<FilterPlan>(std::make_shared<ScanPlan>(tab_name), conds);
+  }
+
+  static auto Scan(const std::string &tab_name) -> std::shared_ptr<AbstractPlan>
+  {
+    return std::make_shared<ScanPlan>(tab_name);
+  }
+
+  static auto Join(std::shared_ptr<AbstractPlan> left, std::shared_ptr<AbstractPlan> right, ConditionVec conds,
+      JoinStrategy strategy = HASH_JOIN) -> std::shared_ptr<JoinPlan>
+  {
+    return std::make_shared<JoinPlan>(std::move(left), std::move(right), conds, INNER_JOIN, strategy);
+  }
+
+  /// ids of the tables read by a plan
+  auto TablesOf(const std::shared_ptr<AbstractPlan> &plan) -> std::set<table_id_t>
+  {
+    if (auto scan = std::dynamic_pointer_cast<ScanPlan>(plan)) {
+      return {db_->GetTable(scan->table_name_)->GetTableId()};
+    } else if (auto idx_scan = std::dynamic_pointer_cast<IdxScanPlan>(plan)) {
+      return {db_->GetTable(idx_scan->table_name_)->GetTableId()};
+    } else if (auto filter = std::dynamic_pointer_cast<FilterPlan>(plan)) {
+      return TablesOf(filter->child_);
+    } else if (auto sort = std::dynamic_pointer_cast<SortPlan>(plan)) {
+      return TablesOf(sort->child_);
+    } else if (auto join = std::dynamic_pointer_cast<JoinPlan>(plan)) {
+      auto tables = TablesOf(join->left_);
+      tables.merge(TablesOf(join->right_));
+      return tables;
+    }
+    ADD_FAILURE() << "unexpected plan\n" << plan->ToString(0);
+    return {};
+  }
+
+  auto TablesOf(const std::vector<std::string> &tab_names) -> std::set<table_id_t>
+  {
+    std::set<table_id_t> tables;
+    for (const auto &name : tab_names) {
+      tables.insert(db_->GetTable(name)->GetTableId());
+    }
+    return tables;
+  }
+
+  /// every join of the tree reads the columns on the left of its conditions from its left input, returns the joins
+  auto CheckJoins(const std::shared_ptr<AbstractPlan> &plan) -> size_t
+  {
+    auto join = std::dynamic_pointer_cast<JoinPlan>(plan);
+    if (join == nullptr) {
+      return 0;
+    }
+    auto left  = TablesOf(join->left_);
+    auto right = TablesOf(join->right_);
+    for (const auto &cond : join->conds_) {
+      EXPECT_EQ(left.count(cond.GetLCol().field_.table_id_), 1) << cond.ToString();
+      EXPECT_EQ(right.count(cond.GetRCol().field_.table_id_), 1) << cond.ToString();
+    }
+    auto unwrap = [](const std::shared_ptr<AbstractPlan> &input) {
+      auto sort = std::dynamic_pointer_cast<SortPlan>(input);
+      return sort != nullptr ? sort->child_ : input;
+    };
+    return 1 + CheckJoins(unwrap(join->left_)) + CheckJoins(unwrap(join->right_));
+  }
+
+  const std::string                  db_name_ = "optimizer_test_db";
+  std::unique_ptr<DiskManager>       disk_manager_;
+  std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+  std::unique_ptr<TableManager>      table_manager_;
+  std::unique_ptr<IndexManager>      index_manager_;
+  std::unique_ptr<DatabaseHandle>    db_;
+};
+
+TEST_F(OptimizerTest, StarJoin)
+{
+  // the fact table refers to each dimension by its k, a filter keeps one row of every dimension
+  MakeTable("fact", 5000, 100);
+  MakeTable("dim1", 100, 100);
+  MakeTable("dim2", 100, 100);
+  MakeTable("dim3", 100, 100);
+  // written as joins of the fact table with one dimension after another
+  auto plan = Join(Join(Join(Scan("fact"),
+                                 Filter("dim1", OP_EQ, "id", 1),
+                                 {Eq(Col("fact", "k"), Col("dim1", "id"))}),
+                       Filter("dim2", OP_EQ, "id", 2),
+                       {Eq(Col("fact", "k"), Col("dim2", "id"))}),
+      Filter("dim3", OP_EQ, "id", 3),
+      {Eq(Col("fact", "k"), Col("dim3", "id"))});
+  auto opt  = std::dynamic_pointer_cast<JoinPlan>(Optimizer::Optimize(plan, db_.get()));
+  ASSERT_NE(opt, nullptr);
+  ASSERT_EQ(CheckJoins(opt), 3);
+  // the filtered dimensions are combined first and the fact table is joined once at the top, on the probe side
+  ASSERT_EQ(TablesOf(opt->left_), TablesOf({"fact"})) << opt->ToString(0);
+  ASSERT_EQ(TablesOf(opt->right_), TablesOf({"dim1", "dim2", "dim3"})) << opt->ToString(0);
+  ASSERT_EQ(opt->strategy_, HASH_JOIN);
+  ASSERT_EQ(opt->conds_.size(), 3);
+  ASSERT_FALSE(opt->build_left_);
+}
+
+TEST_F(OptimizerTest, GreedyAboveDPLimit)
+{
+  // a chain t0 - t1 - ... - tn of growing tables, written from the largest table down
+  const size_t n = JOIN_REORDER_DP_LIMIT + 1;
+  for (size_t i = 0; i < n; ++i) {
+    MakeTable(fmt::format("t{}", i), static_cast<int>(10 * (i + 1)), 10);
+  }
+  std::shared_ptr<AbstractPlan> plan = Scan(fmt::format("t{}", n - 1));
+  for (size_t i = n - 1; i > 0; --i) {
+    auto cur  = fmt::format("t{}", i);
+    auto next = fmt::format("t{}", i - 1);
+    plan      = Join(plan, Scan(next), {Eq(Col(cur, "id"), Col(next, "id"))});
+  }
+  auto opt = std::dynamic_pointer_cast<JoinPlan>(Optimizer::Optimize(plan, db_.get()));
+  ASSERT_NE(opt, nullptr);
+  ASSERT_EQ(CheckJoins(opt), n - 1);
+  std::vector<std::string> names;
+  for (size_t i = 0; i < n; ++i) {
+    names.push_back(fmt::format("t{}", i));
+  }
+  ASSERT_EQ(TablesOf(opt), TablesOf(names));
+  // the chain is connected, so no join is a cross product
+  std::function<void(const std::shared_ptr<AbstractPlan> &)> no_cross = [&](const auto &p) {
+    if (auto join = std::dynamic_pointer_cast<JoinPlan>(p)) {
+      ASSERT_FALSE(join->conds_.empty()) << opt->ToString(0);
+      ASSERT_EQ(join->strategy_, HASH_JOIN);
+      no_cross(join->left_);
+      no_cross(join->right_);
+    }
+  };
+  no_cross(opt);
+}
+
+TEST_F(OptimizerTest, CrossProduct)
+{
+  MakeTable("a", 1000, 10);
+  MakeTable("b", 100, 10);
+  MakeTable("c", 10, 10);
+  // c is not connected to the others, the condition between a and b is given above the cross product
+  auto plan = Join(Join(Scan("a"), Scan("c"), {}), Scan("b"), {Eq(Col("a", "id"), Col("b", "id"))});
+  auto opt  = std::dynamic_pointer_cast<JoinPlan>(Optimizer::Optimize(plan, db_.get()));
+  ASSERT_NE(opt, nullptr);
+  ASSERT_EQ(CheckJoins(opt), 2);
+  // the connected tables are joined first by their condition, the cross product with c is left to the end
+  ASSERT_TRUE(opt->conds_.empty()) << opt->ToString(0);
+  ASSERT_EQ(opt->strategy_, NESTED_LOOP);
+  ASSERT_EQ(TablesOf(opt->right_), TablesOf({"c"})) << opt->ToString(0);
+  auto inner = std::dynamic_pointer_cast<JoinPlan>(opt->left_);
+  ASSERT_NE(inner, nullptr);
+  ASSERT_EQ(inner->conds_.size(), 1);
+  ASSERT_EQ(inner->strategy_, HASH_JOIN);
+  ASSERT_EQ(TablesOf(inner), TablesOf({"a", "b"}));
+}
+
+TEST_F(OptimizerTest, FlipCondition)
+{
+  MakeTable("big", 1000, 10);
+  MakeTable("small", 10, 10);
+  // an implicit condition of the where clause names the columns in the other order than the tables are joined
+  auto plan = Join(Scan("small"),
+      Scan("big"),
+      {Eq(Col("big", "id"), Col("small", "id")), Condition(OP_LT, Col("big", "k"), Col("small", "k"))},
+      NESTED_LOOP);
+  auto opt  = std::dynamic_pointer_cast<JoinPlan>(Optimizer::Optimize(plan, db_.get()));
+  ASSERT_NE(opt, nullptr);
+  ASSERT_EQ(CheckJoins(opt), 1);
+  // the larger input is moved to the left and the conditions follow their columns
+  ASSERT_EQ(TablesOf(opt->left_), TablesOf({"big"}));
+  ASSERT_EQ(opt->conds_.size(), 2);
+  ASSERT_EQ(opt->conds_[0].GetOp(), OP_EQ);
+  ASSERT_EQ(opt->conds_[1].GetOp(), OP_LT);
+  // joined the other way round the conditions are flipped, a < b becomes b > a
+  plan = Join(Scan("big"),
+      Scan("small"),
+      {Eq(Col("small", "id"), Col("big", "id")), Condition(OP_LT, Col("small", "k"), Col("big", "k"))},
+      NESTED_LOOP);
+  opt  = std::dynamic_pointer_cast<JoinPlan>(Optimizer::Optimize(plan, db_.get()));
+  ASSERT_NE(opt, nullptr);
+  ASSERT_EQ(CheckJoins(opt), 1);
+  ASSERT_EQ(TablesOf(opt->left_), TablesOf({"big"}));
+  ASSERT_EQ(opt->conds_[0].GetOp(), OP_EQ);
+  ASSERT_EQ(opt->conds_[1].GetOp(), OP_GT);
+  ASSERT_EQ(opt->conds_[1].GetLCol().field_.field_name_, "k");
+}
+
+TEST_F(OptimizerTest, CostBasedStrategy)
+{
+  MakeTable("r", 1000, 10);
+  MakeTable("s", 500, 10);
+  db_->CreateIndex("r", RecordSchema({Col("r", "id")}), IndexType::BPTREE);
+  db_->CreateIndex("s", RecordSchema({Col("s", "id")}), IndexType::BPTREE);
+  // both inputs come out of b+tree index scans ordered by the join key
+  auto plan = Join(Filter("r", OP_GE, "id", 0), Filter("s", OP_GE, "id", 0), {Eq(Col("r", "id"), Col("s", "id"))},
+      COST_BASED);
+  auto opt  = std::dynamic_pointer_cast<JoinPlan>(Optimizer::Optimize(plan, db_.get()));
+  ASSERT_NE(opt, nullptr);
+  ASSERT_EQ(opt->strategy_, SORT_MERGE) << opt->ToString(0);
+  ASSERT_EQ(std::dynamic_pointer_cast<SortPlan>(opt->left_), nullptr);
+  ASSERT_EQ(std::dynamic_pointer_cast<SortPlan>(opt->right_), nullptr);
+  // without an equality there are no keys to merge or hash on
+  plan = Join(Scan("r"), Scan("s"), {Condition(OP_LT, Col("r", "k"), Col("s", "k"))}, COST_BASED);
+  opt  = std::dynamic_pointer_cast<JoinPlan>(Optimizer::Optimize(plan, db_.get()));
+  ASSERT_NE(opt, nullptr);
+  ASSERT_EQ(opt->strategy_, NESTED_LOOP);
+  // unordered inputs with equality keys are hashed
+  plan = Join(Scan("r"), Scan("s"), {Eq(Col("r", "k"), Col("s", "k"))}, COST_BASED);
+  opt  = std::dynamic_pointer_cast<JoinPlan>(Optimizer::Optimize(plan, db_.get()));
+  ASSERT_NE(opt, nullptr);
+  ASSERT_EQ(opt->strategy_, HASH_JOIN);
+  ASSERT_NE(opt->left_key_schema_, nullptr);
+  ASSERT_NE(opt->right_key_schema_, nullptr);
+  // ordered only on one side is still hashed
+  plan = Join(Filter("r", OP_GE, "id", 0), Scan("s"), {Eq(Col("r", "id"), Col("s", "id"))}, COST_BASED);
+  opt  = std::dynamic_pointer_cast<JoinPlan>(Optimizer::Optimize(plan, db_.get()));
+  ASSERT_NE(opt, nullptr);
+  ASSERT_EQ(opt->strategy_, HASH_JOIN);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,220 @@
+//
+// Created by ziqi on 2024/8/21.
+//
+
+#include "../config.h"
+#include "storage/index/index_bp_tree.h"
+#include "system/handle/index_handle.h"
+#include "system/index/index_manager.h"
+#include "system/table/table_manager.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class BPTreeIndexTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    disk_manager_        = std::make_unique<DiskManager>();
+    buffer_pool_manager_ = std::make_unique<BufferPoolManager>(disk_manager_.get(), nullptr, 0, 256, 1);
+    table_manager_       = std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    index_manager_       = std::make_unique<IndexManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    if (!std::filesystem::exists(TEST_DIR))
+      std::filesystem::create_directory(TEST_DIR);
+    for (const auto &file : {FILE_NAME(TEST_DIR, table_name_, TAB_SUFFIX), FILE_NAME(TEST_DIR, index_name_, IDX_SUFFIX)})
+      if (std::filesystem::exists(file))
+        std::filesystem::remove(file);
+    std::vector<RTField> fields(2);
+    fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+    fields[1].field_ = {.field_name_ = "name", .field_size_ = 16, .field_type_ = TYPE_STRING};
+    RecordSchema schema(fields);
+    table_manager_->CreateTable(TEST_DIR, table_name_, schema, NARY_MODEL);
+    table_ = table_manager_->OpenTable(TEST_DIR, table_name_, NARY_MODEL);
+    RecordSchema key_schema({table_->GetSchema().GetFieldAt(0)});
+    index_manager_->CreateIndex(TEST_DIR, index_name_, table_name_, key_schema, IndexType::BPTREE);
+    index_ = index_manager_->OpenIndex(TEST_DIR, index_name_, IndexType::BPTREE);
+  }
+
+  void TearDown() override
+  {
+    index_manager_->CloseIndex(*index_);
+    table_manager_->CloseTable(TEST_DIR, *table_);
+  }
+
+  auto Key(int k) -> Record
+  {
+    return {&index_->GetKeySchema(), std::vector<ValueSptr>{ValueFactory::CreateIntValue(k)}, INVALID_RID};
+  }
+
+  auto Tree() -> BPTreeIndex * { return dynamic_cast<BPTreeIndex *>(index_->GetIndex()); }
+
+  /// rids of all entries in [low, high] in key order
+  auto ScanRange(int low, int high) -> std::vector<RID>
+  {
+    std::vector<RID> rids;
+    for (auto iter = Tree()->Scan(Key(low), 1, Key(high), 1); !iter->IsEnd(); iter->Next()) {
+      rids.push_back(iter->GetRID());
+    }
+    return rids;
+  }
+
+  const std::string                  table_name_ = "bptree_index_table";
+  const std::string                  index_name_ = "bptree_index_table_id";
+  std::unique_ptr<DiskManager>       disk_manager_;
+  std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+  std::unique_ptr<TableManager>      table_manager_;
+  std::unique_ptr<IndexManager>      index_manager_;
+  TableHandleUptr                    table_;
+  IndexHandleUptr                    index_;
+};
+
+// the rid of key k stores k so that the order of a scan can be checked
+static auto RIDOf(int k, int dup) -> RID { return {k + 2, static_cast<slot_id_t>(dup)}; }
+
+TEST_F(BPTreeIndexTest, InsertSearchScan)
+{
+  const int        n = 20000;
+  std::vector<int> keys(n);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+  auto tree = Tree();
+  ASSERT_NE(tree, nullptr);
+  // every key is inserted twice with different rids
+  for (auto k : keys) {
+    tree->Insert(Key(k), RIDOf(k, 0));
+    tree->Insert(Key(k), RIDOf(k, 1));
+  }
+  ASSERT_GT(tree->GetHeight(), 1);
+  for (int k = 0; k < n; k += 7) {
+    auto rids = tree->Search(Key(k));
+    ASSERT_EQ(rids.size(), 2);
+    ASSERT_EQ(rids[0], RIDOf(k, 0));
+    ASSERT_EQ(rids[1], RIDOf(k, 1));
+  }
+  ASSERT_TRUE(tree->Search(Key(-1)).empty());
+  ASSERT_TRUE(tree->Search(Key(n)).empty());
+  auto rids = ScanRange(1000, 2999);
+  ASSERT_EQ(rids.size(), 4000);
+  for (int i = 0; i < 4000; ++i) {
+    ASSERT_EQ(rids[i], RIDOf(1000 + i / 2, i % 2));
+  }
+  // without bounds the scan covers the whole tree
+  size_t count = 0;
+  for (auto iter = tree->Scan(Key(0), 0, Key(0), 0); !iter->IsEnd(); iter->Next()) {
+    count++;
+  }
+  ASSERT_EQ(count, 2 * n);
+}
+
+TEST_F(BPTreeIndexTest, Delete)
+{
+  const int n    = 10000;
+  auto      tree = Tree();
+  for (int k = 0; k < n; ++k) {
+    tree->Insert(Key(k), RIDOf(k, 0));
+  }
+  for (int k = 0; k < n; k += 2) {
+    tree->Delete(Key(k), RIDOf(k, 0));
+  }
+  for (int k = 0; k < n; ++k) {
+    ASSERT_EQ(tree->Search(Key(k)).size(), k % 2 == 0 ? 0 : 1);
+  }
+  auto rids = ScanRange(0, n);
+  ASSERT_EQ(rids.size(), n / 2);
+  for (int i = 0; i < n / 2; ++i) {
+    ASSERT_EQ(rids[i], RIDOf(2 * i + 1, 0));
+  }
+  // deleted slots can be filled again
+  for (int k = 0; k < n; k += 2) {
+    tree->Insert(Key(k), RIDOf(k, 0));
+  }
+  ASSERT_EQ(ScanRange(0, n).size(), n);
+}
+
+TEST_F(BPTreeIndexTest, BulkInsert)
+{
+  const int                           n = 30000;
+  std::vector<std::pair<Record, RID>> entries;
+  for (int k = 0; k < n; ++k) {
+    entries.emplace_back(Key(k), RIDOf(k, 0));
+  }
+  auto tree = Tree();
+  tree->BulkInsert(entries);
+  ASSERT_GT(tree->GetHeight(), 1);
+  auto rids = ScanRange(0, n);
+  ASSERT_EQ(rids.size(), n);
+  for (int k = 0; k < n; ++k) {
+    ASSERT_EQ(rids[k], RIDOf(k, 0));
+  }
+  // the built tree accepts further inserts
+  for (int k = 0; k < n; k += 3) {
+    tree->Insert(Key(k), RIDOf(k, 1));
+  }
+  ASSERT_EQ(tree->Search(Key(3)).size(), 2);
+  ASSERT_EQ(tree->Search(Key(4)).size(), 1);
+  ASSERT_EQ(ScanRange(0, n).size(), n + (n + 2) / 3);
+}
+
+TEST_F(BPTreeIndexTest, Reopen)
+{
+  const int n = 5000;
+  for (int k = 0; k < n; ++k) {
+    Tree()->Insert(Key(k), RIDOf(k, 0));
+  }
+  index_manager_->CloseIndex(*index_);
+  index_ = index_manager_->OpenIndex(TEST_DIR, index_name_, IndexType::BPTREE);
+  ASSERT_EQ(ScanRange(0, n).size(), n);
+  ASSERT_EQ(Tree()->Search(Key(n / 2)).front(), RIDOf(n / 2, 0));
+}
+
+TEST_F(BPTreeIndexTest, Concurrent)
+{
+  const int                thread_num = 8;
+  const int                per_thread = 4000;
+  auto                     tree       = Tree();
+  std::vector<std::thread> threads;
+  // writers insert interleaved keys so that they split the same leaves, readers look up what is already there
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([this, tree, t] {
+      for (int i = 0; i < per_thread; ++i) {
+        int k = i * thread_num + t;
+        tree->Insert(Key(k), RIDOf(k, 0));
+        auto rids = tree->Search(Key(k));
+        ASSERT_EQ(rids.size(), 1);
+        ASSERT_EQ(rids[0], RIDOf(k, 0));
+      }
+    });
+  }
+  for (int t = 0; t < 2; ++t) {
+    threads.emplace_back([this] {
+      for (int i = 0; i < 20; ++i) {
+        auto rids = ScanRange(0, thread_num * per_thread);
+        for (size_t j = 1; j < rids.size(); ++j) {
+          ASSERT_LT(rids[j - 1].PageID(), rids[j].PageID());
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto rids = ScanRange(0, thread_num * per_thread);
+  ASSERT_EQ(rids.size(), thread_num * per_thread);
+  for (int k = 0; k < thread_num * per_thread; ++k) {
+    ASSERT_EQ(rids[k], RIDOf(k, 0));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
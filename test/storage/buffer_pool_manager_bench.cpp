@@ -0,0 +1,123 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/16.
+//
+
+#include "storage/buffer/buffer_pool_manager.h"
+#include "../config.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+[[maybe_unused]] constexpr int BENCH_THREADS   = 10;
+[[maybe_unused]] constexpr int BENCH_OPS       = 20000;
+[[maybe_unused]] constexpr int BENCH_POOL_SIZE = 128;
+[[maybe_unused]] constexpr int BENCH_PAGES     = 256;
+
+/**
+ * Run BENCH_THREADS threads doing random FetchPage/UnpinPage on a file whose working set is larger than the pool,
+ * 20% of the accesses dirty the page, returns the throughput in operations per second
+ */
+static auto RunThroughput(wsdb::DiskManager &disk_manager, file_id_t fd, size_t num_partitions) -> double
+{
+  wsdb::BufferPoolManager  bpm(&disk_manager, nullptr, REPLACER_LRU_K, BENCH_POOL_SIZE, num_partitions);
+  std::vector<std::thread> threads;
+  std::atomic<bool>        start{false};
+  threads.reserve(BENCH_THREADS);
+  for (int i = 0; i < BENCH_THREADS; ++i) {
+    threads.emplace_back([&bpm, &start, fd, i] {
+      std::mt19937                       gen(i);
+      std::uniform_int_distribution<int> dist(0, BENCH_PAGES - 1);
+      while (!start.load()) {
+        std::this_thread::yield();
+      }
+      for (int j = 0; j < BENCH_OPS; ++j) {
+        page_id_t pid  = dist(gen);
+        Page     *page = nullptr;
+        while (page == nullptr) {
+          try {
+            page = bpm.FetchPage(fd, pid);
+          } catch (wsdb::WSDBException_ &e) {
+            if (e.type_ != wsdb::WSDB_NO_FREE_FRAME) {
+              throw;
+            }
+            std::this_thread::yield();
+          }
+        }
+        ASSERT_EQ(page->GetPageId(), pid);
+        bpm.UnpinPage(fd, pid, j % 5 == 0);
+      }
+    });
+  }
+  auto begin = std::chrono::steady_clock::now();
+  start.store(true);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto   end     = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(end - begin).count();
+  bpm.DeleteAllPages(fd);
+  return BENCH_THREADS * BENCH_OPS / seconds;
+}
+
+TEST(BufferPoolManagerBench, PartitionThroughput)
+{
+  wsdb::DiskManager disk_manager{};
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  std::filesystem::current_path(TEST_DIR);
+  try {
+    wsdb::DiskManager::CreateFile("bench.tbl");
+  } catch (wsdb::WSDBException_ &e) {
+    // destroy and recreate the file
+    wsdb::DiskManager::DestroyFile("bench.tbl");
+    wsdb::DiskManager::CreateFile("bench.tbl");
+  }
+  auto fd = disk_manager.OpenFile("bench.tbl");
+  // materialize the pages so that every fetch reads a full page
+  {
+    wsdb::BufferPoolManager bpm(&disk_manager);
+    for (page_id_t pid = 0; pid < BENCH_PAGES; ++pid) {
+      bpm.FetchPage(fd, pid);
+      bpm.UnpinPage(fd, pid, true);
+    }
+    bpm.FlushAllPages(fd);
+    bpm.DeleteAllPages(fd);
+  }
+  for (size_t num_partitions : {1, 2, 4, 8, 16}) {
+    double ops = RunThroughput(disk_manager, fd, num_partitions);
+    std::cout << fmt::format("partitions: {:>2}, threads: {}, throughput: {:.0f} ops/s", num_partitions, BENCH_THREADS, ops)
+              << std::endl;
+  }
+  disk_manager.CloseFile(fd);
+  wsdb::DiskManager::DestroyFile("bench.tbl");
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
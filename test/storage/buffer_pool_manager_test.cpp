@@ -16,6 +16,8 @@
  -----------------------------------------------------------------------------*/
 #include "storage/buffer/buffer_pool_manager.h"
 #include "storage/buffer/replacer/lru_replacer.h"
+#include "storage/buffer/read_ahead.h"
+#include "log/log_manager.h"
 #include "../config.h"
 
 #include <cassert>
@@ -169,6 +171,261 @@ TEST(BufferPoolManagerTest, SimpleTest)
   }
 }
 
+TEST(BufferPoolManagerTest, ReadAhead)
+{
+  wsdb::DiskManager       disk_manager{};
+  wsdb::BufferPoolManager buffer_pool_manager(&disk_manager, nullptr, REPLACER_LRU_K, 4 * MAX_PAGES, 1);
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  std::filesystem::current_path(TEST_DIR);
+  try {
+    wsdb::DiskManager::CreateFile("test.tbl");
+  } catch (wsdb::WSDBException_ &e) {
+    // destroy and recreate the file
+    wsdb::DiskManager::DestroyFile("test.tbl");
+    wsdb::DiskManager::CreateFile("test.tbl");
+  }
+  auto                     fd = disk_manager.OpenFile("test.tbl");
+  std::vector<std::string> page_data(MAX_PAGES);
+  for (int i = 0; i < MAX_PAGES; ++i) {
+    page_data[i] = std::to_string(rand());
+    auto page    = buffer_pool_manager.FetchPage(fd, i);
+    memcpy(page->GetData(), page_data[i].c_str(), page_data[i].size());
+    buffer_pool_manager.UnpinPage(fd, i, true);
+  }
+  buffer_pool_manager.DeleteAllPages(fd);
+  SUB_TEST(PrefetchPage)
+  {
+    // prefetched page is loaded but not pinned
+    ASSERT_TRUE(buffer_pool_manager.PrefetchPage(fd, 0));
+    ASSERT_FALSE(buffer_pool_manager.PrefetchPage(fd, 0));
+    auto frame = buffer_pool_manager.GetFrame(fd, 0);
+    ASSERT_NE(frame, nullptr);
+    ASSERT_EQ(frame->GetPinCount(), 0);
+    ASSERT_EQ(memcmp(frame->GetPage()->GetData(), page_data[0].c_str(), page_data[0].size()), 0);
+    ASSERT_TRUE(buffer_pool_manager.DeletePage(fd, 0));
+  }
+  SUB_TEST(SequentialScan)
+  {
+    wsdb::ReadAhead read_ahead(&buffer_pool_manager, fd);
+    for (int i = 0; i < MAX_PAGES / 2; ++i) {
+      read_ahead.OnAccess(i, MAX_PAGES);
+      auto page = buffer_pool_manager.FetchPage(fd, i);
+      ASSERT_EQ(memcmp(page->GetData(), page_data[i].c_str(), page_data[i].size()), 0);
+      buffer_pool_manager.UnpinPage(fd, i, false);
+    }
+    // the page next to the scan is never fetched, it should be brought in by the read-ahead workers
+    int retry = 0;
+    while (!buffer_pool_manager.IsPageLoaded(fd, MAX_PAGES / 2) && retry++ < 1000) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto frame = buffer_pool_manager.GetFrame(fd, MAX_PAGES / 2);
+    ASSERT_NE(frame, nullptr);
+    ASSERT_EQ(frame->GetPinCount(), 0);
+    ASSERT_EQ(memcmp(frame->GetPage()->GetData(), page_data[MAX_PAGES / 2].c_str(), page_data[MAX_PAGES / 2].size()), 0);
+    buffer_pool_manager.DeleteAllPages(fd);
+  }
+  disk_manager.CloseFile(fd);
+  wsdb::DiskManager::DestroyFile("test.tbl");
+}
+
+TEST(BufferPoolManagerTest, Cleaner)
+{
+  wsdb::DiskManager       disk_manager{};
+  wsdb::BufferPoolManager buffer_pool_manager(&disk_manager, nullptr, REPLACER_LRU_K, MAX_PAGES, 1);
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  std::filesystem::current_path(TEST_DIR);
+  try {
+    wsdb::DiskManager::CreateFile("test.tbl");
+  } catch (wsdb::WSDBException_ &e) {
+    // destroy and recreate the file
+    wsdb::DiskManager::DestroyFile("test.tbl");
+    wsdb::DiskManager::CreateFile("test.tbl");
+  }
+  auto                     fd = disk_manager.OpenFile("test.tbl");
+  std::vector<std::string> page_data(MAX_PAGES);
+  for (int i = 0; i < MAX_PAGES; ++i) {
+    page_data[i] = std::to_string(rand());
+    auto page    = buffer_pool_manager.FetchPage(fd, i);
+    memcpy(page->GetData(), page_data[i].c_str(), page_data[i].size());
+    buffer_pool_manager.UnpinPage(fd, i, true);
+  }
+  // keep one page pinned, the cleaner must leave it alone
+  buffer_pool_manager.FetchPage(fd, 0);
+  SUB_TEST(CleanDirtyPages)
+  {
+    auto low = static_cast<size_t>(MAX_PAGES * BUFFER_POOL_DIRTY_RATIO_LOW);
+    ASSERT_EQ(buffer_pool_manager.CleanDirtyPages(), MAX_PAGES - low);
+    ASSERT_TRUE(buffer_pool_manager.GetFrame(fd, 0)->IsDirty());
+    size_t dirty = 0;
+    for (int i = 0; i < MAX_PAGES; ++i) {
+      dirty += buffer_pool_manager.GetFrame(fd, i)->IsDirty() ? 1 : 0;
+    }
+    ASSERT_EQ(dirty, low);
+    // nothing to do below the low mark
+    ASSERT_EQ(buffer_pool_manager.CleanDirtyPages(), 0);
+    char data[PAGE_SIZE];
+    for (int i = 0; i < MAX_PAGES; ++i) {
+      if (!buffer_pool_manager.GetFrame(fd, i)->IsDirty()) {
+        disk_manager.ReadPage(fd, i, data);
+        ASSERT_EQ(memcmp(data, page_data[i].c_str(), page_data[i].size()), 0);
+      }
+    }
+  }
+  SUB_TEST(Background)
+  {
+    buffer_pool_manager.StartCleaner();
+    for (int i = 1; i < MAX_PAGES; ++i) {
+      buffer_pool_manager.FetchPage(fd, i);
+      buffer_pool_manager.UnpinPage(fd, i, true);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10 * BUFFER_POOL_CLEANER_INTERVAL_MS));
+    buffer_pool_manager.StopCleaner();
+    size_t dirty = 0;
+    for (int i = 0; i < MAX_PAGES; ++i) {
+      dirty += buffer_pool_manager.GetFrame(fd, i)->IsDirty() ? 1 : 0;
+    }
+    ASSERT_LE(dirty, static_cast<size_t>(MAX_PAGES * BUFFER_POOL_DIRTY_RATIO_LOW));
+  }
+  buffer_pool_manager.UnpinPage(fd, 0, false);
+  buffer_pool_manager.DeleteAllPages(fd);
+  disk_manager.CloseFile(fd);
+  wsdb::DiskManager::DestroyFile("test.tbl");
+}
+
+/// a disk manager whose vectored and asynchronous writes fail while fail_ is set
+class FailingDiskManager : public wsdb::DiskManager
+{
+public:
+  void WritePages(file_id_t fid, page_id_t first_page_id, const char *const *pages, size_t page_num) override
+  {
+    if (fail_) {
+      WSDB_THROW(wsdb::WSDB_FILE_WRITE_ERROR, "injected write failure");
+    }
+    DiskManager::WritePages(fid, first_page_id, pages, page_num);
+  }
+
+  auto WritePageAsync(file_id_t fid, page_id_t page_id, const char *data) -> std::future<void> override
+  {
+    if (fail_) {
+      std::promise<void> failed;
+      failed.set_exception(std::make_exception_ptr(
+          wsdb::WSDBException_(wsdb::WSDB_FILE_WRITE_ERROR, "FailingDiskManager", "WritePageAsync", "injected")));
+      return failed.get_future();
+    }
+    return DiskManager::WritePageAsync(fid, page_id, data);
+  }
+
+  std::atomic<bool> fail_{false};
+};
+
+TEST(BufferPoolManagerTest, WriteBackFailure)
+{
+  constexpr size_t   DATA_OFFSET = PAGE_SIZE / 2;
+  FailingDiskManager disk_manager{};
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  std::filesystem::current_path(TEST_DIR);
+  if (std::filesystem::exists("write_back_failure.log"))
+    std::filesystem::remove("write_back_failure.log");
+  wsdb::LogManager        log_manager(&disk_manager, "write_back_failure.log");
+  wsdb::BufferPoolManager buffer_pool_manager(&disk_manager, &log_manager, REPLACER_LRU_K, MAX_PAGES, 1);
+  try {
+    wsdb::DiskManager::CreateFile("test.tbl");
+  } catch (wsdb::WSDBException_ &e) {
+    // destroy and recreate the file
+    wsdb::DiskManager::DestroyFile("test.tbl");
+    wsdb::DiskManager::CreateFile("test.tbl");
+  }
+  auto                     fd = disk_manager.OpenFile("test.tbl");
+  std::vector<std::string> page_data(MAX_PAGES);
+  for (int i = 0; i < MAX_PAGES; ++i) {
+    page_data[i] = std::to_string(rand());
+    auto page    = buffer_pool_manager.FetchPage(fd, i);
+    memcpy(page->GetData() + DATA_OFFSET, page_data[i].c_str(), page_data[i].size());
+    buffer_pool_manager.UnpinPage(fd, i, true);
+  }
+  auto rec_lsn = buffer_pool_manager.GetMinRecLsn();
+  ASSERT_NE(rec_lsn, INVALID_LSN);
+
+  // neither a checkpoint flush nor the cleaner may lose the pages when the write fails
+  disk_manager.fail_ = true;
+  ASSERT_EQ(buffer_pool_manager.FlushPagesBefore(std::numeric_limits<lsn_t>::max()), 0);
+  ASSERT_EQ(buffer_pool_manager.CleanDirtyPages(), 0);
+  for (int i = 0; i < MAX_PAGES; ++i) {
+    ASSERT_TRUE(buffer_pool_manager.GetFrame(fd, i)->IsDirty());
+  }
+  ASSERT_EQ(buffer_pool_manager.GetMinRecLsn(), rec_lsn);
+
+  // the pages are written once the device recovers
+  disk_manager.fail_ = false;
+  ASSERT_EQ(buffer_pool_manager.FlushPagesBefore(std::numeric_limits<lsn_t>::max()), MAX_PAGES);
+  ASSERT_EQ(buffer_pool_manager.GetMinRecLsn(), INVALID_LSN);
+  char data[PAGE_SIZE];
+  for (int i = 0; i < MAX_PAGES; ++i) {
+    ASSERT_FALSE(buffer_pool_manager.GetFrame(fd, i)->IsDirty());
+    disk_manager.ReadPage(fd, i, data);
+    ASSERT_EQ(memcmp(data + DATA_OFFSET, page_data[i].c_str(), page_data[i].size()), 0);
+  }
+  buffer_pool_manager.DeleteAllPages(fd);
+  disk_manager.CloseFile(fd);
+  wsdb::DiskManager::DestroyFile("test.tbl");
+}
+
+TEST(BufferPoolManagerTest, EvictionWriteFailure)
+{
+  constexpr size_t   DATA_OFFSET = PAGE_SIZE / 2;
+  constexpr int      POOL_SIZE   = 4;
+  FailingDiskManager disk_manager{};
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  std::filesystem::current_path(TEST_DIR);
+  if (std::filesystem::exists("eviction_write_failure.log"))
+    std::filesystem::remove("eviction_write_failure.log");
+  wsdb::LogManager        log_manager(&disk_manager, "eviction_write_failure.log");
+  wsdb::BufferPoolManager buffer_pool_manager(&disk_manager, &log_manager, REPLACER_LRU_K, POOL_SIZE, 1);
+  try {
+    wsdb::DiskManager::CreateFile("test.tbl");
+  } catch (wsdb::WSDBException_ &e) {
+    // destroy and recreate the file
+    wsdb::DiskManager::DestroyFile("test.tbl");
+    wsdb::DiskManager::CreateFile("test.tbl");
+  }
+  auto                     fd = disk_manager.OpenFile("test.tbl");
+  std::vector<std::string> page_data(MAX_PAGES);
+  auto                     check = [&](int i) {
+    auto page = buffer_pool_manager.FetchPage(fd, i);
+    ASSERT_NE(page, nullptr);
+    ASSERT_EQ(memcmp(page->GetData() + DATA_OFFSET, page_data[i].c_str(), page_data[i].size()), 0) << "page " << i;
+    buffer_pool_manager.UnpinPage(fd, i, false);
+  };
+
+  // every eviction write fails, the evicted pages must come back with their latest content
+  disk_manager.fail_ = true;
+  for (int i = 0; i < MAX_PAGES; ++i) {
+    page_data[i] = std::to_string(rand());
+    auto page    = buffer_pool_manager.FetchPage(fd, i);
+    memcpy(page->GetData() + DATA_OFFSET, page_data[i].c_str(), page_data[i].size());
+    buffer_pool_manager.UnpinPage(fd, i, true);
+  }
+  ASSERT_NE(buffer_pool_manager.GetMinRecLsn(), INVALID_LSN);
+  for (int i = 0; i < MAX_PAGES; ++i) {
+    check(i);
+  }
+  // the copies that were never taken back reach the disk once it recovers
+  disk_manager.fail_ = false;
+  ASSERT_TRUE(buffer_pool_manager.DeleteAllPages(fd));
+  ASSERT_EQ(buffer_pool_manager.GetMinRecLsn(), INVALID_LSN);
+  char data[PAGE_SIZE];
+  for (int i = 0; i < MAX_PAGES; ++i) {
+    disk_manager.ReadPage(fd, i, data);
+    ASSERT_EQ(memcmp(data + DATA_OFFSET, page_data[i].c_str(), page_data[i].size()), 0) << "page " << i;
+  }
+  disk_manager.CloseFile(fd);
+  wsdb::DiskManager::DestroyFile("test.tbl");
+}
+
 class Progress
 {
 public:
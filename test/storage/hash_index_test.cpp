@@ -0,0 +1,196 @@
+//
+// Created by ziqi on 2024/8/22.
+//
+
+#include "../config.h"
+#include "storage/index/index_hash.h"
+#include "system/handle/index_handle.h"
+#include "system/index/index_manager.h"
+#include "system/table/table_manager.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class HashIndexTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    disk_manager_        = std::make_unique<DiskManager>();
+    buffer_pool_manager_ = std::make_unique<BufferPoolManager>(disk_manager_.get(), nullptr, 0, 256, 1);
+    table_manager_       = std::make_unique<TableManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    index_manager_       = std::make_unique<IndexManager>(disk_manager_.get(), buffer_pool_manager_.get());
+    if (!std::filesystem::exists(TEST_DIR))
+      std::filesystem::create_directory(TEST_DIR);
+    for (const auto &file : {FILE_NAME(TEST_DIR, table_name_, TAB_SUFFIX), FILE_NAME(TEST_DIR, index_name_, IDX_SUFFIX)})
+      if (std::filesystem::exists(file))
+        std::filesystem::remove(file);
+    std::vector<RTField> fields(2);
+    fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+    fields[1].field_ = {.field_name_ = "name", .field_size_ = 16, .field_type_ = TYPE_STRING};
+    RecordSchema schema(fields);
+    table_manager_->CreateTable(TEST_DIR, table_name_, schema, NARY_MODEL);
+    table_ = table_manager_->OpenTable(TEST_DIR, table_name_, NARY_MODEL);
+    RecordSchema key_schema({table_->GetSchema().GetFieldAt(0)});
+    index_manager_->CreateIndex(TEST_DIR, index_name_, table_name_, key_schema, IndexType::HASH);
+    index_ = index_manager_->OpenIndex(TEST_DIR, index_name_, IndexType::HASH);
+  }
+
+  void TearDown() override
+  {
+    index_manager_->CloseIndex(*index_);
+    table_manager_->CloseTable(TEST_DIR, *table_);
+  }
+
+  auto Key(int k) -> Record
+  {
+    return {&index_->GetKeySchema(), std::vector<ValueSptr>{ValueFactory::CreateIntValue(k)}, INVALID_RID};
+  }
+
+  auto Hash() -> HashIndex * { return dynamic_cast<HashIndex *>(index_->GetIndex()); }
+
+  const std::string                  table_name_ = "hash_index_table";
+  const std::string                  index_name_ = "hash_index_table_id";
+  std::unique_ptr<DiskManager>       disk_manager_;
+  std::unique_ptr<BufferPoolManager> buffer_pool_manager_;
+  std::unique_ptr<TableManager>      table_manager_;
+  std::unique_ptr<IndexManager>      index_manager_;
+  TableHandleUptr                    table_;
+  IndexHandleUptr                    index_;
+};
+
+// the rid of key k stores k so that lookups can be checked
+static auto RIDOf(int k, int dup) -> RID { return {k + 2, static_cast<slot_id_t>(dup)}; }
+
+TEST_F(HashIndexTest, InsertSearch)
+{
+  const int        n = 20000;
+  std::vector<int> keys(n);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+  auto hash = Hash();
+  ASSERT_NE(hash, nullptr);
+  // every key is inserted twice with different rids
+  for (auto k : keys) {
+    hash->Insert(Key(k), RIDOf(k, 0));
+    hash->Insert(Key(k), RIDOf(k, 1));
+  }
+  // the table grew one bucket at a time
+  ASSERT_GT(hash->GetBucketNum(), HASH_INDEX_INIT_BUCKETS * 8);
+  for (int k = 0; k < n; ++k) {
+    auto rids = hash->Search(Key(k));
+    ASSERT_EQ(rids.size(), 2);
+    std::sort(rids.begin(), rids.end(), [](const RID &lhs, const RID &rhs) { return lhs.SlotID() < rhs.SlotID(); });
+    ASSERT_EQ(rids[0], RIDOf(k, 0));
+    ASSERT_EQ(rids[1], RIDOf(k, 1));
+  }
+  ASSERT_TRUE(hash->Search(Key(-1)).empty());
+  ASSERT_TRUE(hash->Search(Key(n)).empty());
+  // a scan is a point lookup, ranges are rejected
+  size_t count = 0;
+  for (auto iter = hash->Scan(Key(7), 1, Key(7), 1); !iter->IsEnd(); iter->Next()) {
+    ASSERT_EQ(iter->GetRID().PageID(), 7 + 2);
+    count++;
+  }
+  ASSERT_EQ(count, 2);
+  ASSERT_TRUE(hash->Scan(Key(7), 1, Key(8), 1)->IsEnd());
+  ASSERT_THROW(hash->Scan(Key(7), 0, Key(7), 1), WSDBException_);
+}
+
+TEST_F(HashIndexTest, Delete)
+{
+  const int n    = 10000;
+  auto      hash = Hash();
+  for (int k = 0; k < n; ++k) {
+    hash->Insert(Key(k), RIDOf(k, 0));
+  }
+  for (int k = 0; k < n; k += 2) {
+    hash->Delete(Key(k), RIDOf(k, 0));
+  }
+  // deleting an entry that does not exist changes nothing
+  hash->Delete(Key(1), RIDOf(1, 1));
+  for (int k = 0; k < n; ++k) {
+    ASSERT_EQ(hash->Search(Key(k)).size(), k % 2 == 0 ? 0 : 1);
+  }
+  for (int k = 0; k < n; k += 2) {
+    hash->Insert(Key(k), RIDOf(k, 0));
+  }
+  for (int k = 0; k < n; ++k) {
+    ASSERT_EQ(hash->Search(Key(k)).size(), 1);
+  }
+}
+
+TEST_F(HashIndexTest, Overflow)
+{
+  // many duplicates of a few keys cannot be split apart and go to overflow pages
+  auto hash = Hash();
+  for (int k = 0; k < 3; ++k) {
+    for (int i = 0; i < 2000; ++i) {
+      hash->Insert(Key(k), RIDOf(k, i));
+    }
+  }
+  for (int k = 0; k < 3; ++k) {
+    ASSERT_EQ(hash->Search(Key(k)).size(), 2000);
+  }
+  for (int i = 0; i < 2000; i += 2) {
+    hash->Delete(Key(1), RIDOf(1, i));
+  }
+  ASSERT_EQ(hash->Search(Key(1)).size(), 1000);
+}
+
+TEST_F(HashIndexTest, Reopen)
+{
+  const int n = 5000;
+  for (int k = 0; k < n; ++k) {
+    Hash()->Insert(Key(k), RIDOf(k, 0));
+  }
+  auto bucket_num = Hash()->GetBucketNum();
+  index_manager_->CloseIndex(*index_);
+  index_ = index_manager_->OpenIndex(TEST_DIR, index_name_, IndexType::HASH);
+  ASSERT_EQ(Hash()->GetBucketNum(), bucket_num);
+  for (int k = 0; k < n; ++k) {
+    ASSERT_EQ(Hash()->Search(Key(k)).front(), RIDOf(k, 0));
+  }
+}
+
+TEST_F(HashIndexTest, Concurrent)
+{
+  const int                thread_num = 8;
+  const int                per_thread = 4000;
+  auto                     hash       = Hash();
+  std::vector<std::thread> threads;
+  // readers look up the keys of all writers while buckets split under them
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([this, hash, t] {
+      for (int i = 0; i < per_thread; ++i) {
+        int k = i * thread_num + t;
+        hash->Insert(Key(k), RIDOf(k, 0));
+        auto rids = hash->Search(Key(k));
+        ASSERT_EQ(rids.size(), 1);
+        ASSERT_EQ(rids[0], RIDOf(k, 0));
+        if (i > 0) {
+          ASSERT_EQ(hash->Search(Key(k - thread_num)).size(), 1);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int k = 0; k < thread_num * per_thread; ++k) {
+    ASSERT_EQ(hash->Search(Key(k)).size(), 1);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
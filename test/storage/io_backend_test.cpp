@@ -0,0 +1,163 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+#include "storage/disk/io_backend.h"
+#include "../../common/error.h"
+#include "../config.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+using namespace wsdb;
+
+class IOBackendTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    if (!std::filesystem::exists(TEST_DIR))
+      std::filesystem::create_directory(TEST_DIR);
+    fd_ = open(file_name_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd_, 0);
+  }
+
+  void TearDown() override
+  {
+    close(fd_);
+    std::filesystem::remove(file_name_);
+  }
+
+  static auto PageOf(int i) -> std::vector<char>
+  {
+    std::vector<char> page(PAGE_SIZE, static_cast<char>('a' + i % 26));
+    auto              tag = std::to_string(i);
+    memcpy(page.data(), tag.c_str(), tag.size());
+    return page;
+  }
+
+  /// write one page and read it back
+  void RoundTrip(IOBackend &backend)
+  {
+    auto page = PageOf(7);
+    backend.Submit(IOType::WRITE, fd_, page.data(), PAGE_SIZE, 3 * PAGE_SIZE).get();
+    std::vector<char> data(PAGE_SIZE, 0);
+    backend.Submit(IOType::READ, fd_, data.data(), PAGE_SIZE, 3 * PAGE_SIZE).get();
+    ASSERT_EQ(memcmp(data.data(), page.data(), PAGE_SIZE), 0);
+    // beyond the end of file is a short read, not an error
+    std::vector<char> tail(PAGE_SIZE, 0);
+    ASSERT_NO_THROW(backend.Submit(IOType::READ, fd_, tail.data(), PAGE_SIZE, 8 * PAGE_SIZE).get());
+  }
+
+  /// submit every page before waiting for any of them
+  void ManyInFlight(IOBackend &backend, int page_num)
+  {
+    std::vector<std::vector<char>> pages;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < page_num; ++i) {
+      pages.push_back(PageOf(i));
+    }
+    for (int i = 0; i < page_num; ++i) {
+      futures.push_back(backend.Submit(IOType::WRITE, fd_, pages[i].data(), PAGE_SIZE, i * PAGE_SIZE));
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+    futures.clear();
+    std::vector<std::vector<char>> reads(page_num, std::vector<char>(PAGE_SIZE, 0));
+    for (int i = page_num - 1; i >= 0; --i) {
+      futures.push_back(backend.Submit(IOType::READ, fd_, reads[i].data(), PAGE_SIZE, i * PAGE_SIZE));
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+    for (int i = 0; i < page_num; ++i) {
+      ASSERT_EQ(memcmp(reads[i].data(), pages[i].data(), PAGE_SIZE), 0) << "page " << i;
+    }
+  }
+
+  /// a failed request is reported by the future, not by Submit
+  void Errors(IOBackend &backend)
+  {
+    std::vector<char> page(PAGE_SIZE, 0);
+    auto              read = backend.Submit(IOType::READ, -1, page.data(), PAGE_SIZE, 0);
+    try {
+      read.get();
+      FAIL() << "read of a bad fd succeeded";
+    } catch (WSDBException_ &e) {
+      ASSERT_EQ(e.type_, WSDB_FILE_READ_ERROR);
+    }
+    int ro_fd = open(file_name_.c_str(), O_RDONLY);
+    ASSERT_GE(ro_fd, 0);
+    auto write = backend.Submit(IOType::WRITE, ro_fd, page.data(), PAGE_SIZE, 0);
+    try {
+      write.get();
+      FAIL() << "write to a read only fd succeeded";
+    } catch (WSDBException_ &e) {
+      ASSERT_EQ(e.type_, WSDB_FILE_WRITE_ERROR);
+    }
+    close(ro_fd);
+    // the backend keeps working after a failure
+    RoundTrip(backend);
+  }
+
+  const std::string file_name_ = TEST_DIR + "/io_backend_test.dat";
+  int               fd_{-1};
+};
+
+TEST_F(IOBackendTest, PosixIO)
+{
+  PosixIOBackend backend;
+  RoundTrip(backend);
+  ManyInFlight(backend, 64);
+  Errors(backend);
+}
+
+TEST_F(IOBackendTest, IOUring)
+{
+  // a small ring makes submitters wait for free slots
+  IOUringBackend backend(4);
+  if (!backend.Valid()) {
+    GTEST_SKIP() << "io_uring is not available";
+  }
+  RoundTrip(backend);
+  ManyInFlight(backend, 64);
+  Errors(backend);
+}
+
+TEST_F(IOBackendTest, Fallback)
+{
+  // a ring without entries is refused by the kernel, just like one that is too old
+  IOUringBackend ring(0);
+  ASSERT_FALSE(ring.Valid());
+  auto backend = CreateIOBackend("IOUring", 0);
+  ASSERT_NE(dynamic_cast<PosixIOBackend *>(backend.get()), nullptr);
+  RoundTrip(*backend);
+  ManyInFlight(*backend, 16);
+  Errors(*backend);
+  ASSERT_NE(dynamic_cast<PosixIOBackend *>(CreateIOBackend("PosixIO").get()), nullptr);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,138 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/16.
+//
+
+#include "storage/buffer/replacer/lru_replacer.h"
+#include "storage/buffer/replacer/lru_k_replacer.h"
+#include "storage/buffer/replacer/two_q_replacer.h"
+
+#include "../config.h"
+#include "common/config.h"
+
+#include <list>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+[[maybe_unused]] constexpr size_t POOL_FRAMES  = 64;
+[[maybe_unused]] constexpr int    HOT_PAGES    = 48;
+[[maybe_unused]] constexpr int    SCAN_PAGES   = 1000;
+[[maybe_unused]] constexpr int    SCAN_PINS    = 4;  // a scan pins each page several times in a row, one per record
+[[maybe_unused]] constexpr int    TRACE_ROUNDS = 20;
+
+struct Access
+{
+  page_id_t pid_;
+  bool      is_scan_;
+};
+
+/**
+ * Each round does point lookups on the hot pages, then a long scan over cold pages interleaved with point lookups
+ */
+static auto MakeTrace() -> std::vector<Access>
+{
+  std::vector<Access>                trace;
+  std::mt19937                       gen(2024);
+  std::uniform_int_distribution<int> hot(0, HOT_PAGES - 1);
+  page_id_t                          scan_pid = HOT_PAGES;
+  for (int round = 0; round < TRACE_ROUNDS; ++round) {
+    for (int i = 0; i < 2000; ++i) {
+      trace.push_back({hot(gen), false});
+    }
+    for (int i = 0; i < SCAN_PAGES; ++i, ++scan_pid) {
+      for (int j = 0; j < SCAN_PINS; ++j) {
+        trace.push_back({scan_pid, true});
+      }
+      trace.push_back({hot(gen), false});
+    }
+  }
+  return trace;
+}
+
+struct HitRatio
+{
+  double total_;
+  double point_;
+};
+
+/**
+ * Replay the trace on a simulated buffer pool of POOL_FRAMES frames driven by the replacer
+ */
+static auto Replay(wsdb::Replacer &replacer, const std::vector<Access> &trace) -> HitRatio
+{
+  std::unordered_map<page_id_t, frame_id_t> page_frame;
+  std::vector<page_id_t>                    frame_page(POOL_FRAMES, INVALID_PAGE_ID);
+  std::list<frame_id_t>                     free_list;
+  for (frame_id_t i = 0; i < static_cast<frame_id_t>(POOL_FRAMES); ++i) {
+    free_list.push_back(i);
+  }
+  size_t hits = 0, point_hits = 0, points = 0;
+  for (const auto &access : trace) {
+    points += access.is_scan_ ? 0 : 1;
+    frame_id_t frame_id;
+    auto       it = page_frame.find(access.pid_);
+    if (it != page_frame.end()) {
+      frame_id = it->second;
+      hits++;
+      point_hits += access.is_scan_ ? 0 : 1;
+    } else {
+      if (!free_list.empty()) {
+        frame_id = free_list.front();
+        free_list.pop_front();
+      } else {
+        EXPECT_TRUE(replacer.Victim(&frame_id));
+        page_frame.erase(frame_page[frame_id]);
+      }
+      frame_page[frame_id]     = access.pid_;
+      page_frame[access.pid_] = frame_id;
+    }
+    replacer.Pin(frame_id);
+    replacer.Unpin(frame_id);
+  }
+  return {static_cast<double>(hits) / static_cast<double>(trace.size()),
+      static_cast<double>(point_hits) / static_cast<double>(points)};
+}
+
+TEST(ReplacerBench, MixedScanPointHitRatio)
+{
+  auto trace = MakeTrace();
+  std::vector<std::pair<std::string, std::unique_ptr<wsdb::Replacer>>> replacers;
+  replacers.emplace_back("LRUReplacer", std::make_unique<wsdb::LRUReplacer>());
+  replacers.emplace_back("LRUKReplacer", std::make_unique<wsdb::LRUKReplacer>(2));
+  replacers.emplace_back("TwoQReplacer", std::make_unique<wsdb::TwoQReplacer>());
+  std::unordered_map<std::string, HitRatio> ratios;
+  for (auto &[name, replacer] : replacers) {
+    auto ratio = Replay(*replacer, trace);
+    ratios[name] = ratio;
+    std::cout << fmt::format("{:<14} hit ratio: {:.4f}, point lookup hit ratio: {:.4f}", name, ratio.total_, ratio.point_)
+              << std::endl;
+  }
+  // the scan must not flush the hot pages out of a scan resistant pool
+  ASSERT_GT(ratios["TwoQReplacer"].point_, ratios["LRUReplacer"].point_);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -20,6 +20,7 @@
 //
 #include "storage/buffer/replacer/lru_replacer.h"
 #include "storage/buffer/replacer/lru_k_replacer.h"
+#include "storage/buffer/replacer/two_q_replacer.h"
 
 #include "../config.h"
 #include "common/types.h"
@@ -243,6 +244,79 @@ TEST(ReplacerTest, LRUK)
   }
 }
 
+TEST(ReplacerTest, TwoQ)
+{
+  std::vector<frame_id_t> frame_ids = {0, 1, 2, 3, 4, 5, 6, 7};
+  auto                    replacer  = wsdb::TwoQReplacer();
+  SUB_TEST(Basic)
+  {
+    for (auto frame_id : frame_ids) {
+      replacer.Pin(frame_id);
+    }
+    ASSERT_EQ(replacer.Size(), 0);
+    for (auto frame_id : frame_ids) {
+      replacer.Unpin(frame_id);
+    }
+    ASSERT_EQ(replacer.Size(), 8);
+    frame_id_t frame_id;
+    for (int i = 0; i < 8; ++i) {
+      replacer.Victim(&frame_id);
+      ASSERT_EQ(frame_id, i);
+    }
+    ASSERT_EQ(replacer.Size(), 0);
+    ASSERT_FALSE(replacer.Victim(&frame_id));
+  }
+
+  SUB_TEST(ScanResistance)
+  {
+    // frames 0 and 1 are hot, a scan touching frames 2-7 runs in between their accesses,
+    // each scanned frame is pinned several times in a row, which is one correlated reference
+    for (int i = 0; i < 2; ++i) {
+      replacer.Pin(i);
+      replacer.Unpin(i);
+    }
+    for (int i = 2; i < 8; ++i) {
+      for (int j = 0; j < 5; ++j) {
+        replacer.Pin(i);
+        replacer.Unpin(i);
+      }
+    }
+    for (int i = 0; i < 2; ++i) {
+      replacer.Pin(i);
+      replacer.Unpin(i);
+    }
+    ASSERT_EQ(replacer.Size(), 8);
+    // scanned frames are evicted first while hot frames stay, A1in keeps its share of the frames at last
+    frame_id_t frame_id;
+    for (int i = 2; i < 7; ++i) {
+      replacer.Victim(&frame_id);
+      ASSERT_EQ(frame_id, i);
+    }
+    for (int i = 0; i < 3; ++i) {
+      replacer.Victim(&frame_id);
+    }
+    ASSERT_EQ(replacer.Size(), 0);
+  }
+
+  SUB_TEST(PinnedNotVictim)
+  {
+    replacer.Pin(0);
+    replacer.Pin(1);
+    replacer.Unpin(1);
+    replacer.Admit(2);
+    ASSERT_EQ(replacer.Size(), 2);
+    frame_id_t frame_id;
+    replacer.Victim(&frame_id);
+    ASSERT_EQ(frame_id, 1);
+    replacer.Victim(&frame_id);
+    ASSERT_EQ(frame_id, 2);
+    ASSERT_FALSE(replacer.Victim(&frame_id));
+    replacer.Unpin(0);
+    replacer.Victim(&frame_id);
+    ASSERT_EQ(frame_id, 0);
+  }
+}
+
 int main(int argc, char **argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,142 @@
+/*------------------------------------------------------------------------------
+ - Copyright (c) 2024. Websoft research group, Nanjing University.
+ -
+ - This program is free software: you can redistribute it and/or modify
+ - it under the terms of the GNU General Public License as published by
+ - the Free Software Foundation, either version 3 of the License, or
+ - (at your option) any later version.
+ -
+ - This program is distributed in the hope that it will be useful,
+ - but WITHOUT ANY WARRANTY; without even the implied warranty of
+ - MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ - GNU General Public License for more details.
+ -
+ - You should have received a copy of the GNU General Public License
+ - along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ -----------------------------------------------------------------------------*/
+
+//
+// Created by ziqi on 2024/10/26.
+//
+
+#include "system/handle/key_encoder.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using namespace wsdb;
+
+auto MakeField(const std::string &name, FieldType type, size_t size) -> RTField
+{
+  RTField f;
+  f.field_.field_name_ = name;
+  f.field_.field_type_ = type;
+  f.field_.field_size_ = size;
+  return f;
+}
+
+static auto Sign(int v) -> int { return v < 0 ? -1 : (v > 0 ? 1 : 0); }
+
+static auto RandomRecords(const RecordSchema *schema, size_t num) -> std::vector<Record>
+{
+  std::mt19937             rng(42);
+  std::vector<std::string> strs{"", "a", "ab", "abc", "abcdefgh", "b", "\x7f", "\xff\x01"};
+  std::vector<Record>      recs;
+  for (size_t i = 0; i < num; ++i) {
+    std::vector<ValueSptr> values;
+    for (size_t j = 0; j < schema->GetFieldCount(); ++j) {
+      auto type = schema->GetFieldAt(j).field_.field_type_;
+      if (rng() % 8 == 0) {
+        values.push_back(ValueFactory::CreateNullValue(type));
+        continue;
+      }
+      switch (type) {
+        case TYPE_INT: values.push_back(ValueFactory::CreateIntValue(static_cast<int>(rng() % 21) - 10)); break;
+        case TYPE_FLOAT:
+          values.push_back(ValueFactory::CreateFloatValue(static_cast<float>(static_cast<int>(rng() % 41) - 20) / 4));
+          break;
+        case TYPE_BOOL: values.push_back(ValueFactory::CreateBoolValue(rng() % 2 == 0)); break;
+        default: {
+          auto str = strs[rng() % strs.size()].substr(0, schema->GetFieldAt(j).field_.field_size_);
+          values.push_back(ValueFactory::CreateStringValue(str.c_str(), str.size()));
+        }
+      }
+    }
+    recs.emplace_back(schema, values, INVALID_RID);
+  }
+  return recs;
+}
+
+// memcmp of encoded keys should agree with Record::Compare of the key fields, and so should the prefixes when they
+// differ
+TEST(KeyEncoderTest, MatchesRecordCompare)
+{
+  RecordSchema schema({MakeField("i", TYPE_INT, 4),
+      MakeField("f", TYPE_FLOAT, 4),
+      MakeField("s", TYPE_STRING, 8),
+      MakeField("b", TYPE_BOOL, 1)});
+  auto         recs = RandomRecords(&schema, 300);
+  std::vector<std::vector<size_t>> key_sets{{0}, {1}, {2}, {3}, {2, 0}, {3, 1, 0}, {0, 1, 2, 3}};
+  for (const auto &key_set : key_sets) {
+    std::vector<RTField> key_fields;
+    for (auto idx : key_set) {
+      key_fields.push_back(schema.GetFieldAt(idx));
+    }
+    RecordSchema key_schema(key_fields);
+    for (bool is_desc : {false, true}) {
+      KeyEncoder               encoder(&schema, &key_schema, is_desc);
+      std::vector<std::string> keys;
+      for (const auto &rec : recs) {
+        keys.push_back(encoder.Encode(rec));
+        ASSERT_EQ(keys.back().size(), encoder.GetKeySize());
+      }
+      for (size_t l = 0; l < recs.size(); ++l) {
+        for (size_t r = 0; r < recs.size(); ++r) {
+          auto expected = Record::Compare(Record(&key_schema, recs[l]), Record(&key_schema, recs[r]));
+          expected      = is_desc ? -expected : expected;
+          ASSERT_EQ(Sign(encoder.Compare(keys[l].data(), keys[r].data())), Sign(expected));
+          auto lprefix = encoder.Prefix(keys[l].data());
+          auto rprefix = encoder.Prefix(keys[r].data());
+          if (lprefix != rprefix) {
+            ASSERT_EQ(lprefix < rprefix, expected < 0);
+          }
+        }
+      }
+    }
+  }
+}
+
+// keys of two schemas encoded against each other compare like the fields do, int against float and strings of
+// different sizes
+TEST(KeyEncoderTest, MixedSchemas)
+{
+  RecordSchema left({MakeField("i", TYPE_INT, 4), MakeField("s", TYPE_STRING, 4)});
+  RecordSchema right({MakeField("f", TYPE_FLOAT, 4), MakeField("s", TYPE_STRING, 8)});
+  auto         lrecs = RandomRecords(&left, 200);
+  auto         rrecs = RandomRecords(&right, 200);
+  KeyEncoder   lencoder(&left, &left, false, &right);
+  KeyEncoder   rencoder(&right, &right, false, &left);
+  ASSERT_EQ(lencoder.GetKeySize(), rencoder.GetKeySize());
+  for (const auto &lrec : lrecs) {
+    auto lkey = lencoder.Encode(lrec);
+    for (const auto &rrec : rrecs) {
+      auto rkey = rencoder.Encode(rrec);
+      ASSERT_EQ(Sign(lencoder.Compare(lkey.data(), rkey.data())), Sign(Record::Compare(lrec, rrec)));
+    }
+  }
+  // -0.0 equals 0.0
+  RecordSchema floats({MakeField("f", TYPE_FLOAT, 4)});
+  KeyEncoder   encoder(&floats, &floats);
+  auto         neg = encoder.Encode(Record(&floats, {ValueFactory::CreateFloatValue(-0.0F)}, INVALID_RID));
+  auto         pos = encoder.Encode(Record(&floats, {ValueFactory::CreateFloatValue(0.0F)}, INVALID_RID));
+  ASSERT_EQ(neg, pos);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -9,6 +9,7 @@
 #include "system/table/table_manager.h"
 
 #include <cassert>
+#include <set>
 #include <unordered_map>
 #include <vector>
 #include <unordered_set>
@@ -106,6 +107,140 @@ TEST(TableHandle, Simple)
   table_manager->DropTable(TEST_DIR, table_name);
 }
 
+TEST(TableHandle, BulkInsert)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_bulk";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX)))
+    std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, TAB_SUFFIX));
+  auto tbl_schema = GenTableSchema(10);
+  table_manager->CreateTable(TEST_DIR, table_name, *tbl_schema, NARY_MODEL);
+  auto tbl   = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  tbl_schema = nullptr;
+  // leave holes in the first pages so the batch has to fill them before appending new pages
+  std::vector<RID> rids;
+  for (int i = 0; i < 200; ++i) {
+    rids.push_back(tbl->InsertRecord(*GenRecordUnderSchema(tbl->GetSchema())));
+  }
+  for (size_t i = 0; i < rids.size(); i += 3) {
+    tbl->DeleteRecord(rids[i]);
+  }
+  std::vector<RecordUptr> records;
+  for (int i = 0; i < 1000; ++i) {
+    records.push_back(GenRecordUnderSchema(tbl->GetSchema()));
+  }
+  tbl->InsertRecords(records);
+  std::set<std::pair<page_id_t, slot_id_t>> slots;
+  for (const auto &record : records) {
+    ASSERT_NE(record->GetRID().PageID(), INVALID_PAGE_ID);
+    ASSERT_TRUE(slots.emplace(record->GetRID().PageID(), record->GetRID().SlotID()).second);
+    auto record2 = tbl->GetRecord(record->GetRID());
+    ASSERT_TRUE(*record == *record2);
+  }
+  ASSERT_EQ(tbl->GetTableHeader().rec_num_, 200 - (rids.size() + 2) / 3 + records.size());
+  // every record is reachable by a scan
+  size_t count = 0;
+  for (auto rid = tbl->GetFirstRID(); rid != INVALID_RID; rid = tbl->GetNextRID(rid)) {
+    count++;
+  }
+  ASSERT_EQ(count, tbl->GetTableHeader().rec_num_);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+}
+
+TEST(TableHandle, Statistics)
+{
+  auto        disk_manager        = std::make_unique<DiskManager>();
+  auto        buffer_pool_manager = std::make_unique<BufferPoolManager>(disk_manager.get(), nullptr);
+  auto        table_manager       = std::make_unique<TableManager>(disk_manager.get(), buffer_pool_manager.get());
+  std::string table_name          = "table_handle_stats";
+  if (!std::filesystem::exists(TEST_DIR))
+    std::filesystem::create_directory(TEST_DIR);
+  for (const auto &suffix : {TAB_SUFFIX, STAT_SUFFIX})
+    if (std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, suffix)))
+      std::filesystem::remove(FILE_NAME(TEST_DIR, table_name, suffix));
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "name", .field_size_ = 8, .field_type_ = TYPE_STRING};
+  table_manager->CreateTable(TEST_DIR, table_name, RecordSchema(fields), NARY_MODEL);
+  auto tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_EQ(tbl->GetStatistics(), nullptr);
+  // ids 0..999, ten names, every tenth name is null
+  for (int i = 0; i < 1000; ++i) {
+    auto name = fmt::format("name_{}", i % 10);
+    auto rec  = Record(&tbl->GetSchema(),
+        std::vector<ValueSptr>{ValueFactory::CreateIntValue(i),
+            i % 10 == 9 ? ValueFactory::CreateNullValue(TYPE_STRING)
+                        : ValueFactory::CreateStringValue(name.c_str(), name.size())},
+        INVALID_RID);
+    tbl->InsertRecord(rec);
+  }
+  tbl->Analyze();
+  auto check = [](const TableStatistics &stats) {
+    ASSERT_EQ(stats.rec_num_, 1000);
+    ASSERT_EQ(stats.columns_[0].ndv_, 1000);
+    ASSERT_EQ(stats.columns_[0].min_, 0);
+    ASSERT_EQ(stats.columns_[0].max_, 999);
+    ASSERT_EQ(stats.columns_[1].ndv_, 9);
+    ASSERT_EQ(stats.columns_[1].null_num_, 100);
+    ASSERT_NEAR(stats.Selectivity(0, OP_EQ, *ValueFactory::CreateIntValue(42)), 0.001, 1e-9);
+    ASSERT_EQ(stats.Selectivity(0, OP_EQ, *ValueFactory::CreateIntValue(5000)), 0);
+    ASSERT_NEAR(stats.Selectivity(0, OP_LT, *ValueFactory::CreateIntValue(250)), 0.25, 0.01);
+    ASSERT_NEAR(stats.Selectivity(0, OP_GE, *ValueFactory::CreateIntValue(900)), 0.1, 0.01);
+    ASSERT_NEAR(stats.Selectivity(1, OP_EQ, *ValueFactory::CreateStringValue("name_3", 6)), 0.1, 1e-9);
+    ASSERT_NEAR(stats.Selectivity(1, OP_LE, *ValueFactory::CreateStringValue("name_4", 6)), 0.5, 0.05);
+    // unknown for another type and for an unbound placeholder
+    ASSERT_LT(stats.Selectivity(1, OP_EQ, *ValueFactory::CreateIntValue(3)), 0);
+    ASSERT_LT(stats.Selectivity(0, OP_EQ, *ValueFactory::CreateNullValue(TYPE_INT)), 0);
+  };
+  ASSERT_NE(tbl->GetStatistics(), nullptr);
+  check(*tbl->GetStatistics());
+  // the statistics are kept next to the table and read back when it is opened
+  table_manager->WriteStatistics(TEST_DIR, *tbl);
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  tbl = table_manager->OpenTable(TEST_DIR, table_name, NARY_MODEL);
+  ASSERT_NE(tbl->GetStatistics(), nullptr);
+  check(*tbl->GetStatistics());
+  table_manager->CloseTable(TEST_DIR, *tbl);
+  table_manager->DropTable(TEST_DIR, table_name);
+  ASSERT_FALSE(std::filesystem::exists(FILE_NAME(TEST_DIR, table_name, STAT_SUFFIX)));
+}
+
+TEST(TableHandle, StatisticsOfLargeTable)
+{
+  // more rows than the sample holds and more distinct values than are counted exactly in both columns
+  std::vector<RTField> fields(2);
+  fields[0].field_ = {.field_name_ = "id", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  fields[1].field_ = {.field_name_ = "k", .field_size_ = sizeof(int), .field_type_ = TYPE_INT};
+  RecordSchema        schema(fields);
+  StatisticsCollector collector(&schema);
+  const int           rec_num = 10 * static_cast<int>(STATS_SAMPLE_SIZE);
+  const int           k_num   = rec_num / 4;
+  ASSERT_GT(k_num, STATS_NDV_EXACT_LIMIT);
+  for (int i = 0; i < rec_num; ++i) {
+    // the ids arrive in descending order so that a prefix of the table is no sample
+    Record rec(&schema,
+        std::vector<ValueSptr>{ValueFactory::CreateIntValue(rec_num - 1 - i), ValueFactory::CreateIntValue(i % k_num)},
+        INVALID_RID);
+    collector.Add(rec);
+  }
+  auto stats = collector.Build();
+  ASSERT_EQ(stats->rec_num_, rec_num);
+  ASSERT_NEAR(static_cast<double>(stats->columns_[0].ndv_), rec_num, rec_num * 0.05);
+  ASSERT_NEAR(static_cast<double>(stats->columns_[1].ndv_), k_num, k_num * 0.05);
+  ASSERT_EQ(stats->columns_[0].min_, 0);
+  ASSERT_EQ(stats->columns_[0].max_, rec_num - 1);
+  ASSERT_EQ(stats->columns_[0].bounds_.size(), STATS_HISTOGRAM_BUCKETS);
+  ASSERT_EQ(stats->columns_[0].bounds_.back(), rec_num - 1);
+  ASSERT_NEAR(stats->Selectivity(0, OP_LT, *ValueFactory::CreateIntValue(rec_num / 4)), 0.25, 0.02);
+  ASSERT_NEAR(stats->Selectivity(0, OP_GE, *ValueFactory::CreateIntValue(rec_num / 10 * 9)), 0.1, 0.02);
+  ASSERT_NEAR(stats->Selectivity(1, OP_LT, *ValueFactory::CreateIntValue(k_num / 2)), 0.5, 0.02);
+}
+
 TEST(TableHandle, MultiThread)
 {
   auto        disk_manager        = std::make_unique<DiskManager>();